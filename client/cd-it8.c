@@ -36,6 +36,7 @@ typedef struct {
 	GOptionContext		*context;
 	GPtrArray		*cmd_array;
 	gboolean		 timestamps;
+	gchar			*weights;
 } CdUtilPrivate;
 
 typedef gboolean (*CdUtilPrivateCb)	(CdUtilPrivate	*util,
@@ -351,6 +352,163 @@ cd_util_calculate_ccmx (CdUtilPrivate *priv,
 	return TRUE;
 }
 
+static GArray *
+cd_util_load_weights (const gchar *filename, GError **error)
+{
+	g_autofree gchar *data = NULL;
+	g_auto(GStrv) lines = NULL;
+	g_autoptr(GArray) weights = NULL;
+
+	/* one weight per line, in the same order as the patches */
+	if (!g_file_get_contents (filename, &data, NULL, error))
+		return NULL;
+	weights = g_array_new (FALSE, FALSE, sizeof (gdouble));
+	lines = g_strsplit (data, "\n", -1);
+	for (guint i = 0; lines[i] != NULL; i++) {
+		gchar *endptr = NULL;
+		gdouble tmp;
+
+		g_strstrip (lines[i]);
+		if (lines[i][0] == '\0' || lines[i][0] == '#')
+			continue;
+		tmp = g_ascii_strtod (lines[i], &endptr);
+		if (*endptr != '\0' || tmp < 0.f) {
+			g_set_error (error,
+				     CD_ERROR,
+				     CD_ERROR_INVALID_ARGUMENTS,
+				     "Invalid weight on line %u of %s: %s",
+				     i + 1, filename, lines[i]);
+			return NULL;
+		}
+		g_array_append_val (weights, tmp);
+	}
+	return g_steal_pointer (&weights);
+}
+
+static gboolean
+cd_util_calculate_ccmx_batch (CdUtilPrivate *priv,
+			      gchar **values,
+			      GError **error)
+{
+	guint len = g_strv_length (values);
+	g_autoptr(GArray) residuals = NULL;
+	g_autoptr(GArray) weights_pair = NULL;
+	g_autoptr(GHashTable) path_hash = NULL;
+	g_autoptr(GHashTable) ref_hash = NULL;
+	g_autoptr(GPtrArray) ccmx = NULL;
+	g_autoptr(GPtrArray) meas = NULL;
+	g_autoptr(GPtrArray) paths = NULL;
+	g_autoptr(GPtrArray) refs = NULL;
+	g_autoptr(GPtrArray) weights = NULL;
+
+	/* check args */
+	if (len < 3 || (len - 1) % 2 != 0) {
+		g_set_error_literal (error,
+				     CD_ERROR,
+				     CD_ERROR_INVALID_ARGUMENTS,
+				     "Not enough arguments, expected: directory, "
+				     "file, file, [file, file]...");
+		return FALSE;
+	}
+
+	/* each CCMX file is named after the measurement, so these have to differ */
+	path_hash = g_hash_table_new (g_str_hash, g_str_equal);
+	paths = g_ptr_array_new_with_free_func (g_free);
+	for (guint i = 2; i < len; i += 2) {
+		gchar *tmp;
+		const gchar *dupe;
+		g_autofree gchar *basename = NULL;
+		g_autofree gchar *filename = NULL;
+		gchar *path;
+
+		basename = g_path_get_basename (values[i]);
+		tmp = g_strrstr (basename, ".");
+		if (tmp != NULL)
+			*tmp = '\0';
+		filename = g_strdup_printf ("%s.ccmx", basename);
+		path = g_build_filename (values[0], filename, NULL);
+		g_ptr_array_add (paths, path);
+		dupe = g_hash_table_lookup (path_hash, path);
+		if (dupe != NULL) {
+			g_set_error (error,
+				     CD_ERROR,
+				     CD_ERROR_INVALID_ARGUMENTS,
+				     "%s and %s would both be saved as %s",
+				     dupe, values[i], path);
+			return FALSE;
+		}
+		g_hash_table_insert (path_hash, path, values[i]);
+	}
+
+	/* the same weights are used for every pair */
+	if (priv->weights != NULL) {
+		weights_pair = cd_util_load_weights (priv->weights, error);
+		if (weights_pair == NULL)
+			return FALSE;
+		weights = g_ptr_array_new ();
+		for (guint i = 1; i < len; i += 2)
+			g_ptr_array_add (weights, weights_pair);
+	}
+
+	/* load each pair, sharing references that are used more than once */
+	ref_hash = g_hash_table_new_full (g_str_hash, g_str_equal,
+					  NULL, (GDestroyNotify) g_object_unref);
+	refs = g_ptr_array_new ();
+	meas = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	for (guint i = 1; i < len; i += 2) {
+		CdIt8 *it8_ref;
+		g_autoptr(CdIt8) it8_meas = NULL;
+		g_autoptr(GFile) file_meas = NULL;
+
+		it8_ref = g_hash_table_lookup (ref_hash, values[i]);
+		if (it8_ref == NULL) {
+			g_autoptr(GFile) file_ref = NULL;
+			it8_ref = cd_it8_new ();
+			g_hash_table_insert (ref_hash, values[i], it8_ref);
+			file_ref = g_file_new_for_path (values[i]);
+			if (!cd_it8_load_from_file (it8_ref, file_ref, error))
+				return FALSE;
+		}
+		g_ptr_array_add (refs, it8_ref);
+
+		it8_meas = cd_it8_new ();
+		file_meas = g_file_new_for_path (values[i + 1]);
+		if (!cd_it8_load_from_file (it8_meas, file_meas, error))
+			return FALSE;
+		g_ptr_array_add (meas, g_steal_pointer (&it8_meas));
+	}
+
+	/* calculate all the correction matrices */
+	residuals = g_array_new (FALSE, FALSE, sizeof (CdCcmxResidual));
+	ccmx = cd_it8_utils_calculate_ccmx_lsq_array (refs, meas, weights,
+						      residuals, error);
+	if (ccmx == NULL)
+		return FALSE;
+
+	/* save each CCMX file next to the others, named after the measurement */
+	for (guint i = 0; i < ccmx->len; i++) {
+		CdCcmxResidual *residual = &g_array_index (residuals, CdCcmxResidual, i);
+		CdIt8 *it8_ccmx = g_ptr_array_index (ccmx, i);
+		const gchar *path = g_ptr_array_index (paths, i);
+		gchar *tmp;
+		g_autofree gchar *basename = NULL;
+		g_autoptr(GFile) file_ccmx = NULL;
+
+		basename = g_path_get_basename (values[i * 2 + 2]);
+		tmp = g_strrstr (basename, ".");
+		if (tmp != NULL)
+			*tmp = '\0';
+		cd_it8_add_option (it8_ccmx, "TYPE_FACTORY");
+		cd_it8_set_title (it8_ccmx, basename);
+		file_ccmx = g_file_new_for_path (path);
+		if (!cd_it8_save_to_file (it8_ccmx, file_ccmx, error))
+			return FALSE;
+		g_print ("%s\tdE mean %.2f\tdE max %.2f\n", path,
+			 residual->delta_e_mean, residual->delta_e_max);
+	}
+	return TRUE;
+}
+
 static gboolean
 cd_util_create_sp (CdUtilPrivate *priv,
 		   gchar **values,
@@ -459,6 +617,7 @@ main (int argc, char *argv[])
 	gboolean ret;
 	gboolean verbose = FALSE;
 	gboolean enable_timestamps = FALSE;
+	gchar *weights = NULL;
 	guint retval = 1;
 	g_autoptr(GError) error = NULL;
 	g_autofree gchar *cmd_descriptions = NULL;
@@ -469,6 +628,9 @@ main (int argc, char *argv[])
 		{ "enable-timestamps", 'd', 0, G_OPTION_ARG_NONE, &enable_timestamps,
 			/* TRANSLATORS: command line option */
 			_("Write embedded creation timestamps"), NULL },
+		{ "weights", '\0', 0, G_OPTION_ARG_FILENAME, &weights,
+			/* TRANSLATORS: command line option */
+			_("Weight the patches using a file with one value per line"), NULL },
 		{ NULL}
 	};
 
@@ -480,7 +642,6 @@ main (int argc, char *argv[])
 
 	/* create helper object */
 	priv = g_new0 (CdUtilPrivate, 1);
-	priv->timestamps = enable_timestamps;
 
 	/* add commands */
 	priv->cmd_array = g_ptr_array_new_with_free_func ((GDestroyNotify) cd_util_item_free);
@@ -502,6 +663,12 @@ main (int argc, char *argv[])
 		     /* TRANSLATORS: command description */
 		     _("Create a CCMX from reference and measurement data"),
 		     cd_util_calculate_ccmx);
+	cd_util_add (priv->cmd_array,
+		     "calculate-ccmx-batch",
+		     "[OUTPUT-DIR] [REFERENCE.ti3] [MEASURED.ti3]...",
+		     /* TRANSLATORS: command description */
+		     _("Create CCMX files from many sets of reference and measurement data"),
+		     cd_util_calculate_ccmx_batch);
 
 	/* sort by command name */
 	g_ptr_array_sort (priv->cmd_array,
@@ -516,6 +683,8 @@ main (int argc, char *argv[])
 	g_set_application_name (_("Color Management"));
 	g_option_context_add_main_entries (priv->context, options, NULL);
 	ret = g_option_context_parse (priv->context, &argc, &argv, &error);
+	priv->timestamps = enable_timestamps;
+	priv->weights = weights;
 	if (!ret) {
 		/* TRANSLATORS: the user didn't read the man page */
 		g_print ("%s: %s\n",
@@ -553,6 +722,7 @@ out:
 		if (priv->cmd_array != NULL)
 			g_ptr_array_unref (priv->cmd_array);
 		g_option_context_free (priv->context);
+		g_free (priv->weights);
 		g_free (priv);
 	}
 	return retval;
@@ -34,22 +34,42 @@
 #include "cd-session.h"
 
 typedef struct {
-	/* global */
 	CdClient		*client;
-	CdSessionStatus		 status;
 	GDBusConnection		*connection;
 	GDBusNodeInfo		*introspection;
 	GMainLoop		*loop;
 	GSettings		*settings;
-	guint32			 progress;
+	GPtrArray		*sessions;	/* of CdMainSession */
 	guint			 sample_delay;
+	guint			 session_id_next;
+	guint			 quit_id;
+} CdMainPrivate;
+
+/* each display is calibrated by a session with its own object path, and
+ * the measurements run in a worker thread so that sessions can make
+ * progress at the same time. The sensor proxy belongs to the context of
+ * the session, which is only ever iterated by one thread at a time, and
+ * everything else is only touched from the main thread; the worker hands
+ * signals and property changes back to it with g_main_context_invoke() */
+typedef struct {
+	CdMainPrivate		*priv;
+	gchar			*object_path;
+	guint			 registration_id;
+	guint			 remove_id;
+	gboolean		 active;
+	CdSessionStatus		 status;
+	guint32			 progress;
 	guint			 watcher_id;
 	CdState			*state;
+	GMainContext		*context;
+	GMainContext		*main_context;	/* owns the object */
 
 	/* for the task */
 	CdSessionInteraction	 interaction_code_last;
-	CdSensor		*sensor;
-	CdDevice		*device;
+	CdSensor		*sensor;	/* in context */
+	CdDevice		*device;	/* main thread only */
+	gchar			*device_id;
+	gchar			*device_model;
 	CdProfile		*profile;
 	CdSensorCap		 device_kind;
 	GPtrArray		*array;
@@ -60,6 +80,7 @@ typedef struct {
 	gdouble			 gamma_scale_factor;
 	guint			 target_whitepoint;
 	guint			 screen_brightness;
+	CdColorRGB		 sample_color;
 	CdIt8			*it8_cal;
 	CdIt8			*it8_ti1;
 	CdIt8			*it8_ti3;
@@ -68,7 +89,7 @@ typedef struct {
 	gchar			*title;
 	gchar			*basename;
 	gchar			*working_path;
-} CdMainPrivate;
+} CdMainSession;
 
 typedef struct {
 	CdColorRGB		 color;
@@ -127,18 +148,43 @@ cd_main_calib_idle_delay_cb (gpointer user_data)
 	return G_SOURCE_REMOVE;
 }
 
+static gboolean
+cd_main_calib_idle_cancelled_cb (GCancellable *cancellable, gpointer user_data)
+{
+	GMainLoop *loop = (GMainLoop *) user_data;
+	g_main_loop_quit (loop);
+	return G_SOURCE_REMOVE;
+}
+
+/* wait for the display to settle, processing the sensor proxy and
+ * returning early if the session is cancelled */
 static void
-cd_main_calib_idle_delay (guint ms)
+cd_main_calib_idle_delay (CdMainSession *session, guint ms)
 {
-	GMainLoop *loop;
-	loop = g_main_loop_new (NULL, FALSE);
-	g_timeout_add (ms, cd_main_calib_idle_delay_cb, loop);
+	GSource *source_cancel;
+	GSource *source_timeout;
+	g_autoptr(GMainLoop) loop = NULL;
+
+	loop = g_main_loop_new (session->context, FALSE);
+	source_timeout = g_timeout_source_new (ms);
+	g_source_set_callback (source_timeout,
+			       cd_main_calib_idle_delay_cb,
+			       loop, NULL);
+	g_source_attach (source_timeout, session->context);
+	source_cancel = g_cancellable_source_new (session->cancellable);
+	g_source_set_callback (source_cancel,
+			       (GSourceFunc) cd_main_calib_idle_cancelled_cb,
+			       loop, NULL);
+	g_source_attach (source_cancel, session->context);
 	g_main_loop_run (loop);
-	g_main_loop_unref (loop);
+	g_source_destroy (source_timeout);
+	g_source_destroy (source_cancel);
+	g_source_unref (source_timeout);
+	g_source_unref (source_cancel);
 }
 
 static gboolean
-cd_main_emit_update_sample (CdMainPrivate *priv,
+cd_main_emit_update_sample (CdMainSession *session,
 			    CdColorRGB *color,
 			    GError **error)
 {
@@ -147,9 +193,10 @@ cd_main_emit_update_sample (CdMainPrivate *priv,
 	/* emit signal */
 	g_debug ("CdMain: Emitting UpdateSample(%f,%f,%f)",
 		 color->R, color->G, color->B);
-	g_dbus_connection_emit_signal (priv->connection,
+	cd_color_rgb_copy (color, &session->sample_color);
+	g_dbus_connection_emit_signal (session->priv->connection,
 				       NULL,
-				       CD_SESSION_DBUS_PATH,
+				       session->object_path,
 				       CD_SESSION_DBUS_INTERFACE_DISPLAY,
 				       "UpdateSample",
 				       g_variant_new ("(ddd)",
@@ -159,7 +206,7 @@ cd_main_emit_update_sample (CdMainPrivate *priv,
 				       NULL);
 
 	/* if this is the dummy sensor then set the sample RGB value */
-	if (cd_sensor_get_kind (priv->sensor) == CD_SENSOR_KIND_DUMMY) {
+	if (cd_sensor_get_kind (session->sensor) == CD_SENSOR_KIND_DUMMY) {
 		hash = g_hash_table_new_full (g_str_hash,
 					      g_str_equal,
 					      g_free,
@@ -173,13 +220,13 @@ cd_main_emit_update_sample (CdMainPrivate *priv,
 		g_hash_table_insert (hash,
 				     g_strdup ("sample[blue]"),
 				     g_variant_take_ref (g_variant_new_double (color->B)));
-		if (!cd_sensor_set_options_sync (priv->sensor,
+		if (!cd_sensor_set_options_sync (session->sensor,
 						 hash,
-						 priv->cancellable,
+						 session->cancellable,
 						 error))
 			return FALSE;
 	}
-	cd_main_calib_idle_delay (priv->sample_delay);
+	cd_main_calib_idle_delay (session, session->priv->sample_delay);
 	return TRUE;
 }
 
@@ -199,31 +246,41 @@ cd_main_get_display_ti1 (CdProfileQuality quality)
 	return NULL;
 }
 
+typedef struct {
+	CdMainSession		*session;
+	CdSessionInteraction	 code;
+	guint32			 progress;
+	gchar			*image;
+} CdMainSessionUpdate;
+
 static void
-cd_main_emit_interaction_required (CdMainPrivate *priv,
-				   CdSessionInteraction code)
+cd_main_session_update_free (CdMainSessionUpdate *update)
 {
-	const gchar *image = NULL;
+	g_free (update->image);
+	g_free (update);
+}
+
+/* run in the main context, so the session cannot have been removed yet:
+ * that only happens from an idle after the worker has returned */
+static gboolean
+cd_main_emit_interaction_required_cb (gpointer user_data)
+{
+	CdMainSessionUpdate *update = (CdMainSessionUpdate *) user_data;
+	CdMainSession *session = update->session;
 	const gchar *message = NULL;
 
 	/* save so we know what was asked for */
-	priv->interaction_code_last = code;
+	session->interaction_code_last = update->code;
 
 	/* emit signal */
-	switch (code) {
+	switch (update->code) {
 	case CD_SESSION_INTERACTION_ATTACH_TO_SCREEN:
-		image = cd_sensor_get_metadata_item (priv->sensor,
-						     CD_SENSOR_METADATA_IMAGE_ATTACH);
 		message = "attach the sensor to the screen";
 		break;
 	case CD_SESSION_INTERACTION_MOVE_TO_SURFACE:
-		image = cd_sensor_get_metadata_item (priv->sensor,
-						     CD_SENSOR_METADATA_IMAGE_SCREEN);
 		message = "move the sensor to the surface position";
 		break;
 	case CD_SESSION_INTERACTION_MOVE_TO_CALIBRATION:
-		image = cd_sensor_get_metadata_item (priv->sensor,
-						     CD_SENSOR_METADATA_IMAGE_CALIBRATE);
 		message = "move the sensor to the calibrate position";
 		break;
 	case CD_SESSION_INTERACTION_SHUT_LAPTOP_LID:
@@ -234,21 +291,59 @@ cd_main_emit_interaction_required (CdMainPrivate *priv,
 		break;
 	}
 	g_debug ("CdMain: Emitting InteractionRequired(%u,%s,%s)",
-		 code, message, image);
-	g_dbus_connection_emit_signal (priv->connection,
+		 update->code, message, update->image);
+	g_dbus_connection_emit_signal (session->priv->connection,
 				       NULL,
-				       CD_SESSION_DBUS_PATH,
+				       session->object_path,
 				       CD_SESSION_DBUS_INTERFACE_DISPLAY,
 				       "InteractionRequired",
 				       g_variant_new ("(uss)",
-						      code,
+						      update->code,
 						      message,
-						      image != NULL ? image : ""),
+						      update->image != NULL ? update->image : ""),
 				       NULL);
+	return G_SOURCE_REMOVE;
 }
 
 static void
-cd_main_emit_update_gamma (CdMainPrivate *priv,
+cd_main_emit_interaction_required (CdMainSession *session,
+				   CdSessionInteraction code)
+{
+	CdMainSessionUpdate *update;
+	const gchar *image = NULL;
+
+	/* the sensor metadata is read in the context of the caller */
+	switch (code) {
+	case CD_SESSION_INTERACTION_ATTACH_TO_SCREEN:
+		image = cd_sensor_get_metadata_item (session->sensor,
+						     CD_SENSOR_METADATA_IMAGE_ATTACH);
+		break;
+	case CD_SESSION_INTERACTION_MOVE_TO_SURFACE:
+		image = cd_sensor_get_metadata_item (session->sensor,
+						     CD_SENSOR_METADATA_IMAGE_SCREEN);
+		break;
+	case CD_SESSION_INTERACTION_MOVE_TO_CALIBRATION:
+		image = cd_sensor_get_metadata_item (session->sensor,
+						     CD_SENSOR_METADATA_IMAGE_CALIBRATE);
+		break;
+	default:
+		break;
+	}
+
+	/* this runs straight away when called from the main thread */
+	update = g_new0 (CdMainSessionUpdate, 1);
+	update->session = session;
+	update->code = code;
+	update->image = g_strdup (image);
+	g_main_context_invoke_full (session->main_context,
+				    G_PRIORITY_DEFAULT,
+				    cd_main_emit_interaction_required_cb,
+				    update,
+				    (GDestroyNotify) cd_main_session_update_free);
+}
+
+static void
+cd_main_emit_update_gamma (CdMainSession *session,
 			   GPtrArray *array)
 {
 	GVariantBuilder builder;
@@ -269,19 +364,19 @@ cd_main_emit_update_gamma (CdMainPrivate *priv,
 				       color->G,
 				       color->B);
 	}
-	g_dbus_connection_emit_signal (priv->connection,
+	g_dbus_connection_emit_signal (session->priv->connection,
 				       NULL,
-				       CD_SESSION_DBUS_PATH,
+				       session->object_path,
 				       CD_SESSION_DBUS_INTERFACE_DISPLAY,
 				       "UpdateGamma",
 				       g_variant_new ("(a(ddd))",
 						      &builder),
 				       NULL);
-	cd_main_calib_idle_delay (200);
+	cd_main_calib_idle_delay (session, 200);
 }
 
 static void
-cd_main_emit_finished (CdMainPrivate *priv,
+cd_main_emit_finished (CdMainSession *session,
 		       CdSessionError exit_code,
 		       const gchar *message)
 {
@@ -297,11 +392,11 @@ cd_main_emit_finished (CdMainPrivate *priv,
 		g_variant_builder_add (&builder,
 				       "{sv}",
 				       "ProfileId",
-				       g_variant_new_string (cd_profile_get_id (priv->profile)));
+				       g_variant_new_string (cd_profile_get_id (session->profile)));
 		g_variant_builder_add (&builder,
 				       "{sv}",
 				       "ProfilePath",
-				       g_variant_new_string (cd_profile_get_object_path (priv->profile)));
+				       g_variant_new_string (cd_profile_get_object_path (session->profile)));
 	} else {
 		g_variant_builder_add (&builder,
 				       "{sv}",
@@ -309,9 +404,9 @@ cd_main_emit_finished (CdMainPrivate *priv,
 				       g_variant_new_string (message));
 	}
 
-	g_dbus_connection_emit_signal (priv->connection,
+	g_dbus_connection_emit_signal (session->priv->connection,
 				       NULL,
-				       CD_SESSION_DBUS_PATH,
+				       session->object_path,
 				       CD_SESSION_DBUS_INTERFACE_DISPLAY,
 				       "Finished",
 				       g_variant_new ("(ua{sv})",
@@ -320,25 +415,58 @@ cd_main_emit_finished (CdMainPrivate *priv,
 				       NULL);
 }
 
+static void
+cd_main_emit_sample_taken (CdMainSession *session,
+			   const CdColorXYZ *xyz,
+			   gint64 timestamp)
+{
+	/* emit signal */
+	g_debug ("CdMain: Emitting SampleTaken(%f,%f,%f,%f,%f,%f,%" G_GINT64_FORMAT ")",
+		 session->sample_color.R,
+		 session->sample_color.G,
+		 session->sample_color.B,
+		 xyz->X, xyz->Y, xyz->Z,
+		 timestamp);
+	g_dbus_connection_emit_signal (session->priv->connection,
+				       NULL,
+				       session->object_path,
+				       CD_SESSION_DBUS_INTERFACE_DISPLAY,
+				       "SampleTaken",
+				       g_variant_new ("(ddddddx)",
+						      session->sample_color.R,
+						      session->sample_color.G,
+						      session->sample_color.B,
+						      xyz->X,
+						      xyz->Y,
+						      xyz->Z,
+						      timestamp),
+				       NULL);
+}
+
 static gboolean
-cd_main_calib_get_sample (CdMainPrivate *priv,
+cd_main_calib_get_sample (CdMainSession *session,
 			  CdColorXYZ *xyz,
 			  GError **error)
 {
+	gint64 timestamp;
 	g_autoptr(CdColorXYZ) xyz_tmp = NULL;
 
-	xyz_tmp = cd_sensor_get_sample_sync (priv->sensor,
-					     priv->device_kind,
-					     priv->cancellable,
+	/* the monotonic clock is shared by all the sessions, so runs on
+	 * different displays can be lined up afterwards */
+	timestamp = g_get_monotonic_time ();
+	xyz_tmp = cd_sensor_get_sample_sync (session->sensor,
+					     session->device_kind,
+					     session->cancellable,
 					     error);
 	if (xyz_tmp == NULL)
 		return FALSE;
 	cd_color_xyz_copy (xyz_tmp, xyz);
+	cd_main_emit_sample_taken (session, xyz, timestamp);
 	return TRUE;
 }
 
 static gboolean
-cd_main_calib_get_native_whitepoint (CdMainPrivate *priv,
+cd_main_calib_get_native_whitepoint (CdMainSession *session,
 				     gdouble *temp,
 				     GError **error)
 {
@@ -349,15 +477,15 @@ cd_main_calib_get_native_whitepoint (CdMainPrivate *priv,
 	rgb.R = 1.0;
 	rgb.G = 1.0;
 	rgb.B = 1.0;
-	if (!cd_main_emit_update_sample (priv, &rgb, error))
+	if (!cd_main_emit_update_sample (session, &rgb, error))
 		return FALSE;
-	if (!cd_main_calib_get_sample (priv, &xyz, error))
+	if (!cd_main_calib_get_sample (session, &xyz, error))
 		return FALSE;
 
 	/* save the absolute XYZ measurement so we can scale each sample->Y
 	 * to 1.0 for the gamma error check */
-	cd_color_xyz_copy (&xyz, &priv->absolute_white);
-	g_debug ("Absolute white: %f", priv->absolute_white.Y);
+	cd_color_xyz_copy (&xyz, &session->absolute_white);
+	g_debug ("Absolute white: %f", session->absolute_white.Y);
 
 	cmsXYZ2xyY (&chroma, (cmsCIEXYZ *) &xyz);
 	g_debug ("x:%f,y:%f,Y:%f", chroma.x, chroma.y, chroma.Y);
@@ -366,7 +494,7 @@ cd_main_calib_get_native_whitepoint (CdMainPrivate *priv,
 }
 
 static gboolean
-cd_main_calib_try_item (CdMainPrivate *priv,
+cd_main_calib_try_item (CdMainSession *session,
 		        CdMainCalibrateItem *item,
 		        gboolean *new_best,
 		        GError **error)
@@ -378,18 +506,18 @@ cd_main_calib_try_item (CdMainPrivate *priv,
 	gdouble lumi_target;
 
 	g_debug ("try %f,%f,%f", item->color.R, item->color.G, item->color.B);
-	cd_main_emit_update_gamma (priv, priv->array);
+	cd_main_emit_update_gamma (session, session->array);
 
 	/* get the sample using the default matrix */
-	if (!cd_main_calib_get_sample (priv, &xyz, error))
+	if (!cd_main_calib_get_sample (session, &xyz, error))
 		return FALSE;
 
 	/* get error */
-	cmsXYZ2Lab (&priv->whitepoint, &lab, (const cmsCIEXYZ *) &xyz);
+	cmsXYZ2Lab (&session->whitepoint, &lab, (const cmsCIEXYZ *) &xyz);
 
 	/* scale by absolute white luminance */
-	lumi_measured = xyz.Y / priv->absolute_white.Y;
-	lumi_target = pow (item->index_factor, priv->target_gamma);
+	lumi_measured = xyz.Y / session->absolute_white.Y;
+	lumi_target = pow (item->index_factor, session->target_gamma);
 	g_debug ("Absolute luminance at this point should be %f but is %f",
 		 lumi_target, lumi_measured);
 
@@ -398,7 +526,7 @@ cd_main_calib_try_item (CdMainPrivate *priv,
 	g_debug ("Lab: %f\t%f\t%f error %f", lab.L, lab.a, lab.b, error_tmp);
 
 	/* add in gamma error */
-	error_tmp += priv->gamma_scale_factor * ABS (lumi_target - lumi_measured);
+	error_tmp += session->gamma_scale_factor * ABS (lumi_target - lumi_measured);
 	g_debug ("Total error %f", error_tmp);
 
 	/* is it better than we ever got before */
@@ -412,7 +540,7 @@ cd_main_calib_try_item (CdMainPrivate *priv,
 }
 
 static gboolean
-cd_main_calib_process_item (CdMainPrivate *priv,
+cd_main_calib_process_item (CdMainSession *session,
 			    CdMainCalibrateItem *item,
 			    CdState *state,
 			    GError **error)
@@ -439,7 +567,7 @@ cd_main_calib_process_item (CdMainPrivate *priv,
 	cd_color_rgb_copy (&item->color, &item->best_so_far);
 
 	/* get a baseline error */
-	ret = cd_main_calib_try_item (priv, item, NULL, error);
+	ret = cd_main_calib_try_item (session, item, NULL, error);
 	if (!ret)
 		return FALSE;
 
@@ -448,11 +576,11 @@ cd_main_calib_process_item (CdMainPrivate *priv,
 		return FALSE;
 
 	/* use a different smallest interval for each quality */
-	if (priv->quality == CD_PROFILE_QUALITY_LOW) {
+	if (session->quality == CD_PROFILE_QUALITY_LOW) {
 		good_enough_interval = 0.009;
-	} else if (priv->quality == CD_PROFILE_QUALITY_MEDIUM) {
+	} else if (session->quality == CD_PROFILE_QUALITY_MEDIUM) {
 		good_enough_interval = 0.006;
-	} else if (priv->quality == CD_PROFILE_QUALITY_HIGH) {
+	} else if (session->quality == CD_PROFILE_QUALITY_HIGH) {
 		good_enough_interval = 0.003;
 	}
 
@@ -464,14 +592,14 @@ cd_main_calib_process_item (CdMainPrivate *priv,
 	for (i = 0; i < 500; i++) {
 
 		/* check if cancelled */
-		if (g_cancellable_set_error_if_cancelled (priv->cancellable, error))
+		if (g_cancellable_set_error_if_cancelled (session->cancellable, error))
 			return FALSE;
 
 		/* blue */
 		cd_color_rgb_copy (&item->best_so_far, &item->color);
 		if (item->best_so_far.B > interval) {
 			item->color.B = item->best_so_far.B - interval;
-			if (!cd_main_calib_try_item (priv, item, &new_best, error))
+			if (!cd_main_calib_try_item (session, item, &new_best, error))
 				return FALSE;
 			if (new_best) {
 				g_debug ("New best: blue down by %f", interval);
@@ -481,7 +609,7 @@ cd_main_calib_process_item (CdMainPrivate *priv,
 		}
 		if (item->best_so_far.B < 1.0 - interval) {
 			item->color.B = item->best_so_far.B + interval;
-			if (!cd_main_calib_try_item (priv, item, &new_best, error))
+			if (!cd_main_calib_try_item (session, item, &new_best, error))
 				return FALSE;
 			if (new_best) {
 				g_debug ("New best: blue up by %f", interval);
@@ -494,7 +622,7 @@ cd_main_calib_process_item (CdMainPrivate *priv,
 		cd_color_rgb_copy (&item->best_so_far, &item->color);
 		if (item->best_so_far.R > interval) {
 			item->color.R = item->best_so_far.R - interval;
-			if (!cd_main_calib_try_item (priv, item, &new_best, error))
+			if (!cd_main_calib_try_item (session, item, &new_best, error))
 				return FALSE;
 			if (new_best) {
 				g_debug ("New best: red down by %f", interval);
@@ -504,7 +632,7 @@ cd_main_calib_process_item (CdMainPrivate *priv,
 		}
 		if (item->best_so_far.R < 1.0 - interval) {
 			item->color.R = item->best_so_far.R + interval;
-			if (!cd_main_calib_try_item (priv, item, &new_best, error))
+			if (!cd_main_calib_try_item (session, item, &new_best, error))
 				return FALSE;
 			if (new_best) {
 				g_debug ("New best: red up by %f", interval);
@@ -517,7 +645,7 @@ cd_main_calib_process_item (CdMainPrivate *priv,
 		cd_color_rgb_copy (&item->best_so_far, &item->color);
 		if (item->best_so_far.G > interval) {
 			item->color.G = item->best_so_far.G - interval;
-			if (!cd_main_calib_try_item (priv, item, &new_best, error))
+			if (!cd_main_calib_try_item (session, item, &new_best, error))
 				return FALSE;
 			if (new_best) {
 				g_debug ("New best: green down by %f", interval);
@@ -527,7 +655,7 @@ cd_main_calib_process_item (CdMainPrivate *priv,
 		}
 		if (item->best_so_far.G < 1.0 - interval) {
 			item->color.G = item->best_so_far.G + interval;
-			if (!cd_main_calib_try_item (priv, item, &new_best, error))
+			if (!cd_main_calib_try_item (session, item, &new_best, error))
 				return FALSE;
 			if (new_best) {
 				g_debug ("New best: green up by %f", interval);
@@ -560,7 +688,7 @@ cd_main_calib_process_item (CdMainPrivate *priv,
 }
 
 static gboolean
-cd_main_calib_interpolate_up (CdMainPrivate *priv,
+cd_main_calib_interpolate_up (CdMainSession *session,
 			      guint new_size,
 			      GError **error)
 {
@@ -574,8 +702,8 @@ cd_main_calib_interpolate_up (CdMainPrivate *priv,
 
 	/* make a deep copy */
 	old_array = g_ptr_array_new_with_free_func (g_free);
-	for (i = 0; i < priv->array->len; i++) {
-		p1 = g_ptr_array_index (priv->array, i);
+	for (i = 0; i < session->array->len; i++) {
+		p1 = g_ptr_array_index (session->array, i);
 		result = g_new (CdMainCalibrateItem, 1);
 		result->error = p1->error;
 		cd_color_rgb_copy (&p1->color, &result->color);
@@ -583,7 +711,7 @@ cd_main_calib_interpolate_up (CdMainPrivate *priv,
 	}
 
 	/* interpolate the new array */
-	g_ptr_array_set_size (priv->array, 0);
+	g_ptr_array_set_size (session->array, 0);
 	for (i = 0; i < new_size; i++) {
 		mix = (gdouble) (old_array->len - 1) /
 			(gdouble) (new_size - 1) *
@@ -598,13 +726,13 @@ cd_main_calib_interpolate_up (CdMainPrivate *priv,
 					  &p2->color,
 					  mix - (gint) mix,
 					  &result->color);
-		g_ptr_array_add (priv->array, result);
+		g_ptr_array_add (session->array, result);
 	}
 	return ret;
 }
 
 static gboolean
-cd_main_calib_process (CdMainPrivate *priv,
+cd_main_calib_process (CdMainSession *session,
 		       CdState *state,
 		       GError **error)
 {
@@ -635,60 +763,60 @@ cd_main_calib_process (CdMainPrivate *priv,
 		return FALSE;
 
 	/* clear gamma ramp to linear */
-	priv->array = g_ptr_array_new_with_free_func (g_free);
+	session->array = g_ptr_array_new_with_free_func (g_free);
 	item = g_new0 (CdMainCalibrateItem, 1);
 	item->error = G_MAXDOUBLE;
 	item->index_factor = 0.0f;
 	cd_color_rgb_set (&item->color, 0.0, 0.0, 0.0);
-	g_ptr_array_add (priv->array, item);
+	g_ptr_array_add (session->array, item);
 	item = g_new0 (CdMainCalibrateItem, 1);
 	item->error = G_MAXDOUBLE;
 	item->index_factor = 1.0f;
 	cd_color_rgb_set (&item->color, 1.0, 1.0, 1.0);
-	g_ptr_array_add (priv->array, item);
-	cd_main_emit_update_gamma (priv, priv->array);
+	g_ptr_array_add (session->array, item);
+	cd_main_emit_update_gamma (session, session->array);
 
 	/* get whitepoint */
-	ret = cd_main_calib_get_native_whitepoint (priv, &priv->native_whitepoint, error);
+	ret = cd_main_calib_get_native_whitepoint (session, &session->native_whitepoint, error);
 	if (!ret)
 		return FALSE;
-	if (priv->native_whitepoint < 1000 ||
-	    priv->native_whitepoint > 100000) {
+	if (session->native_whitepoint < 1000 ||
+	    session->native_whitepoint > 100000) {
 		g_set_error_literal (error,
 				     CD_SESSION_ERROR,
 				     CD_SESSION_ERROR_FAILED_TO_GET_WHITEPOINT,
 				     "failed to get native temperature");
 		return FALSE;
 	}
-	g_debug ("native temperature %f", priv->native_whitepoint);
+	g_debug ("native temperature %f", session->native_whitepoint);
 
 	/* get the target whitepoint XYZ for the Lab check */
-	if (priv->target_whitepoint > 0) {
+	if (session->target_whitepoint > 0) {
 		cmsWhitePointFromTemp (&whitepoint_tmp,
-				       (gdouble) priv->target_whitepoint);
+				       (gdouble) session->target_whitepoint);
 	} else {
 		cmsWhitePointFromTemp (&whitepoint_tmp,
-				       priv->native_whitepoint);
+				       session->native_whitepoint);
 	}
-	cmsxyY2XYZ (&priv->whitepoint, &whitepoint_tmp);
+	cmsxyY2XYZ (&session->whitepoint, &whitepoint_tmp);
 
 	/* done */
 	if (!cd_state_done (state, error))
 		return FALSE;
 
 	/* should we seed the first value with a good approximation */
-	if (priv->target_whitepoint > 0) {
+	if (session->target_whitepoint > 0) {
 		CdColorRGB tmp;
-		cd_color_get_blackbody_rgb (6500 - (priv->native_whitepoint - priv->target_whitepoint), &tmp);
+		cd_color_get_blackbody_rgb (6500 - (session->native_whitepoint - session->target_whitepoint), &tmp);
 		g_debug ("Seeding with %f,%f,%f",
 			 tmp.R, tmp.G, tmp.B);
 		cd_color_rgb_copy (&tmp, &item->color);
 	}
 
 	/* process the last item in the array (255,255,255) */
-	item = g_ptr_array_index (priv->array, 1);
+	item = g_ptr_array_index (session->array, 1);
 	state_local = cd_state_get_child (state);
-	if (!cd_main_calib_process_item (priv, item, state_local, error))
+	if (!cd_main_calib_process_item (session, item, state_local, error))
 		return FALSE;
 
 	/* ensure white is normalised to 1 */
@@ -702,32 +830,32 @@ cd_main_calib_process (CdMainPrivate *priv,
 		return FALSE;
 
 	/* expand out the array into more points (interpolating) */
-	if (priv->quality == CD_PROFILE_QUALITY_LOW) {
+	if (session->quality == CD_PROFILE_QUALITY_LOW) {
 		precision_steps = 5;
-	} else if (priv->quality == CD_PROFILE_QUALITY_MEDIUM) {
+	} else if (session->quality == CD_PROFILE_QUALITY_MEDIUM) {
 		precision_steps = 11;
-	} else if (priv->quality == CD_PROFILE_QUALITY_HIGH) {
+	} else if (session->quality == CD_PROFILE_QUALITY_HIGH) {
 		precision_steps = 21;
 	}
-	if (!cd_main_calib_interpolate_up (priv, precision_steps, error))
+	if (!cd_main_calib_interpolate_up (session, precision_steps, error))
 		return FALSE;
 
 	/* refine the other points */
 	state_local = cd_state_get_child (state);
-	cd_state_set_number_steps (state_local, priv->array->len - 1);
-	for (i = priv->array->len - 2; i > 0 ; i--) {
+	cd_state_set_number_steps (state_local, session->array->len - 1);
+	for (i = session->array->len - 2; i > 0 ; i--) {
 
 		/* set new sample patch */
-		rgb.R = 1.0 / (gdouble) (priv->array->len - 1) * (gdouble) i;
-		rgb.G = 1.0 / (gdouble) (priv->array->len - 1) * (gdouble) i;
-		rgb.B = 1.0 / (gdouble) (priv->array->len - 1) * (gdouble) i;
-		if (!cd_main_emit_update_sample (priv, &rgb, error))
+		rgb.R = 1.0 / (gdouble) (session->array->len - 1) * (gdouble) i;
+		rgb.G = 1.0 / (gdouble) (session->array->len - 1) * (gdouble) i;
+		rgb.B = 1.0 / (gdouble) (session->array->len - 1) * (gdouble) i;
+		if (!cd_main_emit_update_sample (session, &rgb, error))
 			return FALSE;
 
 		/* process this section */
-		item = g_ptr_array_index (priv->array, i);
+		item = g_ptr_array_index (session->array, i);
 		state_loop = cd_state_get_child (state_local);
-		if (!cd_main_calib_process_item (priv, item, state_loop, error))
+		if (!cd_main_calib_process_item (session, item, state_loop, error))
 			return FALSE;
 
 		/* done */
@@ -740,10 +868,10 @@ cd_main_calib_process (CdMainPrivate *priv,
 		return FALSE;
 
 	/* set this */
-	cd_main_emit_update_gamma (priv, priv->array);
+	cd_main_emit_update_gamma (session, session->array);
 
 	/* get new whitepoint */
-	if (!cd_main_calib_get_native_whitepoint (priv, &temp, error))
+	if (!cd_main_calib_get_native_whitepoint (session, &temp, error))
 		return FALSE;
 	g_debug ("new native temperature %f", temp);
 
@@ -752,14 +880,14 @@ cd_main_calib_process (CdMainPrivate *priv,
 		return FALSE;
 
 	/* save the results */
-	priv->it8_cal = cd_it8_new_with_kind (CD_IT8_KIND_CAL);
-	cd_it8_set_originator (priv->it8_cal, "colord-session");
-	cd_it8_set_instrument (priv->it8_cal, cd_sensor_kind_to_string (cd_sensor_get_kind (priv->sensor)));
+	session->it8_cal = cd_it8_new_with_kind (CD_IT8_KIND_CAL);
+	cd_it8_set_originator (session->it8_cal, "colord-session");
+	cd_it8_set_instrument (session->it8_cal, cd_sensor_kind_to_string (cd_sensor_get_kind (session->sensor)));
 
 	/* flatten source data (but don't copy) */
 	gamma_data = g_ptr_array_new ();
-	for (i = 0; i < priv->array->len; i++) {
-		item = g_ptr_array_index (priv->array, i);
+	for (i = 0; i < session->array->len; i++) {
+		item = g_ptr_array_index (session->array, i);
 		g_ptr_array_add (gamma_data, &item->color);
 	}
 
@@ -785,7 +913,7 @@ cd_main_calib_process (CdMainPrivate *priv,
 	/* write the new smoothed monotonic data */
 	for (i = 0; i < vcgt_smoothed->len; i++) {
 		rgb_tmp = g_ptr_array_index (vcgt_smoothed, i);
-		cd_it8_add_data (priv->it8_cal, rgb_tmp, NULL);
+		cd_it8_add_data (session->it8_cal, rgb_tmp, NULL);
 	}
 
 	/* done */
@@ -793,21 +921,13 @@ cd_main_calib_process (CdMainPrivate *priv,
 }
 
 static gboolean
-cd_main_finished_quit_cb (gpointer user_data)
-{
-	CdMainPrivate *priv = (CdMainPrivate *) user_data;
-	g_main_loop_quit (priv->loop);
-	return G_SOURCE_REMOVE;
-}
-
-static gboolean
-cd_main_load_samples (CdMainPrivate *priv, GError **error)
+cd_main_load_samples (CdMainSession *session, GError **error)
 {
 	const gchar *filename;
 	g_autofree gchar *path = NULL;
 	g_autoptr(GFile) file = NULL;
 
-	filename = cd_main_get_display_ti1 (priv->quality);
+	filename = cd_main_get_display_ti1 (session->quality);
 	path = g_build_filename (DATADIR,
 				 "colord",
 				 "ti1",
@@ -815,12 +935,12 @@ cd_main_load_samples (CdMainPrivate *priv, GError **error)
 				 NULL);
 	g_debug ("opening source file %s", path);
 	file = g_file_new_for_path (path);
-	priv->it8_ti1 = cd_it8_new ();
-	return cd_it8_load_from_file (priv->it8_ti1, file, error);
+	session->it8_ti1 = cd_it8_new ();
+	return cd_it8_load_from_file (session->it8_ti1, file, error);
 }
 
 static gboolean
-cd_main_write_colprof_files (CdMainPrivate *priv, GError **error)
+cd_main_write_colprof_files (CdMainSession *session, GError **error)
 {
 	gboolean ret = TRUE;
 	g_autofree gchar *data_cal = NULL;
@@ -830,26 +950,26 @@ cd_main_write_colprof_files (CdMainPrivate *priv, GError **error)
 	g_autofree gchar *path_ti3 = NULL;
 
 	/* build temp path */
-	priv->working_path = g_dir_make_tmp ("colord-session-XXXXXX", error);
-	if (priv->working_path == NULL)
+	session->working_path = g_dir_make_tmp ("colord-session-XXXXXX", error);
+	if (session->working_path == NULL)
 		return FALSE;
 
 	/* save .ti3 with ti1 and cal data appended together */
-	ret = cd_it8_save_to_data (priv->it8_ti3,
+	ret = cd_it8_save_to_data (session->it8_ti3,
 				   &data_ti3,
 				   NULL,
 				   error);
 	if (!ret)
 		return FALSE;
-	ret = cd_it8_save_to_data (priv->it8_cal,
+	ret = cd_it8_save_to_data (session->it8_cal,
 				   &data_cal,
 				   NULL,
 				   error);
 	if (!ret)
 		return FALSE;
 	data = g_strdup_printf ("%s\n%s", data_ti3, data_cal);
-	filename_ti3 = g_strdup_printf ("%s.ti3", priv->basename);
-	path_ti3 = g_build_filename (priv->working_path,
+	filename_ti3 = g_strdup_printf ("%s.ti3", session->basename);
+	path_ti3 = g_build_filename (session->working_path,
 				     filename_ti3,
 				     NULL);
 	g_debug ("saving %s", path_ti3);
@@ -902,54 +1022,7 @@ cd_main_find_argyll_tool (const gchar *command,
 }
 
 static gboolean
-cd_main_import_profile (CdMainPrivate *priv, GError **error)
-{
-	gboolean ret = TRUE;
-	g_autofree gchar *filename = NULL;
-	g_autofree gchar *path = NULL;
-	g_autoptr(GFile) file = NULL;
-
-	filename = g_strdup_printf ("%s.icc", priv->basename);
-	path = g_build_filename (priv->working_path,
-				 filename,
-				 NULL);
-	g_debug ("trying to import %s", path);
-	file = g_file_new_for_path (path);
-	priv->profile = cd_client_import_profile_sync (priv->client,
-						       file,
-						       priv->cancellable,
-						       error);
-	if (priv->profile == NULL)
-		return FALSE;
-	g_debug ("imported %s", cd_profile_get_object_path (priv->profile));
-
-	/* add profile to device and set default */
-	ret = cd_profile_connect_sync (priv->profile,
-				       priv->cancellable,
-				       error);
-	if (!ret)
-		return FALSE;
-	ret = cd_device_add_profile_sync (priv->device,
-					  CD_DEVICE_RELATION_HARD,
-					  priv->profile,
-					  priv->cancellable,
-					  error);
-	if (!ret)
-		return FALSE;
-	ret = cd_device_make_profile_default_sync (priv->device,
-						   priv->profile,
-						   priv->cancellable,
-						   error);
-	if (!ret)
-		return FALSE;
-	g_debug ("set %s default on %s",
-		 cd_profile_get_id (priv->profile),
-		 cd_device_get_id (priv->device));
-	return TRUE;
-}
-
-static gboolean
-cd_main_set_profile_metadata (CdMainPrivate *priv, GError **error)
+cd_main_set_profile_metadata (CdMainSession *session, GError **error)
 {
 	gboolean ret;
 	g_autoptr(GError) error_local = NULL;
@@ -959,8 +1032,8 @@ cd_main_set_profile_metadata (CdMainPrivate *priv, GError **error)
 	g_autoptr(GFile) file = NULL;
 
 	/* get profile */
-	profile_fn = g_strdup_printf ("%s.icc", priv->basename);
-	profile_path = g_build_filename (priv->working_path,
+	profile_fn = g_strdup_printf ("%s.icc", session->basename);
+	profile_path = g_build_filename (session->working_path,
 					 profile_fn,
 					 NULL);
 
@@ -970,7 +1043,7 @@ cd_main_set_profile_metadata (CdMainPrivate *priv, GError **error)
 	ret = cd_icc_load_file (icc,
 				file,
 				CD_ICC_LOAD_FLAGS_NONE,
-				priv->cancellable,
+				session->cancellable,
 				error);
 	if (!ret)
 		return FALSE;
@@ -993,16 +1066,16 @@ cd_main_set_profile_metadata (CdMainPrivate *priv, GError **error)
 			     "CC0");
 	cd_icc_add_metadata (icc,
 			     CD_PROFILE_METADATA_QUALITY,
-			     cd_profile_quality_to_string (priv->quality));
+			     cd_profile_quality_to_string (session->quality));
 	cd_icc_add_metadata (icc,
 			     CD_PROFILE_METADATA_MAPPING_DEVICE_ID,
-			     cd_device_get_id (priv->device));
+			     session->device_id);
 	cd_icc_add_metadata (icc,
 			     CD_PROFILE_METADATA_MEASUREMENT_DEVICE,
-			     cd_sensor_kind_to_string (cd_sensor_get_kind (priv->sensor)));
-	if (priv->screen_brightness > 0) {
+			     cd_sensor_kind_to_string (cd_sensor_get_kind (session->sensor)));
+	if (session->screen_brightness > 0) {
 		g_autofree gchar *brightness_str = NULL;
-		brightness_str = g_strdup_printf ("%u", priv->screen_brightness);
+		brightness_str = g_strdup_printf ("%u", session->screen_brightness);
 		cd_icc_add_metadata (icc,
 				     CD_PROFILE_METADATA_SCREEN_BRIGHTNESS,
 				     brightness_str);
@@ -1012,7 +1085,7 @@ cd_main_set_profile_metadata (CdMainPrivate *priv, GError **error)
 	ret = cd_icc_save_file (icc,
 				file,
 				CD_ICC_SAVE_FLAGS_NONE,
-				priv->cancellable,
+				session->cancellable,
 				&error_local);
 	if (!ret) {
 		g_set_error (error,
@@ -1026,7 +1099,7 @@ cd_main_set_profile_metadata (CdMainPrivate *priv, GError **error)
 }
 
 static gboolean
-cd_main_generate_profile (CdMainPrivate *priv, GError **error)
+cd_main_generate_profile (CdMainSession *session, GError **error)
 {
 	gboolean ret;
 	gint exit_status = 0;
@@ -1046,19 +1119,19 @@ cd_main_generate_profile (CdMainPrivate *priv, GError **error)
 	/* setup the command */
 	g_ptr_array_add (array, g_strdup (command));
 	g_ptr_array_add (array, g_strdup ("-v"));
-//	g_ptr_array_add (array, g_strdup_printf ("-A%s", cd_device_get_vendor (priv->device)));
-	g_ptr_array_add (array, g_strdup_printf ("-M%s", cd_device_get_model (priv->device)));
-	g_ptr_array_add (array, g_strdup_printf ("-D%s", priv->title));
+//	g_ptr_array_add (array, g_strdup_printf ("-A%s", cd_device_get_vendor (session->device)));
+	g_ptr_array_add (array, g_strdup_printf ("-M%s", session->device_model));
+	g_ptr_array_add (array, g_strdup_printf ("-D%s", session->title));
 	g_ptr_array_add (array, g_strdup_printf ("-C%s", CD_PROFILE_DEFAULT_COPYRIGHT_STRING));
-	g_ptr_array_add (array, g_strdup (cd_main_get_colprof_quality_arg (priv->quality)));
+	g_ptr_array_add (array, g_strdup (cd_main_get_colprof_quality_arg (session->quality)));
 	g_ptr_array_add (array, g_strdup ("-aG"));
-	g_ptr_array_add (array, g_strdup (priv->basename));
+	g_ptr_array_add (array, g_strdup (session->basename));
 	g_ptr_array_add (array, NULL);
 
 	/* run the command */
 	cmd_debug = g_strjoinv (" ", (gchar **) array->pdata);
 	g_debug ("running '%s'", cmd_debug);
-	ret = g_spawn_sync (priv->working_path,
+	ret = g_spawn_sync (session->working_path,
 			    (gchar **) array->pdata,
 			    NULL,
 			    0,
@@ -1080,7 +1153,7 @@ cd_main_generate_profile (CdMainPrivate *priv, GError **error)
 }
 
 static gboolean
-cd_main_display_get_samples (CdMainPrivate *priv,
+cd_main_display_get_samples (CdMainSession *session,
 			     CdState *state,
 			     GError **error)
 {
@@ -1089,18 +1162,18 @@ cd_main_display_get_samples (CdMainPrivate *priv,
 	guint i;
 	guint size;
 
-	size = cd_it8_get_data_size (priv->it8_ti1);
+	size = cd_it8_get_data_size (session->it8_ti1);
 	cd_state_set_number_steps (state, size);
 	for (i = 0; i < size; i++) {
-		cd_it8_get_data_item (priv->it8_ti1,
+		cd_it8_get_data_item (session->it8_ti1,
 				      i,
 				      &rgb,
 				      NULL);
-		if (!cd_main_emit_update_sample (priv, &rgb, error))
+		if (!cd_main_emit_update_sample (session, &rgb, error))
 			return FALSE;
-		if (!cd_main_calib_get_sample (priv, &xyz, error))
+		if (!cd_main_calib_get_sample (session, &xyz, error))
 			return FALSE;
-		cd_it8_add_data (priv->it8_ti3, &rgb, &xyz);
+		cd_it8_add_data (session->it8_ti3, &rgb, &xyz);
 
 		/* done */
 		if (!cd_state_done (state, error))
@@ -1110,7 +1183,7 @@ cd_main_display_get_samples (CdMainPrivate *priv,
 }
 
 static gboolean
-cd_main_display_characterize (CdMainPrivate *priv,
+cd_main_display_characterize (CdMainSession *session,
 			      CdState *state,
 			      GError **error)
 {
@@ -1122,15 +1195,14 @@ cd_main_display_characterize (CdMainPrivate *priv,
 				  error,
 				  1,	/* load samples */
 				  96,	/* measure samples */
-				  1,	/* run colprof */
+				  2,	/* run colprof */
 				  1,	/* set metadata */
-				  1,	/* import profile */
 				  -1);
 	if (!ret)
 		return FALSE;
 
 	/* load the ti1 file */
-	if (!cd_main_load_samples (priv, error))
+	if (!cd_main_load_samples (session, error))
 		return FALSE;
 
 	/* done */
@@ -1138,16 +1210,16 @@ cd_main_display_characterize (CdMainPrivate *priv,
 		return FALSE;
 
 	/* create the ti3 file */
-	priv->it8_ti3 = cd_it8_new_with_kind (CD_IT8_KIND_TI3);
-	cd_it8_set_normalized (priv->it8_ti3, TRUE);
-	cd_it8_set_originator (priv->it8_ti3, "colord-session");
-	cd_it8_set_title (priv->it8_ti3, priv->title);
-	cd_it8_set_spectral (priv->it8_ti3, FALSE);
-	cd_it8_set_instrument (priv->it8_ti3, cd_sensor_get_model (priv->sensor));
+	session->it8_ti3 = cd_it8_new_with_kind (CD_IT8_KIND_TI3);
+	cd_it8_set_normalized (session->it8_ti3, TRUE);
+	cd_it8_set_originator (session->it8_ti3, "colord-session");
+	cd_it8_set_title (session->it8_ti3, session->title);
+	cd_it8_set_spectral (session->it8_ti3, FALSE);
+	cd_it8_set_instrument (session->it8_ti3, cd_sensor_get_model (session->sensor));
 
 	/* measure each sample */
 	state_local = cd_state_get_child (state);
-	ret = cd_main_display_get_samples (priv, state_local, error);
+	ret = cd_main_display_get_samples (session, state_local, error);
 	if (!ret)
 		return FALSE;
 
@@ -1156,12 +1228,12 @@ cd_main_display_characterize (CdMainPrivate *priv,
 		return FALSE;
 
 	/* write out files */
-	ret = cd_main_write_colprof_files (priv, error);
+	ret = cd_main_write_colprof_files (session, error);
 	if (!ret)
 		return FALSE;
 
 	/* run colprof */
-	ret = cd_main_generate_profile (priv, error);
+	ret = cd_main_generate_profile (session, error);
 	if (!ret)
 		return FALSE;
 
@@ -1169,17 +1241,8 @@ cd_main_display_characterize (CdMainPrivate *priv,
 	if (!cd_state_done (state, error))
 		return FALSE;
 
-	/* set metadata on the profile */
-	ret = cd_main_set_profile_metadata (priv, error);
-	if (!ret)
-		return FALSE;
-
-	/* done */
-	if (!cd_state_done (state, error))
-		return FALSE;
-
-	/* import profile */
-	ret = cd_main_import_profile (priv, error);
+	/* set metadata on the profile, which is imported by the main thread */
+	ret = cd_main_set_profile_metadata (session, error);
 	if (!ret)
 		return FALSE;
 
@@ -1200,7 +1263,7 @@ cd_main_remove_temp_file (const gchar *filename,
 }
 
 static gboolean
-cd_main_remove_temp_files (CdMainPrivate *priv, GError **error)
+cd_main_remove_temp_files (CdMainSession *session, GError **error)
 {
 	const gchar *filename;
 	gboolean ret;
@@ -1208,17 +1271,17 @@ cd_main_remove_temp_files (CdMainPrivate *priv, GError **error)
 	g_autoptr(GDir) dir = NULL;
 
 	/* try to open */
-	dir = g_dir_open (priv->working_path, 0, error);
+	dir = g_dir_open (session->working_path, 0, error);
 	if (dir == NULL)
 		return FALSE;
 
 	/* find each */
 	while ((filename = g_dir_read_name (dir))) {
-		src = g_build_filename (priv->working_path,
+		src = g_build_filename (session->working_path,
 					filename,
 					NULL);
 		ret = cd_main_remove_temp_file (src,
-						priv->cancellable,
+						session->cancellable,
 						error);
 		g_free (src);
 		if (!ret)
@@ -1226,14 +1289,15 @@ cd_main_remove_temp_files (CdMainPrivate *priv, GError **error)
 	}
 
 	/* remove directory */
-	return cd_main_remove_temp_file (priv->working_path,
-					 priv->cancellable,
+	return cd_main_remove_temp_file (session->working_path,
+					 session->cancellable,
 					 error);
 }
 
 static gboolean
-cd_main_start_calibration (CdMainPrivate *priv,
+cd_main_start_calibration (CdMainSession *session,
 			   CdState *state,
+			   gboolean *waiting,
 			   GError **error)
 {
 	CdState *state_local;
@@ -1244,28 +1308,27 @@ cd_main_start_calibration (CdMainPrivate *priv,
 	ret = cd_state_set_steps (state,
 				  error,
 				  74,	/* calibration */
-				  25,	/* characterization */
-				  1,	/* remove temp files */
+				  26,	/* characterization */
 				  -1);
 	if (!ret)
 		return FALSE;
 
 	/* do the calibration */
 	state_local = cd_state_get_child (state);
-	ret = cd_main_calib_process (priv, state_local, &error_local);
+	ret = cd_main_calib_process (session, state_local, &error_local);
 	if (!ret) {
 		if (g_error_matches (error_local,
 				     CD_SENSOR_ERROR,
 				     CD_SENSOR_ERROR_REQUIRED_POSITION_CALIBRATE)) {
-			priv->status = CD_SESSION_STATUS_WAITING_FOR_INTERACTION;
-			cd_main_emit_interaction_required (priv,
+			*waiting = TRUE;
+			cd_main_emit_interaction_required (session,
 							   CD_SESSION_INTERACTION_MOVE_TO_CALIBRATION);
 			return TRUE;
 		} else if (g_error_matches (error_local,
 					    CD_SENSOR_ERROR,
 					    CD_SENSOR_ERROR_REQUIRED_POSITION_SURFACE)) {
-			priv->status = CD_SESSION_STATUS_WAITING_FOR_INTERACTION;
-			cd_main_emit_interaction_required (priv,
+			*waiting = TRUE;
+			cd_main_emit_interaction_required (session,
 							   CD_SESSION_INTERACTION_MOVE_TO_SURFACE);
 			return TRUE;
 		}
@@ -1279,16 +1342,7 @@ cd_main_start_calibration (CdMainPrivate *priv,
 
 	/* do the characterization */
 	state_local = cd_state_get_child (state);
-	ret = cd_main_display_characterize (priv, state_local, error);
-	if (!ret)
-		return FALSE;
-
-	/* done */
-	if (!cd_state_done (state, error))
-		return FALSE;
-
-	/* remove temp files */
-	ret = cd_main_remove_temp_files (priv, error);
+	ret = cd_main_display_characterize (session, state_local, error);
 	if (!ret)
 		return FALSE;
 
@@ -1297,36 +1351,272 @@ cd_main_start_calibration (CdMainPrivate *priv,
 }
 
 static gboolean
-cd_main_start_calibration_cb (gpointer user_data)
+cd_main_quit_loop_cb (gpointer user_data)
 {
 	CdMainPrivate *priv = (CdMainPrivate *) user_data;
+	priv->quit_id = 0;
+	g_main_loop_quit (priv->loop);
+	return G_SOURCE_REMOVE;
+}
+
+/* the helper exits once every session has finished */
+static void
+cd_main_check_quit (CdMainPrivate *priv, guint delay)
+{
+	guint i;
+
+	for (i = 0; i < priv->sessions->len; i++) {
+		CdMainSession *session = g_ptr_array_index (priv->sessions, i);
+		if (session->active ||
+		    session->status == CD_SESSION_STATUS_RUNNING)
+			return;
+	}
+	if (priv->quit_id == 0)
+		priv->quit_id = g_timeout_add (delay, cd_main_quit_loop_cb, priv);
+}
+
+static gboolean
+cd_main_session_remove_cb (gpointer user_data)
+{
+	CdMainSession *session = (CdMainSession *) user_data;
+	CdMainPrivate *priv = session->priv;
 	g_autoptr(GError) error = NULL;
 
-	/* reset the state */
-	cd_state_reset (priv->state);
-	if (!cd_main_start_calibration (priv, priv->state, &error)) {
-		/* use the error code if it's our error domain */
-		if (error->domain == CD_SESSION_ERROR) {
-			cd_main_emit_finished (priv,
-					       error->code,
-					       error->message);
-		} else {
-			cd_main_emit_finished (priv,
-					       CD_SESSION_ERROR_INTERNAL,
-					       error->message);
+	/* let other sessions use the sensor; the worker has finished so
+	 * the context of the session is free to be iterated here */
+	session->remove_id = 0;
+	if (session->sensor != NULL && cd_sensor_get_locked (session->sensor)) {
+		g_main_context_push_thread_default (session->context);
+		if (!cd_sensor_unlock_sync (session->sensor, NULL, &error)) {
+			g_warning ("failed to unlock %s: %s",
+				   cd_sensor_get_object_path (session->sensor),
+				   error->message);
+			g_clear_error (&error);
 		}
-		g_timeout_add (200, cd_main_finished_quit_cb, priv);
-		return FALSE;
+		g_main_context_pop_thread_default (session->context);
+	}
+	if (session->device != NULL) {
+		if (!cd_device_profiling_uninhibit_sync (session->device, NULL, &error)) {
+			g_warning ("failed to uninhibit %s: %s",
+				   session->device_id, error->message);
+		}
+	}
+
+	/* this unregisters the object */
+	g_debug ("CdMain: removing %s", session->object_path);
+	g_ptr_array_remove (priv->sessions, session);
+	return G_SOURCE_REMOVE;
+}
+
+static void
+cd_main_session_deactivate (CdMainSession *session, guint delay)
+{
+	session->active = FALSE;
+	if (session->watcher_id > 0) {
+		g_bus_unwatch_name (session->watcher_id);
+		session->watcher_id = 0;
+	}
+
+	/* the worker has to finish before the session can be idle */
+	if (session->status != CD_SESSION_STATUS_RUNNING) {
+		session->status = CD_SESSION_STATUS_IDLE;
+
+		/* the root object lives as long as the helper */
+		if (g_strcmp0 (session->object_path, CD_SESSION_DBUS_PATH) != 0 &&
+		    session->remove_id == 0)
+			session->remove_id = g_idle_add (cd_main_session_remove_cb, session);
+	}
+	cd_main_check_quit (session->priv, delay);
+}
+
+static void
+cd_main_session_finished (CdMainSession *session, const GError *error)
+{
+	session->status = CD_SESSION_STATUS_IDLE;
+	if (error == NULL) {
+		cd_main_emit_finished (session, CD_SESSION_ERROR_NONE, NULL);
+	} else if (error->domain == CD_SESSION_ERROR) {
+		/* use the error code if it's our error domain */
+		cd_main_emit_finished (session, error->code, error->message);
+	} else {
+		cd_main_emit_finished (session,
+				       CD_SESSION_ERROR_INTERNAL,
+				       error->message);
+	}
+	cd_main_session_deactivate (session, 200);
+}
+
+static void
+cd_main_make_profile_default_cb (GObject *source,
+				 GAsyncResult *res,
+				 gpointer user_data)
+{
+	CdMainSession *session = (CdMainSession *) user_data;
+	g_autoptr(GError) error = NULL;
+
+	if (!cd_device_make_profile_default_finish (CD_DEVICE (source), res, &error)) {
+		cd_main_session_finished (session, error);
+		return;
+	}
+	g_debug ("set %s default on %s",
+		 cd_profile_get_id (session->profile),
+		 session->device_id);
+
+	/* remove temp files */
+	if (!cd_main_remove_temp_files (session, &error)) {
+		cd_main_session_finished (session, error);
+		return;
+	}
+	cd_main_session_finished (session, NULL);
+}
+
+static void
+cd_main_add_profile_cb (GObject *source,
+			GAsyncResult *res,
+			gpointer user_data)
+{
+	CdMainSession *session = (CdMainSession *) user_data;
+	g_autoptr(GError) error = NULL;
+
+	if (!cd_device_add_profile_finish (CD_DEVICE (source), res, &error)) {
+		cd_main_session_finished (session, error);
+		return;
+	}
+	cd_device_make_profile_default (session->device,
+					session->profile,
+					session->cancellable,
+					cd_main_make_profile_default_cb,
+					session);
+}
+
+static void
+cd_main_profile_connect_cb (GObject *source,
+			    GAsyncResult *res,
+			    gpointer user_data)
+{
+	CdMainSession *session = (CdMainSession *) user_data;
+	g_autoptr(GError) error = NULL;
+
+	if (!cd_profile_connect_finish (CD_PROFILE (source), res, &error)) {
+		cd_main_session_finished (session, error);
+		return;
+	}
+
+	/* add profile to device and set default */
+	cd_device_add_profile (session->device,
+			       CD_DEVICE_RELATION_HARD,
+			       session->profile,
+			       session->cancellable,
+			       cd_main_add_profile_cb,
+			       session);
+}
+
+static void
+cd_main_import_profile_cb (GObject *source,
+			   GAsyncResult *res,
+			   gpointer user_data)
+{
+	CdMainSession *session = (CdMainSession *) user_data;
+	g_autoptr(GError) error = NULL;
+
+	session->profile = cd_client_import_profile_finish (CD_CLIENT (source),
+							    res, &error);
+	if (session->profile == NULL) {
+		cd_main_session_finished (session, error);
+		return;
+	}
+	g_debug ("imported %s", cd_profile_get_object_path (session->profile));
+	cd_profile_connect (session->profile,
+			    session->cancellable,
+			    cd_main_profile_connect_cb,
+			    session);
+}
+
+/* the profile is imported from the main thread, using the proxies that
+ * are shared with the rest of the helper */
+static void
+cd_main_import_profile (CdMainSession *session)
+{
+	g_autofree gchar *filename = NULL;
+	g_autofree gchar *path = NULL;
+	g_autoptr(GFile) file = NULL;
+
+	filename = g_strdup_printf ("%s.icc", session->basename);
+	path = g_build_filename (session->working_path,
+				 filename,
+				 NULL);
+	g_debug ("trying to import %s", path);
+	file = g_file_new_for_path (path);
+	cd_client_import_profile (session->priv->client,
+				  file,
+				  session->cancellable,
+				  cd_main_import_profile_cb,
+				  session);
+}
+
+static gpointer
+cd_main_start_calibration_thread_cb (gpointer user_data)
+{
+	g_autoptr(GTask) task = G_TASK (user_data);
+	CdMainSession *session = g_task_get_task_data (task);
+	gboolean ret;
+	gboolean waiting = FALSE;
+	g_autoptr(GError) error = NULL;
+
+	/* the sync calls on the sensor iterate the context of the session */
+	g_main_context_push_thread_default (session->context);
+	cd_state_reset (session->state);
+	ret = cd_main_start_calibration (session, session->state, &waiting, &error);
+	g_main_context_pop_thread_default (session->context);
+	if (!ret) {
+		g_task_return_error (task, g_steal_pointer (&error));
+		return NULL;
+	}
+	g_task_return_int (task, waiting ?
+			   CD_SESSION_STATUS_WAITING_FOR_INTERACTION :
+			   CD_SESSION_STATUS_IDLE);
+	return NULL;
+}
+
+static void
+cd_main_start_calibration_done_cb (GObject *source,
+				   GAsyncResult *res,
+				   gpointer user_data)
+{
+	CdMainSession *session = (CdMainSession *) user_data;
+	gssize status;
+	g_autoptr(GError) error = NULL;
+
+	status = g_task_propagate_int (G_TASK (res), &error);
+	if (status < 0) {
+		cd_main_session_finished (session, error);
+		return;
 	}
 
 	/* still waiting */
-	if (priv->status == CD_SESSION_STATUS_WAITING_FOR_INTERACTION)
-		return FALSE;
+	if (status == CD_SESSION_STATUS_WAITING_FOR_INTERACTION) {
+		session->status = CD_SESSION_STATUS_WAITING_FOR_INTERACTION;
+		return;
+	}
 
-	/* success */
-	cd_main_emit_finished (priv, CD_SESSION_ERROR_NONE, NULL);
-	g_timeout_add (200, cd_main_finished_quit_cb, priv);
-	return FALSE;
+	/* the session stays running until the profile is the default */
+	cd_main_import_profile (session);
+}
+
+static void
+cd_main_session_run (CdMainSession *session)
+{
+	GTask *task;
+
+	/* each session gets its own thread rather than sharing a pool, as
+	 * the worker spends nearly all of its time blocked on the sensor */
+	session->status = CD_SESSION_STATUS_RUNNING;
+	task = g_task_new (NULL, session->cancellable,
+			   cd_main_start_calibration_done_cb, session);
+	g_task_set_task_data (task, session, NULL);
+	g_thread_unref (g_thread_new ("colord-session",
+				      cd_main_start_calibration_thread_cb,
+				      task));
 }
 
 static const gchar *
@@ -1346,16 +1636,17 @@ cd_main_sender_vanished_cb (GDBusConnection *connection,
 			    const gchar *name,
 			    gpointer user_data)
 {
-	CdMainPrivate *priv = (CdMainPrivate *) user_data;
+	CdMainSession *session = (CdMainSession *) user_data;
 
 	/* FIXME: make configurable? */
-	g_debug ("Quitting daemon as sender has quit");
-	g_cancellable_cancel (priv->cancellable);
-	g_main_loop_quit (priv->loop);
+	g_debug ("CdMain: cancelling %s as sender has quit",
+		 session->object_path);
+	g_cancellable_cancel (session->cancellable);
+	cd_main_session_deactivate (session, 0);
 }
 
 static CdDevice *
-cd_main_find_device (CdMainPrivate *priv,
+cd_main_find_device (CdMainSession *session,
 		     const gchar *device_id,
 		     GError **error)
 {
@@ -1363,7 +1654,7 @@ cd_main_find_device (CdMainPrivate *priv,
 	g_autoptr(GError) error_local = NULL;
 	g_autoptr(CdDevice) device_tmp = NULL;
 
-	device_tmp = cd_client_find_device_sync (priv->client,
+	device_tmp = cd_client_find_device_sync (session->priv->client,
 						 device_id,
 						 NULL,
 						 &error_local);
@@ -1397,45 +1688,49 @@ cd_main_find_device (CdMainPrivate *priv,
 		return NULL;
 	}
 
+	/* the worker cannot use the proxy */
+	session->device_id = g_strdup (cd_device_get_id (device_tmp));
+	session->device_model = g_strdup (cd_device_get_model (device_tmp));
+
 	/* success */
 	return g_object_ref (device_tmp);
 }
 
 static CdSensor *
-cd_main_find_sensor (CdMainPrivate *priv,
+cd_main_find_sensor (CdMainSession *session,
 		     const gchar *sensor_id,
 		     GError **error)
 {
 	gboolean ret;
 	g_autoptr(GError) error_local = NULL;
+	g_autoptr(CdSensor) sensor_found = NULL;
 	g_autoptr(CdSensor) sensor_tmp = NULL;
 
-	sensor_tmp = cd_client_find_sensor_sync (priv->client,
-						 sensor_id,
-						 NULL,
-						 &error_local);
-	if (sensor_tmp == NULL) {
+	sensor_found = cd_client_find_sensor_sync (session->priv->client,
+						   sensor_id,
+						   NULL,
+						   &error_local);
+	if (sensor_found == NULL) {
 		g_set_error (error,
 			     CD_SESSION_ERROR,
 			     CD_SESSION_ERROR_FAILED_TO_FIND_SENSOR,
 			     "%s", error_local->message);
 		return NULL;
 	}
+
+	/* the worker uses its own proxy, created in the session context */
+	g_main_context_push_thread_default (session->context);
+	sensor_tmp = cd_sensor_new_with_object_path (cd_sensor_get_object_path (sensor_found));
 	ret = cd_sensor_connect_sync (sensor_tmp,
 				      NULL,
 				      &error_local);
-	if (!ret) {
-		g_set_error (error,
-			     CD_SESSION_ERROR,
-			     CD_SESSION_ERROR_FAILED_TO_FIND_SENSOR,
-			     "%s", error_local->message);
-		return NULL;
+	if (ret) {
+		/* lock the sensor */
+		ret = cd_sensor_lock_sync (sensor_tmp,
+					   NULL,
+					   &error_local);
 	}
-
-	/* lock the sensor */
-	ret = cd_sensor_lock_sync (sensor_tmp,
-				   NULL,
-				   &error_local);
+	g_main_context_pop_thread_default (session->context);
 	if (!ret) {
 		g_set_error (error,
 			     CD_SESSION_ERROR,
@@ -1449,7 +1744,7 @@ cd_main_find_sensor (CdMainPrivate *priv,
 }
 
 static void
-cd_main_set_basename (CdMainPrivate *priv)
+cd_main_set_basename (CdMainSession *session)
 {
 	const gchar *tmp;
 	GDateTime *datetime;
@@ -1459,12 +1754,12 @@ cd_main_set_basename (CdMainPrivate *priv)
 	str = g_string_new ("");
 
 	/* add vendor */
-	tmp = cd_device_get_vendor (priv->device);
+	tmp = cd_device_get_vendor (session->device);
 	if (tmp != NULL)
 		g_string_append_printf (str, "%s ", tmp);
 
 	/* add model */
-	tmp = cd_device_get_model (priv->device);
+	tmp = cd_device_get_model (session->device);
 	if (tmp != NULL)
 		g_string_append_printf (str, "%s ", tmp);
 
@@ -1474,7 +1769,7 @@ cd_main_set_basename (CdMainPrivate *priv)
 
 	/* add the quality */
 	g_string_append_printf (str, "(%s) ",
-				cd_profile_quality_to_string (priv->quality));
+				cd_profile_quality_to_string (session->quality));
 
 	/* add date and time */
 	datetime = g_date_time_new_now_utc ();
@@ -1483,7 +1778,7 @@ cd_main_set_basename (CdMainPrivate *priv)
 	g_date_time_unref (datetime);
 
 	/* add the sensor */
-	tmp = cd_sensor_kind_to_string (cd_sensor_get_kind (priv->sensor));
+	tmp = cd_sensor_kind_to_string (cd_sensor_get_kind (session->sensor));
 	if (tmp != NULL)
 		g_string_append_printf (str, "%s ", tmp);
 
@@ -1492,28 +1787,20 @@ cd_main_set_basename (CdMainPrivate *priv)
 
 	/* make suitable filename */
 	g_strdelimit (str->str, "/\"*?", '_');
-	priv->basename = g_string_free (str, FALSE);
-}
-
-static gboolean
-cd_main_quit_loop_cb (gpointer user_data)
-{
-	CdMainPrivate *priv = (CdMainPrivate *) user_data;
-	g_main_loop_quit (priv->loop);
-	return G_SOURCE_REMOVE;
+	session->basename = g_string_free (str, FALSE);
 }
 
 static void
-cd_main_daemon_method_call (GDBusConnection *connection,
-			    const gchar *sender,
-			    const gchar *object_path,
-			    const gchar *interface_name,
-			    const gchar *method_name,
-			    GVariant *parameters,
-			    GDBusMethodInvocation *invocation,
-			    gpointer user_data)
+cd_main_session_method_call (GDBusConnection *connection,
+			     const gchar *sender,
+			     const gchar *object_path,
+			     const gchar *interface_name,
+			     const gchar *method_name,
+			     GVariant *parameters,
+			     GDBusMethodInvocation *invocation,
+			     gpointer user_data)
 {
-	CdMainPrivate *priv = (CdMainPrivate *) user_data;
+	CdMainSession *session = (CdMainSession *) user_data;
 	const gchar *device_id;
 	const gchar *prop_key;
 	const gchar *sensor_id;
@@ -1522,7 +1809,7 @@ cd_main_daemon_method_call (GDBusConnection *connection,
 	g_autoptr(GError) error = NULL;
 
 	/* should be impossible */
-	if (g_strcmp0 (interface_name, "org.freedesktop.ColorHelper.Display") != 0) {
+	if (g_strcmp0 (interface_name, CD_SESSION_DBUS_INTERFACE_DISPLAY) != 0) {
 		g_dbus_method_invocation_return_error (invocation,
 						       CD_SESSION_ERROR,
 						       CD_SESSION_ERROR_INTERNAL,
@@ -1542,32 +1829,32 @@ cd_main_daemon_method_call (GDBusConnection *connection,
 			 sensor_id);
 
 		/* set the default parameters */
-		priv->quality = CD_PROFILE_QUALITY_MEDIUM;
-		priv->device_kind = CD_SENSOR_CAP_LCD;
-		priv->target_gamma = 2.2;
+		session->quality = CD_PROFILE_QUALITY_MEDIUM;
+		session->device_kind = CD_SENSOR_CAP_LCD;
+		session->target_gamma = 2.2;
 		while (g_variant_iter_next (iter, "{&sv}",
 					    &prop_key, &prop_value)) {
 			if (g_strcmp0 (prop_key, "Quality") == 0) {
-				priv->quality = g_variant_get_uint32 (prop_value);
+				session->quality = g_variant_get_uint32 (prop_value);
 				g_debug ("Quality: %s",
-					 cd_profile_quality_to_string (priv->quality));
+					 cd_profile_quality_to_string (session->quality));
 			} else if (g_strcmp0 (prop_key, "Whitepoint") == 0) {
-				priv->target_whitepoint = g_variant_get_uint32 (prop_value);
+				session->target_whitepoint = g_variant_get_uint32 (prop_value);
 				g_debug ("Whitepoint: %uK",
-					 priv->target_whitepoint);
+					 session->target_whitepoint);
 			} else if (g_strcmp0 (prop_key, "Title") == 0) {
-				priv->title = g_variant_dup_string (prop_value, NULL);
-				g_debug ("Title: %s", priv->title);
+				session->title = g_variant_dup_string (prop_value, NULL);
+				g_debug ("Title: %s", session->title);
 			} else if (g_strcmp0 (prop_key, "DeviceKind") == 0) {
-				priv->device_kind = g_variant_get_uint32 (prop_value);
+				session->device_kind = g_variant_get_uint32 (prop_value);
 				g_debug ("Device kind: %s",
-					 cd_sensor_cap_to_string (priv->device_kind));
+					 cd_sensor_cap_to_string (session->device_kind));
 			} else if (g_strcmp0 (prop_key, "Brightness") == 0) {
-				priv->screen_brightness = g_variant_get_uint32 (prop_value);
-				g_debug ("Device brightness: %u", priv->screen_brightness);
+				session->screen_brightness = g_variant_get_uint32 (prop_value);
+				g_debug ("Device brightness: %u", session->screen_brightness);
 			} else if (g_strcmp0 (prop_key, "Gamma") == 0) {
-				priv->target_gamma = g_variant_get_double (prop_value);
-				g_debug ("Gamma: %.2f", priv->target_gamma);
+				session->target_gamma = g_variant_get_double (prop_value);
+				g_debug ("Gamma: %.2f", session->target_gamma);
 			} else {
 				/* not a fatal warning */
 				g_warning ("option %s unsupported", prop_key);
@@ -1575,128 +1862,137 @@ cd_main_daemon_method_call (GDBusConnection *connection,
 		}
 
 		/* set a decent default */
-		if (priv->title == NULL)
-			priv->title = g_strdup ("Profile");
+		if (session->title == NULL)
+			session->title = g_strdup ("Profile");
 
-		if (priv->status != CD_SESSION_STATUS_IDLE) {
+		if (session->device != NULL) {
+			g_dbus_method_invocation_return_error (invocation,
+							       CD_SESSION_ERROR,
+							       CD_SESSION_ERROR_INTERNAL,
+							       "cannot start %s more than once",
+							       session->object_path);
+			return;
+		}
+		if (session->status != CD_SESSION_STATUS_IDLE) {
 			g_dbus_method_invocation_return_error (invocation,
 							       CD_SESSION_ERROR,
 							       CD_SESSION_ERROR_INTERNAL,
 							       "cannot start as status is %s",
-							       cd_main_status_to_text (priv->status));
+							       cd_main_status_to_text (session->status));
 			return;
 		}
 
 		/* check the quality argument */
-		if (priv->quality > 2) {
+		if (session->quality > 2) {
 			g_dbus_method_invocation_return_error (invocation,
 							       CD_SESSION_ERROR,
 							       CD_SESSION_ERROR_INVALID_VALUE,
 							       "invalid quality value %u",
-							       priv->quality);
+							       session->quality);
 			return;
 		}
 
 		/* check the gamma */
-		if (priv->target_gamma < 1.0 || priv->target_gamma > 4.0) {
+		if (session->target_gamma < 1.0 || session->target_gamma > 4.0) {
 			g_dbus_method_invocation_return_error (invocation,
 							       CD_SESSION_ERROR,
 							       CD_SESSION_ERROR_INVALID_VALUE,
 							       "invalid target gamma value %f",
-							       priv->target_gamma);
+							       session->target_gamma);
 			return;
 		}
 
 		/* check the whitepoint */
-		if (priv->target_whitepoint != 0 &&
-		    (priv->target_whitepoint < 1000 ||
-		     priv->target_whitepoint > 100000)) {
+		if (session->target_whitepoint != 0 &&
+		    (session->target_whitepoint < 1000 ||
+		     session->target_whitepoint > 100000)) {
 			g_dbus_method_invocation_return_error (invocation,
 							       CD_SESSION_ERROR,
 							       CD_SESSION_ERROR_INVALID_VALUE,
 							       "invalid target whitepoint value %u",
-							       priv->target_whitepoint);
+							       session->target_whitepoint);
 			return;
 		}
 
 		/* watch to see when the sender quits */
-		priv->watcher_id = g_bus_watch_name (G_BUS_TYPE_SESSION,
-						     sender,
-						     G_BUS_NAME_WATCHER_FLAGS_NONE,
-						     NULL,
-						     cd_main_sender_vanished_cb,
-						     priv, NULL);
-		priv->status = CD_SESSION_STATUS_IDLE;
+		if (session->watcher_id == 0) {
+			session->watcher_id = g_bus_watch_name (G_BUS_TYPE_SESSION,
+								sender,
+								G_BUS_NAME_WATCHER_FLAGS_NONE,
+								NULL,
+								cd_main_sender_vanished_cb,
+								session, NULL);
+		}
+		session->status = CD_SESSION_STATUS_IDLE;
+		session->active = TRUE;
 
 		/* start calibration */
-		priv->device = cd_main_find_device (priv,
+		session->device = cd_main_find_device (session,
 						    device_id,
 						    &error);
-		if (priv->device == NULL) {
+		if (session->device == NULL) {
 			g_dbus_method_invocation_return_gerror (invocation,
 								error);
-			g_timeout_add (200, cd_main_finished_quit_cb, priv);
+			cd_main_session_deactivate (session, 200);
 			return;
 		}
-		priv->sensor = cd_main_find_sensor (priv,
+		session->sensor = cd_main_find_sensor (session,
 						    sensor_id,
 						    &error);
-		if (priv->sensor == NULL) {
+		if (session->sensor == NULL) {
 			g_dbus_method_invocation_return_gerror (invocation,
 								error);
-			g_timeout_add (200, cd_main_finished_quit_cb, priv);
+			cd_main_session_deactivate (session, 200);
 			return;
 		}
 
 		/* set the filename of all the calibrated files */
-		cd_main_set_basename (priv);
+		cd_main_set_basename (session);
 
 		/* ask the user to attach the device to the screen if
 		 * the sensor is external, otherwise to shut the lid */
-		if (cd_sensor_get_embedded (priv->sensor)) {
-			cd_main_emit_interaction_required (priv,
+		if (cd_sensor_get_embedded (session->sensor)) {
+			cd_main_emit_interaction_required (session,
 							   CD_SESSION_INTERACTION_SHUT_LAPTOP_LID);
 		} else {
-			cd_main_emit_interaction_required (priv,
+			cd_main_emit_interaction_required (session,
 							   CD_SESSION_INTERACTION_ATTACH_TO_SCREEN);
 		}
-		priv->status = CD_SESSION_STATUS_WAITING_FOR_INTERACTION;
+		session->status = CD_SESSION_STATUS_WAITING_FOR_INTERACTION;
 		g_dbus_method_invocation_return_value (invocation, NULL);
 		return;
 	}
 
 	if (g_strcmp0 (method_name, "Cancel") == 0) {
 		g_debug ("CdMain: %s:Cancel()", sender);
-		if (priv->status != CD_SESSION_STATUS_RUNNING &&
-		    priv->status != CD_SESSION_STATUS_WAITING_FOR_INTERACTION) {
+		if (session->status != CD_SESSION_STATUS_RUNNING &&
+		    session->status != CD_SESSION_STATUS_WAITING_FOR_INTERACTION) {
 			g_dbus_method_invocation_return_error (invocation,
 							       CD_SESSION_ERROR,
 							       CD_SESSION_ERROR_INTERNAL,
 							       "cannot cancel as status is %s",
-							       cd_main_status_to_text (priv->status));
+							       cd_main_status_to_text (session->status));
 			return;
 		}
-		g_cancellable_cancel (priv->cancellable);
-		priv->status = CD_SESSION_STATUS_IDLE;
-		g_timeout_add (1000, cd_main_quit_loop_cb, priv);
+		g_cancellable_cancel (session->cancellable);
+		cd_main_session_deactivate (session, 1000);
 		g_dbus_method_invocation_return_value (invocation, NULL);
 		return;
 	}
 
 	if (g_strcmp0 (method_name, "Resume") == 0) {
 		g_debug ("CdMain: %s:Resume()", sender);
-		if (priv->status != CD_SESSION_STATUS_WAITING_FOR_INTERACTION) {
+		if (session->status != CD_SESSION_STATUS_WAITING_FOR_INTERACTION) {
 			g_dbus_method_invocation_return_error (invocation,
 							       CD_SESSION_ERROR,
 							       CD_SESSION_ERROR_INTERNAL,
 							       "cannot resume as status is %s",
-							       cd_main_status_to_text (priv->status));
+							       cd_main_status_to_text (session->status));
 			return;
 		}
 
 		/* actually start the process now */
-		priv->status = CD_SESSION_STATUS_IDLE;
-		g_idle_add (cd_main_start_calibration_cb, priv);
+		cd_main_session_run (session);
 		g_dbus_method_invocation_return_value (invocation, NULL);
 		return;
 	}
@@ -1705,14 +2001,230 @@ cd_main_daemon_method_call (GDBusConnection *connection,
 	g_critical ("failed to process method %s", method_name);
 }
 
+static GVariant *
+cd_main_session_get_property (GDBusConnection *connection_, const gchar *sender,
+			      const gchar *object_path, const gchar *interface_name,
+			      const gchar *property_name, GError **error,
+			      gpointer user_data)
+{
+	CdMainSession *session = (CdMainSession *) user_data;
+
+	/* display interface */
+	if (g_strcmp0 (interface_name, CD_SESSION_DBUS_INTERFACE_DISPLAY) == 0) {
+		if (g_strcmp0 (property_name, "Progress") == 0)
+			return g_variant_new_uint32 (session->progress);
+		g_critical ("failed to get %s property %s", interface_name, property_name);
+		return NULL;
+	}
+
+	return NULL;
+}
+
+static void
+cd_main_emit_property_changed (CdMainSession *session,
+			       const gchar *property_name,
+			       GVariant *property_value)
+{
+	GVariantBuilder builder;
+	GVariantBuilder invalidated_builder;
+
+	/* build the dict */
+	g_variant_builder_init (&invalidated_builder, G_VARIANT_TYPE ("as"));
+	g_variant_builder_init (&builder, G_VARIANT_TYPE_ARRAY);
+	g_variant_builder_add (&builder,
+			       "{sv}",
+			       property_name,
+			       property_value);
+	g_dbus_connection_emit_signal (session->priv->connection,
+				       NULL,
+				       session->object_path,
+				       "org.freedesktop.DBus.Properties",
+				       "PropertiesChanged",
+				       g_variant_new ("(sa{sv}as)",
+				       CD_SESSION_DBUS_INTERFACE_DISPLAY,
+				       &builder,
+				       &invalidated_builder),
+				       NULL);
+}
+
+static gboolean
+cd_main_percentage_changed_idle_cb (gpointer user_data)
+{
+	CdMainSessionUpdate *update = (CdMainSessionUpdate *) user_data;
+	CdMainSession *session = update->session;
+
+	g_debug ("CdMain: Emitting PropertiesChanged(Progress) %u",
+		 update->progress);
+	session->progress = update->progress;
+	cd_main_emit_property_changed (session,
+				       "Progress",
+				       g_variant_new_uint32 (update->progress));
+	return G_SOURCE_REMOVE;
+}
+
+static void
+cd_main_percentage_changed_cb (CdState *state,
+			       guint value,
+			       CdMainSession *session)
+{
+	CdMainSessionUpdate *update;
+
+	/* the state is updated from the worker thread */
+	update = g_new0 (CdMainSessionUpdate, 1);
+	update->session = session;
+	update->progress = value;
+	g_main_context_invoke_full (session->main_context,
+				    G_PRIORITY_DEFAULT,
+				    cd_main_percentage_changed_idle_cb,
+				    update,
+				    (GDestroyNotify) cd_main_session_update_free);
+}
+
+static CdMainSession *
+cd_main_session_new (CdMainPrivate *priv, const gchar *object_path)
+{
+	CdMainSession *session;
+
+	session = g_new0 (CdMainSession, 1);
+	session->priv = priv;
+	session->object_path = g_strdup (object_path);
+	session->gamma_scale_factor = 10.0f;
+	session->status = CD_SESSION_STATUS_IDLE;
+	session->interaction_code_last = CD_SESSION_INTERACTION_NONE;
+	session->cancellable = g_cancellable_new ();
+	session->context = g_main_context_new ();
+	session->main_context = g_main_context_ref_thread_default ();
+
+	/* track progress of the calibration */
+	session->state = cd_state_new ();
+	cd_state_set_enable_profile (session->state, TRUE);
+	g_signal_connect (session->state,
+			  "percentage-changed",
+			  G_CALLBACK (cd_main_percentage_changed_cb),
+			  session);
+	g_ptr_array_add (priv->sessions, session);
+	return session;
+}
+
+static void
+cd_main_session_free (CdMainSession *session)
+{
+	if (session->registration_id > 0) {
+		g_dbus_connection_unregister_object (session->priv->connection,
+						     session->registration_id);
+	}
+	if (session->remove_id > 0)
+		g_source_remove (session->remove_id);
+	if (session->watcher_id > 0)
+		g_bus_unwatch_name (session->watcher_id);
+	if (session->array != NULL)
+		g_ptr_array_unref (session->array);
+	if (session->sensor != NULL)
+		g_object_unref (session->sensor);
+	if (session->device != NULL)
+		g_object_unref (session->device);
+	if (session->profile != NULL)
+		g_object_unref (session->profile);
+	if (session->cancellable != NULL)
+		g_object_unref (session->cancellable);
+	if (session->it8_cal != NULL)
+		g_object_unref (session->it8_cal);
+	if (session->it8_ti1 != NULL)
+		g_object_unref (session->it8_ti1);
+	if (session->it8_ti3 != NULL)
+		g_object_unref (session->it8_ti3);
+	if (session->state != NULL)
+		g_object_unref (session->state);
+	if (session->context != NULL)
+		g_main_context_unref (session->context);
+	if (session->main_context != NULL)
+		g_main_context_unref (session->main_context);
+	g_free (session->object_path);
+	g_free (session->device_id);
+	g_free (session->device_model);
+	g_free (session->working_path);
+	g_free (session->basename);
+	g_free (session->title);
+	g_free (session);
+}
+
+static gboolean
+cd_main_session_register (CdMainSession *session, GError **error)
+{
+	CdMainPrivate *priv = session->priv;
+	static const GDBusInterfaceVTable interface_vtable = {
+		cd_main_session_method_call,
+		cd_main_session_get_property,
+		NULL
+	};
+
+	session->registration_id = g_dbus_connection_register_object (priv->connection,
+								      session->object_path,
+								      priv->introspection->interfaces[1],
+								      &interface_vtable,
+								      session,  /* user_data */
+								      NULL,  /* user_data_free_func */
+								      error);
+	return session->registration_id > 0;
+}
+
+static void
+cd_main_daemon_method_call (GDBusConnection *connection,
+			    const gchar *sender,
+			    const gchar *object_path,
+			    const gchar *interface_name,
+			    const gchar *method_name,
+			    GVariant *parameters,
+			    GDBusMethodInvocation *invocation,
+			    gpointer user_data)
+{
+	CdMainPrivate *priv = (CdMainPrivate *) user_data;
+	CdMainSession *session;
+	g_autofree gchar *session_path = NULL;
+	g_autoptr(GError) error = NULL;
+
+	if (g_strcmp0 (method_name, "CreateSession") == 0) {
+		g_debug ("CdMain: %s:CreateSession()", sender);
+
+		/* do not quit with a session waiting to be started */
+		if (priv->quit_id > 0) {
+			g_source_remove (priv->quit_id);
+			priv->quit_id = 0;
+		}
+
+		session_path = g_strdup_printf ("/sessions/%u",
+						priv->session_id_next++);
+		session = cd_main_session_new (priv, session_path);
+		if (!cd_main_session_register (session, &error)) {
+			g_dbus_method_invocation_return_gerror (invocation,
+								error);
+			return;
+		}
+
+		/* the session is abandoned if the sender quits */
+		session->active = TRUE;
+		session->watcher_id = g_bus_watch_name (G_BUS_TYPE_SESSION,
+							sender,
+							G_BUS_NAME_WATCHER_FLAGS_NONE,
+							NULL,
+							cd_main_sender_vanished_cb,
+							session, NULL);
+		g_dbus_method_invocation_return_value (invocation,
+						       g_variant_new ("(o)",
+								      session_path));
+		return;
+	}
+
+	/* we suck */
+	g_critical ("failed to process method %s", method_name);
+}
+
 static GVariant *
 cd_main_daemon_get_property (GDBusConnection *connection_, const gchar *sender,
 			     const gchar *object_path, const gchar *interface_name,
 			     const gchar *property_name, GError **error,
 			     gpointer user_data)
 {
-	CdMainPrivate *priv = (CdMainPrivate *) user_data;
-
 	/* main interface */
 	if (g_strcmp0 (interface_name, CD_SESSION_DBUS_INTERFACE) == 0) {
 		if (g_strcmp0 (property_name, "DaemonVersion") == 0)
@@ -1721,14 +2233,6 @@ cd_main_daemon_get_property (GDBusConnection *connection_, const gchar *sender,
 		return NULL;
 	}
 
-	/* display interface */
-	if (g_strcmp0 (interface_name, CD_SESSION_DBUS_INTERFACE_DISPLAY) == 0) {
-		if (g_strcmp0 (property_name, "Progress") == 0)
-			return g_variant_new_uint32 (priv->progress);
-		g_critical ("failed to get %s property %s", interface_name, property_name);
-		return NULL;
-	}
-
 	return NULL;
 }
 
@@ -1738,8 +2242,8 @@ cd_main_on_bus_acquired_cb (GDBusConnection *connection,
 			    gpointer user_data)
 {
 	CdMainPrivate *priv = (CdMainPrivate *) user_data;
+	CdMainSession *session;
 	guint registration_id;
-	guint i;
 	static const GDBusInterfaceVTable interface_vtable = {
 		cd_main_daemon_method_call,
 		cd_main_daemon_get_property,
@@ -1747,16 +2251,19 @@ cd_main_on_bus_acquired_cb (GDBusConnection *connection,
 	};
 
 	priv->connection = g_object_ref (connection);
-	for (i = 0; i < 2; i++) {
-		registration_id = g_dbus_connection_register_object (connection,
-								     CD_SESSION_DBUS_PATH,
-								     priv->introspection->interfaces[i],
-								     &interface_vtable,
-								     priv,  /* user_data */
-								     NULL,  /* user_data_free_func */
-								     NULL); /* GError** */
-		g_assert (registration_id > 0);
-	}
+	registration_id = g_dbus_connection_register_object (connection,
+							     CD_SESSION_DBUS_PATH,
+							     priv->introspection->interfaces[0],
+							     &interface_vtable,
+							     priv,  /* user_data */
+							     NULL,  /* user_data_free_func */
+							     NULL); /* GError** */
+	g_assert (registration_id > 0);
+
+	/* the root object is also a session for older clients */
+	session = g_ptr_array_index (priv->sessions, 0);
+	if (!cd_main_session_register (session, NULL))
+		g_assert_not_reached ();
 }
 
 static void
@@ -1800,44 +2307,6 @@ cd_main_load_introspection (const gchar *filename, GError **error)
 	return g_dbus_node_info_new_for_xml (data, error);
 }
 
-static void
-cd_main_emit_property_changed (CdMainPrivate *priv,
-			       const gchar *property_name,
-			       GVariant *property_value)
-{
-	GVariantBuilder builder;
-	GVariantBuilder invalidated_builder;
-
-	/* build the dict */
-	g_variant_builder_init (&invalidated_builder, G_VARIANT_TYPE ("as"));
-	g_variant_builder_init (&builder, G_VARIANT_TYPE_ARRAY);
-	g_variant_builder_add (&builder,
-			       "{sv}",
-			       property_name,
-			       property_value);
-	g_dbus_connection_emit_signal (priv->connection,
-				       NULL,
-				       CD_SESSION_DBUS_PATH,
-				       "org.freedesktop.DBus.Properties",
-				       "PropertiesChanged",
-				       g_variant_new ("(sa{sv}as)",
-				       CD_SESSION_DBUS_INTERFACE_DISPLAY,
-				       &builder,
-				       &invalidated_builder),
-				       NULL);
-}
-
-static void
-cd_main_percentage_changed_cb (CdState *state,
-			       guint value,
-			       CdMainPrivate *priv)
-{
-	g_debug ("CdMain: Emitting PropertiesChanged(Progress) %u", value);
-	cd_main_emit_property_changed (priv,
-				       "Progress",
-				       g_variant_new_uint32 (value));
-}
-
 int
 main (int argc, char *argv[])
 {
@@ -1856,22 +2325,18 @@ main (int argc, char *argv[])
 
 	setlocale (LC_ALL, "");
 
+	/* register the D-Bus errors before any worker thread can use them */
+	cd_main_error_quark ();
+
 	priv = g_new0 (CdMainPrivate, 1);
-	priv->gamma_scale_factor = 10.0f;
-	priv->status = CD_SESSION_STATUS_IDLE;
-	priv->interaction_code_last = CD_SESSION_INTERACTION_NONE;
-	priv->cancellable = g_cancellable_new ();
 	priv->loop = g_main_loop_new (NULL, FALSE);
 	priv->settings = g_settings_new ("org.freedesktop.ColorHelper");
 	priv->sample_delay = g_settings_get_int (priv->settings, "sample-delay");
+	priv->sessions = g_ptr_array_new_with_free_func ((GDestroyNotify) cd_main_session_free);
+	priv->session_id_next = 1;
 
-	/* track progress of the calibration */
-	priv->state = cd_state_new ();
-	cd_state_set_enable_profile (priv->state, TRUE);
-	g_signal_connect (priv->state,
-			  "percentage-changed",
-			  G_CALLBACK (cd_main_percentage_changed_cb),
-			  priv);
+	/* the root object is the session used by older clients */
+	cd_main_session_new (priv, CD_SESSION_DBUS_PATH);
 
 	/* TRANSLATORS: program name */
 	g_set_application_name ("Color Management");
@@ -1927,7 +2392,10 @@ main (int argc, char *argv[])
 out:
 	if (owner_id > 0)
 		g_bus_unown_name (owner_id);
+	if (priv->quit_id > 0)
+		g_source_remove (priv->quit_id);
 	g_main_loop_unref (priv->loop);
+	g_ptr_array_unref (priv->sessions);
 	if (priv->settings != NULL)
 		g_object_unref (priv->settings);
 	if (priv->client != NULL)
@@ -1936,27 +2404,6 @@ out:
 		g_object_unref (priv->connection);
 	if (priv->introspection != NULL)
 		g_dbus_node_info_unref (priv->introspection);
-	if (priv->array != NULL)
-		g_ptr_array_unref (priv->array);
-	if (priv->sensor != NULL)
-		g_object_unref (priv->sensor);
-	if (priv->device != NULL)
-		g_object_unref (priv->device);
-	if (priv->profile != NULL)
-		g_object_unref (priv->profile);
-	if (priv->cancellable != NULL)
-		g_object_unref (priv->cancellable);
-	if (priv->it8_cal != NULL)
-		g_object_unref (priv->it8_cal);
-	if (priv->it8_ti1 != NULL)
-		g_object_unref (priv->it8_ti1);
-	if (priv->it8_ti3 != NULL)
-		g_object_unref (priv->it8_ti3);
-	if (priv->state != NULL)
-		g_object_unref (priv->state);
-	g_free (priv->working_path);
-	g_free (priv->basename);
-	g_free (priv->title);
 	g_free (priv);
 	return retval;
 }
@@ -84,7 +84,7 @@ cd_client_connect_sync (CdClient *client,
 
 	/* create temp object */
 	memset (&helper, 0, sizeof (CdClientHelper));
-	helper.loop = g_main_loop_new (NULL, FALSE);
+	helper.loop = g_main_loop_new (g_main_context_get_thread_default (), FALSE);
 	helper.error = error;
 
 	/* run async method */
@@ -135,7 +135,7 @@ cd_client_delete_profile_sync (CdClient *client,
 
 	/* create temp object */
 	memset (&helper, 0, sizeof (CdClientHelper));
-	helper.loop = g_main_loop_new (NULL, FALSE);
+	helper.loop = g_main_loop_new (g_main_context_get_thread_default (), FALSE);
 	helper.error = error;
 
 	/* run async method */
@@ -186,7 +186,7 @@ cd_client_delete_device_sync (CdClient *client,
 
 	/* create temp object */
 	memset (&helper, 0, sizeof (CdClientHelper));
-	helper.loop = g_main_loop_new (NULL, FALSE);
+	helper.loop = g_main_loop_new (g_main_context_get_thread_default (), FALSE);
 	helper.error = error;
 
 	/* run async method */
@@ -239,7 +239,7 @@ cd_client_find_profile_sync (CdClient *client,
 
 	/* create temp object */
 	memset (&helper, 0, sizeof (CdClientHelper));
-	helper.loop = g_main_loop_new (NULL, FALSE);
+	helper.loop = g_main_loop_new (g_main_context_get_thread_default (), FALSE);
 	helper.error = error;
 	helper.profile = NULL;
 
@@ -294,7 +294,7 @@ cd_client_find_profile_by_filename_sync (CdClient *client,
 
 	/* create temp object */
 	memset (&helper, 0, sizeof (CdClientHelper));
-	helper.loop = g_main_loop_new (NULL, FALSE);
+	helper.loop = g_main_loop_new (g_main_context_get_thread_default (), FALSE);
 	helper.error = error;
 	helper.profile = NULL;
 
@@ -354,7 +354,7 @@ cd_client_create_profile_sync (CdClient *client,
 
 	/* create temp object */
 	memset (&helper, 0, sizeof (CdClientHelper));
-	helper.loop = g_main_loop_new (NULL, FALSE);
+	helper.loop = g_main_loop_new (g_main_context_get_thread_default (), FALSE);
 	helper.error = error;
 	helper.profile = NULL;
 
@@ -412,7 +412,7 @@ cd_client_create_profile_for_icc_sync (CdClient *client,
 
 	/* create temp object */
 	memset (&helper, 0, sizeof (CdClientHelper));
-	helper.loop = g_main_loop_new (NULL, FALSE);
+	helper.loop = g_main_loop_new (g_main_context_get_thread_default (), FALSE);
 	helper.error = error;
 	helper.profile = NULL;
 
@@ -467,7 +467,7 @@ cd_client_import_profile_sync (CdClient *client,
 	CdClientHelper helper;
 
 	/* import temp object */
-	helper.loop = g_main_loop_new (NULL, FALSE);
+	helper.loop = g_main_loop_new (g_main_context_get_thread_default (), FALSE);
 	helper.error = error;
 	helper.profile = NULL;
 
@@ -527,7 +527,7 @@ cd_client_create_device_sync (CdClient *client,
 
 	/* create temp object */
 	memset (&helper, 0, sizeof (CdClientHelper));
-	helper.loop = g_main_loop_new (NULL, FALSE);
+	helper.loop = g_main_loop_new (g_main_context_get_thread_default (), FALSE);
 	helper.error = error;
 	helper.device = NULL;
 
@@ -582,7 +582,7 @@ cd_client_get_devices_sync (CdClient *client,
 
 	/* create temp object */
 	memset (&helper, 0, sizeof (CdClientHelper));
-	helper.loop = g_main_loop_new (NULL, FALSE);
+	helper.loop = g_main_loop_new (g_main_context_get_thread_default (), FALSE);
 	helper.error = error;
 	helper.array = NULL;
 
@@ -636,7 +636,7 @@ cd_client_get_profiles_sync (CdClient *client,
 
 	/* create temp object */
 	memset (&helper, 0, sizeof (CdClientHelper));
-	helper.loop = g_main_loop_new (NULL, FALSE);
+	helper.loop = g_main_loop_new (g_main_context_get_thread_default (), FALSE);
 	helper.error = error;
 	helper.array = NULL;
 
@@ -690,7 +690,7 @@ cd_client_get_sensors_sync (CdClient *client,
 
 	/* create temp object */
 	memset (&helper, 0, sizeof (CdClientHelper));
-	helper.loop = g_main_loop_new (NULL, FALSE);
+	helper.loop = g_main_loop_new (g_main_context_get_thread_default (), FALSE);
 	helper.error = error;
 	helper.array = NULL;
 
@@ -745,7 +745,7 @@ cd_client_find_device_sync (CdClient *client,
 
 	/* create temp object */
 	memset (&helper, 0, sizeof (CdClientHelper));
-	helper.loop = g_main_loop_new (NULL, FALSE);
+	helper.loop = g_main_loop_new (g_main_context_get_thread_default (), FALSE);
 	helper.error = error;
 
 	/* run async method */
@@ -801,7 +801,7 @@ cd_client_find_device_by_property_sync (CdClient *client,
 
 	/* create temp object */
 	memset (&helper, 0, sizeof (CdClientHelper));
-	helper.loop = g_main_loop_new (NULL, FALSE);
+	helper.loop = g_main_loop_new (g_main_context_get_thread_default (), FALSE);
 	helper.error = error;
 
 	/* run async method */
@@ -855,7 +855,7 @@ cd_client_get_standard_space_sync (CdClient *client,
 
 	/* create temp object */
 	memset (&helper, 0, sizeof (CdClientHelper));
-	helper.loop = g_main_loop_new (NULL, FALSE);
+	helper.loop = g_main_loop_new (g_main_context_get_thread_default (), FALSE);
 	helper.error = error;
 	helper.profile = NULL;
 
@@ -911,7 +911,7 @@ cd_client_get_devices_by_kind_sync (CdClient *client,
 
 	/* create temp object */
 	memset (&helper, 0, sizeof (CdClientHelper));
-	helper.loop = g_main_loop_new (NULL, FALSE);
+	helper.loop = g_main_loop_new (g_main_context_get_thread_default (), FALSE);
 	helper.error = error;
 
 	/* run async method */
@@ -967,7 +967,7 @@ cd_client_find_profile_by_property_sync (CdClient *client,
 
 	/* create temp object */
 	memset (&helper, 0, sizeof (CdClientHelper));
-	helper.loop = g_main_loop_new (NULL, FALSE);
+	helper.loop = g_main_loop_new (g_main_context_get_thread_default (), FALSE);
 	helper.error = error;
 
 	/* run async method */
@@ -1021,7 +1021,7 @@ cd_client_find_sensor_sync (CdClient *client,
 
 	/* create temp object */
 	memset (&helper, 0, sizeof (CdClientHelper));
-	helper.loop = g_main_loop_new (NULL, FALSE);
+	helper.loop = g_main_loop_new (g_main_context_get_thread_default (), FALSE);
 	helper.error = error;
 
 	/* run async method */
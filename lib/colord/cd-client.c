@@ -36,6 +36,9 @@
 #include <stdlib.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#ifdef __unix__
+#include <unistd.h>
+#endif
 
 #include <gio/gio.h>
 #ifdef __unix__
@@ -72,6 +75,8 @@ static void	cd_client_finalize	(GObject	*object);
 typedef struct
 {
 	GDBusProxy		*proxy;
+	GDBusProxy		*peer_proxy;	/* read-only, may be NULL */
+	guint			 signal_id;
 	gchar			*daemon_version;
 	gchar			*system_vendor;
 	gchar			*system_model;
@@ -245,12 +250,15 @@ cd_client_get_has_server (CdClient *client)
 /**********************************************************************/
 
 static void
-cd_client_dbus_signal_cb (GDBusProxy *proxy,
-			  gchar      *sender_name,
-			  gchar      *signal_name,
-			  GVariant   *parameters,
-			  CdClient   *client)
+cd_client_dbus_signal_cb (GDBusConnection *connection,
+			  const gchar *sender_name,
+			  const gchar *object_path,
+			  const gchar *interface_name,
+			  const gchar *signal_name,
+			  GVariant *parameters,
+			  gpointer user_data)
 {
+	CdClient *client = CD_CLIENT (user_data);
 	g_autofree gchar *object_path_tmp = NULL;
 	g_autoptr(CdDevice) device = NULL;
 	g_autoptr(CdProfile) profile = NULL;
@@ -308,12 +316,108 @@ cd_client_dbus_signal_cb (GDBusProxy *proxy,
 	}
 }
 
+/* a client with a scope gets the manager signals as unicast messages */
+static void
+cd_client_subscribe_signals (CdClient *client, gboolean scoped)
+{
+	CdClientPrivate *priv = GET_PRIVATE (client);
+	GDBusConnection *connection = g_dbus_proxy_get_connection (priv->proxy);
+	g_autofree gchar *name_owner = NULL;
+
+	if (priv->signal_id != 0)
+		g_dbus_connection_signal_unsubscribe (connection, priv->signal_id);
+	name_owner = g_dbus_proxy_get_name_owner (priv->proxy);
+	priv->signal_id =
+		g_dbus_connection_signal_subscribe (connection,
+						    name_owner != NULL ? name_owner : COLORD_DBUS_SERVICE,
+						    COLORD_DBUS_INTERFACE,
+						    NULL,
+						    COLORD_DBUS_PATH,
+						    NULL,
+						    scoped ? G_DBUS_SIGNAL_FLAGS_NO_MATCH_RULE :
+							     G_DBUS_SIGNAL_FLAGS_NONE,
+						    cd_client_dbus_signal_cb,
+						    client,
+						    NULL);
+}
+
+static void
+cd_client_register_signal_scope (CdClient *client,
+				 GCancellable *cancellable,
+				 GAsyncReadyCallback callback,
+				 gpointer user_data)
+{
+	CdClientPrivate *priv = GET_PRIVATE (client);
+	GVariantBuilder builder;
+	const gchar *seat;
+
+	/* objects owned by root or without a seat are always included */
+	g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+#ifdef __unix__
+	if (getuid () != 0) {
+		g_variant_builder_add (&builder, "{sv}", "Uid",
+				       g_variant_new_uint32 (getuid ()));
+	}
+#endif
+	seat = g_getenv ("XDG_SEAT");
+	if (seat != NULL && seat[0] != '\0') {
+		g_variant_builder_add (&builder, "{sv}", "Seat",
+				       g_variant_new_string (seat));
+	}
+	g_dbus_proxy_call (priv->proxy,
+			   "RegisterSignalScope",
+			   g_variant_new ("(a{sv})", &builder),
+			   G_DBUS_CALL_FLAGS_NONE,
+			   -1,
+			   cancellable,
+			   callback,
+			   user_data);
+}
+
+static void
+cd_client_owner_scope_cb (GObject *source_object,
+			  GAsyncResult *res,
+			  gpointer user_data)
+{
+	g_autoptr(CdClient) client = CD_CLIENT (user_data);
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GVariant) result = NULL;
+
+	result = g_dbus_proxy_call_finish (G_DBUS_PROXY (source_object), res, &error);
+	if (result == NULL)
+		g_debug ("failed to register signal scope: %s", error->message);
+	cd_client_subscribe_signals (client, result != NULL);
+}
+
 static void
 cd_client_owner_notify_cb (GObject *object,
 			   GParamSpec *pspec,
 			   CdClient *client)
 {
+	CdClientPrivate *priv = GET_PRIVATE (client);
+	g_autofree gchar *name_owner = NULL;
+
 	/* daemon has quit, clearing caches */
+	name_owner = g_dbus_proxy_get_name_owner (priv->proxy);
+	if (name_owner == NULL)
+		return;
+
+	/* the scope died with the old daemon */
+	cd_client_register_signal_scope (client,
+					 NULL,
+					 cd_client_owner_scope_cb,
+					 g_object_ref (client));
+}
+
+/* read-only methods can skip the bus daemon if there is a direct connection */
+static GDBusProxy *
+cd_client_get_read_proxy (CdClient *client)
+{
+	CdClientPrivate *priv = GET_PRIVATE (client);
+	if (priv->peer_proxy != NULL &&
+	    !g_dbus_connection_is_closed (g_dbus_proxy_get_connection (priv->peer_proxy)))
+		return priv->peer_proxy;
+	return priv->proxy;
 }
 
 /**********************************************************************/
@@ -339,6 +443,93 @@ cd_client_connect_finish (CdClient *client,
 	return g_task_propagate_boolean (G_TASK (res), error);
 }
 
+static void
+cd_client_connect_peer_proxy_cb (GObject *source_object,
+				 GAsyncResult *res,
+				 gpointer user_data)
+{
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GTask) task = G_TASK (user_data);
+	CdClient *client = CD_CLIENT (g_task_get_source_object (task));
+	CdClientPrivate *priv = GET_PRIVATE (client);
+
+	/* the bus proxy is used for everything instead */
+	priv->peer_proxy = g_dbus_proxy_new_finish (res, &error);
+	if (priv->peer_proxy == NULL)
+		g_debug ("failed to create peer proxy: %s", error->message);
+	g_task_return_boolean (task, TRUE);
+}
+
+static void
+cd_client_connect_peer_cb (GObject *source_object,
+			   GAsyncResult *res,
+			   gpointer user_data)
+{
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GDBusConnection) connection = NULL;
+	g_autoptr(GTask) task = G_TASK (user_data);
+
+	/* the system bus is still used for everything */
+	connection = g_dbus_connection_new_for_address_finish (res, &error);
+	if (connection == NULL) {
+		g_debug ("failed to connect to peer socket: %s", error->message);
+		g_task_return_boolean (task, TRUE);
+		return;
+	}
+
+	/* there is no bus name, and signals still arrive from the bus */
+	g_dbus_proxy_new (connection,
+			  G_DBUS_PROXY_FLAGS_DO_NOT_LOAD_PROPERTIES |
+			  G_DBUS_PROXY_FLAGS_DO_NOT_CONNECT_SIGNALS,
+			  NULL,
+			  NULL,
+			  COLORD_DBUS_PATH,
+			  COLORD_DBUS_INTERFACE,
+			  g_task_get_cancellable (task),
+			  cd_client_connect_peer_proxy_cb,
+			  g_steal_pointer (&task));
+}
+
+static void
+cd_client_connect_scope_cb (GObject *source_object,
+			    GAsyncResult *res,
+			    gpointer user_data)
+{
+	const gchar *socket_path;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GTask) task = G_TASK (user_data);
+	g_autoptr(GVariant) result = NULL;
+	CdClient *client = CD_CLIENT (g_task_get_source_object (task));
+
+	/* older daemons broadcast everything */
+	result = g_dbus_proxy_call_finish (G_DBUS_PROXY (source_object), res, &error);
+	if (result == NULL)
+		g_debug ("failed to register signal scope: %s", error->message);
+	cd_client_subscribe_signals (client, result != NULL);
+
+	/* the daemon may also be listening for direct connections */
+	socket_path = g_getenv ("COLORD_PEER_SOCKET");
+	if (socket_path == NULL)
+		socket_path = CD_PEER_SOCKET;
+	if (socket_path[0] != '\0' &&
+	    g_file_test (socket_path, G_FILE_TEST_EXISTS)) {
+		g_autofree gchar *address = NULL;
+		g_autofree gchar *escaped = NULL;
+		escaped = g_dbus_address_escape_value (socket_path);
+		address = g_strdup_printf ("unix:path=%s", escaped);
+		g_dbus_connection_new_for_address (address,
+						   G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT,
+						   NULL,
+						   g_task_get_cancellable (task),
+						   cd_client_connect_peer_cb,
+						   g_steal_pointer (&task));
+		return;
+	}
+
+	/* success */
+	g_task_return_boolean (task, TRUE);
+}
+
 static void
 cd_client_connect_cb (GObject *source_object,
 		      GAsyncResult *res,
@@ -387,20 +578,17 @@ cd_client_connect_cb (GObject *source_object,
 		priv->system_model = g_variant_dup_string (system_model, NULL);
 	}
 
-	/* get signals from DBus */
-	g_signal_connect_object (priv->proxy,
-				 "g-signal",
-				 G_CALLBACK (cd_client_dbus_signal_cb),
-				 client, 0);
-
 	/* watch to see if it's fallen off the bus */
 	g_signal_connect_object (priv->proxy,
 				 "notify::g-name-owner",
 				 G_CALLBACK (cd_client_owner_notify_cb),
 				 client, 0);
 
-	/* success */
-	g_task_return_boolean (task, TRUE);
+	/* only get the signals we care about */
+	cd_client_register_signal_scope (client,
+					 g_task_get_cancellable (task),
+					 cd_client_connect_scope_cb,
+					 g_steal_pointer (&task));
 }
 
 /**
@@ -412,6 +600,9 @@ cd_client_connect_cb (GObject *source_object,
  *
  * Connects to the colord daemon.
  *
+ * Signals about objects created by other users, or on other seats, are
+ * not emitted if the daemon supports signal scopes.
+ *
  * Since: 0.1.6
  **/
 void
@@ -437,7 +628,7 @@ cd_client_connect (CdClient *client,
 
 	/* connect async */
 	g_dbus_proxy_new_for_bus (G_BUS_TYPE_SYSTEM,
-				  G_DBUS_PROXY_FLAGS_NONE,
+				  G_DBUS_PROXY_FLAGS_DO_NOT_CONNECT_SIGNALS,
 				  NULL,
 				  COLORD_DBUS_SERVICE,
 				  COLORD_DBUS_PATH,
@@ -1353,7 +1544,7 @@ cd_client_find_device (CdClient *client,
 	g_return_if_fail (priv->proxy != NULL);
 
 	task = g_task_new (G_OBJECT (client), cancellable, callback, user_data);
-	g_dbus_proxy_call (priv->proxy,
+	g_dbus_proxy_call (cd_client_get_read_proxy (client),
 			   "FindDeviceById",
 			   g_variant_new ("(s)", id),
 			   G_DBUS_CALL_FLAGS_NONE,
@@ -1446,7 +1637,7 @@ cd_client_find_device_by_property (CdClient *client,
 	g_return_if_fail (priv->proxy != NULL);
 
 	task = g_task_new (G_OBJECT (client), cancellable, callback, user_data);
-	g_dbus_proxy_call (priv->proxy,
+	g_dbus_proxy_call (cd_client_get_read_proxy (client),
 			   "FindDeviceByProperty",
 			   g_variant_new ("(ss)", key, value),
 			   G_DBUS_CALL_FLAGS_NONE,
@@ -1537,7 +1728,7 @@ cd_client_find_profile (CdClient *client,
 	g_return_if_fail (priv->proxy != NULL);
 
 	task = g_task_new (G_OBJECT (client), cancellable, callback, user_data);
-	g_dbus_proxy_call (priv->proxy,
+	g_dbus_proxy_call (cd_client_get_read_proxy (client),
 			   "FindProfileById",
 			   g_variant_new ("(s)", id),
 			   G_DBUS_CALL_FLAGS_NONE,
@@ -1628,7 +1819,7 @@ cd_client_find_profile_by_filename (CdClient *client,
 	g_return_if_fail (priv->proxy != NULL);
 
 	task = g_task_new (G_OBJECT (client), cancellable, callback, user_data);
-	g_dbus_proxy_call (priv->proxy,
+	g_dbus_proxy_call (cd_client_get_read_proxy (client),
 			   "FindProfileByFilename",
 			   g_variant_new ("(s)", filename),
 			   G_DBUS_CALL_FLAGS_NONE,
@@ -1718,7 +1909,7 @@ cd_client_get_standard_space (CdClient *client,
 	g_return_if_fail (priv->proxy != NULL);
 
 	task = g_task_new (G_OBJECT (client), cancellable, callback, user_data);
-	g_dbus_proxy_call (priv->proxy,
+	g_dbus_proxy_call (cd_client_get_read_proxy (client),
 			   "GetStandardSpace",
 			   g_variant_new ("(s)",
 			   		  cd_standard_space_to_string (standard_space)),
@@ -1832,7 +2023,7 @@ cd_client_get_devices (CdClient *client,
 	g_return_if_fail (priv->proxy != NULL);
 
 	task = g_task_new (G_OBJECT (client), cancellable, callback, user_data);
-	g_dbus_proxy_call (priv->proxy,
+	g_dbus_proxy_call (cd_client_get_read_proxy (client),
 			   "GetDevices",
 			   NULL,
 			   G_DBUS_CALL_FLAGS_NONE,
@@ -1922,7 +2113,7 @@ cd_client_get_devices_by_kind (CdClient *client,
 	g_return_if_fail (priv->proxy != NULL);
 
 	task = g_task_new (G_OBJECT (client), cancellable, callback, user_data);
-	g_dbus_proxy_call (priv->proxy,
+	g_dbus_proxy_call (cd_client_get_read_proxy (client),
 			   "GetDevicesByKind",
 			   g_variant_new ("(s)",
 			   		  cd_device_kind_to_string (kind)),
@@ -2036,7 +2227,7 @@ cd_client_get_profiles (CdClient *client,
 	g_return_if_fail (priv->proxy != NULL);
 
 	task = g_task_new (G_OBJECT (client), cancellable, callback, user_data);
-	g_dbus_proxy_call (priv->proxy,
+	g_dbus_proxy_call (cd_client_get_read_proxy (client),
 			   "GetProfiles",
 			   NULL,
 			   G_DBUS_CALL_FLAGS_NONE,
@@ -2149,7 +2340,7 @@ cd_client_get_sensors (CdClient *client,
 	g_return_if_fail (priv->proxy != NULL);
 
 	task = g_task_new (G_OBJECT (client), cancellable, callback, user_data);
-	g_dbus_proxy_call (priv->proxy,
+	g_dbus_proxy_call (cd_client_get_read_proxy (client),
 			   "GetSensors",
 			   NULL,
 			   G_DBUS_CALL_FLAGS_NONE,
@@ -2242,7 +2433,7 @@ cd_client_find_profile_by_property (CdClient *client,
 	g_return_if_fail (priv->proxy != NULL);
 
 	task = g_task_new (G_OBJECT (client), cancellable, callback, user_data);
-	g_dbus_proxy_call (priv->proxy,
+	g_dbus_proxy_call (cd_client_get_read_proxy (client),
 			   "FindProfileByProperty",
 			   g_variant_new ("(ss)", key, value),
 			   G_DBUS_CALL_FLAGS_NONE,
@@ -2333,7 +2524,7 @@ cd_client_find_sensor (CdClient *client,
 	g_return_if_fail (priv->proxy != NULL);
 
 	task = g_task_new (G_OBJECT (client), cancellable, callback, user_data);
-	g_dbus_proxy_call (priv->proxy,
+	g_dbus_proxy_call (cd_client_get_read_proxy (client),
 			   "FindSensorById",
 			   g_variant_new ("(s)", id),
 			   G_DBUS_CALL_FLAGS_NONE,
@@ -2623,8 +2814,14 @@ cd_client_finalize (GObject *object)
 	g_free (priv->daemon_version);
 	g_free (priv->system_vendor);
 	g_free (priv->system_model);
+	if (priv->signal_id != 0) {
+		g_dbus_connection_signal_unsubscribe (g_dbus_proxy_get_connection (priv->proxy),
+						      priv->signal_id);
+	}
 	if (priv->proxy != NULL)
 		g_object_unref (priv->proxy);
+	if (priv->peer_proxy != NULL)
+		g_object_unref (priv->peer_proxy);
 
 	G_OBJECT_CLASS (cd_client_parent_class)->finalize (object);
 }
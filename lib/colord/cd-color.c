@@ -1505,3 +1505,141 @@ cd_color_get_blackbody_rgb (guint temp, CdColorRGB *result)
 	return cd_color_get_blackbody_rgb_full (temp, result,
 						CD_COLOR_BLACKBODY_FLAG_NONE);
 }
+
+/* SMPTE ST 2084 */
+#define CD_COLOR_PQ_M1		(2610.f / 16384.f)
+#define CD_COLOR_PQ_M2		(2523.f / 4096.f * 128.f)
+#define CD_COLOR_PQ_C1		(3424.f / 4096.f)
+#define CD_COLOR_PQ_C2		(2413.f / 4096.f * 32.f)
+#define CD_COLOR_PQ_C3		(2392.f / 4096.f * 32.f)
+#define CD_COLOR_PQ_PEAK	10000.f
+
+/* ITU-R BT.2100 */
+#define CD_COLOR_HLG_A		0.17883277
+#define CD_COLOR_HLG_B		(1.f - 4.f * CD_COLOR_HLG_A)
+#define CD_COLOR_HLG_C		(0.5f - CD_COLOR_HLG_A * log (4.f * CD_COLOR_HLG_A))
+
+/**
+ * cd_color_pq_to_luminance:
+ * @value: the non-linear PQ signal, from 0.0 to 1.0
+ *
+ * Decodes a SMPTE ST 2084 perceptual quantizer signal into absolute
+ * luminance using the PQ EOTF.
+ *
+ * Return value: the luminance in cd/m², from 0 to 10000
+ *
+ * Since: 1.4.8
+ **/
+gdouble
+cd_color_pq_to_luminance (gdouble value)
+{
+	gdouble tmp;
+
+	if (value <= 0.f)
+		return 0.f;
+	if (value >= 1.f)
+		return CD_COLOR_PQ_PEAK;
+	tmp = pow (value, 1.f / CD_COLOR_PQ_M2);
+	tmp = MAX (tmp - CD_COLOR_PQ_C1, 0.f) / (CD_COLOR_PQ_C2 - CD_COLOR_PQ_C3 * tmp);
+	return CD_COLOR_PQ_PEAK * pow (tmp, 1.f / CD_COLOR_PQ_M1);
+}
+
+/**
+ * cd_color_luminance_to_pq:
+ * @luminance: the luminance in cd/m²
+ *
+ * Encodes absolute luminance as a SMPTE ST 2084 perceptual quantizer
+ * signal using the inverse PQ EOTF.
+ *
+ * Return value: the non-linear PQ signal, from 0.0 to 1.0
+ *
+ * Since: 1.4.8
+ **/
+gdouble
+cd_color_luminance_to_pq (gdouble luminance)
+{
+	gdouble tmp;
+
+	if (luminance <= 0.f)
+		return 0.f;
+	if (luminance >= CD_COLOR_PQ_PEAK)
+		return 1.f;
+	tmp = pow (luminance / CD_COLOR_PQ_PEAK, CD_COLOR_PQ_M1);
+	return pow ((CD_COLOR_PQ_C1 + CD_COLOR_PQ_C2 * tmp) /
+		    (1.f + CD_COLOR_PQ_C3 * tmp), CD_COLOR_PQ_M2);
+}
+
+/**
+ * cd_color_hlg_to_scene_linear:
+ * @value: the non-linear HLG signal, from 0.0 to 1.0
+ *
+ * Decodes an ITU-R BT.2100 hybrid log-gamma signal into normalised scene
+ * light using the inverse HLG OETF. The display OOTF is not applied.
+ *
+ * Return value: the scene light, from 0.0 to 1.0
+ *
+ * Since: 1.4.8
+ **/
+gdouble
+cd_color_hlg_to_scene_linear (gdouble value)
+{
+	if (value <= 0.f)
+		return 0.f;
+	if (value <= 0.5f)
+		return value * value / 3.f;
+	return MIN ((exp ((value - CD_COLOR_HLG_C) / CD_COLOR_HLG_A) +
+		     CD_COLOR_HLG_B) / 12.f, 1.f);
+}
+
+/**
+ * cd_color_tone_map_bt2390:
+ * @luminance: the luminance in cd/m²
+ * @source_peak: the peak luminance of the source in cd/m², e.g. 1000
+ * @target_peak: the peak luminance of the target in cd/m², e.g. 100
+ *
+ * Maps luminance from a source onto a target with a lower peak using the
+ * ITU-R BT.2390 EETF, which leaves the shadows and mid-tones unchanged and
+ * rolls the highlights off smoothly in the PQ domain. Both black levels are
+ * assumed to be zero.
+ *
+ * If the target is at least as bright as the source then the luminance is
+ * only clipped to @source_peak.
+ *
+ * Return value: the mapped luminance in cd/m², no more than @target_peak
+ *
+ * Since: 1.4.8
+ **/
+gdouble
+cd_color_tone_map_bt2390 (gdouble luminance,
+			  gdouble source_peak,
+			  gdouble target_peak)
+{
+	gdouble e1, e2;
+	gdouble ks;
+	gdouble max_lum;
+	gdouble pq_source;
+	gdouble t, t2, t3;
+
+	g_return_val_if_fail (source_peak > 0.f, 0.f);
+	g_return_val_if_fail (target_peak > 0.f, 0.f);
+
+	if (target_peak >= source_peak)
+		return CLAMP (luminance, 0.f, source_peak);
+
+	/* normalised to the source in the PQ domain */
+	pq_source = cd_color_luminance_to_pq (source_peak);
+	e1 = MIN (cd_color_luminance_to_pq (luminance) / pq_source, 1.f);
+	max_lum = cd_color_luminance_to_pq (target_peak) / pq_source;
+
+	/* Hermite spline above the knee */
+	ks = 1.5f * max_lum - 0.5f;
+	if (e1 < ks)
+		return cd_color_pq_to_luminance (e1 * pq_source);
+	t = (e1 - ks) / (1.f - ks);
+	t2 = t * t;
+	t3 = t2 * t;
+	e2 = (2.f * t3 - 3.f * t2 + 1.f) * ks +
+	     (t3 - 2.f * t2 + t) * (1.f - ks) +
+	     (-2.f * t3 + 3.f * t2) * max_lum;
+	return MIN (cd_color_pq_to_luminance (e2 * pq_source), target_peak);
+}
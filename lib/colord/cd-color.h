@@ -200,6 +200,12 @@ gdouble		 cd_color_xyz_to_cct			(const CdColorXYZ	*src);
 void		 cd_color_xyz_normalize			(const CdColorXYZ	*src,
 							 gdouble		 max,
 							 CdColorXYZ		*dest);
+gdouble		 cd_color_pq_to_luminance		(gdouble		 value);
+gdouble		 cd_color_luminance_to_pq		(gdouble		 luminance);
+gdouble		 cd_color_hlg_to_scene_linear		(gdouble		 value);
+gdouble		 cd_color_tone_map_bt2390		(gdouble		 luminance,
+							 gdouble		 source_peak,
+							 gdouble		 target_peak);
 
 GPtrArray	*cd_color_rgb_array_new			(void);
 gboolean	 cd_color_rgb_array_is_monotonic	(const GPtrArray	*array);
@@ -83,7 +83,7 @@ cd_device_connect_sync (CdDevice *device,
 
 	/* create temp object */
 	memset (&helper, 0, sizeof (CdDeviceHelper));
-	helper.loop = g_main_loop_new (NULL, FALSE);
+	helper.loop = g_main_loop_new (g_main_context_get_thread_default (), FALSE);
 	helper.error = error;
 
 	/* run async method */
@@ -139,7 +139,7 @@ cd_device_set_property_sync (CdDevice *device,
 
 	/* create temp object */
 	memset (&helper, 0, sizeof (CdDeviceHelper));
-	helper.loop = g_main_loop_new (NULL, FALSE);
+	helper.loop = g_main_loop_new (g_main_context_get_thread_default (), FALSE);
 	helper.error = error;
 
 	/* run async method */
@@ -195,7 +195,7 @@ cd_device_add_profile_sync (CdDevice *device,
 
 	/* create temp object */
 	memset (&helper, 0, sizeof (CdDeviceHelper));
-	helper.loop = g_main_loop_new (NULL, FALSE);
+	helper.loop = g_main_loop_new (g_main_context_get_thread_default (), FALSE);
 	helper.error = error;
 
 	/* run async method */
@@ -249,7 +249,7 @@ cd_device_remove_profile_sync (CdDevice *device,
 
 	/* create temp object */
 	memset (&helper, 0, sizeof (CdDeviceHelper));
-	helper.loop = g_main_loop_new (NULL, FALSE);
+	helper.loop = g_main_loop_new (g_main_context_get_thread_default (), FALSE);
 	helper.error = error;
 
 	/* run async method */
@@ -303,7 +303,7 @@ cd_device_get_profile_for_qualifiers_sync (CdDevice *device,
 
 	/* create temp object */
 	memset (&helper, 0, sizeof (CdDeviceHelper));
-	helper.loop = g_main_loop_new (NULL, FALSE);
+	helper.loop = g_main_loop_new (g_main_context_get_thread_default (), FALSE);
 	helper.error = error;
 
 	/* run async method */
@@ -357,7 +357,7 @@ cd_device_make_profile_default_sync (CdDevice *device,
 
 	/* create temp object */
 	memset (&helper, 0, sizeof (CdDeviceHelper));
-	helper.loop = g_main_loop_new (NULL, FALSE);
+	helper.loop = g_main_loop_new (g_main_context_get_thread_default (), FALSE);
 	helper.error = error;
 
 	/* run async method */
@@ -410,7 +410,7 @@ cd_device_profiling_inhibit_sync (CdDevice *device,
 
 	/* create temp object */
 	memset (&helper, 0, sizeof (CdDeviceHelper));
-	helper.loop = g_main_loop_new (NULL, FALSE);
+	helper.loop = g_main_loop_new (g_main_context_get_thread_default (), FALSE);
 	helper.error = error;
 
 	/* run async method */
@@ -463,7 +463,7 @@ cd_device_profiling_uninhibit_sync (CdDevice *device,
 
 	/* create temp object */
 	memset (&helper, 0, sizeof (CdDeviceHelper));
-	helper.loop = g_main_loop_new (NULL, FALSE);
+	helper.loop = g_main_loop_new (g_main_context_get_thread_default (), FALSE);
 	helper.error = error;
 
 	/* run async method */
@@ -517,7 +517,7 @@ cd_device_get_profile_relation_sync (CdDevice *device,
 
 	/* create temp object */
 	memset (&helper, 0, sizeof (CdDeviceHelper));
-	helper.loop = g_main_loop_new (NULL, FALSE);
+	helper.loop = g_main_loop_new (g_main_context_get_thread_default (), FALSE);
 	helper.error = error;
 
 	/* run async method */
@@ -571,7 +571,7 @@ cd_device_set_enabled_sync (CdDevice *device,
 
 	/* create temp object */
 	memset (&helper, 0, sizeof (CdDeviceHelper));
-	helper.loop = g_main_loop_new (NULL, FALSE);
+	helper.loop = g_main_loop_new (g_main_context_get_thread_default (), FALSE);
 	helper.error = error;
 
 	/* run async method */
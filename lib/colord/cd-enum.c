@@ -113,6 +113,8 @@ static const CdEnumMatch enum_pixel_format[] = {
 	{CD_PIXEL_FORMAT_ARGB32,			"argb32"},
 	{CD_PIXEL_FORMAT_RGB24,				"rgb24"},
 	{CD_PIXEL_FORMAT_CMYK32,			"cmyk32"},
+	{CD_PIXEL_FORMAT_I420,				"i420"},
+	{CD_PIXEL_FORMAT_NV12,				"nv12"},
 	{0, NULL}
 };
 
@@ -871,6 +873,8 @@ cd_client_error_to_string (CdClientError error_enum)
 		return CD_DBUS_INTERFACE_DAEMON ".InputInvalid";
 	if (error_enum == CD_CLIENT_ERROR_FILE_INVALID)
 		return CD_DBUS_INTERFACE_DAEMON ".FileInvalid";
+	if (error_enum == CD_CLIENT_ERROR_LIMIT_EXCEEDED)
+		return CD_DBUS_INTERFACE_DAEMON ".LimitExceeded";
 	return NULL;
 }
 
@@ -900,6 +904,8 @@ cd_client_error_from_string (const gchar *error_desc)
 		return CD_CLIENT_ERROR_INPUT_INVALID;
 	if (g_strcmp0 (error_desc, CD_DBUS_INTERFACE_DAEMON ".FileInvalid") == 0)
 		return CD_CLIENT_ERROR_FILE_INVALID;
+	if (g_strcmp0 (error_desc, CD_DBUS_INTERFACE_DAEMON ".LimitExceeded") == 0)
+		return CD_CLIENT_ERROR_LIMIT_EXCEEDED;
 	return CD_CLIENT_ERROR_LAST;
 }
 
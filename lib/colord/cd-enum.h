@@ -102,7 +102,9 @@ typedef enum {
  * CdPixelFormat:
  *
  * The pixel format of an image.
- * NOTE: these values are the same as the lcms2 AOTTTTTUYFPXSEEECCCCBBB type.
+ * NOTE: these values are the same as the lcms2 AOTTTTTUYFPXSEEECCCCBBB type,
+ * apart from the 4:2:0 subsampled Y'CbCr formats which lcms2 cannot unpack.
+ * These set the high bit, which is never used by any lcms2 TYPE_ value.
  **/
 typedef guint32 CdPixelFormat;
 
@@ -112,6 +114,8 @@ typedef guint32 CdPixelFormat;
 #define	CD_PIXEL_FORMAT_CMYK32		0x00060021	/* Since: 1.0.0 */
 #define	CD_PIXEL_FORMAT_BGRA32		0x00044499	/* Since: 1.0.0 */
 #define	CD_PIXEL_FORMAT_RGBA32		0x00040099	/* Since: 1.1.8 */
+#define	CD_PIXEL_FORMAT_I420		0x80000001	/* Since: 1.4.8 */
+#define	CD_PIXEL_FORMAT_NV12		0x80000002	/* Since: 1.4.8 */
 
 /**
  * CdColorspace:
@@ -410,6 +414,7 @@ typedef enum
  * @CD_CLIENT_ERROR_NOT_FOUND:		Profile or device not found
  * @CD_CLIENT_ERROR_INPUT_INVALID:	One or more of the parameters is invalid
  * @CD_CLIENT_ERROR_FILE_INVALID:	The file if invalid
+ * @CD_CLIENT_ERROR_LIMIT_EXCEEDED:	The sender made too many requests
  *
  * Errors that can be thrown
  */
@@ -421,6 +426,7 @@ typedef enum {
 	CD_CLIENT_ERROR_NOT_FOUND,			/* Since: 0.1.26 */
 	CD_CLIENT_ERROR_INPUT_INVALID,			/* Since: 0.1.26 */
 	CD_CLIENT_ERROR_FILE_INVALID,			/* Since: 0.1.26 */
+	CD_CLIENT_ERROR_LIMIT_EXCEEDED,			/* Since: 1.4.8 */
 	/*< private >*/
 	CD_CLIENT_ERROR_LAST
 } CdClientError;
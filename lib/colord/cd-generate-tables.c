@@ -0,0 +1,216 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2012-2014 Richard Hughes <richard@hughsie.com>
+ *
+ * Licensed under the GNU Lesser General Public License Version 2.1
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+/*
+ * This is run at build time to convert the CMF and illuminant CSV files
+ * into C arrays, so they can be used without any file I/O. It only uses
+ * libc as it has to run on the build machine.
+ *
+ * Usage: cd-generate-tables OUTPUT.c [cmf|illuminant NORM FILE.csv]...
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+	const char	*kind;
+	char		*id;
+	double		 start;
+	double		 end;
+	unsigned int	 size;
+	unsigned int	 channels;
+	double		*data;		/* size * channels, interleaved */
+} CdGenerateTable;
+
+static int
+cd_generate_table_load (CdGenerateTable *table, double norm, const char *filename)
+{
+	FILE *f;
+	char line[1024];
+	char *dot;
+	const char *basename;
+	double step = 0.f;
+	double nm_last = 0.f;
+	unsigned int reserved = 0;
+
+	f = fopen (filename, "r");
+	if (f == NULL) {
+		fprintf (stderr, "failed to open %s\n", filename);
+		return 0;
+	}
+
+	/* the ID is the basename without the extension */
+	basename = strrchr (filename, '/');
+	table->id = strdup (basename != NULL ? basename + 1 : filename);
+	dot = strrchr (table->id, '.');
+	if (dot != NULL)
+		*dot = '\0';
+
+	while (fgets (line, sizeof (line), f) != NULL) {
+		char *endptr;
+		char *ptr = line;
+		double nm;
+		unsigned int i;
+
+		/* ignore comments and blank lines */
+		if (line[0] == '#' || line[0] == '\n' || line[0] == '\0')
+			continue;
+
+		/* the spectral data has to be evenly spaced */
+		nm = strtod (ptr, &endptr);
+		if (endptr == ptr) {
+			fprintf (stderr, "%s: invalid line: %s", filename, line);
+			goto fail;
+		}
+		if (table->size == 1)
+			step = nm - nm_last;
+		if (table->size > 1 &&
+		    (nm - nm_last - step > 0.001 || nm - nm_last - step < -0.001)) {
+			fprintf (stderr, "%s: uneven spacing at %.1fnm\n", filename, nm);
+			goto fail;
+		}
+		if (table->size == 0)
+			table->start = nm;
+		table->end = nm;
+		nm_last = nm;
+
+		/* add the values */
+		if (table->size == reserved) {
+			reserved = reserved > 0 ? reserved * 2 : 512;
+			table->data = realloc (table->data, sizeof (double) * reserved * table->channels);
+		}
+		for (i = 0; i < table->channels; i++) {
+			ptr = endptr + strspn (endptr, ", \t");
+			table->data[table->size * table->channels + i] = strtod (ptr, &endptr) / norm;
+			if (endptr == ptr) {
+				fprintf (stderr, "%s: expected %u values: %s",
+					 filename, table->channels, line);
+				goto fail;
+			}
+		}
+		table->size++;
+	}
+	fclose (f);
+
+	/* did we get enough data */
+	if (table->size < 3) {
+		fprintf (stderr, "%s: not enough data\n", filename);
+		return 0;
+	}
+	return 1;
+fail:
+	fclose (f);
+	return 0;
+}
+
+static void
+cd_generate_table_write (FILE *f, const CdGenerateTable *table, unsigned int idx)
+{
+	unsigned int c;
+	unsigned int i;
+
+	/* planar, so each channel can be copied in one go */
+	fprintf (f, "static const gdouble cd_standard_table_%u[] = {\n", idx);
+	for (c = 0; c < table->channels; c++) {
+		for (i = 0; i < table->size; i++) {
+			fprintf (f, "%s%.10g,%s",
+				 i % 6 == 0 ? "\t" : "",
+				 table->data[i * table->channels + c],
+				 i % 6 == 5 || i == table->size - 1 ? "\n" : " ");
+		}
+	}
+	fprintf (f, "};\n\n");
+}
+
+int
+main (int argc, char *argv[])
+{
+	CdGenerateTable *tables;
+	FILE *f;
+	int i;
+	unsigned int len = 0;
+	unsigned int j;
+
+	if (argc < 2 || (argc - 2) % 3 != 0) {
+		fprintf (stderr, "Usage: %s OUTPUT.c [cmf|illuminant NORM FILE.csv]...\n",
+			 argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	/* load all the tables */
+	tables = calloc ((argc - 2) / 3, sizeof (CdGenerateTable));
+	for (i = 2; i < argc; i += 3) {
+		CdGenerateTable *table = &tables[len++];
+		if (strcmp (argv[i], "cmf") == 0) {
+			table->kind = "CD_STANDARD_TABLE_KIND_CMF";
+			table->channels = 3;
+		} else if (strcmp (argv[i], "illuminant") == 0) {
+			table->kind = "CD_STANDARD_TABLE_KIND_ILLUMINANT";
+			table->channels = 1;
+		} else {
+			fprintf (stderr, "unknown kind %s\n", argv[i]);
+			return EXIT_FAILURE;
+		}
+		if (!cd_generate_table_load (table, strtod (argv[i + 1], NULL), argv[i + 2]))
+			return EXIT_FAILURE;
+	}
+
+	/* write the C source */
+	f = fopen (argv[1], "w");
+	if (f == NULL) {
+		fprintf (stderr, "failed to write %s\n", argv[1]);
+		return EXIT_FAILURE;
+	}
+	fprintf (f, "/* generated by cd-generate-tables, do not edit */\n\n");
+	fprintf (f, "#include \"config.h\"\n\n");
+	fprintf (f, "#include \"cd-standard-tables.h\"\n\n");
+	for (j = 0; j < len; j++)
+		cd_generate_table_write (f, &tables[j], j);
+	fprintf (f, "static const CdStandardTable cd_standard_tables[] = {\n");
+	for (j = 0; j < len; j++) {
+		fprintf (f, "\t{ %s, \"%s\", %.1f, %.1f, %u, cd_standard_table_%u },\n",
+			 tables[j].kind, tables[j].id,
+			 tables[j].start, tables[j].end,
+			 tables[j].size, j);
+	}
+	fprintf (f, "};\n\n");
+	fprintf (f, "G_GNUC_INTERNAL const CdStandardTable *\n"
+		 "cd_standard_table_lookup (CdStandardTableKind kind, const gchar *id)\n"
+		 "{\n"
+		 "\tguint i;\n"
+		 "\tfor (i = 0; i < G_N_ELEMENTS (cd_standard_tables); i++) {\n"
+		 "\t\tif (cd_standard_tables[i].kind == kind &&\n"
+		 "\t\t    g_strcmp0 (cd_standard_tables[i].id, id) == 0)\n"
+		 "\t\t\treturn &cd_standard_tables[i];\n"
+		 "\t}\n"
+		 "\treturn NULL;\n"
+		 "}\n");
+	if (fclose (f) != 0)
+		return EXIT_FAILURE;
+
+	for (j = 0; j < len; j++) {
+		free (tables[j].id);
+		free (tables[j].data);
+	}
+	free (tables);
+	return EXIT_SUCCESS;
+}
@@ -24,9 +24,21 @@
  * @short_description: An object to monitor a directory full of ICC profiles
  */
 
+/* for name_to_handle_at(), which has to come before any system header */
+#define _GNU_SOURCE
+
 #include "config.h"
 
+#ifdef HAVE_FANOTIFY
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/fanotify.h>
+#include <sys/statfs.h>
+#include <unistd.h>
+#endif
+
 #include <glib-object.h>
+#include <glib-unix.h>
 #include <gio/gio.h>
 
 #include "cd-icc-store.h"
@@ -38,9 +50,20 @@ static void	cd_icc_store_finalize	(GObject	*object);
 typedef struct
 {
 	CdIccLoadFlags		 load_flags;
-	GPtrArray		*directory_array;
+	GHashTable		*directory_hash;	/* path:CdIccStoreDirHelper */
 	GPtrArray		*icc_array;
 	GResource		*cache;
+	guint			 max_watches;
+	guint			 watch_count;
+	guint			 rescan_interval;
+	guint			 rescan_id;
+	gint			 fanotify_fd;
+	gboolean		 fanotify_failed;
+	guint			 fanotify_id;
+	guint			 fanotify_pending_id;
+	GHashTable		*fanotify_handles;	/* GBytes:path */
+	GHashTable		*fanotify_filesystems;	/* GBytes */
+	GHashTable		*fanotify_pending;	/* path */
 } CdIccStorePrivate;
 
 enum {
@@ -54,6 +77,12 @@ static guint signals[SIGNAL_LAST] = { 0 };
 G_DEFINE_TYPE_WITH_PRIVATE (CdIccStore, cd_icc_store, G_TYPE_OBJECT)
 
 #define CD_ICC_STORE_MAX_RECURSION_LEVELS	  2
+#define CD_ICC_STORE_MAX_WATCHES_DEFAULT	 64
+#define CD_ICC_STORE_RESCAN_INTERVAL_DEFAULT	 30	/* s */
+#define CD_ICC_STORE_FANOTIFY_DELAY		100	/* ms */
+#define CD_ICC_STORE_FANOTIFY_MASK		(FAN_CREATE | FAN_DELETE | \
+						 FAN_MOVED_FROM | FAN_MOVED_TO | \
+						 FAN_ONDIR)
 
 static gboolean
 cd_icc_store_search_path (CdIccStore *store,
@@ -70,8 +99,11 @@ cd_icc_store_search_path_child (CdIccStore *store,
 				GError **error);
 
 typedef struct {
-	gchar		*path;
-	GFileMonitor	*monitor;
+	gchar			*path;
+	GFileMonitor		*monitor;	/* or NULL if not watched */
+	GBytes			*handle;	/* fanotify directory handle */
+	guint			 depth;
+	guint64			 mtime;		/* usec */
 } CdIccStoreDirHelper;
 
 static void
@@ -80,9 +112,18 @@ cd_icc_store_helper_free (CdIccStoreDirHelper *helper)
 	g_free (helper->path);
 	if (helper->monitor != NULL)
 		g_object_unref (helper->monitor);
+	if (helper->handle != NULL)
+		g_bytes_unref (helper->handle);
 	g_free (helper);
 }
 
+static void	cd_icc_store_rescan_directory	(CdIccStore		*store,
+						 CdIccStoreDirHelper	*helper);
+#ifdef HAVE_FANOTIFY
+static void	cd_icc_store_fanotify_unwatch	(CdIccStore		*store,
+						 CdIccStoreDirHelper	*helper);
+#endif
+
 /**
  * cd_icc_store_find_by_filename:
  * @store: a #CdIccStore instance.
@@ -147,16 +188,48 @@ static CdIccStoreDirHelper *
 cd_icc_store_find_by_directory (CdIccStore *store, const gchar *path)
 {
 	CdIccStorePrivate *priv = GET_PRIVATE (store);
-	CdIccStoreDirHelper *tmp;
-	guint i;
-	GPtrArray *array = priv->directory_array;
+	return g_hash_table_lookup (priv->directory_hash, path);
+}
 
-	for (i = 0; i < array->len; i++) {
-		tmp = g_ptr_array_index (array, i);
-		if (g_strcmp0 (path, tmp->path) == 0)
-			return tmp;
+static void
+cd_icc_store_remove_directory (CdIccStore *store, const gchar *path)
+{
+	CdIccStorePrivate *priv = GET_PRIVATE (store);
+	CdIccStoreDirHelper *helper;
+	GHashTableIter iter;
+	g_autofree gchar *prefix = g_strconcat (path, G_DIR_SEPARATOR_S, NULL);
+
+	/* also remove any child directories */
+	g_hash_table_iter_init (&iter, priv->directory_hash);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &helper)) {
+		if (g_strcmp0 (helper->path, path) != 0 &&
+		    !g_str_has_prefix (helper->path, prefix))
+			continue;
+		if (helper->monitor != NULL)
+			priv->watch_count--;
+#ifdef HAVE_FANOTIFY
+		if (helper->handle != NULL)
+			cd_icc_store_fanotify_unwatch (store, helper);
+#endif
+		g_hash_table_iter_remove (&iter);
 	}
-	return NULL;
+}
+
+static guint64
+cd_icc_store_get_mtime (const gchar *path)
+{
+	g_autoptr(GFile) file = g_file_new_for_path (path);
+	g_autoptr(GFileInfo) info = NULL;
+
+	info = g_file_query_info (file,
+				  G_FILE_ATTRIBUTE_TIME_MODIFIED ","
+				  G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC,
+				  G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+				  NULL, NULL);
+	if (info == NULL)
+		return 0;
+	return g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED) * G_USEC_PER_SEC +
+		g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC);
 }
 
 static gboolean
@@ -280,14 +353,18 @@ cd_icc_store_remove_from_prefix (CdIccStore *store, const gchar *prefix)
 	CdIcc *tmp;
 	const gchar *filename;
 	guint i;
+	g_autoptr(GPtrArray) filenames = g_ptr_array_new_with_free_func (g_free);
 
+	/* removing modifies the array */
 	for (i = 0; i < priv->icc_array->len; i++) {
 		tmp = g_ptr_array_index (priv->icc_array, i);
 		filename = cd_icc_get_filename (tmp);
-		if (g_str_has_prefix (filename, prefix)) {
-			g_debug ("auto-removed %s as path removed", prefix);
-			cd_icc_store_remove_icc (store, filename);
-		}
+		if (g_str_has_prefix (filename, prefix))
+			g_ptr_array_add (filenames, g_strdup (filename));
+	}
+	for (i = 0; i < filenames->len; i++) {
+		g_debug ("auto-removed %s as path removed", prefix);
+		cd_icc_store_remove_icc (store, g_ptr_array_index (filenames, i));
 	}
 }
 
@@ -298,9 +375,7 @@ cd_icc_store_file_monitor_changed_cb (GFileMonitor *monitor,
 				      GFileMonitorEvent event_type,
 				      CdIccStore *store)
 {
-	CdIccStorePrivate *priv = GET_PRIVATE (store);
 	CdIcc *tmp;
-	CdIccStoreDirHelper *helper;
 	g_autofree gchar *path = NULL;
 
 	/* icc was deleted */
@@ -319,11 +394,7 @@ cd_icc_store_file_monitor_changed_cb (GFileMonitor *monitor,
 
 		/* is a directory, urgh. Remove all ICCs there. */
 		cd_icc_store_remove_from_prefix (store, path);
-		helper = cd_icc_store_find_by_directory (store, path);
-		if (helper != NULL) {
-			g_ptr_array_remove (priv->directory_array,
-					    helper);
-		}
+		cd_icc_store_remove_directory (store, path);
 		return;
 	}
 
@@ -349,6 +420,354 @@ cd_icc_store_file_monitor_changed_cb (GFileMonitor *monitor,
 	}
 }
 
+#ifdef HAVE_FANOTIFY
+static GBytes *
+cd_icc_store_fanotify_key (const guint8 *fsid, const struct file_handle *fh)
+{
+	GByteArray *buf = g_byte_array_new ();
+
+	/* fsid, handle type and the opaque handle itself */
+	g_byte_array_append (buf, fsid, 8);
+	g_byte_array_append (buf, (const guint8 *) &fh->handle_type, sizeof (fh->handle_type));
+	g_byte_array_append (buf, fh->f_handle, fh->handle_bytes);
+	return g_byte_array_free_to_bytes (buf);
+}
+
+static GBytes *
+cd_icc_store_fanotify_get_handle (const gchar *path, GBytes **fsid)
+{
+	gint mount_id;
+	struct statfs buf;
+	g_autofree struct file_handle *fh = NULL;
+
+	if (statfs (path, &buf) != 0)
+		return NULL;
+	fh = g_malloc0 (sizeof (struct file_handle) + MAX_HANDLE_SZ);
+	fh->handle_bytes = MAX_HANDLE_SZ;
+	if (name_to_handle_at (AT_FDCWD, path, fh, &mount_id, 0) != 0)
+		return NULL;
+	*fsid = g_bytes_new (&buf.f_fsid, 8);
+	return cd_icc_store_fanotify_key ((const guint8 *) &buf.f_fsid, fh);
+}
+
+static gboolean
+cd_icc_store_fanotify_pending_cb (gpointer user_data)
+{
+	CdIccStore *store = CD_ICC_STORE (user_data);
+	CdIccStorePrivate *priv = GET_PRIVATE (store);
+	CdIccStoreDirHelper *helper;
+	GHashTableIter iter;
+	const gchar *path;
+	g_autoptr(GHashTable) pending = NULL;
+
+	/* new events may arrive while rescanning */
+	pending = g_steal_pointer (&priv->fanotify_pending);
+	priv->fanotify_pending = g_hash_table_new_full (g_str_hash, g_str_equal,
+							g_free, NULL);
+	priv->fanotify_pending_id = 0;
+
+	g_hash_table_iter_init (&iter, pending);
+	while (g_hash_table_iter_next (&iter, (gpointer *) &path, NULL)) {
+		helper = cd_icc_store_find_by_directory (store, path);
+		if (helper != NULL)
+			cd_icc_store_rescan_directory (store, helper);
+	}
+	return G_SOURCE_REMOVE;
+}
+
+static gboolean
+cd_icc_store_fanotify_cb (gint fd, GIOCondition condition, gpointer user_data)
+{
+	CdIccStore *store = CD_ICC_STORE (user_data);
+	CdIccStorePrivate *priv = GET_PRIVATE (store);
+	struct fanotify_event_metadata *md;
+	ssize_t len;
+	union {
+		struct fanotify_event_metadata md;
+		guint8 data[4096];
+	} buf;
+
+	while ((len = read (fd, buf.data, sizeof (buf.data))) > 0) {
+		for (md = &buf.md; FAN_EVENT_OK (md, len); md = FAN_EVENT_NEXT (md, len)) {
+			const struct fanotify_event_info_fid *fid;
+			const gchar *path;
+			g_autoptr(GBytes) key = NULL;
+
+			/* we lost events, so check everything */
+			if (md->mask & FAN_Q_OVERFLOW) {
+				GHashTableIter iter;
+				g_hash_table_iter_init (&iter, priv->directory_hash);
+				while (g_hash_table_iter_next (&iter, (gpointer *) &path, NULL))
+					g_hash_table_add (priv->fanotify_pending, g_strdup (path));
+				continue;
+			}
+
+			/* find the parent directory */
+			if (md->event_len < sizeof (*md) + sizeof (*fid))
+				continue;
+			fid = (const struct fanotify_event_info_fid *) (md + 1);
+			if (fid->hdr.info_type != FAN_EVENT_INFO_TYPE_DFID_NAME &&
+			    fid->hdr.info_type != FAN_EVENT_INFO_TYPE_DFID)
+				continue;
+			key = cd_icc_store_fanotify_key ((const guint8 *) &fid->fsid,
+							 (const struct file_handle *) fid->handle);
+			path = g_hash_table_lookup (priv->fanotify_handles, key);
+			if (path == NULL)
+				continue;
+			g_hash_table_add (priv->fanotify_pending, g_strdup (path));
+		}
+	}
+
+	/* coalesce bursts, e.g. when a package installs many profiles */
+	if (g_hash_table_size (priv->fanotify_pending) > 0 &&
+	    priv->fanotify_pending_id == 0) {
+		priv->fanotify_pending_id =
+			g_timeout_add (CD_ICC_STORE_FANOTIFY_DELAY,
+				       cd_icc_store_fanotify_pending_cb,
+				       store);
+	}
+	return G_SOURCE_CONTINUE;
+}
+
+static void
+cd_icc_store_fanotify_disable (CdIccStore *store)
+{
+	CdIccStorePrivate *priv = GET_PRIVATE (store);
+	priv->fanotify_failed = TRUE;
+	if (priv->fanotify_id != 0) {
+		g_source_remove (priv->fanotify_id);
+		priv->fanotify_id = 0;
+	}
+	if (priv->fanotify_fd != -1) {
+		g_close (priv->fanotify_fd, NULL);
+		priv->fanotify_fd = -1;
+	}
+}
+
+static gboolean
+cd_icc_store_fanotify_watch (CdIccStore *store, CdIccStoreDirHelper *helper)
+{
+	CdIccStorePrivate *priv = GET_PRIVATE (store);
+	g_autoptr(GBytes) fsid = NULL;
+	g_autoptr(GBytes) handle = NULL;
+
+	/* filesystem marks need CAP_SYS_ADMIN, so only try once */
+	if (priv->fanotify_failed)
+		return FALSE;
+	if (priv->fanotify_fd == -1) {
+		priv->fanotify_fd = fanotify_init (FAN_CLASS_NOTIF |
+						   FAN_CLOEXEC |
+						   FAN_NONBLOCK |
+						   FAN_REPORT_DFID_NAME,
+						   O_RDONLY);
+		if (priv->fanotify_fd == -1) {
+			g_debug ("CdIccStore: not using fanotify: %s",
+				 g_strerror (errno));
+			priv->fanotify_failed = TRUE;
+			return FALSE;
+		}
+		priv->fanotify_id = g_unix_fd_add (priv->fanotify_fd, G_IO_IN,
+						   cd_icc_store_fanotify_cb,
+						   store);
+	}
+
+	/* events are reported against the parent directory handle, which
+	 * is how the directories we do not care about are filtered out */
+	handle = cd_icc_store_fanotify_get_handle (helper->path, &fsid);
+	if (handle == NULL)
+		return FALSE;
+
+	/* one mark covers every directory on the filesystem */
+	if (!g_hash_table_contains (priv->fanotify_filesystems, fsid)) {
+		if (fanotify_mark (priv->fanotify_fd,
+				   FAN_MARK_ADD | FAN_MARK_FILESYSTEM,
+				   CD_ICC_STORE_FANOTIFY_MASK,
+				   AT_FDCWD, helper->path) != 0) {
+			g_debug ("CdIccStore: cannot mark filesystem of %s: %s",
+				 helper->path, g_strerror (errno));
+			if (errno == EPERM &&
+			    g_hash_table_size (priv->fanotify_filesystems) == 0)
+				cd_icc_store_fanotify_disable (store);
+			return FALSE;
+		}
+		g_hash_table_add (priv->fanotify_filesystems,
+				  g_steal_pointer (&fsid));
+	}
+	helper->handle = g_bytes_ref (handle);
+	g_hash_table_insert (priv->fanotify_handles,
+			     g_steal_pointer (&handle),
+			     g_strdup (helper->path));
+	return TRUE;
+}
+
+static void
+cd_icc_store_fanotify_unwatch (CdIccStore *store, CdIccStoreDirHelper *helper)
+{
+	CdIccStorePrivate *priv = GET_PRIVATE (store);
+
+	/* the filesystem mark is kept for the other directories */
+	g_hash_table_remove (priv->fanotify_handles, helper->handle);
+}
+#endif
+
+static void
+cd_icc_store_rescan_directory (CdIccStore *store, CdIccStoreDirHelper *helper)
+{
+	CdIccStorePrivate *priv = GET_PRIVATE (store);
+	CdIccStoreDirHelper *tmp;
+	GHashTableIter iter;
+	guint depth = helper->depth;
+	guint i;
+	g_autofree gchar *path = g_strdup (helper->path);
+	g_autoptr(GFile) file = g_file_new_for_path (path);
+	g_autoptr(GFileEnumerator) enumerator = NULL;
+	g_autoptr(GHashTable) present = NULL;
+	g_autoptr(GPtrArray) removed = g_ptr_array_new_with_free_func (g_free);
+	g_autoptr(GPtrArray) removed_dirs = g_ptr_array_new_with_free_func (g_free);
+
+	/* get contents of directory */
+	helper->mtime = cd_icc_store_get_mtime (path);
+	enumerator = g_file_enumerate_children (file,
+						G_FILE_ATTRIBUTE_STANDARD_NAME ","
+						G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE ","
+						G_FILE_ATTRIBUTE_STANDARD_TYPE,
+						G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+						NULL, NULL);
+	if (enumerator == NULL) {
+		/* the directory itself was removed */
+		cd_icc_store_remove_from_prefix (store, path);
+		cd_icc_store_remove_directory (store, path);
+		return;
+	}
+
+	/* add anything we do not already know about */
+	present = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	while (TRUE) {
+		g_autofree gchar *full_path = NULL;
+		g_autoptr(GError) error = NULL;
+		g_autoptr(GFileInfo) info = NULL;
+
+		info = g_file_enumerator_next_file (enumerator, NULL, NULL);
+		if (info == NULL)
+			break;
+		full_path = g_build_filename (path, g_file_info_get_name (info), NULL);
+		g_hash_table_add (present, g_strdup (full_path));
+		if (g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY) {
+			if (cd_icc_store_find_by_directory (store, full_path) != NULL)
+				continue;
+		} else {
+			g_autoptr(CdIcc) icc = NULL;
+			icc = cd_icc_store_find_by_filename (store, full_path);
+			if (icc != NULL)
+				continue;
+		}
+		if (!cd_icc_store_search_path_child (store, path, info,
+						     depth, NULL, &error)) {
+			g_debug ("failed to add %s: %s", full_path, error->message);
+		}
+	}
+
+	/* remove anything that has gone away */
+	for (i = 0; i < priv->icc_array->len; i++) {
+		const gchar *filename;
+		g_autofree gchar *dirname = NULL;
+		filename = cd_icc_get_filename (g_ptr_array_index (priv->icc_array, i));
+		dirname = g_path_get_dirname (filename);
+		if (g_strcmp0 (dirname, path) != 0)
+			continue;
+		if (!g_hash_table_contains (present, filename))
+			g_ptr_array_add (removed, g_strdup (filename));
+	}
+	for (i = 0; i < removed->len; i++)
+		cd_icc_store_remove_icc (store, g_ptr_array_index (removed, i));
+	g_hash_table_iter_init (&iter, priv->directory_hash);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &tmp)) {
+		g_autofree gchar *dirname = g_path_get_dirname (tmp->path);
+		if (g_strcmp0 (dirname, path) != 0)
+			continue;
+		if (!g_hash_table_contains (present, tmp->path))
+			g_ptr_array_add (removed_dirs, g_strdup (tmp->path));
+	}
+	for (i = 0; i < removed_dirs->len; i++) {
+		const gchar *tmp_path = g_ptr_array_index (removed_dirs, i);
+		g_autofree gchar *prefix = g_strconcat (tmp_path, G_DIR_SEPARATOR_S, NULL);
+		cd_icc_store_remove_from_prefix (store, prefix);
+		cd_icc_store_remove_directory (store, tmp_path);
+	}
+}
+
+static gboolean
+cd_icc_store_rescan_cb (gpointer user_data)
+{
+	CdIccStore *store = CD_ICC_STORE (user_data);
+	CdIccStorePrivate *priv = GET_PRIVATE (store);
+	CdIccStoreDirHelper *helper;
+	GHashTableIter iter;
+	guint i;
+	guint unwatched = 0;
+	g_autoptr(GPtrArray) changed = g_ptr_array_new_with_free_func (g_free);
+
+	/* only stat() the directories nothing is watching */
+	g_hash_table_iter_init (&iter, priv->directory_hash);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &helper)) {
+		if (helper->monitor != NULL || helper->handle != NULL)
+			continue;
+		unwatched++;
+		if (cd_icc_store_get_mtime (helper->path) != helper->mtime)
+			g_ptr_array_add (changed, g_strdup (helper->path));
+	}
+	for (i = 0; i < changed->len; i++) {
+		helper = cd_icc_store_find_by_directory (store, g_ptr_array_index (changed, i));
+		if (helper != NULL)
+			cd_icc_store_rescan_directory (store, helper);
+	}
+	if (unwatched == 0) {
+		priv->rescan_id = 0;
+		return G_SOURCE_REMOVE;
+	}
+	return G_SOURCE_CONTINUE;
+}
+
+static gboolean
+cd_icc_store_watch_directory (CdIccStore *store,
+			      CdIccStoreDirHelper *helper,
+			      GError **error)
+{
+	CdIccStorePrivate *priv = GET_PRIVATE (store);
+	g_autoptr(GFile) file = NULL;
+
+#ifdef HAVE_FANOTIFY
+	/* a filesystem mark does not use a watch for each directory */
+	if (cd_icc_store_fanotify_watch (store, helper))
+		return TRUE;
+#endif
+
+	/* use a kernel watch while we are under budget */
+	if (priv->watch_count < priv->max_watches) {
+		file = g_file_new_for_path (helper->path);
+		helper->monitor = g_file_monitor_directory (file,
+							    G_FILE_MONITOR_NONE,
+							    NULL,
+							    error);
+		if (helper->monitor == NULL)
+			return FALSE;
+		g_signal_connect (helper->monitor, "changed",
+				  G_CALLBACK(cd_icc_store_file_monitor_changed_cb),
+				  store);
+		priv->watch_count++;
+		return TRUE;
+	}
+
+	/* fall back to checking the mtime periodically */
+	helper->mtime = cd_icc_store_get_mtime (helper->path);
+	if (priv->rescan_id == 0) {
+		priv->rescan_id = g_timeout_add_seconds (priv->rescan_interval,
+							 cd_icc_store_rescan_cb,
+							 store);
+	}
+	return TRUE;
+}
+
 static gboolean
 cd_icc_store_search_path_child (CdIccStore *store,
 				const gchar *path,
@@ -416,24 +835,18 @@ cd_icc_store_search_path (CdIccStore *store,
 		return FALSE;
 	}
 
-	/* add an inotify watch if not already added */
+	/* watch the directory if not already added */
 	file = g_file_new_for_path (path);
 	helper = cd_icc_store_find_by_directory (store, path);
 	if (helper == NULL) {
 		helper = g_new0 (CdIccStoreDirHelper, 1);
 		helper->path = g_strdup (path);
-		helper->monitor = g_file_monitor_directory (file,
-							    G_FILE_MONITOR_NONE,
-							    NULL,
-							    error);
-		if (helper->monitor == NULL) {
+		helper->depth = depth;
+		if (!cd_icc_store_watch_directory (store, helper, error)) {
 			cd_icc_store_helper_free (helper);
 			return FALSE;
 		}
-		g_signal_connect (helper->monitor, "changed",
-				  G_CALLBACK(cd_icc_store_file_monitor_changed_cb),
-				  store);
-		g_ptr_array_add (priv->directory_array, helper);
+		g_hash_table_insert (priv->directory_hash, helper->path, helper);
 	}
 
 	/* get contents of directory */
@@ -445,9 +858,7 @@ cd_icc_store_search_path (CdIccStore *store,
 						cancellable,
 						error);
 	if (enumerator == NULL) {
-		helper = cd_icc_store_find_by_directory (store, path);
-		if (helper != NULL)
-			g_ptr_array_remove (priv->directory_array, helper);
+		cd_icc_store_remove_directory (store, path);
 		return FALSE;
 	}
 
@@ -513,6 +924,80 @@ cd_icc_store_get_load_flags (CdIccStore *store)
 	return priv->load_flags;
 }
 
+/**
+ * cd_icc_store_set_max_watches:
+ * @store: a #CdIccStore instance.
+ * @max_watches: the maximum number of inotify watches, e.g. 64
+ *
+ * Sets the maximum number of directories that get a dedicated inotify
+ * watch. Any further directories are checked every rescan interval.
+ * This only affects directories added after this call.
+ *
+ * Since: 1.4.8
+ **/
+void
+cd_icc_store_set_max_watches (CdIccStore *store, guint max_watches)
+{
+	CdIccStorePrivate *priv = GET_PRIVATE (store);
+	g_return_if_fail (CD_IS_ICC_STORE (store));
+	priv->max_watches = max_watches;
+}
+
+/**
+ * cd_icc_store_get_max_watches:
+ * @store: a #CdIccStore instance.
+ *
+ * Gets the maximum number of inotify watches.
+ *
+ * Return value: the maximum number of watches
+ *
+ * Since: 1.4.8
+ **/
+guint
+cd_icc_store_get_max_watches (CdIccStore *store)
+{
+	CdIccStorePrivate *priv = GET_PRIVATE (store);
+	g_return_val_if_fail (CD_IS_ICC_STORE (store), 0);
+	return priv->max_watches;
+}
+
+/**
+ * cd_icc_store_set_rescan_interval:
+ * @store: a #CdIccStore instance.
+ * @rescan_interval: the interval in seconds, e.g. 30
+ *
+ * Sets how often unwatched directories are checked for changes.
+ * This only affects directories added after this call.
+ *
+ * Since: 1.4.8
+ **/
+void
+cd_icc_store_set_rescan_interval (CdIccStore *store, guint rescan_interval)
+{
+	CdIccStorePrivate *priv = GET_PRIVATE (store);
+	g_return_if_fail (CD_IS_ICC_STORE (store));
+	g_return_if_fail (rescan_interval > 0);
+	priv->rescan_interval = rescan_interval;
+}
+
+/**
+ * cd_icc_store_get_watch_count:
+ * @store: a #CdIccStore instance.
+ *
+ * Gets the number of kernel watch descriptors in use by the store.
+ *
+ * Return value: the number of watches
+ *
+ * Since: 1.4.8
+ **/
+guint
+cd_icc_store_get_watch_count (CdIccStore *store)
+{
+	CdIccStorePrivate *priv = GET_PRIVATE (store);
+	g_return_val_if_fail (CD_IS_ICC_STORE (store), 0);
+	return priv->watch_count;
+}
+
 /**
  * cd_icc_store_set_cache:
  * @store: a #CdIccStore instance.
@@ -703,7 +1188,19 @@ cd_icc_store_init (CdIccStore *store)
 	CdIccStorePrivate *priv = GET_PRIVATE (store);
 	priv->load_flags = CD_ICC_LOAD_FLAGS_FALLBACK_MD5;
 	priv->icc_array = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
-	priv->directory_array = g_ptr_array_new_with_free_func ((GDestroyNotify) cd_icc_store_helper_free);
+	priv->directory_hash = g_hash_table_new_full (g_str_hash, g_str_equal,
+						      NULL, (GDestroyNotify) cd_icc_store_helper_free);
+	priv->max_watches = CD_ICC_STORE_MAX_WATCHES_DEFAULT;
+	priv->rescan_interval = CD_ICC_STORE_RESCAN_INTERVAL_DEFAULT;
+	priv->fanotify_fd = -1;
+	priv->fanotify_handles = g_hash_table_new_full (g_bytes_hash, g_bytes_equal,
+							(GDestroyNotify) g_bytes_unref,
+							g_free);
+	priv->fanotify_filesystems = g_hash_table_new_full (g_bytes_hash, g_bytes_equal,
+							    (GDestroyNotify) g_bytes_unref,
+							    NULL);
+	priv->fanotify_pending = g_hash_table_new_full (g_str_hash, g_str_equal,
+							g_free, NULL);
 }
 
 static void
@@ -712,8 +1209,19 @@ cd_icc_store_finalize (GObject *object)
 	CdIccStore *store = CD_ICC_STORE (object);
 	CdIccStorePrivate *priv = GET_PRIVATE (store);
 
+	if (priv->rescan_id != 0)
+		g_source_remove (priv->rescan_id);
+	if (priv->fanotify_pending_id != 0)
+		g_source_remove (priv->fanotify_pending_id);
+	if (priv->fanotify_id != 0)
+		g_source_remove (priv->fanotify_id);
+	if (priv->fanotify_fd != -1)
+		g_close (priv->fanotify_fd, NULL);
 	g_ptr_array_unref (priv->icc_array);
-	g_ptr_array_unref (priv->directory_array);
+	g_hash_table_unref (priv->directory_hash);
+	g_hash_table_unref (priv->fanotify_handles);
+	g_hash_table_unref (priv->fanotify_filesystems);
+	g_hash_table_unref (priv->fanotify_pending);
 	if (priv->cache != NULL)
 		g_resource_unref (priv->cache);
 
@@ -97,6 +97,12 @@ CdIcc		*cd_icc_store_find_by_filename	(CdIccStore	*store,
 						 const gchar	*filename);
 CdIcc		*cd_icc_store_find_by_checksum	(CdIccStore	*store,
 						 const gchar	*checksum);
+void		 cd_icc_store_set_max_watches	(CdIccStore	*store,
+						 guint		 max_watches);
+guint		 cd_icc_store_get_max_watches	(CdIccStore	*store);
+void		 cd_icc_store_set_rescan_interval (CdIccStore	*store,
+						 guint		 rescan_interval);
+guint		 cd_icc_store_get_watch_count	(CdIccStore	*store);
 
 G_END_DECLS
 
@@ -31,6 +31,7 @@
 
 #include <glib-object.h>
 #include <lcms2.h>
+#include <string.h>
 
 #include "cd-icc-utils.h"
 
@@ -69,6 +70,11 @@ cd_icc_utils_get_coverage_calc (CdIcc *icc,
 	g_autofree cmsFloat32Number *data = NULL;
 	g_autofree cmsUInt16Number *alarm_codes = NULL;
 
+	/* set gamut alarm to 0xffff for this context only */
+	alarm_codes = g_new0 (cmsUInt16Number, cmsMAXCHANNELS);
+	alarm_codes[0] = 0xffff;
+	cmsSetAlarmCodesTHR (cd_icc_get_context (icc), alarm_codes);
+
 	/* create a proofing transform with gamut check */
 	profile_null = cmsCreateNULLProfileTHR (cd_icc_get_context (icc));
 	transform = cmsCreateProofingTransformTHR (cd_icc_get_context (icc),
@@ -92,11 +98,6 @@ cd_icc_utils_get_coverage_calc (CdIcc *icc,
 		goto out;
 	}
 
-	/* set gamut alarm to 0xffff */
-	alarm_codes = g_new0 (cmsUInt16Number, cmsMAXCHANNELS);
-	alarm_codes[0] = 0xffff;
-	cmsSetAlarmCodes (alarm_codes);
-
 	/* slice profile in regular intervals */
 	data = g_new0 (cmsFloat32Number, data_len * 3);
 	helper.data = data;
@@ -296,3 +297,124 @@ cd_icc_utils_get_adaptation_matrix (CdIcc *icc,
 
 	return cd_mat33_is_finite (mat, error);
 }
+
+/**
+ * cd_icc_utils_embed_profile_id:
+ * @data: (array length=data_len): ICC profile data
+ * @data_len: Length of @data
+ * @error: A #GError or %NULL
+ *
+ * Writes the ICC profile ID into the header of @data if it is not already
+ * set. The ID is the MD5 of the profile with the flags, rendering intent and
+ * profile ID fields set to zero, as defined in the ICC specification.
+ *
+ * Once set, the checksum of the profile can be read from the header rather
+ * than computed from the whole file each time the profile is loaded. This
+ * changes the checksum of a profile that had no ID, and with it the colord
+ * profile ID, so callers have to opt in.
+ *
+ * Return value: TRUE for success
+ *
+ * Since: 1.4.8
+ **/
+gboolean
+cd_icc_utils_embed_profile_id (guint8 *data, gsize data_len, GError **error)
+{
+	gsize digest_len = 16;
+	guint8 header[100];
+	guint i;
+	guint32 size;
+	g_autoptr(GChecksum) checksum = NULL;
+
+	g_return_val_if_fail (data != NULL, FALSE);
+
+	/* ensure we have the header */
+	if (data_len < 0x84) {
+		g_set_error_literal (error,
+				     CD_ICC_ERROR,
+				     CD_ICC_ERROR_FAILED_TO_PARSE,
+				     "icc was not valid (file size too small)");
+		return FALSE;
+	}
+
+	/* already set */
+	for (i = 84; i < 100; i++) {
+		if (data[i] != 0)
+			return TRUE;
+	}
+
+	/* do not trust a profile that lies about its size */
+	memcpy (&size, data, sizeof (size));
+	if (GUINT32_FROM_BE (size) != data_len) {
+		g_set_error (error,
+			     CD_ICC_ERROR,
+			     CD_ICC_ERROR_FAILED_TO_PARSE,
+			     "icc size %u does not match data length %" G_GSIZE_FORMAT,
+			     GUINT32_FROM_BE (size), data_len);
+		return FALSE;
+	}
+
+	/* hash the profile with flags, intent and ID cleared */
+	memcpy (header, data, sizeof (header));
+	memset (header + 44, 0, 4);
+	memset (header + 64, 0, 4);
+	checksum = g_checksum_new (G_CHECKSUM_MD5);
+	g_checksum_update (checksum, header, sizeof (header));
+	g_checksum_update (checksum, data + sizeof (header), data_len - sizeof (header));
+	g_checksum_get_digest (checksum, data + 84, &digest_len);
+	return TRUE;
+}
+
+/**
+ * cd_icc_utils_embed_profile_id_file:
+ * @file: a #GFile
+ * @cancellable: A #GCancellable or %NULL
+ * @error: A #GError or %NULL
+ *
+ * Writes the ICC profile ID into the header of @file if it is not already
+ * set, replacing the file atomically. Only the header is read if the
+ * profile already has an ID.
+ *
+ * Return value: TRUE for success
+ *
+ * Since: 1.4.8
+ **/
+gboolean
+cd_icc_utils_embed_profile_id_file (GFile *file,
+				    GCancellable *cancellable,
+				    GError **error)
+{
+	gsize data_len = 0;
+	gsize header_len = 0;
+	guint8 header[100];
+	guint i;
+	g_autofree gchar *data = NULL;
+	g_autoptr(GFileInputStream) stream = NULL;
+
+	g_return_val_if_fail (G_IS_FILE (file), FALSE);
+
+	/* check the profile ID from the header */
+	stream = g_file_read (file, cancellable, error);
+	if (stream == NULL)
+		return FALSE;
+	if (!g_input_stream_read_all (G_INPUT_STREAM (stream),
+				      header, sizeof (header), &header_len,
+				      cancellable, error))
+		return FALSE;
+	if (header_len == sizeof (header)) {
+		for (i = 84; i < 100; i++) {
+			if (header[i] != 0)
+				return TRUE;
+		}
+	}
+	g_clear_object (&stream);
+
+	/* add the ID and write it back */
+	if (!g_file_load_contents (file, cancellable, &data, &data_len, NULL, error))
+		return FALSE;
+	if (!cd_icc_utils_embed_profile_id ((guint8 *) data, data_len, error))
+		return FALSE;
+	return g_file_replace_contents (file, data, data_len, NULL, FALSE,
+					G_FILE_CREATE_NONE, NULL,
+					cancellable, error);
+}
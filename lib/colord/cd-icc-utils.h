@@ -44,6 +44,13 @@ gboolean	cd_icc_utils_get_adaptation_matrix (CdIcc		*icc,
 						    CdMat3x3		*out,
 						    GError		**error);
 
+gboolean	 cd_icc_utils_embed_profile_id		(guint8		*data,
+							 gsize		 data_len,
+							 GError		**error);
+gboolean	 cd_icc_utils_embed_profile_id_file	(GFile		*file,
+							 GCancellable	*cancellable,
+							 GError		**error);
+
 G_END_DECLS
 
 #endif /* __CD_ICC_UTILS_H__ */
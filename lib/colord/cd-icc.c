@@ -72,6 +72,7 @@ typedef struct
 	gchar			*characterization_data;
 	gdouble			 version;
 	GHashTable		*mluc_data[CD_MLUC_LAST]; /* key is 'en_GB' or '' for default */
+	GMutex			 mluc_mutex;	/* the getters fill mluc_data lazily */
 	GHashTable		*metadata;
 	gint64			 creation_time;
 	guint32			 size;
@@ -1213,6 +1214,114 @@ cd_icc_load_data (CdIcc *icc,
 	return TRUE;
 }
 
+/* shared instances for cd_icc_new_interned(), keyed by the profile data */
+typedef struct {
+	GBytes		*data;
+	GWeakRef	 icc;
+	gpointer	 icc_ptr;
+	CdIccLoadFlags	 flags;
+} CdIccInternEntry;
+
+static GHashTable *cd_icc_intern_table = NULL;	/* GBytes:CdIccInternEntry */
+G_LOCK_DEFINE_STATIC (cd_icc_intern_table);
+
+static void
+cd_icc_intern_entry_free (CdIccInternEntry *entry)
+{
+	g_weak_ref_clear (&entry->icc);
+	g_bytes_unref (entry->data);
+	g_free (entry);
+}
+
+static void
+cd_icc_intern_weak_notify_cb (gpointer data, GObject *where_the_object_was)
+{
+	GBytes *key = (GBytes *) data;
+	CdIccInternEntry *entry;
+
+	/* only remove the entry if it was not replaced in the meantime */
+	G_LOCK (cd_icc_intern_table);
+	entry = g_hash_table_lookup (cd_icc_intern_table, key);
+	if (entry != NULL && entry->icc_ptr == where_the_object_was)
+		g_hash_table_remove (cd_icc_intern_table, key);
+	G_UNLOCK (cd_icc_intern_table);
+	g_bytes_unref (key);
+}
+
+/**
+ * cd_icc_new_interned:
+ * @data: (array length=data_len): binary data
+ * @data_len: Length of @data
+ * @flags: a set of #CdIccLoadFlags
+ * @error: A #GError or %NULL
+ *
+ * Loads an ICC profile from raw byte data, returning an existing object if
+ * byte-identical data has already been loaded by this process.
+ *
+ * This is useful for image decoders where many files carry the same
+ * embedded profile. The returned object is shared between threads, so only
+ * the cd_icc_get_*() functions may be used on it; it must not be modified
+ * or saved. It is removed from the table when the last reference is dropped.
+ *
+ * Return value: (transfer full): a #CdIcc, or %NULL for error
+ *
+ * Since: 1.4.8
+ **/
+CdIcc *
+cd_icc_new_interned (const guint8 *data,
+		     gsize data_len,
+		     CdIccLoadFlags flags,
+		     GError **error)
+{
+	CdIcc *icc = NULL;
+	CdIccInternEntry *entry;
+	g_autoptr(CdIcc) icc_new = NULL;
+	g_autoptr(GBytes) key = NULL;
+
+	g_return_val_if_fail (data != NULL, NULL);
+
+	/* the key does not copy the data, as this is the fast path */
+	key = g_bytes_new_static (data, data_len);
+	G_LOCK (cd_icc_intern_table);
+	if (cd_icc_intern_table == NULL) {
+		cd_icc_intern_table = g_hash_table_new_full (g_bytes_hash,
+							     g_bytes_equal,
+							     NULL,
+							     (GDestroyNotify) cd_icc_intern_entry_free);
+	}
+	entry = g_hash_table_lookup (cd_icc_intern_table, key);
+	if (entry != NULL && (flags & ~entry->flags) == 0)
+		icc = g_weak_ref_get (&entry->icc);
+	G_UNLOCK (cd_icc_intern_table);
+	if (icc != NULL)
+		return icc;
+
+	/* parse outside the lock */
+	icc_new = cd_icc_new ();
+	if (!cd_icc_load_data (icc_new, data, data_len, flags, error))
+		return NULL;
+
+	/* another thread may have got there first */
+	G_LOCK (cd_icc_intern_table);
+	entry = g_hash_table_lookup (cd_icc_intern_table, key);
+	if (entry != NULL && (flags & ~entry->flags) == 0)
+		icc = g_weak_ref_get (&entry->icc);
+	if (icc == NULL) {
+		entry = g_new0 (CdIccInternEntry, 1);
+		entry->data = g_bytes_new (data, data_len);
+		entry->flags = flags;
+		entry->icc_ptr = icc_new;
+		g_weak_ref_init (&entry->icc, icc_new);
+		g_hash_table_replace (cd_icc_intern_table, entry->data, entry);
+		g_object_weak_ref (G_OBJECT (icc_new),
+				   cd_icc_intern_weak_notify_cb,
+				   g_bytes_ref (entry->data));
+		icc = g_steal_pointer (&icc_new);
+	}
+	G_UNLOCK (cd_icc_intern_table);
+	return icc;
+}
+
 static gboolean
 cd_util_write_dict_entry (cmsHANDLE dict,
 			  const gchar *key,
@@ -2556,6 +2665,7 @@ cd_icc_get_mluc_data (CdIcc *icc,
 	g_return_val_if_fail (CD_IS_ICC (icc), NULL);
 
 	/* does cache entry exist already? */
+	g_mutex_lock (&priv->mluc_mutex);
 	locale_key = cd_icc_get_locale_key (locale);
 	value = g_hash_table_lookup (priv->mluc_data[mluc], locale_key);
 	if (value != NULL)
@@ -2640,6 +2750,7 @@ cd_icc_get_mluc_data (CdIcc *icc,
 			     tmp);
 	value = tmp;
 out:
+	g_mutex_unlock (&priv->mluc_mutex);
 	return value;
 }
 
@@ -2764,9 +2875,11 @@ cd_icc_set_description (CdIcc *icc, const gchar *locale, const gchar *value)
 {
 	CdIccPrivate *priv = GET_PRIVATE (icc);
 	g_return_if_fail (value == NULL || g_utf8_validate (value, -1, NULL));
+	g_mutex_lock (&priv->mluc_mutex);
 	g_hash_table_insert (priv->mluc_data[CD_MLUC_DESCRIPTION],
 			     cd_icc_get_locale_key (locale),
 			     g_strdup (value));
+	g_mutex_unlock (&priv->mluc_mutex);
 }
 
 /**
@@ -2812,9 +2925,11 @@ cd_icc_set_copyright (CdIcc *icc, const gchar *locale, const gchar *value)
 {
 	CdIccPrivate *priv = GET_PRIVATE (icc);
 	g_return_if_fail (value == NULL || g_utf8_validate (value, -1, NULL));
+	g_mutex_lock (&priv->mluc_mutex);
 	g_hash_table_insert (priv->mluc_data[CD_MLUC_COPYRIGHT],
 			     cd_icc_get_locale_key (locale),
 			     g_strdup (value));
+	g_mutex_unlock (&priv->mluc_mutex);
 }
 
 /**
@@ -2860,9 +2975,11 @@ cd_icc_set_manufacturer (CdIcc *icc, const gchar *locale, const gchar *value)
 {
 	CdIccPrivate *priv = GET_PRIVATE (icc);
 	g_return_if_fail (value == NULL || g_utf8_validate (value, -1, NULL));
+	g_mutex_lock (&priv->mluc_mutex);
 	g_hash_table_insert (priv->mluc_data[CD_MLUC_MANUFACTURER],
 			     cd_icc_get_locale_key (locale),
 			     g_strdup (value));
+	g_mutex_unlock (&priv->mluc_mutex);
 }
 
 /**
@@ -2908,9 +3025,11 @@ cd_icc_set_model (CdIcc *icc, const gchar *locale, const gchar *value)
 {
 	CdIccPrivate *priv = GET_PRIVATE (icc);
 	g_return_if_fail (value == NULL || g_utf8_validate (value, -1, NULL));
+	g_mutex_lock (&priv->mluc_mutex);
 	g_hash_table_insert (priv->mluc_data[CD_MLUC_MODEL],
 			     cd_icc_get_locale_key (locale),
 			     g_strdup (value));
+	g_mutex_unlock (&priv->mluc_mutex);
 }
 
 /**
@@ -4059,6 +4178,7 @@ cd_icc_init (CdIcc *icc)
 								 g_free,
 								 g_free);
 	}
+	g_mutex_init (&priv->mluc_mutex);
 	cd_color_xyz_clear (&priv->white);
 	cd_color_xyz_clear (&priv->red);
 	cd_color_xyz_clear (&priv->green);
@@ -4079,6 +4199,7 @@ cd_icc_finalize (GObject *object)
 	g_hash_table_destroy (priv->metadata);
 	for (i = 0; i < CD_MLUC_LAST; i++)
 		g_hash_table_destroy (priv->mluc_data[i]);
+	g_mutex_clear (&priv->mluc_mutex);
 	if (priv->lcms_profile != NULL)
 		cmsCloseProfile (priv->lcms_profile);
 	cd_context_lcms_free (priv->context_lcms);
@@ -130,6 +130,11 @@ typedef enum {
 
 GQuark		 cd_icc_error_quark			(void);
 CdIcc		*cd_icc_new				(void);
+CdIcc		*cd_icc_new_interned			(const guint8	*data,
+							 gsize		 data_len,
+							 CdIccLoadFlags	 flags,
+							 GError		**error)
+							 G_GNUC_WARN_UNUSED_RESULT;
 
 gboolean	 cd_icc_load_data			(CdIcc		*icc,
 							 const guint8	*data,
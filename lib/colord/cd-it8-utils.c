@@ -225,6 +225,271 @@ cd_it8_utils_calculate_ccmx (CdIt8 *it8_reference,
 	return TRUE;
 }
 
+/* the XYZ of each patch, packed as rows for cd_math_solve_least_squares() */
+static gdouble *
+cd_it8_utils_get_xyz_rows (CdIt8 *it8, guint *len)
+{
+	CdColorXYZ xyz;
+	gdouble *rows;
+
+	*len = cd_it8_get_data_size (it8);
+	rows = g_new (gdouble, *len * 3);
+	for (guint i = 0; i < *len; i++) {
+		cd_it8_get_data_item (it8, i, NULL, &xyz);
+		rows[i * 3 + 0] = xyz.X;
+		rows[i * 3 + 1] = xyz.Y;
+		rows[i * 3 + 2] = xyz.Z;
+	}
+	return rows;
+}
+
+static gboolean
+cd_it8_utils_calculate_ccmx_lsq_internal (const gdouble *xyz_ref,
+					  const gdouble *xyz_meas,
+					  const gdouble *weights,
+					  guint len,
+					  CdMat3x3 *calibration,
+					  CdCcmxResidual *residual,
+					  GError **error)
+{
+	cmsCIEXYZ white = { 0.f, 0.f, 0.f };
+	gdouble *data = cd_mat33_get_data (calibration);
+	gdouble x[9];
+	gdouble de_sum = 0.f;
+	gdouble weight_sum = 0.f;
+
+	/* solve XYZ_meas.M^T = XYZ_ref for all patches at once */
+	if (!cd_math_solve_least_squares (xyz_meas, xyz_ref, weights,
+					  len, 3, 3, x, error))
+		return FALSE;
+	for (guint r = 0; r < 3; r++) {
+		for (guint c = 0; c < 3; c++)
+			data[r * 3 + c] = x[c * 3 + r];
+	}
+	if (!cd_mat33_is_finite (calibration, error))
+		return FALSE;
+	if (residual == NULL)
+		return TRUE;
+
+	/* the brightest reference patch is the white point for the residuals */
+	for (guint i = 0; i < len; i++) {
+		if (xyz_ref[i * 3 + 1] > white.Y) {
+			white.X = xyz_ref[i * 3 + 0];
+			white.Y = xyz_ref[i * 3 + 1];
+			white.Z = xyz_ref[i * 3 + 2];
+		}
+	}
+	if (white.Y <= 0.f) {
+		g_set_error_literal (error, 1, 0,
+				     "no reference patch has a luminance");
+		return FALSE;
+	}
+
+	/* CIEDE2000 between the reference and the corrected measurement */
+	residual->delta_e_max = 0.f;
+	for (guint i = 0; i < len; i++) {
+		CdVec3 meas;
+		CdVec3 corrected;
+		cmsCIEXYZ tmp;
+		cmsCIELab lab_ref;
+		cmsCIELab lab_corrected;
+		gdouble de;
+		gdouble weight = weights != NULL ? weights[i] : 1.f;
+
+		tmp.X = xyz_ref[i * 3 + 0];
+		tmp.Y = xyz_ref[i * 3 + 1];
+		tmp.Z = xyz_ref[i * 3 + 2];
+		cmsXYZ2Lab (&white, &lab_ref, &tmp);
+		cd_vec3_init (&meas,
+			      xyz_meas[i * 3 + 0],
+			      xyz_meas[i * 3 + 1],
+			      xyz_meas[i * 3 + 2]);
+		cd_mat33_vector_multiply (calibration, &meas, &corrected);
+		tmp.X = corrected.v0;
+		tmp.Y = corrected.v1;
+		tmp.Z = corrected.v2;
+		cmsXYZ2Lab (&white, &lab_corrected, &tmp);
+		de = cmsCIE2000DeltaE (&lab_ref, &lab_corrected, 1.f, 1.f, 1.f);
+		if (weight > 0.f)
+			residual->delta_e_max = MAX (residual->delta_e_max, de);
+		de_sum += de * weight;
+		weight_sum += weight;
+	}
+	residual->delta_e_mean = weight_sum > 0.f ? de_sum / weight_sum : 0.f;
+	return TRUE;
+}
+
+/**
+ * cd_it8_utils_calculate_ccmx_lsq:
+ * @it8_reference: The reference data
+ * @it8_measured: The measured data, with the same patches as @it8_reference
+ * @weights: (allow-none): the weight of each patch, or %NULL for all equal
+ * @it8_ccmx: The calculated correction matrix
+ * @residual: (out) (allow-none): the remaining error, or %NULL
+ * @error: A #GError, or %NULL
+ *
+ * This calculates the colorimeter correction matrix that minimizes the
+ * weighted squared XYZ error over all the patches. Unlike
+ * cd_it8_utils_calculate_ccmx() any number of patches of any color can be
+ * used, which makes the result much less sensitive to noise in a single
+ * reading.
+ *
+ * As the error is absolute the brightest patches dominate the fit unless
+ * the weights are set to compensate, for instance using 1/Y².
+ *
+ * Return value: %TRUE if a correction matrix was found.
+ *
+ * Since: 1.4.8
+ **/
+gboolean
+cd_it8_utils_calculate_ccmx_lsq (CdIt8 *it8_reference,
+				 CdIt8 *it8_measured,
+				 const gdouble *weights,
+				 CdIt8 *it8_ccmx,
+				 CdCcmxResidual *residual,
+				 GError **error)
+{
+	CdMat3x3 calibration;
+	guint len_meas;
+	guint len_ref;
+	g_autofree gchar *tmp = NULL;
+	g_autofree gdouble *xyz_meas = NULL;
+	g_autofree gdouble *xyz_ref = NULL;
+
+	g_return_val_if_fail (CD_IS_IT8 (it8_reference), FALSE);
+	g_return_val_if_fail (CD_IS_IT8 (it8_measured), FALSE);
+	g_return_val_if_fail (CD_IS_IT8 (it8_ccmx), FALSE);
+
+	/* the patches are paired by index */
+	xyz_ref = cd_it8_utils_get_xyz_rows (it8_reference, &len_ref);
+	xyz_meas = cd_it8_utils_get_xyz_rows (it8_measured, &len_meas);
+	if (len_ref != len_meas) {
+		g_set_error (error, 1, 0,
+			     "reference has %u patches, measured has %u",
+			     len_ref, len_meas);
+		return FALSE;
+	}
+	if (!cd_it8_utils_calculate_ccmx_lsq_internal (xyz_ref, xyz_meas,
+						       weights, len_ref,
+						       &calibration, residual,
+						       error))
+		return FALSE;
+	tmp = cd_mat33_to_string (&calibration);
+	g_debug ("device calibration = %s", tmp);
+
+	/* save to ccmx file */
+	cd_it8_set_matrix (it8_ccmx, &calibration);
+	cd_it8_set_instrument (it8_ccmx, cd_it8_get_instrument (it8_measured));
+	cd_it8_set_reference (it8_ccmx, cd_it8_get_instrument (it8_reference));
+	return TRUE;
+}
+
+/**
+ * cd_it8_utils_calculate_ccmx_lsq_array:
+ * @references: (element-type CdIt8): The reference data
+ * @measured: (element-type CdIt8): The measured data for each reference
+ * @weights: (element-type GArray) (allow-none): the patch weights for
+ *  each pair as an array of doubles, or %NULL for all equal
+ * @residuals: (element-type CdCcmxResidual) (allow-none): an array to
+ *  append the remaining error of each fit to, or %NULL
+ * @error: A #GError, or %NULL
+ *
+ * This calculates a least-squares correction matrix for each pair of
+ * reference and measured data, as cd_it8_utils_calculate_ccmx_lsq() does.
+ * An entry of @weights may be %NULL to weight the patches of that pair
+ * equally. The same reference may be used in more than one
+ * pair, for instance when correcting a number of colorimeters against
+ * one spectrometer, and its patches are only read once.
+ *
+ * Return value: (transfer container) (element-type CdIt8): the CCMX
+ *  for each pair, or %NULL for error
+ *
+ * Since: 1.4.8
+ **/
+GPtrArray *
+cd_it8_utils_calculate_ccmx_lsq_array (GPtrArray *references,
+				       GPtrArray *measured,
+				       GPtrArray *weights,
+				       GArray *residuals,
+				       GError **error)
+{
+	CdIt8 *it8_ref_last = NULL;
+	guint len_ref = 0;
+	g_autofree gdouble *xyz_ref = NULL;
+	g_autoptr(GPtrArray) results = NULL;
+
+	g_return_val_if_fail (references != NULL, NULL);
+	g_return_val_if_fail (measured != NULL, NULL);
+
+	if (references->len != measured->len) {
+		g_set_error (error, 1, 0,
+			     "got %u references for %u measurements",
+			     references->len, measured->len);
+		return NULL;
+	}
+	if (weights != NULL && weights->len != measured->len) {
+		g_set_error (error, 1, 0,
+			     "got %u sets of weights for %u measurements",
+			     weights->len, measured->len);
+		return NULL;
+	}
+
+	results = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	for (guint i = 0; i < measured->len; i++) {
+		CdIt8 *it8_ref = g_ptr_array_index (references, i);
+		CdIt8 *it8_meas = g_ptr_array_index (measured, i);
+		CdCcmxResidual residual;
+		GArray *weights_pair = NULL;
+		CdMat3x3 calibration;
+		guint len_meas;
+		g_autofree gdouble *xyz_meas = NULL;
+		g_autoptr(CdIt8) it8_ccmx = NULL;
+		g_autoptr(GError) error_local = NULL;
+
+		/* only re-read the reference if it changed */
+		if (it8_ref != it8_ref_last) {
+			g_free (xyz_ref);
+			xyz_ref = cd_it8_utils_get_xyz_rows (it8_ref, &len_ref);
+			it8_ref_last = it8_ref;
+		}
+		xyz_meas = cd_it8_utils_get_xyz_rows (it8_meas, &len_meas);
+		if (len_ref != len_meas) {
+			g_set_error (error, 1, 0,
+				     "pair %u: reference has %u patches, measured has %u",
+				     i, len_ref, len_meas);
+			return NULL;
+		}
+		if (weights != NULL)
+			weights_pair = g_ptr_array_index (weights, i);
+		if (weights_pair != NULL && weights_pair->len != len_ref) {
+			g_set_error (error, 1, 0,
+				     "pair %u: got %u weights for %u patches",
+				     i, weights_pair->len, len_ref);
+			return NULL;
+		}
+		if (!cd_it8_utils_calculate_ccmx_lsq_internal (xyz_ref, xyz_meas,
+							       weights_pair != NULL ?
+							       (const gdouble *) weights_pair->data : NULL,
+							       len_ref,
+							       &calibration,
+							       residuals != NULL ? &residual : NULL,
+							       &error_local)) {
+			g_set_error (error, 1, 0,
+				     "pair %u: %s", i, error_local->message);
+			return NULL;
+		}
+		if (residuals != NULL)
+			g_array_append_val (residuals, residual);
+
+		it8_ccmx = cd_it8_new_with_kind (CD_IT8_KIND_CCMX);
+		cd_it8_set_matrix (it8_ccmx, &calibration);
+		cd_it8_set_instrument (it8_ccmx, cd_it8_get_instrument (it8_meas));
+		cd_it8_set_reference (it8_ccmx, cd_it8_get_instrument (it8_ref));
+		g_ptr_array_add (results, g_steal_pointer (&it8_ccmx));
+	}
+	return g_steal_pointer (&results);
+}
+
 /**
  * cd_it8_utils_calculate_xyz_from_cmf:
  * @cmf: The color match function
@@ -430,6 +695,525 @@ cd_it8_utils_calculate_cri_from_cmf (CdIt8 *cmf,
 	return TRUE;
 }
 
+/* TM-30 uses 1nm data from 380nm to 780nm */
+#define CD_TM30_START		380
+#define CD_TM30_SIZE		401
+
+/* the CIE daylight components S0, S1 and S2 from 380nm to 780nm, 10nm steps */
+static const gdouble cd_tm30_daylight[3][41] = {
+	{ 63.4, 65.8, 94.8, 104.8, 105.9, 96.8, 113.9, 125.6, 125.5, 121.3,
+	  121.3, 113.5, 113.1, 110.8, 106.5, 108.8, 105.3, 104.4, 100.0, 96.0,
+	  95.1, 89.1, 90.5, 90.3, 88.4, 84.0, 85.1, 81.9, 82.6, 84.9,
+	  81.3, 71.9, 74.3, 76.4, 63.3, 71.7, 77.0, 65.2, 47.7, 68.6,
+	  65.0 },
+	{ 38.5, 35.0, 43.4, 46.3, 43.9, 37.1, 36.7, 35.9, 32.6, 27.9,
+	  24.3, 20.1, 16.2, 13.2, 8.6, 6.1, 4.2, 1.9, 0.0, -1.6,
+	  -3.5, -3.5, -5.8, -7.2, -8.6, -9.5, -10.9, -10.7, -12.0, -14.0,
+	  -13.6, -12.0, -13.3, -12.9, -10.6, -11.6, -12.2, -10.2, -7.8, -11.2,
+	  -10.4 },
+	{ 3.0, 1.2, -1.1, -0.5, -0.7, -1.2, -2.6, -2.9, -2.8, -2.6,
+	  -2.6, -1.8, -1.5, -1.3, -1.2, -1.0, -0.5, -0.3, 0.0, 0.2,
+	  0.5, 2.1, 3.2, 4.1, 4.7, 5.1, 6.7, 7.3, 8.6, 9.8,
+	  10.2, 8.3, 9.6, 8.5, 7.0, 7.6, 8.0, 6.7, 5.2, 7.4,
+	  6.8 },
+};
+
+/* everything that does not depend on the test source */
+typedef struct {
+	guint		 n_samples;
+	gdouble		*samples;			/* n_samples * CD_TM30_SIZE */
+	gdouble		 cmf2[3][CD_TM30_SIZE];		/* CIE 1931 2°, for the CCT */
+	gdouble		 cmf10[3][CD_TM30_SIZE];	/* CIE 1964 10° */
+	gdouble		*jab_t;				/* n_samples * 3 */
+	gdouble		*jab_r;				/* n_samples * 3 */
+	CdMat3x3	 cat02;
+	CdMat3x3	 hpe;				/* HPE * CAT02^-1 */
+} CdTm30Helper;
+
+static void
+cd_tm30_helper_free (CdTm30Helper *helper)
+{
+	g_free (helper->samples);
+	g_free (helper->jab_t);
+	g_free (helper->jab_r);
+	g_free (helper);
+}
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(CdTm30Helper, cd_tm30_helper_free)
+
+static void
+cd_tm30_resample (const CdSpectrum *spectrum, gdouble *data)
+{
+	gdouble wl1;
+	gdouble wl2;
+	guint i;
+	guint j = 0;
+	guint size = cd_spectrum_get_size (spectrum);
+
+	/* unity */
+	if (size < 2) {
+		for (i = 0; i < CD_TM30_SIZE; i++)
+			data[i] = size == 0 ? 1.f : cd_spectrum_get_value (spectrum, 0);
+		return;
+	}
+
+	/* both are in order, so walk them together */
+	for (i = 0; i < CD_TM30_SIZE; i++) {
+		gdouble nm = CD_TM30_START + i;
+		while (j + 2 < size && cd_spectrum_get_wavelength (spectrum, j + 1) <= nm)
+			j++;
+		wl1 = cd_spectrum_get_wavelength (spectrum, j);
+		wl2 = cd_spectrum_get_wavelength (spectrum, j + 1);
+		if (nm <= wl1) {
+			data[i] = cd_spectrum_get_value (spectrum, j);
+		} else if (nm >= wl2) {
+			data[i] = cd_spectrum_get_value (spectrum, j + 1);
+		} else {
+			gdouble v1 = cd_spectrum_get_value (spectrum, j);
+			gdouble v2 = cd_spectrum_get_value (spectrum, j + 1);
+			data[i] = v1 + (v2 - v1) * (nm - wl1) / (wl2 - wl1);
+		}
+	}
+}
+
+static CdTm30Helper *
+cd_tm30_helper_new (CdIt8 *ces, GError **error)
+{
+	const gchar *ids[] = { "X", "Y", "Z" };
+	CdMat3x3 hpe;
+	CdMat3x3 tmp;
+	guint i;
+	g_autoptr(CdIt8) cmf2 = NULL;
+	g_autoptr(CdIt8) cmf10 = NULL;
+	g_autoptr(CdTm30Helper) helper = g_new0 (CdTm30Helper, 1);
+	g_autoptr(GPtrArray) samples = NULL;
+
+	/* each hue bin needs at least one sample */
+	samples = cd_it8_get_spectrum_array (ces);
+	if (samples->len < CD_TM30_HUE_BINS) {
+		g_set_error (error,
+			     CD_IT8_ERROR,
+			     CD_IT8_ERROR_FAILED,
+			     "need at least %i color evaluation samples, got %u",
+			     CD_TM30_HUE_BINS, samples->len);
+		return NULL;
+	}
+	helper->n_samples = samples->len;
+	helper->samples = g_new (gdouble, helper->n_samples * CD_TM30_SIZE);
+	for (i = 0; i < helper->n_samples; i++) {
+		cd_tm30_resample (g_ptr_array_index (samples, i),
+				  helper->samples + i * CD_TM30_SIZE);
+	}
+	helper->jab_t = g_new (gdouble, helper->n_samples * 3);
+	helper->jab_r = g_new (gdouble, helper->n_samples * 3);
+
+	/* both standard observers are needed */
+	cmf2 = cd_it8_new_standard_cmf ("CIE1931-2deg-XYZ");
+	cmf10 = cd_it8_new_standard_cmf ("CIE1964-10deg-XYZ");
+	for (i = 0; i < 3; i++) {
+		cd_tm30_resample (cd_it8_get_spectrum_by_id (cmf2, ids[i]),
+				  helper->cmf2[i]);
+		cd_tm30_resample (cd_it8_get_spectrum_by_id (cmf10, ids[i]),
+				  helper->cmf10[i]);
+	}
+
+	/* CIECAM02 matrices */
+	cd_mat33_init (&helper->cat02,
+		       0.7328, 0.4296, -0.1624,
+		       -0.7036, 1.6975, 0.0061,
+		       0.0030, 0.0136, 0.9834);
+	cd_mat33_init (&hpe,
+		       0.38971, 0.68898, -0.07868,
+		       -0.22981, 1.18340, 0.04641,
+		       0.0, 0.0, 1.0);
+	if (!cd_mat33_reciprocal (&helper->cat02, &tmp)) {
+		g_set_error_literal (error,
+				     CD_IT8_ERROR,
+				     CD_IT8_ERROR_FAILED,
+				     "failed to invert CAT02");
+		return NULL;
+	}
+	cd_mat33_matrix_multiply (&hpe, &tmp, &helper->hpe);
+	return g_steal_pointer (&helper);
+}
+
+static gdouble
+cd_tm30_helper_get_y10 (CdTm30Helper *helper, const gdouble *spd)
+{
+	gdouble y = 0.f;
+	guint i;
+	for (i = 0; i < CD_TM30_SIZE; i++)
+		y += spd[i] * helper->cmf10[1][i];
+	return y;
+}
+
+static void
+cd_tm30_helper_get_reference (CdTm30Helper *helper, gdouble cct, gdouble *ref)
+{
+	gdouble frac;
+	gdouble m;
+	gdouble m1;
+	gdouble m2;
+	gdouble norm;
+	gdouble tmp[CD_TM30_SIZE];
+	gdouble xd;
+	gdouble yd;
+	guint i;
+
+	/* blend between 4000K and 5000K at equal luminance */
+	frac = CLAMP ((cct - 4000) / 1000, 0.f, 1.f);
+	for (i = 0; i < CD_TM30_SIZE; i++)
+		ref[i] = 0.f;
+
+	/* Planckian radiator */
+	if (frac < 1.f) {
+		for (i = 0; i < CD_TM30_SIZE; i++) {
+			gdouble wl = (CD_TM30_START + i) * 1e-9;
+			tmp[i] = 1.f / (pow (wl, 5) * (exp (1.4388e-2 / (wl * cct)) - 1.f));
+		}
+		norm = cd_tm30_helper_get_y10 (helper, tmp);
+		for (i = 0; i < CD_TM30_SIZE; i++)
+			ref[i] += (1.f - frac) * tmp[i] / norm;
+	}
+	if (frac <= 0.f)
+		return;
+
+	/* CIE daylight */
+	if (cct <= 7000) {
+		xd = -4.6070e9 / pow (cct, 3) + 2.9678e6 / pow (cct, 2) +
+			0.09911e3 / cct + 0.244063;
+	} else {
+		xd = -2.0064e9 / pow (cct, 3) + 1.9018e6 / pow (cct, 2) +
+			0.24748e3 / cct + 0.237040;
+	}
+	yd = -3.000 * xd * xd + 2.870 * xd - 0.275;
+	m = 0.0241 + 0.2562 * xd - 0.7341 * yd;
+	m1 = (-1.3515 - 1.7703 * xd + 5.9114 * yd) / m;
+	m2 = (0.0300 - 31.4424 * xd + 30.0717 * yd) / m;
+	for (i = 0; i < CD_TM30_SIZE; i++) {
+		guint j = i / 10;
+		gdouble s[3];
+		guint k;
+		for (k = 0; k < 3; k++) {
+			s[k] = cd_tm30_daylight[k][j];
+			if (j < 40) {
+				s[k] += (cd_tm30_daylight[k][j + 1] - s[k]) *
+					(gdouble) (i % 10) / 10.f;
+			}
+		}
+		tmp[i] = s[0] + m1 * s[1] + m2 * s[2];
+	}
+	norm = cd_tm30_helper_get_y10 (helper, tmp);
+	for (i = 0; i < CD_TM30_SIZE; i++)
+		ref[i] += frac * tmp[i] / norm;
+}
+
+static gdouble
+cd_tm30_adapt (gdouble value, gdouble fl)
+{
+	gdouble tmp = pow (fl * fabs (value) / 100.f, 0.42);
+	return copysign (400.f * tmp / (27.13 + tmp), value) + 0.1;
+}
+
+/* CIECAM02 with La=100, Yb=20, average surround and D=1, then CAM02-UCS */
+static void
+cd_tm30_helper_get_jab (CdTm30Helper *helper, const gdouble *spd, gdouble *jab)
+{
+	CdVec3 rgb;
+	CdVec3 rgb_w;
+	CdVec3 xyz;
+	CdVec3 xyz_w;
+	const gdouble c = 0.69;
+	const gdouble la = 100.f;
+	const gdouble nc = 1.f;
+	const gdouble yb = 20.f;
+	gdouble aw;
+	gdouble d[3];
+	gdouble fl;
+	gdouble k;
+	gdouble n;
+	gdouble nbb;
+	gdouble weighted[3][CD_TM30_SIZE];
+	gdouble z;
+	guint i;
+	guint j;
+
+	/* the source weighted by the observer, scaled to Y=100 */
+	k = 100.f / cd_tm30_helper_get_y10 (helper, spd);
+	for (j = 0; j < 3; j++) {
+		for (i = 0; i < CD_TM30_SIZE; i++)
+			weighted[j][i] = k * spd[i] * helper->cmf10[j][i];
+	}
+	cd_vec3_clear (&xyz_w);
+	for (i = 0; i < CD_TM30_SIZE; i++) {
+		xyz_w.v0 += weighted[0][i];
+		xyz_w.v1 += weighted[1][i];
+		xyz_w.v2 += weighted[2][i];
+	}
+
+	/* viewing conditions */
+	k = 1.f / (5.f * la + 1.f);
+	fl = 0.2 * pow (k, 4) * 5.f * la +
+	     0.1 * pow (1.f - pow (k, 4), 2) * cbrt (5.f * la);
+	n = yb / xyz_w.v1;
+	nbb = 0.725 * pow (1.f / n, 0.2);
+	z = 1.48 + sqrt (n);
+
+	/* full chromatic adaptation to the white */
+	cd_mat33_vector_multiply (&helper->cat02, &xyz_w, &rgb_w);
+	d[0] = xyz_w.v1 / rgb_w.v0;
+	d[1] = xyz_w.v1 / rgb_w.v1;
+	d[2] = xyz_w.v1 / rgb_w.v2;
+	cd_vec3_init (&rgb, xyz_w.v1, xyz_w.v1, xyz_w.v1);
+	cd_mat33_vector_multiply (&helper->hpe, &rgb, &rgb_w);
+	aw = (2.f * cd_tm30_adapt (rgb_w.v0, fl) +
+	      cd_tm30_adapt (rgb_w.v1, fl) +
+	      cd_tm30_adapt (rgb_w.v2, fl) / 20.f - 0.305) * nbb;
+
+	for (j = 0; j < helper->n_samples; j++) {
+		CdVec3 rgb_c;
+		CdVec3 rgb_a;
+		const gdouble *r = helper->samples + j * CD_TM30_SIZE;
+		gdouble a;
+		gdouble b;
+		gdouble h;
+		gdouble et;
+		gdouble t;
+		gdouble jj;
+		gdouble mm;
+
+		/* tristimulus values of the sample */
+		cd_vec3_clear (&xyz);
+		for (i = 0; i < CD_TM30_SIZE; i++) {
+			xyz.v0 += weighted[0][i] * r[i];
+			xyz.v1 += weighted[1][i] * r[i];
+			xyz.v2 += weighted[2][i] * r[i];
+		}
+
+		/* adapt and compress */
+		cd_mat33_vector_multiply (&helper->cat02, &xyz, &rgb);
+		rgb.v0 *= d[0];
+		rgb.v1 *= d[1];
+		rgb.v2 *= d[2];
+		cd_mat33_vector_multiply (&helper->hpe, &rgb, &rgb_c);
+		rgb_a.v0 = cd_tm30_adapt (rgb_c.v0, fl);
+		rgb_a.v1 = cd_tm30_adapt (rgb_c.v1, fl);
+		rgb_a.v2 = cd_tm30_adapt (rgb_c.v2, fl);
+
+		/* appearance correlates */
+		a = rgb_a.v0 - 12.f * rgb_a.v1 / 11.f + rgb_a.v2 / 11.f;
+		b = (rgb_a.v0 + rgb_a.v1 - 2.f * rgb_a.v2) / 9.f;
+		h = atan2 (b, a);
+		et = 0.25 * (cos (h + 2.f) + 3.8);
+		jj = 100.f * pow ((2.f * rgb_a.v0 + rgb_a.v1 + rgb_a.v2 / 20.f - 0.305) * nbb / aw,
+				  c * z);
+		t = (50000.f / 13.f * nc * nbb * et * sqrt (a * a + b * b)) /
+		    (rgb_a.v0 + rgb_a.v1 + 21.f / 20.f * rgb_a.v2);
+		mm = pow (t, 0.9) * sqrt (jj / 100.f) *
+		     pow (1.64 - pow (0.29, n), 0.73) * pow (fl, 0.25);
+
+		/* CAM02-UCS */
+		mm = log (1.f + 0.0228 * mm) / 0.0228;
+		jab[j * 3 + 0] = 1.7 * jj / (1.f + 0.007 * jj);
+		jab[j * 3 + 1] = mm * cos (h);
+		jab[j * 3 + 2] = mm * sin (h);
+	}
+}
+
+/* the TM-30-18 and CIE 224:2017 scaling factor, TM-30-15 used 7.54 */
+#define CD_TM30_FIDELITY_FACTOR		6.73
+
+static gdouble
+cd_tm30_get_fidelity (gdouble delta_e)
+{
+	return 10.f * log (exp ((100.f - CD_TM30_FIDELITY_FACTOR * delta_e) / 10.f) + 1.f);
+}
+
+static gdouble
+cd_tm30_get_area (const gdouble *a, const gdouble *b)
+{
+	gdouble area = 0.f;
+	guint i;
+	for (i = 0; i < CD_TM30_HUE_BINS; i++) {
+		guint j = (i + 1) % CD_TM30_HUE_BINS;
+		area += a[i] * b[j] - a[j] * b[i];
+	}
+	return fabs (area) / 2.f;
+}
+
+static gboolean
+cd_tm30_helper_calculate (CdTm30Helper *helper,
+			  CdSpectrum *illuminant,
+			  CdTm30 *value,
+			  GError **error)
+{
+	CdColorXYZ xyz;
+	gdouble at[CD_TM30_HUE_BINS] = { 0.f };
+	gdouble ar[CD_TM30_HUE_BINS] = { 0.f };
+	gdouble bt[CD_TM30_HUE_BINS] = { 0.f };
+	gdouble br[CD_TM30_HUE_BINS] = { 0.f };
+	gdouble de_bin[CD_TM30_HUE_BINS] = { 0.f };
+	gdouble de_sum = 0.f;
+	gdouble ref[CD_TM30_SIZE];
+	gdouble spd[CD_TM30_SIZE];
+	guint cnt[CD_TM30_HUE_BINS] = { 0 };
+	guint i;
+
+	/* get the test source CCT */
+	cd_tm30_resample (illuminant, spd);
+	cd_color_xyz_clear (&xyz);
+	for (i = 0; i < CD_TM30_SIZE; i++) {
+		xyz.X += spd[i] * helper->cmf2[0][i];
+		xyz.Y += spd[i] * helper->cmf2[1][i];
+		xyz.Z += spd[i] * helper->cmf2[2][i];
+	}
+	value->cct = cd_color_xyz_to_cct (&xyz);
+	if (value->cct < 1000 || value->cct > 25000) {
+		g_set_error (error,
+			     CD_IT8_ERROR,
+			     CD_IT8_ERROR_FAILED,
+			     "result not meaningful, CCT=%.0fK",
+			     value->cct);
+		return FALSE;
+	}
+
+	/* get the samples under the test and reference source */
+	cd_tm30_helper_get_reference (helper, value->cct, ref);
+	cd_tm30_helper_get_jab (helper, spd, helper->jab_t);
+	cd_tm30_helper_get_jab (helper, ref, helper->jab_r);
+
+	/* sort into hue bins using the reference hue */
+	for (i = 0; i < helper->n_samples; i++) {
+		const gdouble *jt = helper->jab_t + i * 3;
+		const gdouble *jr = helper->jab_r + i * 3;
+		gdouble de;
+		gdouble h;
+		guint bin;
+
+		de = sqrt (pow (jt[0] - jr[0], 2) +
+			   pow (jt[1] - jr[1], 2) +
+			   pow (jt[2] - jr[2], 2));
+		de_sum += de;
+		h = atan2 (jr[2], jr[1]);
+		if (h < 0)
+			h += 2 * G_PI;
+		bin = MIN (h / (2 * G_PI) * CD_TM30_HUE_BINS, CD_TM30_HUE_BINS - 1);
+		cnt[bin]++;
+		de_bin[bin] += de;
+		at[bin] += jt[1];
+		bt[bin] += jt[2];
+		ar[bin] += jr[1];
+		br[bin] += jr[2];
+	}
+	for (i = 0; i < CD_TM30_HUE_BINS; i++) {
+		gdouble ct;
+		gdouble cr;
+		gdouble dh;
+		if (cnt[i] == 0) {
+			g_set_error (error,
+				     CD_IT8_ERROR,
+				     CD_IT8_ERROR_FAILED,
+				     "no color evaluation samples in hue bin %u",
+				     i + 1);
+			return FALSE;
+		}
+		at[i] /= cnt[i];
+		bt[i] /= cnt[i];
+		ar[i] /= cnt[i];
+		br[i] /= cnt[i];
+		ct = sqrt (at[i] * at[i] + bt[i] * bt[i]);
+		cr = sqrt (ar[i] * ar[i] + br[i] * br[i]);
+		dh = atan2 (bt[i], at[i]) - atan2 (br[i], ar[i]);
+		if (dh > G_PI)
+			dh -= 2 * G_PI;
+		if (dh < -G_PI)
+			dh += 2 * G_PI;
+		value->rf_hue[i] = cd_tm30_get_fidelity (de_bin[i] / cnt[i]);
+		value->rcs_hue[i] = (ct - cr) / cr;
+		value->rhs_hue[i] = dh;
+	}
+	value->rf = cd_tm30_get_fidelity (de_sum / helper->n_samples);
+	value->rg = 100.f * cd_tm30_get_area (at, bt) / cd_tm30_get_area (ar, br);
+	return TRUE;
+}
+
+/**
+ * cd_it8_utils_calculate_tm30:
+ * @ces: The 99 IES TM-30 color evaluation samples
+ * @illuminant: The test source
+ * @value: (out): The TM-30 result
+ * @error: A #GError, or %NULL
+ *
+ * This calculates the IES TM-30-18 fidelity and gamut indices for a light
+ * source using the CIE 1964 observer and CAM02-UCS. The fidelity index
+ * matches CIE 224:2017.
+ *
+ * The reference illuminant is a Planckian radiator below 4000K, CIE daylight
+ * above 5000K and a blend of both in between.
+ *
+ * Return value: %TRUE if @value was set.
+ *
+ * Since: 1.4.8
+ **/
+gboolean
+cd_it8_utils_calculate_tm30 (CdIt8 *ces,
+			     CdSpectrum *illuminant,
+			     CdTm30 *value,
+			     GError **error)
+{
+	g_autoptr(CdTm30Helper) helper = NULL;
+
+	g_return_val_if_fail (CD_IS_IT8 (ces), FALSE);
+	g_return_val_if_fail (illuminant != NULL, FALSE);
+	g_return_val_if_fail (value != NULL, FALSE);
+
+	helper = cd_tm30_helper_new (ces, error);
+	if (helper == NULL)
+		return FALSE;
+	return cd_tm30_helper_calculate (helper, illuminant, value, error);
+}
+
+/**
+ * cd_it8_utils_calculate_tm30_array:
+ * @ces: The 99 IES TM-30 color evaluation samples
+ * @illuminants: (element-type CdSpectrum): The test sources
+ * @error: A #GError, or %NULL
+ *
+ * This calculates the IES TM-30 indices for many light sources. The sample
+ * and observer data is only prepared once, which makes this much faster than
+ * calling cd_it8_utils_calculate_tm30() for each source.
+ *
+ * Return value: (transfer full) (element-type CdTm30): results, or %NULL
+ *
+ * Since: 1.4.8
+ **/
+GArray *
+cd_it8_utils_calculate_tm30_array (CdIt8 *ces,
+				   GPtrArray *illuminants,
+				   GError **error)
+{
+	guint i;
+	g_autoptr(CdTm30Helper) helper = NULL;
+	g_autoptr(GArray) results = NULL;
+
+	g_return_val_if_fail (CD_IS_IT8 (ces), NULL);
+	g_return_val_if_fail (illuminants != NULL, NULL);
+
+	helper = cd_tm30_helper_new (ces, error);
+	if (helper == NULL)
+		return NULL;
+	results = g_array_sized_new (FALSE, TRUE, sizeof (CdTm30), illuminants->len);
+	g_array_set_size (results, illuminants->len);
+	for (i = 0; i < illuminants->len; i++) {
+		if (!cd_tm30_helper_calculate (helper,
+					       g_ptr_array_index (illuminants, i),
+					       &g_array_index (results, CdTm30, i),
+					       error))
+			return NULL;
+	}
+	return g_steal_pointer (&results);
+}
+
 /**
  * _cd_color_rgb_is_gray:
  * @rgb: The sample color
@@ -33,11 +33,58 @@
 
 G_BEGIN_DECLS
 
+#define CD_TM30_HUE_BINS	16
+
+/**
+ * CdTm30:
+ * @cct: the correlated color temperature of the test source in Kelvin
+ * @rf: the fidelity index, Rf
+ * @rg: the gamut index, Rg
+ * @rf_hue: the local fidelity index for each hue bin, Rf,hj
+ * @rcs_hue: the local chroma shift for each hue bin, Rcs,hj
+ * @rhs_hue: the local hue shift in radians for each hue bin, Rhs,hj
+ *
+ * The IES TM-30 color rendition indices of a light source.
+ **/
+typedef struct {
+	gdouble		 cct;
+	gdouble		 rf;
+	gdouble		 rg;
+	gdouble		 rf_hue[CD_TM30_HUE_BINS];
+	gdouble		 rcs_hue[CD_TM30_HUE_BINS];
+	gdouble		 rhs_hue[CD_TM30_HUE_BINS];
+} CdTm30;
+
+/**
+ * CdCcmxResidual:
+ * @delta_e_mean: the mean CIEDE2000 error after correction
+ * @delta_e_max: the largest CIEDE2000 error after correction
+ *
+ * How well a correction matrix fits the patches it was calculated from.
+ **/
+typedef struct {
+	gdouble		 delta_e_mean;
+	gdouble		 delta_e_max;
+} CdCcmxResidual;
+
 gboolean	 cd_it8_utils_calculate_ccmx		(CdIt8		*it8_reference,
 							 CdIt8		*it8_measured,
 							 CdIt8		*it8_ccmx,
 							 GError		**error)
 							 G_GNUC_WARN_UNUSED_RESULT;
+gboolean	 cd_it8_utils_calculate_ccmx_lsq	(CdIt8		*it8_reference,
+							 CdIt8		*it8_measured,
+							 const gdouble	*weights,
+							 CdIt8		*it8_ccmx,
+							 CdCcmxResidual	*residual,
+							 GError		**error)
+							 G_GNUC_WARN_UNUSED_RESULT;
+GPtrArray	*cd_it8_utils_calculate_ccmx_lsq_array	(GPtrArray	*references,
+							 GPtrArray	*measured,
+							 GPtrArray	*weights,
+							 GArray		*residuals,
+							 GError		**error)
+							 G_GNUC_WARN_UNUSED_RESULT;
 gboolean	 cd_it8_utils_calculate_xyz_from_cmf	(CdIt8		*cmf,
 							 CdSpectrum	*illuminant,
 							 CdSpectrum	*spectrum,
@@ -52,6 +99,15 @@ gboolean	 cd_it8_utils_calculate_cri_from_cmf	(CdIt8		*cmf,
 							 gdouble	 resolution,
 							 GError		**error)
 							 G_GNUC_WARN_UNUSED_RESULT;
+gboolean	 cd_it8_utils_calculate_tm30		(CdIt8		*ces,
+							 CdSpectrum	*illuminant,
+							 CdTm30		*value,
+							 GError		**error)
+							 G_GNUC_WARN_UNUSED_RESULT;
+GArray		*cd_it8_utils_calculate_tm30_array	(CdIt8		*ces,
+							 GPtrArray	*illuminants,
+							 GError		**error)
+							 G_GNUC_WARN_UNUSED_RESULT;
 gboolean	 cd_it8_utils_calculate_gamma		(CdIt8		*it8,
 							 gdouble	*gamma_y,
 							 GError		**error);
@@ -37,6 +37,7 @@
 #include "cd-it8.h"
 #include "cd-color.h"
 #include "cd-context-lcms.h"
+#include "cd-standard-tables.h"
 
 static void	cd_it8_class_init	(CdIt8Class	*klass);
 static void	cd_it8_init		(CdIt8		*it8);
@@ -2112,3 +2113,46 @@ cd_it8_new_with_kind (CdIt8Kind kind)
 	return CD_IT8 (it8);
 }
 
+/**
+ * cd_it8_new_standard_cmf:
+ * @id: the observer name, e.g. "CIE1931-2deg-XYZ"
+ *
+ * Creates a new #CdIt8 object containing one of the CIE standard observer
+ * color match functions. The data is compiled into the library and so no
+ * files need to be loaded or parsed.
+ *
+ * Return value: a new CdIt8 object, or %NULL if unknown
+ *
+ * Since: 1.4.8
+ **/
+CdIt8 *
+cd_it8_new_standard_cmf (const gchar *id)
+{
+	CdIt8 *it8;
+	CdIt8Private *priv;
+	const CdStandardTable *table;
+	const gchar *channels[] = { "X", "Y", "Z" };
+	guint i;
+
+	g_return_val_if_fail (id != NULL, NULL);
+
+	table = cd_standard_table_lookup (CD_STANDARD_TABLE_KIND_CMF, id);
+	if (table == NULL)
+		return NULL;
+	it8 = cd_it8_new_with_kind (CD_IT8_KIND_CMF);
+	priv = GET_PRIVATE (it8);
+	cd_it8_set_title (it8, table->id);
+	for (i = 0; i < 3; i++) {
+		CdSpectrum *spectrum = cd_spectrum_sized_new (table->size);
+		g_autoptr(GArray) data = NULL;
+		data = g_array_sized_new (FALSE, FALSE, sizeof (gdouble), table->size);
+		g_array_append_vals (data, table->data + i * table->size, table->size);
+		cd_spectrum_set_id (spectrum, channels[i]);
+		cd_spectrum_set_data (spectrum, data);
+		cd_spectrum_set_start (spectrum, table->start);
+		cd_spectrum_set_end (spectrum, table->end);
+		g_ptr_array_add (priv->array_spectra, spectrum);
+	}
+	return it8;
+}
+
@@ -92,6 +92,7 @@ typedef enum {
 GQuark		 cd_it8_error_quark		(void);
 CdIt8		*cd_it8_new			(void);
 CdIt8		*cd_it8_new_with_kind		(CdIt8Kind	 kind);
+CdIt8		*cd_it8_new_standard_cmf	(const gchar	*id);
 
 /* sync */
 gboolean	 cd_it8_load_from_data		(CdIt8		*it8,
@@ -480,3 +480,132 @@ cd_mat33_is_finite (const CdMat3x3 *mat, GError **error)
 
 	return TRUE;
 }
+
+/**
+ * cd_math_solve_least_squares:
+ * @a: the row-major @rows x @cols design matrix
+ * @b: the row-major @rows x @nrhs right hand sides
+ * @weights: (allow-none): the @rows weights, or %NULL for all equal
+ * @rows: the number of observations
+ * @cols: the number of unknowns, which must not exceed @rows
+ * @nrhs: the number of right hand sides solved at the same time
+ * @x: (out): the row-major @cols x @nrhs solution
+ * @error: A #GError, or %NULL
+ *
+ * Solves the overdetermined system A.X = B so that the weighted sum of
+ * the squared residuals is minimized. A Householder QR decomposition is
+ * used rather than the normal equations so that badly conditioned data
+ * does not lose precision.
+ *
+ * Return value: %FALSE if @a is rank deficient or the weights are invalid.
+ *
+ * Since: 1.4.8
+ **/
+gboolean
+cd_math_solve_least_squares (const gdouble *a,
+			     const gdouble *b,
+			     const gdouble *weights,
+			     guint rows,
+			     guint cols,
+			     guint nrhs,
+			     gdouble *x,
+			     GError **error)
+{
+	gdouble diag_max = 0.f;
+	g_autofree gdouble *diag = NULL;
+	g_autofree gdouble *qr = NULL;
+	g_autofree gdouble *rhs = NULL;
+
+	g_return_val_if_fail (a != NULL, FALSE);
+	g_return_val_if_fail (b != NULL, FALSE);
+	g_return_val_if_fail (x != NULL, FALSE);
+	g_return_val_if_fail (cols > 0, FALSE);
+
+	if (rows < cols) {
+		g_set_error (error, 1, 0,
+			     "need at least %u rows, got %u", cols, rows);
+		return FALSE;
+	}
+
+	/* scale each row by the square root of its weight */
+	qr = g_new (gdouble, rows * cols);
+	rhs = g_new (gdouble, rows * nrhs);
+	diag = g_new (gdouble, cols);
+	for (guint i = 0; i < rows; i++) {
+		gdouble scale = 1.f;
+		if (weights != NULL) {
+			if (!isfinite (weights[i]) || weights[i] < 0.f) {
+				g_set_error (error, 1, 0,
+					     "weight %u invalid: %f",
+					     i, weights[i]);
+				return FALSE;
+			}
+			scale = sqrt (weights[i]);
+		}
+		for (guint j = 0; j < cols; j++)
+			qr[i * cols + j] = a[i * cols + j] * scale;
+		for (guint j = 0; j < nrhs; j++)
+			rhs[i * nrhs + j] = b[i * nrhs + j] * scale;
+	}
+
+	/* reduce to upper triangular, applying the same reflections to B */
+	for (guint k = 0; k < cols; k++) {
+		gdouble alpha;
+		gdouble norm = 0.f;
+		gdouble vnorm2 = 0.f;
+
+		for (guint i = k; i < rows; i++)
+			norm += qr[i * cols + k] * qr[i * cols + k];
+		norm = sqrt (norm);
+		if (norm == 0.f) {
+			g_set_error (error, 1, 0,
+				     "column %u is all zero", k);
+			return FALSE;
+		}
+
+		/* the reflector is stored in place below the diagonal */
+		alpha = qr[k * cols + k] > 0.f ? -norm : norm;
+		qr[k * cols + k] -= alpha;
+		for (guint i = k; i < rows; i++)
+			vnorm2 += qr[i * cols + k] * qr[i * cols + k];
+		diag[k] = alpha;
+		diag_max = MAX (diag_max, fabs (alpha));
+
+		for (guint j = k + 1; j < cols; j++) {
+			gdouble f = 0.f;
+			for (guint i = k; i < rows; i++)
+				f += qr[i * cols + k] * qr[i * cols + j];
+			f = 2.f * f / vnorm2;
+			for (guint i = k; i < rows; i++)
+				qr[i * cols + j] -= f * qr[i * cols + k];
+		}
+		for (guint j = 0; j < nrhs; j++) {
+			gdouble f = 0.f;
+			for (guint i = k; i < rows; i++)
+				f += qr[i * cols + k] * rhs[i * nrhs + j];
+			f = 2.f * f / vnorm2;
+			for (guint i = k; i < rows; i++)
+				rhs[i * nrhs + j] -= f * qr[i * cols + k];
+		}
+	}
+
+	/* the columns have to be independent */
+	for (guint k = 0; k < cols; k++) {
+		if (fabs (diag[k]) <= diag_max * 1e-12) {
+			g_set_error (error, 1, 0,
+				     "matrix is rank deficient at column %u", k);
+			return FALSE;
+		}
+	}
+
+	/* back-substitute R.X = Q^T.B */
+	for (guint k = cols; k-- > 0;) {
+		for (guint j = 0; j < nrhs; j++) {
+			gdouble sum = rhs[k * nrhs + j];
+			for (guint c = k + 1; c < cols; c++)
+				sum -= qr[k * cols + c] * x[c * nrhs + j];
+			x[k * nrhs + j] = sum / diag[k];
+		}
+	}
+	return TRUE;
+}
@@ -90,6 +90,15 @@ void		 cd_mat33_copy			(const CdMat3x3		*src,
 						 CdMat3x3		*dest);
 gboolean	 cd_mat33_is_finite		(const CdMat3x3		*mat,
 						 GError			**error);
+gboolean	 cd_math_solve_least_squares	(const gdouble		*a,
+						 const gdouble		*b,
+						 const gdouble		*weights,
+						 guint			 rows,
+						 guint			 cols,
+						 guint			 nrhs,
+						 gdouble		*x,
+						 GError			**error)
+						 G_GNUC_WARN_UNUSED_RESULT;
 
 #undef __CD_MATH_H_INSIDE__
 
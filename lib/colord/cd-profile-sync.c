@@ -81,7 +81,7 @@ cd_profile_connect_sync (CdProfile *profile,
 
 	/* create temp object */
 	memset (&helper, 0, sizeof (CdProfileHelper));
-	helper.loop = g_main_loop_new (NULL, FALSE);
+	helper.loop = g_main_loop_new (g_main_context_get_thread_default (), FALSE);
 	helper.error = error;
 
 	/* run async method */
@@ -137,7 +137,7 @@ cd_profile_set_property_sync (CdProfile *profile,
 
 	/* create temp object */
 	memset (&helper, 0, sizeof (CdProfileHelper));
-	helper.loop = g_main_loop_new (NULL, FALSE);
+	helper.loop = g_main_loop_new (g_main_context_get_thread_default (), FALSE);
 	helper.error = error;
 
 	/* run async method */
@@ -189,7 +189,7 @@ cd_profile_install_system_wide_sync (CdProfile *profile,
 
 	/* create temp object */
 	memset (&helper, 0, sizeof (CdProfileHelper));
-	helper.loop = g_main_loop_new (NULL, FALSE);
+	helper.loop = g_main_loop_new (g_main_context_get_thread_default (), FALSE);
 	helper.error = error;
 
 	/* run async method */
@@ -82,7 +82,7 @@ cd_sensor_connect_sync (CdSensor *sensor,
 
 	/* create temp object */
 	memset (&helper, 0, sizeof (CdSensorHelper));
-	helper.loop = g_main_loop_new (NULL, FALSE);
+	helper.loop = g_main_loop_new (g_main_context_get_thread_default (), FALSE);
 	helper.error = error;
 
 	/* run async method */
@@ -134,7 +134,7 @@ cd_sensor_lock_sync (CdSensor *sensor,
 
 	/* create temp object */
 	memset (&helper, 0, sizeof (CdSensorHelper));
-	helper.loop = g_main_loop_new (NULL, FALSE);
+	helper.loop = g_main_loop_new (g_main_context_get_thread_default (), FALSE);
 	helper.error = error;
 
 	/* run async method */
@@ -186,7 +186,7 @@ cd_sensor_unlock_sync (CdSensor *sensor,
 
 	/* create temp object */
 	memset (&helper, 0, sizeof (CdSensorHelper));
-	helper.loop = g_main_loop_new (NULL, FALSE);
+	helper.loop = g_main_loop_new (g_main_context_get_thread_default (), FALSE);
 	helper.error = error;
 
 	/* run async method */
@@ -240,7 +240,7 @@ cd_sensor_set_options_sync (CdSensor *sensor,
 
 	/* create temp object */
 	memset (&helper, 0, sizeof (CdSensorHelper));
-	helper.loop = g_main_loop_new (NULL, FALSE);
+	helper.loop = g_main_loop_new (g_main_context_get_thread_default (), FALSE);
 	helper.error = error;
 
 	/* run async method */
@@ -294,7 +294,7 @@ cd_sensor_get_sample_sync (CdSensor *sensor,
 
 	/* create temp object */
 	memset (&helper, 0, sizeof (CdSensorHelper));
-	helper.loop = g_main_loop_new (NULL, FALSE);
+	helper.loop = g_main_loop_new (g_main_context_get_thread_default (), FALSE);
 	helper.error = error;
 
 	/* run async method */
@@ -348,7 +348,7 @@ cd_sensor_get_spectrum_sync (CdSensor *sensor,
 
 	/* create temp object */
 	memset (&helper, 0, sizeof (CdSensorHelper));
-	helper.loop = g_main_loop_new (NULL, FALSE);
+	helper.loop = g_main_loop_new (g_main_context_get_thread_default (), FALSE);
 	helper.error = error;
 
 	/* run async method */
@@ -34,6 +34,7 @@
 #include "cd-color.h"
 #include "cd-interp-linear.h"
 #include "cd-spectrum.h"
+#include "cd-standard-tables.h"
 
 /* this is private */
 struct _CdSpectrum {
@@ -452,6 +453,36 @@ cd_spectrum_planckian_new (gdouble temperature)
 	return cd_spectrum_planckian_new_full (temperature, 300, 830, 1);
 }
 
+/**
+ * cd_spectrum_new_standard_illuminant:
+ * @id: the illuminant name, e.g. "CIE-D65"
+ *
+ * Allocates one of the CIE standard illuminants. The data is compiled into
+ * the library and so no files need to be loaded or parsed.
+ *
+ * Return value: A newly allocated #CdSpectrum object, or %NULL if unknown
+ *
+ * Since: 1.4.8
+ **/
+CdSpectrum *
+cd_spectrum_new_standard_illuminant (const gchar *id)
+{
+	CdSpectrum *s;
+	const CdStandardTable *table;
+
+	g_return_val_if_fail (id != NULL, NULL);
+
+	table = cd_standard_table_lookup (CD_STANDARD_TABLE_KIND_ILLUMINANT, id);
+	if (table == NULL)
+		return NULL;
+	s = cd_spectrum_sized_new (table->size);
+	s->id = g_strdup (table->id);
+	g_array_append_vals (s->data, table->data, table->size);
+	cd_spectrum_set_start (s, table->start);
+	cd_spectrum_set_end (s, table->end);
+	return s;
+}
+
 /**
  * cd_spectrum_add_value:
  * @spectrum: the spectrum
@@ -38,6 +38,7 @@ GType		 cd_spectrum_get_type		(void);
 CdSpectrum	*cd_spectrum_new		(void);
 CdSpectrum	*cd_spectrum_sized_new		(guint			 reserved_size);
 CdSpectrum	*cd_spectrum_planckian_new	(gdouble		 temperature);
+CdSpectrum	*cd_spectrum_new_standard_illuminant (const gchar	*id);
 CdSpectrum	*cd_spectrum_planckian_new_full	(gdouble		 temperature,
 						 gdouble		 start,
 						 gdouble		 end,
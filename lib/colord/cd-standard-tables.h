@@ -0,0 +1,51 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2012-2014 Richard Hughes <richard@hughsie.com>
+ *
+ * Licensed under the GNU Lesser General Public License Version 2.1
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#ifndef __CD_STANDARD_TABLES_H
+#define __CD_STANDARD_TABLES_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef enum {
+	CD_STANDARD_TABLE_KIND_CMF,
+	CD_STANDARD_TABLE_KIND_ILLUMINANT,
+} CdStandardTableKind;
+
+typedef struct {
+	CdStandardTableKind	 kind;
+	const gchar		*id;		/* e.g. "CIE-D65" */
+	gdouble			 start;		/* nm */
+	gdouble			 end;		/* nm */
+	guint			 size;
+	const gdouble		*data;		/* planar, size values per channel */
+} CdStandardTable;
+
+/* generated at build time from data/cmf and data/illuminant; this is
+ * hidden as the version script would otherwise export it as cd_* */
+G_GNUC_INTERNAL
+const CdStandardTable	*cd_standard_table_lookup	(CdStandardTableKind	 kind,
+							 const gchar		*id);
+
+G_END_DECLS
+
+#endif /* __CD_STANDARD_TABLES_H */
@@ -22,10 +22,13 @@
 #include "config.h"
 
 #include <locale.h>
+#include <signal.h>
 #include <string.h>
 #include <glib.h>
 #include <glib-object.h>
+#include <glib/gstdio.h>
 #include <pwd.h>
+#include <sys/wait.h>
 
 #include "cd-client.h"
 #include "cd-client-sync.h"
@@ -2695,6 +2698,406 @@ colord_device_duplicate_func (void)
 	g_object_unref (client);
 }
 
+typedef struct {
+	const gchar	*object_path;
+	guint		 samples;
+	gint64		 timestamp_last;
+	gboolean	 finished;
+} ColordSessionHelper;
+
+static void
+colord_session_signal_cb (GDBusConnection *connection,
+			  const gchar *sender_name,
+			  const gchar *object_path,
+			  const gchar *interface_name,
+			  const gchar *signal_name,
+			  GVariant *parameters,
+			  gpointer user_data)
+{
+	ColordSessionHelper *helper = (ColordSessionHelper *) user_data;
+	gdouble rgb[3];
+	gdouble xyz[3];
+	gint64 timestamp;
+
+	if (g_strcmp0 (object_path, helper->object_path) != 0)
+		return;
+	if (g_strcmp0 (signal_name, "SampleTaken") == 0) {
+		g_variant_get (parameters, "(ddddddx)",
+			       &rgb[0], &rgb[1], &rgb[2],
+			       &xyz[0], &xyz[1], &xyz[2],
+			       &timestamp);
+		g_assert_cmpint (timestamp, >, helper->timestamp_last);
+		helper->timestamp_last = timestamp;
+		if (++helper->samples == 5)
+			cd_test_loop_quit ();
+		return;
+	}
+	if (g_strcmp0 (signal_name, "Finished") == 0) {
+		helper->finished = TRUE;
+		cd_test_loop_quit ();
+		return;
+	}
+}
+
+static gchar *
+colord_session_create (GDBusConnection *connection, GError **error)
+{
+	gchar *object_path = NULL;
+	g_autoptr(GVariant) value = NULL;
+
+	value = g_dbus_connection_call_sync (connection,
+					     "org.freedesktop.ColorHelper",
+					     "/",
+					     "org.freedesktop.ColorHelper",
+					     "CreateSession",
+					     NULL,
+					     G_VARIANT_TYPE ("(o)"),
+					     G_DBUS_CALL_FLAGS_NONE,
+					     -1, NULL, error);
+	if (value == NULL)
+		return NULL;
+	g_variant_get (value, "(o)", &object_path);
+	return object_path;
+}
+
+static GVariant *
+colord_session_call (GDBusConnection *connection,
+		     const gchar *object_path,
+		     const gchar *method_name,
+		     GVariant *parameters,
+		     GError **error)
+{
+	return g_dbus_connection_call_sync (connection,
+					    "org.freedesktop.ColorHelper",
+					    object_path,
+					    "org.freedesktop.ColorHelper.Display",
+					    method_name,
+					    parameters,
+					    NULL,
+					    G_DBUS_CALL_FLAGS_NONE,
+					    -1, NULL, error);
+}
+
+static void
+colord_session_func (void)
+{
+	CdSensor *sensor;
+	ColordSessionHelper helper1 = { NULL, 0, 0, FALSE };
+	gboolean ret;
+	guint i;
+	guint subscription_id;
+	g_autofree gchar *path1 = NULL;
+	g_autofree gchar *path2 = NULL;
+	g_autoptr(CdClient) client = NULL;
+	g_autoptr(CdDevice) device1 = NULL;
+	g_autoptr(CdDevice) device2 = NULL;
+	g_autoptr(GDBusConnection) connection = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GHashTable) device_props = NULL;
+	g_autoptr(GPtrArray) sensors = NULL;
+	g_autoptr(GVariant) value = NULL;
+
+	/* no running colord to use */
+	if (!has_colord_process) {
+		g_print ("[DISABLED] ");
+		return;
+	}
+
+	/* the dummy sensor measures whatever patch the helper shows */
+	client = cd_client_new ();
+	ret = cd_client_connect_sync (client, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	sensors = cd_client_get_sensors_sync (client, NULL, &error);
+	g_assert_no_error (error);
+	if (sensors->len == 0) {
+		g_test_skip ("no dummy sensor");
+		return;
+	}
+	sensor = g_ptr_array_index (sensors, 0);
+	ret = cd_sensor_connect_sync (sensor, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+
+	/* one session per simulated display */
+	connection = g_bus_get_sync (G_BUS_TYPE_SESSION, NULL, &error);
+	if (connection == NULL) {
+		g_test_skip (error->message);
+		return;
+	}
+	path1 = colord_session_create (connection, &error);
+	if (path1 == NULL) {
+		g_test_skip (error->message);
+		return;
+	}
+	path2 = colord_session_create (connection, &error);
+	g_assert_no_error (error);
+	g_assert_cmpstr (path1, !=, path2);
+	device_props = g_hash_table_new_full (g_str_hash, g_str_equal,
+					      g_free, g_free);
+	g_hash_table_insert (device_props,
+			     g_strdup (CD_DEVICE_PROPERTY_KIND),
+			     g_strdup (cd_device_kind_to_string (CD_DEVICE_KIND_DISPLAY)));
+	device1 = cd_client_create_device_sync (client,
+						"colord-test-session1",
+						CD_OBJECT_SCOPE_TEMP,
+						device_props,
+						NULL,
+						&error);
+	g_assert_no_error (error);
+	device2 = cd_client_create_device_sync (client,
+						"colord-test-session2",
+						CD_OBJECT_SCOPE_TEMP,
+						device_props,
+						NULL,
+						&error);
+	g_assert_no_error (error);
+
+	/* the first session locks the sensor */
+	helper1.object_path = path1;
+	subscription_id = g_dbus_connection_signal_subscribe (connection,
+							      "org.freedesktop.ColorHelper",
+							      "org.freedesktop.ColorHelper.Display",
+							      NULL, NULL, NULL,
+							      G_DBUS_SIGNAL_FLAGS_NONE,
+							      colord_session_signal_cb,
+							      &helper1, NULL);
+	value = colord_session_call (connection, path1, "Start",
+				     g_variant_new ("(ssa{sv})",
+						    "colord-test-session1",
+						    cd_sensor_get_id (sensor),
+						    NULL),
+				     &error);
+	g_assert_no_error (error);
+	g_clear_pointer (&value, g_variant_unref);
+	value = colord_session_call (connection, path2, "Start",
+				     g_variant_new ("(ssa{sv})",
+						    "colord-test-session2",
+						    cd_sensor_get_id (sensor),
+						    NULL),
+				     &error);
+	g_assert (value == NULL);
+	g_assert (error != NULL);
+	g_clear_error (&error);
+
+	/* take some samples with monotonic timestamps */
+	value = colord_session_call (connection, path1, "Resume", NULL, &error);
+	g_assert_no_error (error);
+	g_clear_pointer (&value, g_variant_unref);
+	cd_test_loop_run_with_timeout (20000);
+	g_assert_cmpint (helper1.samples, >=, 5);
+
+	/* cancelling finishes the session and removes the object */
+	value = colord_session_call (connection, path1, "Cancel", NULL, &error);
+	g_assert_no_error (error);
+	g_clear_pointer (&value, g_variant_unref);
+	for (i = 0; i < 50 && !helper1.finished; i++)
+		cd_test_loop_run_with_timeout (100);
+	g_assert (helper1.finished);
+	cd_test_loop_run_with_timeout (500);
+	value = colord_session_call (connection, path1, "Cancel", NULL, &error);
+	g_assert (value == NULL);
+	g_assert (error != NULL);
+	g_clear_error (&error);
+
+	/* so the sensor is free for the other display */
+	value = colord_session_call (connection, path2, "Start",
+				     g_variant_new ("(ssa{sv})",
+						    "colord-test-session2",
+						    cd_sensor_get_id (sensor),
+						    NULL),
+				     &error);
+	g_assert_no_error (error);
+	g_clear_pointer (&value, g_variant_unref);
+	value = colord_session_call (connection, path2, "Cancel", NULL, &error);
+	g_assert_no_error (error);
+	g_clear_pointer (&value, g_variant_unref);
+	g_dbus_connection_signal_unsubscribe (connection, subscription_id);
+
+	/* clean up */
+	ret = cd_client_delete_device_sync (client, device1, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	ret = cd_client_delete_device_sync (client, device2, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+}
+
+static gboolean
+colord_client_peer_wait_for_daemon (GDBusConnection *bus, const gchar *socket_path)
+{
+	for (guint i = 0; i < 500; i++) {
+		gboolean has_owner = FALSE;
+		g_autoptr(GVariant) value = NULL;
+		value = g_dbus_connection_call_sync (bus,
+						     "org.freedesktop.DBus",
+						     "/org/freedesktop/DBus",
+						     "org.freedesktop.DBus",
+						     "NameHasOwner",
+						     g_variant_new ("(s)", "org.freedesktop.ColorManager"),
+						     G_VARIANT_TYPE ("(b)"),
+						     G_DBUS_CALL_FLAGS_NONE,
+						     -1, NULL, NULL);
+		if (value != NULL)
+			g_variant_get (value, "(b)", &has_owner);
+		if (has_owner && g_file_test (socket_path, G_FILE_TEST_EXISTS))
+			return TRUE;
+		g_usleep (10000);
+	}
+	return FALSE;
+}
+
+static void
+colord_client_peer_func (void)
+{
+	const gchar *daemon_path = g_getenv ("COLORD_DAEMON");
+	const gchar *argv[] = { NULL, "--peer-socket", NULL,
+				"--database-dir", NULL, NULL };
+	gboolean ret;
+	gdouble elapsed_bus;
+	gdouble elapsed_peer;
+	GPid pid = 0;
+	guint i;
+	guint loops = 1000;
+	GTimer *timer;
+	g_autofree gchar *address = NULL;
+	g_autofree gchar *escaped = NULL;
+	g_autofree gchar *mapping_db = NULL;
+	g_autofree gchar *socket_path = NULL;
+	g_autofree gchar *storage_db = NULL;
+	g_autofree gchar *tmpdir = NULL;
+	g_auto(GStrv) envp = NULL;
+	g_autoptr(GDBusConnection) bus = NULL;
+	g_autoptr(GDBusConnection) peer = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GTestDBus) test_dbus = NULL;
+	g_autoptr(GVariant) devices_bus = NULL;
+	g_autoptr(GVariant) devices_peer = NULL;
+	g_autoptr(GVariant) value = NULL;
+
+	/* run a daemon from the build tree on a private bus */
+	if (daemon_path == NULL || !g_file_test (daemon_path, G_FILE_TEST_IS_EXECUTABLE)) {
+		g_test_skip ("no COLORD_DAEMON set");
+		return;
+	}
+	tmpdir = g_dir_make_tmp ("colord-peer-XXXXXX", &error);
+	g_assert_no_error (error);
+	socket_path = g_build_filename (tmpdir, "colord.socket", NULL);
+	mapping_db = g_build_filename (tmpdir, "mapping.db", NULL);
+	storage_db = g_build_filename (tmpdir, "storage.db", NULL);
+	test_dbus = g_test_dbus_new (G_TEST_DBUS_NONE);
+	g_test_dbus_up (test_dbus);
+	envp = g_environ_setenv (g_get_environ (),
+				 "DBUS_SYSTEM_BUS_ADDRESS",
+				 g_test_dbus_get_bus_address (test_dbus),
+				 TRUE);
+	argv[0] = daemon_path;
+	argv[2] = socket_path;
+	argv[4] = tmpdir;
+	ret = g_spawn_async (NULL, (gchar **) argv, envp,
+			     G_SPAWN_DO_NOT_REAP_CHILD, NULL, NULL, &pid, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+
+	/* connect both ways */
+	bus = g_dbus_connection_new_for_address_sync (g_test_dbus_get_bus_address (test_dbus),
+						      G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT |
+						      G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION,
+						      NULL, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (bus != NULL);
+	g_assert (colord_client_peer_wait_for_daemon (bus, socket_path));
+	escaped = g_dbus_address_escape_value (socket_path);
+	address = g_strdup_printf ("unix:path=%s", escaped);
+	peer = g_dbus_connection_new_for_address_sync (address,
+						       G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT,
+						       NULL, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (peer != NULL);
+
+	/* the same object tree is exported */
+	devices_bus = g_dbus_connection_call_sync (bus,
+						   "org.freedesktop.ColorManager",
+						   "/org/freedesktop/ColorManager",
+						   "org.freedesktop.ColorManager",
+						   "GetDevices",
+						   NULL, NULL,
+						   G_DBUS_CALL_FLAGS_NONE,
+						   -1, NULL, &error);
+	g_assert_no_error (error);
+	devices_peer = g_dbus_connection_call_sync (peer,
+						    NULL,
+						    "/org/freedesktop/ColorManager",
+						    "org.freedesktop.ColorManager",
+						    "GetDevices",
+						    NULL, NULL,
+						    G_DBUS_CALL_FLAGS_NONE,
+						    -1, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (g_variant_equal (devices_bus, devices_peer));
+
+	/* methods that change state are only allowed on the bus */
+	value = g_dbus_connection_call_sync (peer,
+					     NULL,
+					     "/org/freedesktop/ColorManager",
+					     "org.freedesktop.ColorManager",
+					     "DeleteDevice",
+					     g_variant_new ("(o)", "/org/freedesktop/ColorManager/devices/dave"),
+					     NULL,
+					     G_DBUS_CALL_FLAGS_NONE,
+					     -1, NULL, &error);
+	g_assert_error (error, CD_CLIENT_ERROR, CD_CLIENT_ERROR_NOT_SUPPORTED);
+	g_assert (value == NULL);
+
+	/* compare the round-trip latency */
+	timer = g_timer_new ();
+	for (i = 0; i < loops; i++) {
+		g_autoptr(GVariant) tmp = NULL;
+		tmp = g_dbus_connection_call_sync (bus,
+						   "org.freedesktop.ColorManager",
+						   "/org/freedesktop/ColorManager",
+						   "org.freedesktop.ColorManager",
+						   "GetDevices",
+						   NULL, NULL,
+						   G_DBUS_CALL_FLAGS_NONE,
+						   -1, NULL, NULL);
+		g_assert (tmp != NULL);
+	}
+	elapsed_bus = g_timer_elapsed (timer, NULL);
+	g_timer_reset (timer);
+	for (i = 0; i < loops; i++) {
+		g_autoptr(GVariant) tmp = NULL;
+		tmp = g_dbus_connection_call_sync (peer,
+						   NULL,
+						   "/org/freedesktop/ColorManager",
+						   "org.freedesktop.ColorManager",
+						   "GetDevices",
+						   NULL, NULL,
+						   G_DBUS_CALL_FLAGS_NONE,
+						   -1, NULL, NULL);
+		g_assert (tmp != NULL);
+	}
+	elapsed_peer = g_timer_elapsed (timer, NULL);
+	g_print ("GetDevices bus: %.3fms, peer: %.3fms ",
+		 elapsed_bus * 1000.f / loops,
+		 elapsed_peer * 1000.f / loops);
+	if (g_test_perf ())
+		g_assert_cmpfloat (elapsed_peer, <, elapsed_bus);
+	g_timer_destroy (timer);
+
+	/* stop the daemon and the bus */
+	g_dbus_connection_close_sync (peer, NULL, NULL);
+	g_dbus_connection_close_sync (bus, NULL, NULL);
+	kill (pid, SIGTERM);
+	waitpid (pid, NULL, 0);
+	g_spawn_close_pid (pid);
+	g_test_dbus_down (test_dbus);
+	g_unlink (socket_path);
+	g_unlink (mapping_db);
+	g_unlink (storage_db);
+	g_rmdir (tmpdir);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -2732,6 +3135,8 @@ main (int argc, char **argv)
 		g_test_add_func ("/colord/client{systemwide}", colord_client_systemwide_func);
 	g_test_add_func ("/colord/client{fd-pass}", colord_client_fd_pass_func);
 	g_test_add_func ("/colord/client{import}", colord_client_import_func);
+	g_test_add_func ("/colord/client{peer}", colord_client_peer_func);
+	g_test_add_func ("/colord/session", colord_session_func);
 
 	/* run the tests */
 	retval = g_test_run ();
@@ -25,6 +25,7 @@
 #include <locale.h>
 #include <string.h>
 #include <fcntl.h>
+#include <utime.h>
 #include <math.h>
 #include <lcms2.h>
 
@@ -55,24 +56,15 @@ colord_it8_cri_util_func (void)
 {
 	CdIt8 *cmf;
 	CdIt8 *tcs;
-	CdIt8 *test;
 	CdSpectrum *f4;
 	g_autoptr(GError) error = NULL;
 	GFile *file;
 	gboolean ret;
 	gdouble value = 0.f;
 
-	/* load a CMF */
-	cmf = cd_it8_new ();
-	file = g_file_new_for_path ("../build/data/cmf/CIE1931-2deg-XYZ.cmf");
-	if (!g_file_query_exists (file, NULL)) {
-		g_test_skip ("generated files not available");
-		return;
-	}
-	ret = cd_it8_load_from_file (cmf, file, &error);
-	g_assert_no_error (error);
-	g_assert (ret);
-	g_object_unref (file);
+	/* get a CMF */
+	cmf = cd_it8_new_standard_cmf ("CIE1931-2deg-XYZ");
+	g_assert (cmf != NULL);
 	g_assert_cmpint (cd_it8_get_kind (cmf), ==, CD_IT8_KIND_CMF);
 
 	/* load the TCS */
@@ -88,21 +80,8 @@ colord_it8_cri_util_func (void)
 	g_object_unref (file);
 	g_assert_cmpint (cd_it8_get_kind (tcs), ==, CD_IT8_KIND_SPECT);
 
-	/* load the test spectra */
-	test = cd_it8_new ();
-	file = g_file_new_for_path ("../build/data/illuminant/CIE-F4.sp");
-	if (!g_file_query_exists (file, NULL)) {
-		g_test_skip ("generated files not available");
-		return;
-	}
-	ret = cd_it8_load_from_file (test, file, &error);
-	g_assert_no_error (error);
-	g_assert (ret);
-	g_object_unref (file);
-	g_assert_cmpint (cd_it8_get_kind (test), ==, CD_IT8_KIND_SPECT);
-
 	/* calculate the CRI */
-	f4 = cd_it8_get_spectrum_by_id (test, "1");
+	f4 = cd_spectrum_new_standard_illuminant ("CIE-F4");
 	g_assert (f4 != NULL);
 	ret = cd_it8_utils_calculate_cri_from_cmf (cmf, tcs, f4, &value, 1.0f, &error);
 	g_assert_no_error (error);
@@ -112,12 +91,239 @@ colord_it8_cri_util_func (void)
 	g_assert_cmpfloat (value, <, 52);
 	g_assert_cmpfloat (value, >, 50);
 
-	g_object_unref (test);
+	cd_spectrum_free (f4);
 	g_object_unref (cmf);
 	g_object_unref (tcs);
 
 }
 
+static CdIt8 *
+colord_it8_tm30_create_samples (void)
+{
+	CdIt8 *ces;
+	guint i;
+	guint j;
+
+	/* smooth band-pass and band-stop reflectances that cover every hue */
+	ces = cd_it8_new_with_kind (CD_IT8_KIND_SPECT);
+	for (i = 0; i < 99; i++) {
+		g_autofree gchar *id = g_strdup_printf ("CES%02u", i + 1);
+		g_autoptr(CdSpectrum) s = cd_spectrum_sized_new (81);
+		for (j = 0; j < 81; j++) {
+			gdouble wl = 380 + j * 5;
+			gdouble peak;
+			if (i < 60) {
+				peak = 380 + i * 400.f / 59;
+				cd_spectrum_add_value (s, 0.1 + 0.7 * exp (-pow ((wl - peak) / 40, 2)));
+			} else {
+				peak = 380 + (i - 60) * 400.f / 38;
+				cd_spectrum_add_value (s, 0.8 - 0.7 * exp (-pow ((wl - peak) / 40, 2)));
+			}
+		}
+		cd_spectrum_set_id (s, id);
+		cd_spectrum_set_start (s, 380);
+		cd_spectrum_set_end (s, 780);
+		cd_it8_add_spectrum (ces, s);
+	}
+	return ces;
+}
+
+/* the official 99 colour evaluation samples cannot be generated, so the
+ * published values are only checked when a copy is supplied */
+static void
+colord_it8_tm30_reference_func (void)
+{
+	const gchar *filename;
+	gboolean ret;
+	guint i;
+	g_autoptr(CdIt8) ces = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GFile) file = NULL;
+	g_autoptr(GPtrArray) samples = NULL;
+	struct {
+		const gchar	*illuminant;
+		gdouble		 rf;
+		gdouble		 rg;	/* or 0 for unchecked */
+	} data[] = {
+		{ "CIE-A",	100.0,	100.0 },
+		{ "CIE-D65",	100.0,	100.0 },
+		{ "CIE-F2",	70.1,	0 },	/* CIE 224:2017 */
+		{ NULL,		0,	0 } };
+
+	filename = g_getenv ("COLORD_TM30_CES");
+	if (filename == NULL) {
+		g_test_skip ("set COLORD_TM30_CES to the 99 CES as a .sp file");
+		return;
+	}
+	ces = cd_it8_new ();
+	file = g_file_new_for_path (filename);
+	ret = cd_it8_load_from_file (ces, file, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	samples = cd_it8_get_spectrum_array (ces);
+	g_assert_cmpint (samples->len, ==, 99);
+
+	/* published to one decimal place */
+	for (i = 0; data[i].illuminant != NULL; i++) {
+		CdTm30 value;
+		g_autoptr(CdSpectrum) illuminant = NULL;
+		illuminant = cd_spectrum_new_standard_illuminant (data[i].illuminant);
+		g_assert (illuminant != NULL);
+		ret = cd_it8_utils_calculate_tm30 (ces, illuminant, &value, &error);
+		g_assert_no_error (error);
+		g_assert (ret);
+		g_print ("%s: Rf=%.2f Rg=%.2f ", data[i].illuminant, value.rf, value.rg);
+		g_assert_cmpfloat (ABS (value.rf - data[i].rf), <=, 0.05);
+		if (data[i].rg > 0)
+			g_assert_cmpfloat (ABS (value.rg - data[i].rg), <=, 0.05);
+	}
+}
+
+static void
+colord_it8_tm30_func (void)
+{
+	CdTm30 value;
+	GTimer *timer;
+	gboolean ret;
+	guint i;
+	g_autoptr(CdIt8) ces = NULL;
+	g_autoptr(CdIt8) tcs = NULL;
+	g_autoptr(CdSpectrum) d65 = NULL;
+	g_autoptr(CdSpectrum) f4 = NULL;
+	g_autoptr(CdSpectrum) planckian = NULL;
+	g_autoptr(GArray) results = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GPtrArray) illuminants = NULL;
+
+	/* not enough samples */
+	tcs = cd_it8_new_with_kind (CD_IT8_KIND_SPECT);
+	d65 = cd_spectrum_new_standard_illuminant ("CIE-D65");
+	ret = cd_it8_utils_calculate_tm30 (tcs, d65, &value, &error);
+	g_assert_error (error, CD_IT8_ERROR, CD_IT8_ERROR_FAILED);
+	g_assert (!ret);
+	g_clear_error (&error);
+
+	/* a Planckian source is its own reference */
+	ces = colord_it8_tm30_create_samples ();
+	planckian = cd_spectrum_planckian_new (2940);
+	ret = cd_it8_utils_calculate_tm30 (ces, planckian, &value, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpfloat (ABS (value.cct - 2940), <, 20);
+	g_assert_cmpfloat (value.rf, >, 99.5);
+	g_assert_cmpfloat (ABS (value.rg - 100), <, 0.5);
+	for (i = 0; i < CD_TM30_HUE_BINS; i++) {
+		g_assert_cmpfloat (value.rf_hue[i], >, 99);
+		g_assert_cmpfloat (ABS (value.rcs_hue[i]), <, 0.01);
+		g_assert_cmpfloat (ABS (value.rhs_hue[i]), <, 0.01);
+	}
+
+	/* so is CIE D65 */
+	ret = cd_it8_utils_calculate_tm30 (ces, d65, &value, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpfloat (value.rf, >, 99.5);
+	g_assert_cmpfloat (ABS (value.rg - 100), <, 0.5);
+
+	/* a warm white fluorescent tube is not; this only guards against
+	 * regressions as the samples are synthetic, the published values are
+	 * checked in colord_it8_tm30_reference_func() */
+	f4 = cd_spectrum_new_standard_illuminant ("CIE-F4");
+	ret = cd_it8_utils_calculate_tm30 (ces, f4, &value, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpfloat (ABS (value.cct - 2940), <, 20);
+	g_assert_cmpfloat (ABS (value.rf - 56.76), <, 0.5);
+	g_assert_cmpfloat (value.rg, >, 80);
+	g_assert_cmpfloat (value.rg, <, 90);
+
+	/* score lots of sources at once */
+	illuminants = g_ptr_array_new ();
+	for (i = 0; i < 1000; i++)
+		g_ptr_array_add (illuminants, i % 2 == 0 ? f4 : d65);
+	timer = g_timer_new ();
+	results = cd_it8_utils_calculate_tm30_array (ces, illuminants, &error);
+	g_assert_no_error (error);
+	g_assert (results != NULL);
+	g_assert_cmpint (results->len, ==, 1000);
+	g_assert_cmpfloat (ABS (g_array_index (results, CdTm30, 0).rf - value.rf), <, 0.0001);
+	g_print ("1000 sources = %.2fms\n", g_timer_elapsed (timer, NULL) * 1000);
+	g_timer_destroy (timer);
+}
+
+static void
+colord_it8_standard_func (void)
+{
+	CdColorXYZ value;
+	CdSpectrum *tmp;
+	GTimer *timer;
+	gboolean ret;
+	gdouble elapsed_file = 0.f;
+	gdouble elapsed_standard;
+	guint i;
+	g_autoptr(CdIt8) cmf = NULL;
+	g_autoptr(CdSpectrum) d65 = NULL;
+	g_autoptr(CdSpectrum) unity = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GFile) file = NULL;
+
+	/* unknown */
+	g_assert (cd_it8_new_standard_cmf ("CIE1900-1deg-XYZ") == NULL);
+	g_assert (cd_spectrum_new_standard_illuminant ("CIE-Z") == NULL);
+
+	/* check the CMF */
+	cmf = cd_it8_new_standard_cmf ("CIE1931-2deg-XYZ");
+	g_assert (cmf != NULL);
+	g_assert_cmpstr (cd_it8_get_title (cmf), ==, "CIE1931-2deg-XYZ");
+	tmp = cd_it8_get_spectrum_by_id (cmf, "Y");
+	g_assert (tmp != NULL);
+	g_assert_cmpfloat (ABS (cd_spectrum_get_start (tmp) - 360.f), <, 0.0001f);
+	g_assert_cmpfloat (ABS (cd_spectrum_get_end (tmp) - 830.f), <, 0.0001f);
+	g_assert_cmpint (cd_spectrum_get_size (tmp), ==, 95);
+	g_assert_cmpfloat (ABS (cd_spectrum_get_value_for_nm (tmp, 555) - 1.f), <, 0.0001f);
+
+	/* check the illuminant */
+	d65 = cd_spectrum_new_standard_illuminant ("CIE-D65");
+	g_assert (d65 != NULL);
+	g_assert_cmpstr (cd_spectrum_get_id (d65), ==, "CIE-D65");
+	g_assert_cmpfloat (ABS (cd_spectrum_get_start (d65) - 300.f), <, 0.0001f);
+	g_assert_cmpfloat (ABS (cd_spectrum_get_end (d65) - 830.f), <, 0.0001f);
+	g_assert_cmpint (cd_spectrum_get_size (d65), ==, 107);
+	g_assert_cmpfloat (ABS (cd_spectrum_get_value_for_nm (d65, 560) - 1.f), <, 0.0001f);
+
+	/* D65 is the D65 whitepoint */
+	unity = cd_spectrum_new ();
+	ret = cd_it8_utils_calculate_xyz_from_cmf (cmf, unity, d65, &value, 1.f, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	cd_color_xyz_normalize (&value, 1.0, &value);
+	g_assert_cmpfloat (value.X, >, 0.95047f - 0.01);
+	g_assert_cmpfloat (value.X, <, 0.95047f + 0.01);
+	g_assert_cmpfloat (value.Z, >, 1.08883f - 0.01);
+	g_assert_cmpfloat (value.Z, <, 1.08883f + 0.01);
+
+	/* compare against parsing the generated CGATS file */
+	timer = g_timer_new ();
+	for (i = 0; i < 100; i++) {
+		g_autoptr(CdIt8) cmf_tmp = cd_it8_new_standard_cmf ("CIE1931-2deg-XYZ");
+		g_assert (cmf_tmp != NULL);
+	}
+	elapsed_standard = g_timer_elapsed (timer, NULL) * 10;
+	file = g_file_new_for_path ("../build/data/cmf/CIE1931-2deg-XYZ.cmf");
+	if (g_file_query_exists (file, NULL)) {
+		g_timer_reset (timer);
+		for (i = 0; i < 100; i++) {
+			g_autoptr(CdIt8) cmf_tmp = cd_it8_new ();
+			ret = cd_it8_load_from_file (cmf_tmp, file, &error);
+			g_assert_no_error (error);
+			g_assert (ret);
+		}
+		elapsed_file = g_timer_elapsed (timer, NULL) * 10;
+	}
+	g_print ("file = %.2fms, standard = %.2fms\n", elapsed_file, elapsed_standard);
+	g_timer_destroy (timer);
+}
+
 static void
 colord_it8_spectra_util_func (void)
 {
@@ -762,6 +968,121 @@ colord_it8_ccmx_util_func (void)
 	g_object_unref (ccmx);
 }
 
+static void
+colord_it8_ccmx_lsq_func (void)
+{
+	CdCcmxResidual residual;
+	CdMat3x3 actual;
+	CdMat3x3 actual_inv;
+	GTimer *timer;
+	const CdMat3x3 *matrix;
+	gboolean ret;
+	gdouble weights[100];
+	guint i;
+	g_autoptr(CdIt8) ccmx = NULL;
+	g_autoptr(CdIt8) meas = NULL;
+	g_autoptr(CdIt8) ref = NULL;
+	g_autoptr(GArray) residuals = NULL;
+	g_autoptr(GArray) weights_pair = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GPtrArray) ccmx_array = NULL;
+	g_autoptr(GPtrArray) meas_array = NULL;
+	g_autoptr(GPtrArray) ref_array = NULL;
+	g_autoptr(GPtrArray) weights_array = NULL;
+	g_autoptr(GRand) rand = g_rand_new_with_seed (0);
+
+	/* a colorimeter that reads slightly wrong */
+	cd_mat33_init (&actual,
+		       1.05f, 0.02f, -0.03f,
+		       0.01f, 0.98f, 0.04f,
+		       -0.02f, 0.03f, 1.10f);
+	ret = cd_mat33_reciprocal (&actual, &actual_inv);
+	g_assert (ret);
+
+	/* measure lots of patches, one of which is completely wrong */
+	ref = cd_it8_new_with_kind (CD_IT8_KIND_TI3);
+	meas = cd_it8_new_with_kind (CD_IT8_KIND_TI3);
+	for (i = 0; i < 100; i++) {
+		CdColorRGB rgb;
+		CdColorXYZ xyz;
+		CdVec3 tmp;
+		CdVec3 tmp_meas;
+
+		cd_color_rgb_set (&rgb, 1.f, 1.f, 1.f);
+		cd_vec3_init (&tmp,
+			      g_rand_double_range (rand, 1.f, 95.f),
+			      g_rand_double_range (rand, 1.f, 100.f),
+			      g_rand_double_range (rand, 1.f, 108.f));
+		cd_color_xyz_set (&xyz, tmp.v0, tmp.v1, tmp.v2);
+		cd_it8_add_data (ref, &rgb, &xyz);
+		cd_mat33_vector_multiply (&actual_inv, &tmp, &tmp_meas);
+		if (i == 50)
+			tmp_meas.v1 *= 2.f;
+		cd_color_xyz_set (&xyz, tmp_meas.v0, tmp_meas.v1, tmp_meas.v2);
+		cd_it8_add_data (meas, &rgb, &xyz);
+		weights[i] = i == 50 ? 0.f : 1.f;
+	}
+
+	/* the outlier spoils the fit */
+	ccmx = cd_it8_new_with_kind (CD_IT8_KIND_CCMX);
+	ret = cd_it8_utils_calculate_ccmx_lsq (ref, meas, NULL, ccmx, &residual, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpfloat (residual.delta_e_max, >, 1.f);
+
+	/* unless it is ignored */
+	ret = cd_it8_utils_calculate_ccmx_lsq (ref, meas, weights, ccmx, &residual, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	matrix = cd_it8_get_matrix (ccmx);
+	g_assert_cmpfloat (ABS (matrix->m00 - actual.m00), <, 0.0001);
+	g_assert_cmpfloat (ABS (matrix->m12 - actual.m12), <, 0.0001);
+	g_assert_cmpfloat (ABS (matrix->m20 - actual.m20), <, 0.0001);
+	g_assert_cmpfloat (residual.delta_e_mean, <, 0.01f);
+
+	/* correct a fleet of colorimeters against the same reference */
+	weights_pair = g_array_sized_new (FALSE, FALSE, sizeof (gdouble), 100);
+	g_array_append_vals (weights_pair, weights, 100);
+	ref_array = g_ptr_array_new ();
+	meas_array = g_ptr_array_new ();
+	weights_array = g_ptr_array_new ();
+	for (i = 0; i < 500; i++) {
+		g_ptr_array_add (ref_array, ref);
+		g_ptr_array_add (meas_array, meas);
+		g_ptr_array_add (weights_array, i % 2 == 0 ? weights_pair : NULL);
+	}
+	residuals = g_array_new (FALSE, FALSE, sizeof (CdCcmxResidual));
+	timer = g_timer_new ();
+	ccmx_array = cd_it8_utils_calculate_ccmx_lsq_array (ref_array,
+							    meas_array,
+							    weights_array,
+							    residuals,
+							    &error);
+	g_assert_no_error (error);
+	g_assert (ccmx_array != NULL);
+	g_assert_cmpint (ccmx_array->len, ==, 500);
+	g_assert_cmpint (residuals->len, ==, 500);
+	g_print ("500 pairs = %.2fms\n", g_timer_elapsed (timer, NULL) * 1000);
+	g_timer_destroy (timer);
+
+	/* the weights are used for the pairs that have them */
+	matrix = cd_it8_get_matrix (g_ptr_array_index (ccmx_array, 0));
+	g_assert_cmpfloat (ABS (matrix->m00 - actual.m00), <, 0.0001);
+	g_assert_cmpfloat (g_array_index (residuals, CdCcmxResidual, 0).delta_e_mean, <, 0.01f);
+	g_assert_cmpfloat (g_array_index (residuals, CdCcmxResidual, 1).delta_e_max, >, 1.f);
+
+	/* the weights have to match the patches */
+	g_array_set_size (weights_pair, 99);
+	g_ptr_array_unref (ccmx_array);
+	ccmx_array = cd_it8_utils_calculate_ccmx_lsq_array (ref_array,
+							    meas_array,
+							    weights_array,
+							    NULL,
+							    &error);
+	g_assert_error (error, 1, 0);
+	g_assert (ccmx_array == NULL);
+}
+
 static void
 colord_it8_ccmx_func (void)
 {
@@ -1187,6 +1508,42 @@ colord_color_interpolate_func (void)
 	g_assert_cmpint (result->len, ==, 10);
 }
 
+static void
+colord_color_hdr_func (void)
+{
+	/* SMPTE ST 2084 */
+	g_assert_cmpfloat (cd_color_pq_to_luminance (0.f), ==, 0.f);
+	g_assert_cmpfloat (fabs (cd_color_pq_to_luminance (0.25f) - 5.1542f), <, 0.001);
+	g_assert_cmpfloat (fabs (cd_color_pq_to_luminance (0.5f) - 92.2457f), <, 0.001);
+	g_assert_cmpfloat (fabs (cd_color_pq_to_luminance (0.75f) - 983.3779f), <, 0.01);
+	g_assert_cmpfloat (cd_color_pq_to_luminance (1.f), ==, 10000.f);
+	g_assert_cmpfloat (fabs (cd_color_luminance_to_pq (100.f) - 0.5081f), <, 0.0001);
+	g_assert_cmpfloat (fabs (cd_color_luminance_to_pq (203.f) - 0.5807f), <, 0.0001);
+	g_assert_cmpfloat (fabs (cd_color_luminance_to_pq (1000.f) - 0.7518f), <, 0.0001);
+	g_assert_cmpfloat (fabs (cd_color_luminance_to_pq (cd_color_pq_to_luminance (0.3f)) - 0.3f), <, 0.00001);
+
+	/* ITU-R BT.2100 HLG */
+	g_assert_cmpfloat (cd_color_hlg_to_scene_linear (0.f), ==, 0.f);
+	g_assert_cmpfloat (fabs (cd_color_hlg_to_scene_linear (0.25f) - 0.020833f), <, 0.000001);
+	g_assert_cmpfloat (fabs (cd_color_hlg_to_scene_linear (0.5f) - 0.083333f), <, 0.000001);
+	g_assert_cmpfloat (fabs (cd_color_hlg_to_scene_linear (0.75f) - 0.264963f), <, 0.000001);
+	g_assert_cmpfloat (fabs (cd_color_hlg_to_scene_linear (1.f) - 1.f), <, 0.000001);
+
+	/* ITU-R BT.2390 EETF, which only touches the highlights */
+	g_assert_cmpfloat (fabs (cd_color_tone_map_bt2390 (10.f, 1000.f, 100.f) - 10.f), <, 0.001);
+	g_assert_cmpfloat (fabs (cd_color_tone_map_bt2390 (50.f, 1000.f, 100.f) - 46.1430f), <, 0.001);
+	g_assert_cmpfloat (fabs (cd_color_tone_map_bt2390 (100.f, 1000.f, 100.f) - 69.4544f), <, 0.001);
+	g_assert_cmpfloat (fabs (cd_color_tone_map_bt2390 (500.f, 1000.f, 100.f) - 98.9469f), <, 0.001);
+	g_assert_cmpfloat (fabs (cd_color_tone_map_bt2390 (1000.f, 1000.f, 100.f) - 100.f), <, 0.001);
+	g_assert_cmpfloat (fabs (cd_color_tone_map_bt2390 (4000.f, 1000.f, 100.f) - 100.f), <, 0.001);
+	g_assert_cmpfloat (fabs (cd_color_tone_map_bt2390 (203.f, 4000.f, 203.f) - 127.9345f), <, 0.001);
+	g_assert_cmpfloat (fabs (cd_color_tone_map_bt2390 (1000.f, 4000.f, 203.f) - 193.6963f), <, 0.001);
+
+	/* a brighter target only clips */
+	g_assert_cmpfloat (cd_color_tone_map_bt2390 (500.f, 1000.f, 2000.f), ==, 500.f);
+	g_assert_cmpfloat (cd_color_tone_map_bt2390 (1500.f, 1000.f, 2000.f), ==, 1000.f);
+}
+
 static void
 colord_color_blackbody_func (void)
 {
@@ -1940,6 +2297,643 @@ colord_transform_func (void)
 	g_object_unref (transform);
 }
 
+static CdTransform *
+colord_transform_cache_new (const gchar *filename)
+{
+	CdTransform *transform;
+	gboolean ret;
+	g_autoptr(CdIcc) icc = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GFile) file = NULL;
+
+	transform = cd_transform_new ();
+	cd_transform_set_rendering_intent (transform, CD_RENDERING_INTENT_PERCEPTUAL);
+	cd_transform_set_input_pixel_format (transform, CD_PIXEL_FORMAT_RGB24);
+	cd_transform_set_output_pixel_format (transform, CD_PIXEL_FORMAT_RGB24);
+	file = g_file_new_for_path (filename);
+	icc = cd_icc_new ();
+	ret = cd_icc_load_file (icc,
+				file,
+				CD_ICC_LOAD_FLAGS_NONE,
+				NULL,
+				&error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	cd_transform_set_output_icc (transform, icc);
+	return transform;
+}
+
+static guint
+colord_transform_cache_get_size (const gchar *cachedir)
+{
+	guint cnt = 0;
+	g_autoptr(GDir) dir = NULL;
+
+	dir = g_dir_open (cachedir, 0, NULL);
+	if (dir == NULL)
+		return 0;
+	while (g_dir_read_name (dir) != NULL)
+		cnt++;
+	return cnt;
+}
+
+/* the transform caches hold no subdirectories */
+static void
+colord_transform_cache_remove (const gchar *cachedir)
+{
+	const gchar *fn;
+	g_autoptr(GDir) dir = NULL;
+
+	dir = g_dir_open (cachedir, 0, NULL);
+	if (dir == NULL)
+		return;
+	while ((fn = g_dir_read_name (dir)) != NULL) {
+		g_autofree gchar *tmp = g_build_filename (cachedir, fn, NULL);
+		g_unlink (tmp);
+	}
+	g_rmdir (cachedir);
+}
+
+static void
+colord_transform_cache_func (void)
+{
+	cmsCIEXYZ *red;
+	gboolean ret;
+	gdouble elapsed_miss;
+	gdouble elapsed_hit;
+	guint8 data_in[3] = { 127, 32, 64 };
+	guint8 data_out[3];
+	guint i;
+	g_autofree gchar *cachedir = NULL;
+	g_autofree gchar *cachedir_old = NULL;
+	g_autofree gchar *filename = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GTimer) timer = g_timer_new ();
+	g_autoptr(CdTransform) transform1 = NULL;
+	g_autoptr(CdTransform) transform2 = NULL;
+	g_autoptr(CdTransform) transform3 = NULL;
+	g_autoptr(CdTransform) transform4 = NULL;
+
+	/* use an empty cache */
+	cachedir_old = g_strdup (g_getenv ("COLORD_TRANSFORM_CACHE_DIR"));
+	cachedir = g_dir_make_tmp ("colord-transforms-XXXXXX", &error);
+	g_assert_no_error (error);
+	g_assert (cachedir != NULL);
+	(void)g_setenv ("COLORD_TRANSFORM_CACHE_DIR", cachedir, TRUE);
+
+	/* opting out does not write anything */
+	filename = cd_test_get_filename ("ibm-t61.icc");
+	transform1 = colord_transform_cache_new (filename);
+	g_assert (cd_transform_get_use_cache (transform1));
+	cd_transform_set_use_cache (transform1, FALSE);
+	ret = cd_transform_process (transform1, data_in, data_out,
+				    1, 1, 1, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpint (colord_transform_cache_get_size (cachedir), ==, 0);
+
+	/* cache miss creates a device link */
+	transform2 = colord_transform_cache_new (filename);
+	g_timer_reset (timer);
+	ret = cd_transform_process (transform2, data_in, data_out,
+				    1, 1, 1, NULL, &error);
+	elapsed_miss = g_timer_elapsed (timer, NULL) * 1000;
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpint (data_out[0], ==, 144);
+	g_assert_cmpint (data_out[1], ==, 0);
+	g_assert_cmpint (data_out[2], ==, 69);
+	g_assert_cmpint (colord_transform_cache_get_size (cachedir), ==, 1);
+
+	/* cache hit uses the device link */
+	transform3 = colord_transform_cache_new (filename);
+	g_timer_reset (timer);
+	ret = cd_transform_process (transform3, data_in, data_out,
+				    1, 1, 1, NULL, &error);
+	elapsed_hit = g_timer_elapsed (timer, NULL) * 1000;
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpint (ABS (data_out[0] - 144), <=, 1);
+	g_assert_cmpint (ABS (data_out[1] - 0), <=, 1);
+	g_assert_cmpint (ABS (data_out[2] - 69), <=, 1);
+	g_assert_cmpint (colord_transform_cache_get_size (cachedir), ==, 1);
+	g_print ("miss = %.2fms, hit = %.2fms\n", elapsed_miss, elapsed_hit);
+
+	/* changing the profile after it was loaded does not use the old link */
+	transform4 = colord_transform_cache_new (filename);
+	red = cmsReadTag (cd_icc_get_handle (cd_transform_get_output_icc (transform4)),
+			  cmsSigRedColorantTag);
+	g_assert (red != NULL);
+	red->X *= 0.5;
+	ret = cd_transform_process (transform4, data_in, data_out,
+				    1, 1, 1, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpint (ABS (data_out[0] - 144) + ABS (data_out[2] - 69), >, 2);
+	g_assert_cmpint (colord_transform_cache_get_size (cachedir), ==, 2);
+
+	/* check the cache is bounded */
+	for (i = 0; i < 32; i++) {
+		g_autofree gchar *fn = NULL;
+		g_autofree gchar *blob = g_malloc0 (1024 * 1024);
+		fn = g_strdup_printf ("%s/%02u.icc", cachedir, i);
+		ret = g_file_set_contents (fn, blob, 1024 * 1024, &error);
+		g_assert_no_error (error);
+		g_assert (ret);
+	}
+	cd_transform_set_bpc (transform3, TRUE);
+	ret = cd_transform_process (transform3, data_in, data_out,
+				    1, 1, 1, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpint (colord_transform_cache_get_size (cachedir), <, 20);
+
+	colord_transform_cache_remove (cachedir);
+	if (cachedir_old != NULL)
+		(void)g_setenv ("COLORD_TRANSFORM_CACHE_DIR", cachedir_old, TRUE);
+	else
+		g_unsetenv ("COLORD_TRANSFORM_CACHE_DIR");
+}
+
+static void
+colord_transform_ycbcr_check (CdTransform *transform,
+			      guint8 y, guint8 cb, guint8 cr,
+			      guint8 r, guint8 g, guint8 b)
+{
+	gboolean ret;
+	guint8 data_in[6] = { y, y, y, y, cb, cr };
+	guint8 data_out[12];
+	g_autoptr(GError) error = NULL;
+
+	/* 2x2 I420 frame of one colour */
+	ret = cd_transform_process (transform, data_in, data_out,
+				    2, 2, 2, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpint (ABS (data_out[0] - r), <=, 2);
+	g_assert_cmpint (ABS (data_out[1] - g), <=, 2);
+	g_assert_cmpint (ABS (data_out[2] - b), <=, 2);
+}
+
+static void
+colord_transform_ycbcr_func (void)
+{
+	const guint height = 1080;
+	const guint width = 1920;
+	gboolean ret;
+	gsize frame_size = width * height * 3 / 2;
+	guint i, x;
+	g_autofree guint8 *i420 = g_new (guint8, frame_size);
+	g_autofree guint8 *nv12 = g_new (guint8, frame_size);
+	g_autofree guint8 *out_i420 = g_new0 (guint8, width * height * 3);
+	g_autofree guint8 *out_nv12 = g_new0 (guint8, width * height * 3);
+	g_autoptr(CdTransform) transform = cd_transform_new ();
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GTimer) timer = g_timer_new ();
+
+	/* sRGB to sRGB so only the decoding matters */
+	cd_transform_set_use_cache (transform, FALSE);
+	cd_transform_set_rendering_intent (transform, CD_RENDERING_INTENT_PERCEPTUAL);
+	cd_transform_set_input_pixel_format (transform, CD_PIXEL_FORMAT_I420);
+	cd_transform_set_output_pixel_format (transform, CD_PIXEL_FORMAT_RGB24);
+	g_assert_cmpint (cd_transform_get_ycbcr_matrix (transform), ==, CD_TRANSFORM_YCBCR_MATRIX_BT709);
+	g_assert_cmpint (cd_transform_get_ycbcr_range (transform), ==, CD_TRANSFORM_YCBCR_RANGE_LIMITED);
+
+	/* BT.709 limited range */
+	colord_transform_ycbcr_check (transform, 16, 128, 128, 0, 0, 0);
+	colord_transform_ycbcr_check (transform, 235, 128, 128, 255, 255, 255);
+	colord_transform_ycbcr_check (transform, 63, 102, 240, 255, 0, 0);
+	colord_transform_ycbcr_check (transform, 173, 42, 26, 0, 255, 0);
+
+	/* BT.601 full range, as used by JPEG */
+	cd_transform_set_ycbcr_matrix (transform, CD_TRANSFORM_YCBCR_MATRIX_BT601);
+	cd_transform_set_ycbcr_range (transform, CD_TRANSFORM_YCBCR_RANGE_FULL);
+	colord_transform_ycbcr_check (transform, 0, 128, 128, 0, 0, 0);
+	colord_transform_ycbcr_check (transform, 255, 128, 128, 255, 255, 255);
+	colord_transform_ycbcr_check (transform, 76, 85, 255, 254, 0, 0);
+
+	/* BT.2020 limited range */
+	cd_transform_set_ycbcr_matrix (transform, CD_TRANSFORM_YCBCR_MATRIX_BT2020);
+	cd_transform_set_ycbcr_range (transform, CD_TRANSFORM_YCBCR_RANGE_LIMITED);
+	colord_transform_ycbcr_check (transform, 74, 97, 240, 255, 0, 0);
+
+	/* the same synthetic frame as I420 and NV12 */
+	for (i = 0; i < width * height; i++)
+		i420[i] = nv12[i] = 16 + (i % width) * 219 / width;
+	for (i = 0; i < height / 2; i++) {
+		for (x = 0; x < width / 2; x++) {
+			guint8 cb = 16 + x * 224 / (width / 2);
+			guint8 cr = 16 + i * 224 / (height / 2);
+			guint8 *p = i420 + width * height;
+			p[i * (width / 2) + x] = cb;
+			p[(width / 2) * (height / 2) + i * (width / 2) + x] = cr;
+			p = nv12 + width * height;
+			p[i * width + x * 2 + 0] = cb;
+			p[i * width + x * 2 + 1] = cr;
+		}
+	}
+	g_timer_reset (timer);
+	ret = cd_transform_process (transform, i420, out_i420,
+				    width, height, width, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_print ("I420 = %.2fms, ", g_timer_elapsed (timer, NULL) * 1000);
+	cd_transform_set_input_pixel_format (transform, CD_PIXEL_FORMAT_NV12);
+	g_timer_reset (timer);
+	ret = cd_transform_process (transform, nv12, out_nv12,
+				    width, height, width, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_print ("NV12 = %.2fms\n", g_timer_elapsed (timer, NULL) * 1000);
+	g_assert_cmpint (memcmp (out_i420, out_nv12, width * height * 3), ==, 0);
+
+	/* threaded gives the same result */
+	cd_transform_set_max_threads (transform, 4);
+	memset (out_nv12, 0, width * height * 3);
+	ret = cd_transform_process (transform, nv12, out_nv12,
+				    width, height, width, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpint (memcmp (out_i420, out_nv12, width * height * 3), ==, 0);
+
+	/* the chroma would be overwritten before it was used */
+	ret = cd_transform_process (transform, nv12, nv12,
+				    width, height, width, NULL, &error);
+	g_assert_error (error, CD_TRANSFORM_ERROR, CD_TRANSFORM_ERROR_FAILED_TO_SETUP_TRANSFORM);
+	g_assert (!ret);
+	g_clear_error (&error);
+
+	/* not the same as any lcms2 format */
+	g_assert_cmpint (CD_PIXEL_FORMAT_I420, !=, TYPE_YCbCr_8_PLANAR);
+}
+
+static CdIcc *
+colord_transform_abstract_new (gdouble bright)
+{
+	CdIcc *icc = cd_icc_new ();
+	cmsHPROFILE lcms_profile;
+	gboolean ret;
+	g_autoptr(GError) error = NULL;
+
+	lcms_profile = cmsCreateBCHSWabstractProfileTHR (cd_icc_get_context (icc),
+							 17, bright, 1.f, 0.f, 0.f,
+							 6504, 6504);
+	g_assert (lcms_profile != NULL);
+	ret = cd_icc_load_handle (icc, lcms_profile, CD_ICC_LOAD_FLAGS_NONE, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	return icc;
+}
+
+static gdouble
+colord_transform_abstract_chain_run (CdTransform *transform,
+				     guint8 *data_in,
+				     guint8 *data_out,
+				     guint width,
+				     guint height)
+{
+	const guint repeats = 5;
+	gboolean ret;
+	guint i;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GTimer) timer = g_timer_new ();
+
+	/* do not include the setup */
+	ret = cd_transform_process (transform, data_in, data_out,
+				    1, 1, 1, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_timer_reset (timer);
+	for (i = 0; i < repeats; i++) {
+		ret = cd_transform_process (transform, data_in, data_out,
+					    width, height, width, NULL, &error);
+		g_assert_no_error (error);
+		g_assert (ret);
+	}
+	return g_timer_elapsed (timer, NULL) * 1000 / repeats;
+}
+
+static void
+colord_transform_abstract_chain_func (void)
+{
+	const guint height = 1080;
+	const guint width = 1920;
+	gdouble elapsed;
+	guint i;
+	g_autofree guint8 *img_data_in = g_new (guint8, width * height * 3);
+	g_autofree guint8 *img_data_out = g_new (guint8, width * height * 3);
+	g_autofree guint8 *img_data_check = g_new (guint8, width * height * 3);
+	g_autoptr(CdTransform) transform = cd_transform_new ();
+	g_autoptr(GPtrArray) iccs = NULL;
+
+	cd_transform_set_use_cache (transform, FALSE);
+	cd_transform_set_max_threads (transform, 1);
+	cd_transform_set_rendering_intent (transform, CD_RENDERING_INTENT_PERCEPTUAL);
+	cd_transform_set_input_pixel_format (transform, CD_PIXEL_FORMAT_RGB24);
+	cd_transform_set_output_pixel_format (transform, CD_PIXEL_FORMAT_RGB24);
+	for (i = 0; i < width * height * 3; i++)
+		img_data_in[i] = i % 0xff;
+
+	/* one abstract profile */
+	iccs = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	g_ptr_array_add (iccs, colord_transform_abstract_new (-20.f));
+	cd_transform_set_abstract_iccs (transform, iccs);
+	g_assert (cd_transform_get_abstract_icc (transform) == g_ptr_array_index (iccs, 0));
+	elapsed = colord_transform_abstract_chain_run (transform,
+						       img_data_in,
+						       img_data_check,
+						       width, height);
+	g_print ("1 abstract = %.2fms, ", elapsed);
+
+	/* the same effect split into four */
+	g_ptr_array_set_size (iccs, 0);
+	for (i = 0; i < 4; i++)
+		g_ptr_array_add (iccs, colord_transform_abstract_new (-5.f));
+	cd_transform_set_abstract_iccs (transform, iccs);
+	g_assert_cmpint (cd_transform_get_abstract_iccs (transform)->len, ==, 4);
+	elapsed = colord_transform_abstract_chain_run (transform,
+						       img_data_in,
+						       img_data_out,
+						       width, height);
+	g_print ("4 abstract = %.2fms\n", elapsed);
+	for (i = 0; i < width * height * 3; i++)
+		g_assert_cmpint (ABS (img_data_out[i] - img_data_check[i]), <=, 4);
+
+	/* darker than the input */
+	g_assert_cmpint (img_data_out[600], <, img_data_in[600]);
+
+	/* setting the list to itself keeps the chain */
+	cd_transform_set_abstract_iccs (transform,
+					cd_transform_get_abstract_iccs (transform));
+	g_assert_cmpint (cd_transform_get_abstract_iccs (transform)->len, ==, 4);
+	elapsed = colord_transform_abstract_chain_run (transform,
+						       img_data_in,
+						       img_data_out,
+						       width, height);
+	for (i = 0; i < width * height * 3; i++)
+		g_assert_cmpint (ABS (img_data_out[i] - img_data_check[i]), <=, 4);
+
+	/* clearing the list is the same as no abstract profile */
+	cd_transform_set_abstract_iccs (transform, NULL);
+	g_assert (cd_transform_get_abstract_icc (transform) == NULL);
+}
+
+static void
+colord_transform_parametric_func (void)
+{
+	CdColorRGB rgb;
+	const guint repeats = 1000;
+	gboolean ret;
+	gdouble elapsed;
+	guint i;
+	guint8 data_in[6] = { 255, 255, 255, 64, 64, 64 };
+	guint8 data_out[6];
+	g_autoptr(CdTransform) transform = cd_transform_new ();
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GTimer) timer = g_timer_new ();
+
+	cd_transform_set_use_cache (transform, FALSE);
+	cd_transform_set_rendering_intent (transform, CD_RENDERING_INTENT_PERCEPTUAL);
+	cd_transform_set_input_pixel_format (transform, CD_PIXEL_FORMAT_RGB24);
+	cd_transform_set_output_pixel_format (transform, CD_PIXEL_FORMAT_RGB24);
+	g_assert_cmpint (cd_transform_get_temperature (transform), ==, 6500);
+
+	/* warm white */
+	cd_transform_set_temperature (transform, 3000);
+	ret = cd_transform_process (transform, data_in, data_out,
+				    2, 1, 2, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpint (data_out[0], ==, 255);
+	g_assert_cmpint (data_out[1], <, 255);
+	g_assert_cmpint (data_out[2], <, data_out[1]);
+
+	/* half red */
+	cd_transform_set_temperature (transform, 6500);
+	cd_color_rgb_set (&rgb, 0.5f, 1.f, 1.f);
+	cd_transform_set_gain (transform, &rgb);
+	ret = cd_transform_process (transform, data_in, data_out,
+				    2, 1, 2, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpint (ABS (data_out[0] - 128), <=, 1);
+	g_assert_cmpint (data_out[1], ==, 255);
+
+	/* brighter */
+	cd_color_rgb_set (&rgb, 1.f, 1.f, 1.f);
+	cd_transform_set_gain (transform, &rgb);
+	cd_color_rgb_set (&rgb, 2.f, 2.f, 2.f);
+	cd_transform_set_gamma (transform, &rgb);
+	ret = cd_transform_process (transform, data_in, data_out,
+				    2, 1, 2, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpint (ABS (data_out[3] - 128), <=, 2);
+
+	/* not supported for CMYK */
+	cd_transform_set_output_pixel_format (transform, CD_PIXEL_FORMAT_CMYK32);
+	ret = cd_transform_process (transform, data_in, data_out,
+				    1, 1, 1, NULL, &error);
+	g_assert_error (error, CD_TRANSFORM_ERROR, CD_TRANSFORM_ERROR_INVALID_COLORSPACE);
+	g_assert (!ret);
+	g_clear_error (&error);
+	cd_transform_set_output_pixel_format (transform, CD_PIXEL_FORMAT_RGB24);
+
+	/* fade without rebuilding the transform */
+	g_timer_reset (timer);
+	for (i = 0; i < repeats; i++) {
+		cd_transform_set_temperature (transform, 6500 - (i * 4));
+		ret = cd_transform_process (transform, data_in, data_out,
+					    1, 1, 1, NULL, &error);
+		g_assert_no_error (error);
+		g_assert (ret);
+	}
+	elapsed = g_timer_elapsed (timer, NULL) * 1000 / repeats;
+	g_print ("re-parameterise = %.3fms\n", elapsed);
+
+	/* only meaningful on an otherwise idle machine */
+	if (g_test_perf ())
+		g_assert_cmpfloat (elapsed, <, 1.f);
+}
+
+static void
+colord_transform_proof_func (void)
+{
+	CdColorRGB alarm;
+	const guint height = 1080;
+	const guint width = 1920;
+	gboolean ret;
+	guint i;
+	guint8 data_in[6] = { 0, 0, 255, 128, 128, 128 };
+	guint8 data_out[6];
+	g_autofree gchar *filename = NULL;
+	g_autofree guint8 *img_data_in = g_new (guint8, width * height * 3);
+	g_autofree guint8 *img_data_out = g_new (guint8, width * height * 3);
+	g_autoptr(CdIcc) icc = cd_icc_new ();
+	g_autoptr(CdTransform) transform = cd_transform_new ();
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GFile) file = NULL;
+	g_autoptr(GTimer) timer = g_timer_new ();
+
+	/* simulate a laptop panel on a sRGB display */
+	filename = cd_test_get_filename ("ibm-t61.icc");
+	file = g_file_new_for_path (filename);
+	ret = cd_icc_load_file (icc, file, CD_ICC_LOAD_FLAGS_NONE, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	cd_transform_set_use_cache (transform, FALSE);
+	cd_transform_set_max_threads (transform, 1);
+	cd_transform_set_rendering_intent (transform, CD_RENDERING_INTENT_RELATIVE_COLORIMETRIC);
+	cd_transform_set_input_pixel_format (transform, CD_PIXEL_FORMAT_RGB24);
+	cd_transform_set_output_pixel_format (transform, CD_PIXEL_FORMAT_RGB24);
+	for (i = 0; i < width * height * 3; i++)
+		img_data_in[i] = i % 0xff;
+
+	/* get a baseline */
+	ret = cd_transform_process (transform, img_data_in, img_data_out,
+				    width, height, width, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_timer_reset (timer);
+	ret = cd_transform_process (transform, img_data_in, img_data_out,
+				    width, height, width, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_print ("normal = %.2fms, ", g_timer_elapsed (timer, NULL) * 1000);
+
+	/* the saturated blue cannot be shown on the panel */
+	cd_transform_set_proof_icc (transform, icc);
+	g_assert (cd_transform_get_proof_icc (transform) == icc);
+	g_assert (cd_transform_get_gamut_alarm (transform) == NULL);
+	cd_color_rgb_set (&alarm, 0.f, 1.f, 0.f);
+	cd_transform_set_gamut_alarm (transform, &alarm);
+	ret = cd_transform_process (transform, data_in, data_out,
+				    2, 1, 2, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpint (data_out[0], ==, 0);
+	g_assert_cmpint (data_out[1], ==, 255);
+	g_assert_cmpint (data_out[2], ==, 0);
+	g_assert_cmpint (ABS (data_out[3] - data_out[4]), <=, 8);
+	g_assert_cmpint (ABS (data_out[4] - data_out[5]), <=, 8);
+
+	/* proofing the whole image is about the same cost */
+	g_timer_reset (timer);
+	ret = cd_transform_process (transform, img_data_in, img_data_out,
+				    width, height, width, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_print ("proof = %.2fms\n", g_timer_elapsed (timer, NULL) * 1000);
+
+	/* no alarm */
+	cd_transform_set_gamut_alarm (transform, NULL);
+	ret = cd_transform_process (transform, data_in, data_out,
+				    2, 1, 2, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpint (data_out[1], !=, 255);
+}
+
+static gdouble
+colord_transform_hdr_srgb_encode (gdouble value)
+{
+	if (value <= 0.0031308f)
+		return value * 12.92f;
+	return 1.055f * pow (value, 1.f / 2.4f) - 0.055f;
+}
+
+static void
+colord_transform_hdr_check (CdTransform *transform, guint8 value, gdouble luminance)
+{
+	gboolean ret;
+	gdouble expected;
+	guint8 data_in[3] = { value, value, value };
+	guint8 data_out[3];
+	g_autoptr(GError) error = NULL;
+
+	/* grey stays grey as BT.2020 and sRGB share a white point */
+	ret = cd_transform_process (transform, data_in, data_out,
+				    1, 1, 1, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	luminance /= cd_transform_get_target_peak (transform);
+	expected = colord_transform_hdr_srgb_encode (CLAMP (luminance, 0.f, 1.f)) * 255.f;
+	g_assert_cmpfloat (fabs (data_out[0] - expected), <=, 2.f);
+	g_assert_cmpfloat (fabs (data_out[1] - expected), <=, 2.f);
+	g_assert_cmpfloat (fabs (data_out[2] - expected), <=, 2.f);
+}
+
+static void
+colord_transform_hdr_func (void)
+{
+	const guint height = 1080;
+	const guint width = 1920;
+	gboolean ret;
+	gdouble luminance;
+	guint i;
+	guint values[] = { 0, 32, 64, 96, 128, 160, 192, 224, 255 };
+	g_autofree guint8 *img_data_in = g_new (guint8, width * height * 3);
+	g_autofree guint8 *img_data_out = g_new (guint8, width * height * 3);
+	g_autoptr(CdTransform) transform = cd_transform_new ();
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GTimer) timer = g_timer_new ();
+
+	/* BT.2100 PQ onto a 100 cd/m² sRGB display */
+	cd_transform_set_use_cache (transform, FALSE);
+	cd_transform_set_max_threads (transform, 1);
+	cd_transform_set_rendering_intent (transform, CD_RENDERING_INTENT_RELATIVE_COLORIMETRIC);
+	cd_transform_set_input_pixel_format (transform, CD_PIXEL_FORMAT_RGB24);
+	cd_transform_set_output_pixel_format (transform, CD_PIXEL_FORMAT_RGB24);
+	g_assert_cmpint (cd_transform_get_input_transfer (transform), ==, CD_TRANSFORM_TRANSFER_SDR);
+	g_assert_cmpint (cd_transform_get_tone_map (transform), ==, CD_TRANSFORM_TONE_MAP_BT2390);
+	g_assert_cmpfloat (cd_transform_get_source_peak (transform), ==, 1000.f);
+	g_assert_cmpfloat (cd_transform_get_target_peak (transform), ==, 100.f);
+	for (i = 0; i < width * height * 3; i++)
+		img_data_in[i] = i % 0xff;
+
+	/* get a baseline */
+	g_timer_reset (timer);
+	ret = cd_transform_process (transform, img_data_in, img_data_out,
+				    width, height, width, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_print ("SDR = %.2fms, ", g_timer_elapsed (timer, NULL) * 1000);
+
+	/* tone mapped */
+	cd_transform_set_input_transfer (transform, CD_TRANSFORM_TRANSFER_PQ);
+	for (i = 0; i < G_N_ELEMENTS (values); i++) {
+		luminance = cd_color_pq_to_luminance (values[i] / 255.f);
+		luminance = cd_color_tone_map_bt2390 (luminance, 1000.f, 100.f);
+		colord_transform_hdr_check (transform, values[i], luminance);
+	}
+
+	/* the same cost as SDR once the LUT is built */
+	g_timer_reset (timer);
+	ret = cd_transform_process (transform, img_data_in, img_data_out,
+				    width, height, width, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_print ("PQ = %.2fms\n", g_timer_elapsed (timer, NULL) * 1000);
+
+	/* clipped */
+	cd_transform_set_tone_map (transform, CD_TRANSFORM_TONE_MAP_NONE);
+	for (i = 0; i < G_N_ELEMENTS (values); i++) {
+		luminance = cd_color_pq_to_luminance (values[i] / 255.f);
+		colord_transform_hdr_check (transform, values[i], luminance);
+	}
+
+	/* HLG with a 1000 cd/m² nominal peak has a system gamma of 1.2 */
+	cd_transform_set_input_transfer (transform, CD_TRANSFORM_TRANSFER_HLG);
+	cd_transform_set_tone_map (transform, CD_TRANSFORM_TONE_MAP_BT2390);
+	cd_transform_set_target_peak (transform, 203.f);
+	for (i = 0; i < G_N_ELEMENTS (values); i++) {
+		luminance = cd_color_hlg_to_scene_linear (values[i] / 255.f);
+		luminance = 1000.f * pow (luminance, 1.2f);
+		luminance = cd_color_tone_map_bt2390 (luminance, 1000.f, 203.f);
+		colord_transform_hdr_check (transform, values[i], luminance);
+	}
+}
+
 #include <glib/gstdio.h>
 
 static void
@@ -2109,6 +3103,74 @@ colord_icc_store_func (void)
 	g_object_unref (store);
 }
 
+static void
+colord_icc_store_frugal_func (void)
+{
+	gboolean ret;
+	gint rc;
+	guint added = 0;
+	guint i;
+	guint watch_count;
+	g_autofree gchar *file = NULL;
+	g_autofree gchar *filename = NULL;
+	g_autofree gchar *root = NULL;
+	g_autoptr(CdIccStore) store = NULL;
+	g_autoptr(GError) error = NULL;
+
+	store = cd_icc_store_new ();
+	g_signal_connect (store, "added",
+			  G_CALLBACK (colord_icc_store_added_cb),
+			  &added);
+	cd_icc_store_set_load_flags (store, CD_ICC_LOAD_FLAGS_NONE);
+	cd_icc_store_set_max_watches (store, 8);
+	cd_icc_store_set_rescan_interval (store, 1);
+
+	/* create more empty directories than watches */
+	root = g_dir_make_tmp ("colord-frugal-XXXXXX", &error);
+	g_assert_no_error (error);
+	g_assert (root != NULL);
+	for (i = 0; i < 40; i++) {
+		g_autofree gchar *tmp = g_strdup_printf ("%s/%02u", root, i);
+		rc = g_mkdir (tmp, 0777);
+		g_assert_cmpint (rc, ==, 0);
+	}
+	ret = cd_icc_store_search_location (store, root,
+					    CD_ICC_STORE_SEARCH_FLAGS_NONE,
+					    NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+
+	/* the number of watches is bounded */
+	watch_count = cd_icc_store_get_watch_count (store);
+	g_assert_cmpint (watch_count, <=, 8);
+
+	/* a profile is still found in a directory without a watch */
+	filename = cd_test_get_filename ("ibm-t61.icc");
+	file = g_build_filename (root, "39", "new-icc.icc", NULL);
+	_copy_files (filename, file);
+	cd_test_loop_run_with_timeout (5000);
+	cd_test_loop_quit ();
+	g_assert_cmpint (added, ==, 1);
+
+	/* adding more directories does not use any more watches */
+	for (i = 40; i < 60; i++) {
+		g_autofree gchar *tmp = g_strdup_printf ("%s/%02u", root, i);
+		rc = g_mkdir (tmp, 0777);
+		g_assert_cmpint (rc, ==, 0);
+	}
+	cd_test_loop_run_with_timeout (2500);
+	cd_test_loop_quit ();
+	g_assert_cmpint (cd_icc_store_get_watch_count (store), ==, watch_count);
+
+	/* clean up */
+	g_unlink (file);
+	for (i = 0; i < 60; i++) {
+		g_autofree gchar *tmp = g_strdup_printf ("%s/%02u", root, i);
+		g_remove (tmp);
+	}
+	g_remove (root);
+}
+
 static void
 colord_icc_util_func (void)
 {
@@ -2233,6 +3295,250 @@ colord_edid_func (void)
 	g_object_unref (edid);
 }
 
+static gpointer
+colord_icc_interned_thread_cb (gpointer user_data)
+{
+	CdIcc *icc = CD_ICC (user_data);
+	const gchar *value = NULL;
+
+	/* the first call fills the shared cache */
+	for (guint i = 0; i < 100; i++) {
+		const gchar *tmp = cd_icc_get_description (icc, NULL, NULL);
+		g_assert (tmp != NULL);
+		g_assert (value == NULL || tmp == value);
+		value = tmp;
+	}
+	return (gpointer) value;
+}
+
+static void
+colord_icc_interned_func (void)
+{
+	const guint repeats = 1000;
+	gboolean ret;
+	gdouble elapsed_interned;
+	gdouble elapsed_plain;
+	gsize data1_len = 0;
+	gsize data2_len = 0;
+	guint i;
+	g_autofree gchar *data1 = NULL;
+	g_autofree gchar *data2 = NULL;
+	g_autofree gchar *filename1 = NULL;
+	g_autofree gchar *filename2 = NULL;
+	gpointer values[8];
+	GThread *threads[8];
+	g_autoptr(CdIcc) icc1 = NULL;
+	g_autoptr(CdIcc) icc2 = NULL;
+	g_autoptr(CdIcc) icc3 = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GTimer) timer = g_timer_new ();
+
+	filename1 = cd_test_get_filename ("ibm-t61.icc");
+	ret = g_file_get_contents (filename1, &data1, &data1_len, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	filename2 = cd_test_get_filename ("crayons.icc");
+	ret = g_file_get_contents (filename2, &data2, &data2_len, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+
+	/* identical data returns the same object */
+	icc1 = cd_icc_new_interned ((const guint8 *) data1, data1_len,
+				    CD_ICC_LOAD_FLAGS_NONE, &error);
+	g_assert_no_error (error);
+	g_assert (icc1 != NULL);
+	icc2 = cd_icc_new_interned ((const guint8 *) data1, data1_len,
+				    CD_ICC_LOAD_FLAGS_NONE, &error);
+	g_assert_no_error (error);
+	g_assert (icc1 == icc2);
+	g_clear_object (&icc2);
+
+	/* different data does not */
+	icc2 = cd_icc_new_interned ((const guint8 *) data2, data2_len,
+				    CD_ICC_LOAD_FLAGS_NONE, &error);
+	g_assert_no_error (error);
+	g_assert (icc2 != NULL);
+	g_assert (icc1 != icc2);
+
+	/* asking for more than was loaded gets a new object */
+	icc3 = cd_icc_new_interned ((const guint8 *) data2, data2_len,
+				    CD_ICC_LOAD_FLAGS_METADATA, &error);
+	g_assert_no_error (error);
+	g_assert (icc3 != icc2);
+	g_clear_object (&icc3);
+
+	/* invalid data is not interned */
+	icc3 = cd_icc_new_interned ((const guint8 *) "hello", 6,
+				    CD_ICC_LOAD_FLAGS_NONE, &error);
+	g_assert_error (error, CD_ICC_ERROR, CD_ICC_ERROR_FAILED_TO_PARSE);
+	g_assert (icc3 == NULL);
+	g_clear_error (&error);
+
+	/* entries are dropped when unused */
+	g_clear_object (&icc1);
+	g_clear_object (&icc2);
+	icc1 = cd_icc_new_interned ((const guint8 *) data1, data1_len,
+				    CD_ICC_LOAD_FLAGS_NONE, &error);
+	g_assert_no_error (error);
+	g_assert (icc1 != NULL);
+
+	/* a decoder keeps the profile alive while it is in use */
+	icc2 = cd_icc_new_interned ((const guint8 *) data2, data2_len,
+				    CD_ICC_LOAD_FLAGS_NONE, &error);
+	g_assert_no_error (error);
+	g_assert (icc2 != NULL);
+
+	/* the shared object can be read from several threads at once */
+	for (i = 0; i < G_N_ELEMENTS (threads); i++)
+		threads[i] = g_thread_new ("interned", colord_icc_interned_thread_cb, icc2);
+	for (i = 0; i < G_N_ELEMENTS (threads); i++)
+		values[i] = g_thread_join (threads[i]);
+	for (i = 1; i < G_N_ELEMENTS (threads); i++)
+		g_assert (values[i] == values[0]);
+
+	/* decode a corpus of images with the same two embedded profiles */
+	g_timer_reset (timer);
+	for (i = 0; i < repeats; i++) {
+		g_autoptr(CdIcc) icc = cd_icc_new ();
+		if (i % 2 == 0)
+			ret = cd_icc_load_data (icc, (const guint8 *) data1, data1_len,
+						CD_ICC_LOAD_FLAGS_NONE, &error);
+		else
+			ret = cd_icc_load_data (icc, (const guint8 *) data2, data2_len,
+						CD_ICC_LOAD_FLAGS_NONE, &error);
+		g_assert_no_error (error);
+		g_assert (ret);
+	}
+	elapsed_plain = g_timer_elapsed (timer, NULL) * 1000;
+	g_timer_reset (timer);
+	for (i = 0; i < repeats; i++) {
+		g_autoptr(CdIcc) icc = NULL;
+		if (i % 2 == 0)
+			icc = cd_icc_new_interned ((const guint8 *) data1, data1_len,
+						   CD_ICC_LOAD_FLAGS_NONE, &error);
+		else
+			icc = cd_icc_new_interned ((const guint8 *) data2, data2_len,
+						   CD_ICC_LOAD_FLAGS_NONE, &error);
+		g_assert_no_error (error);
+		g_assert (icc != NULL);
+	}
+	elapsed_interned = g_timer_elapsed (timer, NULL) * 1000;
+	g_print ("plain = %.2fms, interned = %.2fms\n",
+		 elapsed_plain, elapsed_interned);
+}
+
+static void
+colord_icc_profile_id_func (void)
+{
+	const guint repeats = 200;
+	gboolean ret;
+	gdouble elapsed_embedded;
+	gdouble elapsed_fallback;
+	GStatBuf stat_buf;
+	gsize data_file_len = 0;
+	gsize data_len = 0;
+	guint i;
+	struct utimbuf utb;
+	g_autofree gchar *data = NULL;
+	g_autofree gchar *data_file = NULL;
+	g_autofree gchar *data_id = NULL;
+	g_autofree gchar *filename = NULL;
+	g_autofree gchar *filename_tmp = NULL;
+	g_autofree gchar *tmpdir = NULL;
+	g_autoptr(CdIcc) icc = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GFile) file = NULL;
+	g_autoptr(GTimer) timer = g_timer_new ();
+
+	/* get a profile without an ID */
+	filename = cd_test_get_filename ("ibm-t61.icc");
+	ret = g_file_get_contents (filename, &data, &data_len, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	memset (data + 84, 0, 16);
+
+	/* embed the ID, then check it is used as the checksum */
+	data_id = g_memdup (data, data_len);
+	ret = cd_icc_utils_embed_profile_id ((guint8 *) data_id, data_len, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert (memcmp (data, data_id, 84) == 0);
+	g_assert (memcmp (data + 84, data_id + 84, 16) != 0);
+	g_assert (memcmp (data + 100, data_id + 100, data_len - 100) == 0);
+	icc = cd_icc_new ();
+	ret = cd_icc_load_data (icc, (const guint8 *) data_id, data_len,
+				CD_ICC_LOAD_FLAGS_NONE, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpint (strlen (cd_icc_get_checksum (icc)), ==, 32);
+	g_clear_object (&icc);
+
+	/* a truncated profile is not changed */
+	ret = cd_icc_utils_embed_profile_id ((guint8 *) data, data_len - 1, &error);
+	g_assert_error (error, CD_ICC_ERROR, CD_ICC_ERROR_FAILED_TO_PARSE);
+	g_assert (!ret);
+	g_clear_error (&error);
+
+	/* loading no longer hashes the whole profile */
+	g_timer_reset (timer);
+	for (i = 0; i < repeats; i++) {
+		g_autoptr(CdIcc) icc_tmp = cd_icc_new ();
+		ret = cd_icc_load_data (icc_tmp, (const guint8 *) data, data_len,
+					CD_ICC_LOAD_FLAGS_FALLBACK_MD5, &error);
+		g_assert_no_error (error);
+		g_assert (ret);
+	}
+	elapsed_fallback = g_timer_elapsed (timer, NULL) * 1000 / repeats;
+	g_timer_reset (timer);
+	for (i = 0; i < repeats; i++) {
+		g_autoptr(CdIcc) icc_tmp = cd_icc_new ();
+		ret = cd_icc_load_data (icc_tmp, (const guint8 *) data_id, data_len,
+					CD_ICC_LOAD_FLAGS_FALLBACK_MD5, &error);
+		g_assert_no_error (error);
+		g_assert (ret);
+	}
+	elapsed_embedded = g_timer_elapsed (timer, NULL) * 1000 / repeats;
+	g_print ("fallback = %.2fms, embedded = %.2fms\n",
+		 elapsed_fallback, elapsed_embedded);
+
+	/* the ID is written into a profile file that lacks one */
+	tmpdir = g_dir_make_tmp ("colord-icc-XXXXXX", &error);
+	g_assert_no_error (error);
+	g_assert (tmpdir != NULL);
+	filename_tmp = g_build_filename (tmpdir, "test.icc", NULL);
+	ret = g_file_set_contents (filename_tmp, data, data_len, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	file = g_file_new_for_path (filename_tmp);
+	ret = cd_icc_utils_embed_profile_id_file (file, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	ret = g_file_get_contents (filename_tmp, &data_file, &data_file_len, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpint (data_file_len, ==, data_len);
+	g_assert (memcmp (data_file, data_id, data_len) == 0);
+
+	/* a profile that already has an ID is not rewritten */
+	utb.actime = 1000000000;
+	utb.modtime = 1000000000;
+	g_assert_cmpint (g_utime (filename_tmp, &utb), ==, 0);
+	ret = cd_icc_utils_embed_profile_id_file (file, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpint (g_stat (filename_tmp, &stat_buf), ==, 0);
+	g_assert_cmpint (stat_buf.st_mtime, ==, 1000000000);
+	g_free (data_file);
+	data_file = NULL;
+	ret = g_file_get_contents (filename_tmp, &data_file, &data_file_len, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpint (data_file_len, ==, data_len);
+	g_assert (memcmp (data_file, data_id, data_len) == 0);
+	g_unlink (filename_tmp);
+	g_rmdir (tmpdir);
+}
+
 static void
 colord_icc_tags_func (void)
 {
@@ -2351,8 +3657,14 @@ colord_it8_gamma_func (void)
 int
 main (int argc, char **argv)
 {
+	gint retval;
+	g_autofree gchar *cache_dir = NULL;
+
 	g_test_init (&argc, &argv, NULL);
 	(void)g_setenv ("G_MESSAGES_DEBUG", "all", TRUE);
+	cache_dir = g_dir_make_tmp ("colord-transforms-XXXXXX", NULL);
+	g_assert (cache_dir != NULL);
+	(void)g_setenv ("COLORD_TRANSFORM_CACHE_DIR", cache_dir, TRUE);
 
 	/* only critical and error are fatal */
 	g_log_set_fatal_mask (NULL, G_LOG_LEVEL_ERROR | G_LOG_LEVEL_CRITICAL);
@@ -2364,6 +3676,12 @@ main (int argc, char **argv)
 	g_test_add_func ("/colord/spectrum{cx}", colord_spect_cx_func);
 	g_test_add_func ("/colord/edid", colord_edid_func);
 	g_test_add_func ("/colord/transform", colord_transform_func);
+	g_test_add_func ("/colord/transform{cache}", colord_transform_cache_func);
+	g_test_add_func ("/colord/transform{ycbcr}", colord_transform_ycbcr_func);
+	g_test_add_func ("/colord/transform{abstract-chain}", colord_transform_abstract_chain_func);
+	g_test_add_func ("/colord/transform{parametric}", colord_transform_parametric_func);
+	g_test_add_func ("/colord/transform{proof}", colord_transform_proof_func);
+	g_test_add_func ("/colord/transform{hdr}", colord_transform_hdr_func);
 	g_test_add_func ("/colord/icc", colord_icc_func);
 	g_test_add_func ("/colord/icc{util}", colord_icc_util_func);
 	g_test_add_func ("/colord/icc{localized}", colord_icc_localized_func);
@@ -2374,7 +3692,10 @@ main (int argc, char **argv)
 	g_test_add_func ("/colord/icc{corrupt-dict}", colord_icc_corrupt_dict_func);
 	g_test_add_func ("/colord/icc{clear}", colord_icc_clear_func);
 	g_test_add_func ("/colord/icc{tags}", colord_icc_tags_func);
+	g_test_add_func ("/colord/icc{interned}", colord_icc_interned_func);
+	g_test_add_func ("/colord/icc{profile-id}", colord_icc_profile_id_func);
 	g_test_add_func ("/colord/icc-store", colord_icc_store_func);
+	g_test_add_func ("/colord/icc-store{frugal}", colord_icc_store_frugal_func);
 	g_test_add_func ("/colord/buffer", colord_buffer_func);
 	g_test_add_func ("/colord/enum", colord_enum_func);
 	g_test_add_func ("/colord/dom", colord_dom_func);
@@ -2385,6 +3706,7 @@ main (int argc, char **argv)
 	g_test_add_func ("/colord/color", colord_color_func);
 	g_test_add_func ("/colord/color{interpolate}", colord_color_interpolate_func);
 	g_test_add_func ("/colord/color{blackbody}", colord_color_blackbody_func);
+	g_test_add_func ("/colord/color{hdr}", colord_color_hdr_func);
 	g_test_add_func ("/colord/math", cd_test_math_func);
 	g_test_add_func ("/colord/it8{raw}", colord_it8_raw_func);
 	g_test_add_func ("/colord/it8{gamma}", colord_it8_gamma_func);
@@ -2392,11 +3714,17 @@ main (int argc, char **argv)
 	g_test_add_func ("/colord/it8{normalized}", colord_it8_normalized_func);
 	g_test_add_func ("/colord/it8{ccmx}", colord_it8_ccmx_func);
 	g_test_add_func ("/colord/it8{ccmx-util}", colord_it8_ccmx_util_func);
+	g_test_add_func ("/colord/it8{ccmx-lsq}", colord_it8_ccmx_lsq_func);
 	g_test_add_func ("/colord/it8{spectra-util}", colord_it8_spectra_util_func);
 	g_test_add_func ("/colord/it8{cri-util}", colord_it8_cri_util_func);
+	g_test_add_func ("/colord/it8{standard}", colord_it8_standard_func);
+	g_test_add_func ("/colord/it8{tm30}", colord_it8_tm30_func);
+	g_test_add_func ("/colord/it8{tm30-reference}", colord_it8_tm30_reference_func);
 	g_test_add_func ("/colord/it8{ccss}", colord_it8_ccss_func);
 	g_test_add_func ("/colord/it8{spect}", colord_it8_spect_func);
 
-	return g_test_run ();
+	retval = g_test_run ();
+	colord_transform_cache_remove (cache_dir);
+	return retval;
 }
 
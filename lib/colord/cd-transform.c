@@ -33,8 +33,11 @@
 #include "config.h"
 
 #include <glib.h>
+#include <glib/gstdio.h>
 #include <lcms2.h>
+#include <math.h>
 
+#include "cd-color.h"
 #include "cd-context-lcms.h"
 #include "cd-transform.h"
 
@@ -53,7 +56,11 @@ typedef struct
 {
 	CdIcc			*input_icc;
 	CdIcc			*output_icc;
-	CdIcc			*abstract_icc;
+	GPtrArray		*abstract_iccs;	/* of CdIcc */
+	CdIcc			*proof_icc;
+	CdRenderingIntent	 proof_rendering_intent;
+	gboolean		 gamut_alarm_enabled;
+	CdColorRGB		 gamut_alarm;
 	CdPixelFormat		 input_pixel_format;
 	CdPixelFormat		 output_pixel_format;
 	CdRenderingIntent	 rendering_intent;
@@ -61,6 +68,18 @@ typedef struct
 	cmsHPROFILE		 srgb;
 	cmsHTRANSFORM		 lcms_transform;
 	gboolean		 bpc;
+	gboolean		 use_cache;
+	CdTransformYcbcrMatrix	 ycbcr_matrix;
+	CdTransformYcbcrRange	 ycbcr_range;
+	CdTransformTransfer	 input_transfer;
+	CdTransformToneMap	 tone_map;
+	gdouble			 source_peak;
+	gdouble			 target_peak;
+	guint			 temperature;
+	CdColorRGB		 gain;
+	CdColorRGB		 gamma;
+	gboolean		 post_lut_enabled;
+	guint8			 post_lut[3][256];
 	guint			 max_threads;
 	guint			 bpp_input;
 	guint			 bpp_output;
@@ -68,6 +87,12 @@ typedef struct
 
 G_DEFINE_TYPE_WITH_PRIVATE (CdTransform, cd_transform, G_TYPE_OBJECT)
 
+/* device links older than this are removed when the cache gets too big */
+#define CD_TRANSFORM_CACHE_SIZE_MAX		(16 * 1024 * 1024)
+
+/* entries in the tone curves that decode HDR input */
+#define CD_TRANSFORM_HDR_SHAPER_SIZE		4096
+
 enum {
 	PROP_0,
 	PROP_BPC,
@@ -77,6 +102,16 @@ enum {
 	PROP_INPUT_ICC,
 	PROP_OUTPUT_ICC,
 	PROP_ABSTRACT_ICC,
+	PROP_USE_CACHE,
+	PROP_YCBCR_MATRIX,
+	PROP_YCBCR_RANGE,
+	PROP_TEMPERATURE,
+	PROP_PROOF_ICC,
+	PROP_PROOF_RENDERING_INTENT,
+	PROP_INPUT_TRANSFER,
+	PROP_TONE_MAP,
+	PROP_SOURCE_PEAK,
+	PROP_TARGET_PEAK,
 	PROP_LAST
 };
 
@@ -216,13 +251,18 @@ cd_transform_set_abstract_icc (CdTransform *transform, CdIcc *icc)
 	g_return_if_fail (icc == NULL || CD_IS_ICC (icc));
 
 	/* no change */
-	if (priv->abstract_icc == icc)
+	if (icc == NULL && priv->abstract_iccs->len == 0)
+		return;
+	if (priv->abstract_iccs->len == 1 &&
+	    g_ptr_array_index (priv->abstract_iccs, 0) == icc)
 		return;
 
-	if (priv->abstract_icc != NULL)
-		g_clear_object (&priv->abstract_icc);
+	/* @icc may only be owned by the list being cleared */
+	if (icc != NULL)
+		g_object_ref (icc);
+	g_ptr_array_set_size (priv->abstract_iccs, 0);
 	if (icc != NULL)
-		priv->abstract_icc = g_object_ref (icc);
+		g_ptr_array_add (priv->abstract_iccs, icc);
 	cd_transform_invalidate (transform);
 }
 
@@ -230,7 +270,8 @@ cd_transform_set_abstract_icc (CdTransform *transform, CdIcc *icc)
  * cd_transform_get_abstract_icc:
  * @transform: a #CdTransform instance.
  *
- * Gets the abstract profile to use for the transform.
+ * Gets the abstract profile to use for the transform. If more than one
+ * abstract profile is set then only the first is returned.
  *
  * Return value: (transfer none): The abstract profile
  *
@@ -241,7 +282,194 @@ cd_transform_get_abstract_icc (CdTransform *transform)
 {
 	CdTransformPrivate *priv = GET_PRIVATE (transform);
 	g_return_val_if_fail (CD_IS_TRANSFORM (transform), NULL);
-	return priv->abstract_icc;
+	if (priv->abstract_iccs->len == 0)
+		return NULL;
+	return g_ptr_array_index (priv->abstract_iccs, 0);
+}
+
+/**
+ * cd_transform_set_abstract_iccs:
+ * @transform: a #CdTransform instance.
+ * @iccs: (element-type CdIcc) (nullable): abstract profiles, or %NULL
+ *
+ * Sets an ordered list of abstract profiles to use for the transform, for
+ * instance a white point adjustment followed by a brightness curve.
+ * All the profiles are combined into one pipeline, so the cost of applying
+ * the transform does not depend on the number of abstract profiles.
+ *
+ * Since: 1.4.8
+ **/
+void
+cd_transform_set_abstract_iccs (CdTransform *transform, GPtrArray *iccs)
+{
+	CdTransformPrivate *priv = GET_PRIVATE (transform);
+	GPtrArray *abstract_iccs;
+	guint i;
+
+	g_return_if_fail (CD_IS_TRANSFORM (transform));
+
+	/* take a copy, as the caller may reuse the array or pass in the
+	 * array returned by cd_transform_get_abstract_iccs() */
+	for (i = 0; iccs != NULL && i < iccs->len; i++)
+		g_return_if_fail (CD_IS_ICC (g_ptr_array_index (iccs, i)));
+	abstract_iccs = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	for (i = 0; iccs != NULL && i < iccs->len; i++) {
+		CdIcc *icc = g_ptr_array_index (iccs, i);
+		g_ptr_array_add (abstract_iccs, g_object_ref (icc));
+	}
+	g_ptr_array_unref (priv->abstract_iccs);
+	priv->abstract_iccs = abstract_iccs;
+	cd_transform_invalidate (transform);
+}
+
+/**
+ * cd_transform_get_abstract_iccs:
+ * @transform: a #CdTransform instance.
+ *
+ * Gets the ordered list of abstract profiles to use for the transform.
+ *
+ * Return value: (transfer none) (element-type CdIcc): The abstract profiles
+ *
+ * Since: 1.4.8
+ **/
+GPtrArray *
+cd_transform_get_abstract_iccs (CdTransform *transform)
+{
+	CdTransformPrivate *priv = GET_PRIVATE (transform);
+	g_return_val_if_fail (CD_IS_TRANSFORM (transform), NULL);
+	return priv->abstract_iccs;
+}
+
+/**
+ * cd_transform_set_proof_icc:
+ * @transform: a #CdTransform instance.
+ * @icc: a #CdIcc instance or %NULL.
+ *
+ * Sets the profile of the device being simulated when soft-proofing, for
+ * instance a printer when the output profile is a display.
+ *
+ * Since: 1.4.8
+ **/
+void
+cd_transform_set_proof_icc (CdTransform *transform, CdIcc *icc)
+{
+	CdTransformPrivate *priv = GET_PRIVATE (transform);
+
+	g_return_if_fail (CD_IS_TRANSFORM (transform));
+	g_return_if_fail (icc == NULL || CD_IS_ICC (icc));
+
+	/* no change */
+	if (priv->proof_icc == icc)
+		return;
+
+	g_clear_object (&priv->proof_icc);
+	if (icc != NULL)
+		priv->proof_icc = g_object_ref (icc);
+	cd_transform_invalidate (transform);
+}
+
+/**
+ * cd_transform_get_proof_icc:
+ * @transform: a #CdTransform instance.
+ *
+ * Gets the profile of the device being simulated when soft-proofing.
+ *
+ * Return value: (transfer none): The proofing profile, or %NULL
+ *
+ * Since: 1.4.8
+ **/
+CdIcc *
+cd_transform_get_proof_icc (CdTransform *transform)
+{
+	CdTransformPrivate *priv = GET_PRIVATE (transform);
+	g_return_val_if_fail (CD_IS_TRANSFORM (transform), NULL);
+	return priv->proof_icc;
+}
+
+/**
+ * cd_transform_set_proof_rendering_intent:
+ * @transform: a #CdTransform instance.
+ * @rendering_intent: a #CdRenderingIntent, e.g. %CD_RENDERING_INTENT_RELATIVE_COLORIMETRIC
+ *
+ * Sets the rendering intent used to show the simulated device on the output
+ * device. The rendering intent set with cd_transform_set_rendering_intent()
+ * is used for the simulated device itself.
+ *
+ * Since: 1.4.8
+ **/
+void
+cd_transform_set_proof_rendering_intent (CdTransform *transform,
+					 CdRenderingIntent rendering_intent)
+{
+	CdTransformPrivate *priv = GET_PRIVATE (transform);
+
+	g_return_if_fail (CD_IS_TRANSFORM (transform));
+	g_return_if_fail (rendering_intent != CD_RENDERING_INTENT_UNKNOWN);
+	g_return_if_fail (rendering_intent < CD_RENDERING_INTENT_LAST);
+
+	priv->proof_rendering_intent = rendering_intent;
+	cd_transform_invalidate (transform);
+}
+
+/**
+ * cd_transform_get_proof_rendering_intent:
+ * @transform: a #CdTransform instance.
+ *
+ * Gets the rendering intent used to show the simulated device.
+ *
+ * Return value: a #CdRenderingIntent, e.g. %CD_RENDERING_INTENT_RELATIVE_COLORIMETRIC
+ *
+ * Since: 1.4.8
+ **/
+CdRenderingIntent
+cd_transform_get_proof_rendering_intent (CdTransform *transform)
+{
+	CdTransformPrivate *priv = GET_PRIVATE (transform);
+	g_return_val_if_fail (CD_IS_TRANSFORM (transform), CD_RENDERING_INTENT_UNKNOWN);
+	return priv->proof_rendering_intent;
+}
+
+/**
+ * cd_transform_set_gamut_alarm:
+ * @transform: a #CdTransform instance.
+ * @color: (nullable): the color to use for out of gamut pixels, or %NULL
+ *
+ * Sets the color used for pixels that cannot be reproduced by the proofing
+ * profile. The gamut check is only done when a proofing profile is set.
+ *
+ * Since: 1.4.8
+ **/
+void
+cd_transform_set_gamut_alarm (CdTransform *transform, const CdColorRGB *color)
+{
+	CdTransformPrivate *priv = GET_PRIVATE (transform);
+
+	g_return_if_fail (CD_IS_TRANSFORM (transform));
+
+	priv->gamut_alarm_enabled = color != NULL;
+	if (color != NULL)
+		cd_color_rgb_copy (color, &priv->gamut_alarm);
+	cd_transform_invalidate (transform);
+}
+
+/**
+ * cd_transform_get_gamut_alarm:
+ * @transform: a #CdTransform instance.
+ *
+ * Gets the color used for out of gamut pixels.
+ *
+ * Return value: the color, or %NULL if the gamut check is disabled
+ *
+ * Since: 1.4.8
+ **/
+const CdColorRGB *
+cd_transform_get_gamut_alarm (CdTransform *transform)
+{
+	CdTransformPrivate *priv = GET_PRIVATE (transform);
+	g_return_val_if_fail (CD_IS_TRANSFORM (transform), NULL);
+	if (!priv->gamut_alarm_enabled)
+		return NULL;
+	return &priv->gamut_alarm;
 }
 
 /**
@@ -343,124 +571,1261 @@ cd_transform_set_rendering_intent (CdTransform *transform, CdRenderingIntent ren
 	cd_transform_invalidate (transform);
 }
 
-/**
- * cd_transform_get_rendering_intent:
- * @transform: a #CdTransform instance.
- *
- * Gets the rendering intent to use for the transform.
- *
- * Return value: The rendering intent, e.g. %CD_RENDERING_INTENT_PERCEPTUAL
- *
- * Since: 1.0.0
- **/
-CdRenderingIntent
-cd_transform_get_rendering_intent (CdTransform *transform)
+/**
+ * cd_transform_get_rendering_intent:
+ * @transform: a #CdTransform instance.
+ *
+ * Gets the rendering intent to use for the transform.
+ *
+ * Return value: The rendering intent, e.g. %CD_RENDERING_INTENT_PERCEPTUAL
+ *
+ * Since: 1.0.0
+ **/
+CdRenderingIntent
+cd_transform_get_rendering_intent (CdTransform *transform)
+{
+	CdTransformPrivate *priv = GET_PRIVATE (transform);
+	g_return_val_if_fail (CD_IS_TRANSFORM (transform), CD_RENDERING_INTENT_UNKNOWN);
+	return priv->rendering_intent;
+}
+
+/**
+ * cd_transform_set_bpc:
+ * @transform: a #CdTransform instance.
+ * @bpc: black point compensation
+ *
+ * Sets if black point compensation should be used for the transform.
+ *
+ * Since: 1.0.0
+ **/
+void
+cd_transform_set_bpc (CdTransform *transform, gboolean bpc)
+{
+	CdTransformPrivate *priv = GET_PRIVATE (transform);
+
+	g_return_if_fail (CD_IS_TRANSFORM (transform));
+
+	priv->bpc = bpc;
+	cd_transform_invalidate (transform);
+}
+
+/**
+ * cd_transform_get_bpc:
+ * @transform: a #CdTransform instance.
+ *
+ * Gets the rendering bpc to use for the transform.
+ *
+ * Return value: If black point compensation should be used for the transform.
+ *
+ * Since: 1.0.0
+ **/
+gboolean
+cd_transform_get_bpc (CdTransform *transform)
+{
+	CdTransformPrivate *priv = GET_PRIVATE (transform);
+	g_return_val_if_fail (CD_IS_TRANSFORM (transform), FALSE);
+	return priv->bpc;
+}
+
+/**
+ * cd_transform_set_max_threads:
+ * @transform: a #CdTransform instance.
+ * @max_threads: number of threads, or 0 for the number of cores on the CPU
+ *
+ * Sets the maximum number of threads to be used for the transform.
+ *
+ * Since: 1.1.1
+ **/
+void
+cd_transform_set_max_threads (CdTransform *transform, guint max_threads)
+{
+	CdTransformPrivate *priv = GET_PRIVATE (transform);
+	g_return_if_fail (CD_IS_TRANSFORM (transform));
+	priv->max_threads = max_threads;
+}
+
+/**
+ * cd_transform_get_max_threads:
+ * @transform: a #CdTransform instance.
+ *
+ * Gets the maximum number of threads to be used for the transform.
+ *
+ * Return value: number of threads
+ *
+ * Since: 1.1.1
+ **/
+guint
+cd_transform_get_max_threads (CdTransform *transform)
+{
+	CdTransformPrivate *priv = GET_PRIVATE (transform);
+	g_return_val_if_fail (CD_IS_TRANSFORM (transform), 0);
+	return priv->max_threads;
+}
+
+/**
+ * cd_transform_set_use_cache:
+ * @transform: a #CdTransform instance.
+ * @use_cache: if the on-disk cache should be used
+ *
+ * Sets if the optimised transform should be saved to, and loaded from, a
+ * per-user cache of device link profiles. This avoids recomputing the
+ * same transform in every process, and is enabled by default.
+ *
+ * Since: 1.4.8
+ **/
+void
+cd_transform_set_use_cache (CdTransform *transform, gboolean use_cache)
+{
+	CdTransformPrivate *priv = GET_PRIVATE (transform);
+	g_return_if_fail (CD_IS_TRANSFORM (transform));
+	priv->use_cache = use_cache;
+}
+
+/**
+ * cd_transform_get_use_cache:
+ * @transform: a #CdTransform instance.
+ *
+ * Gets if the on-disk cache of device link profiles is used.
+ *
+ * Return value: %TRUE if the cache is used
+ *
+ * Since: 1.4.8
+ **/
+gboolean
+cd_transform_get_use_cache (CdTransform *transform)
+{
+	CdTransformPrivate *priv = GET_PRIVATE (transform);
+	g_return_val_if_fail (CD_IS_TRANSFORM (transform), FALSE);
+	return priv->use_cache;
+}
+
+/**
+ * cd_transform_set_ycbcr_matrix:
+ * @transform: a #CdTransform instance.
+ * @ycbcr_matrix: a #CdTransformYcbcrMatrix, e.g. %CD_TRANSFORM_YCBCR_MATRIX_BT709
+ *
+ * Sets the matrix used to decode Y'CbCr input, which is only used when the
+ * input pixel format is %CD_PIXEL_FORMAT_I420 or %CD_PIXEL_FORMAT_NV12.
+ *
+ * Since: 1.4.8
+ **/
+void
+cd_transform_set_ycbcr_matrix (CdTransform *transform,
+			       CdTransformYcbcrMatrix ycbcr_matrix)
+{
+	CdTransformPrivate *priv = GET_PRIVATE (transform);
+
+	g_return_if_fail (CD_IS_TRANSFORM (transform));
+	g_return_if_fail (ycbcr_matrix < CD_TRANSFORM_YCBCR_MATRIX_LAST);
+
+	priv->ycbcr_matrix = ycbcr_matrix;
+	cd_transform_invalidate (transform);
+}
+
+/**
+ * cd_transform_get_ycbcr_matrix:
+ * @transform: a #CdTransform instance.
+ *
+ * Gets the matrix used to decode Y'CbCr input.
+ *
+ * Return value: a #CdTransformYcbcrMatrix, e.g. %CD_TRANSFORM_YCBCR_MATRIX_BT709
+ *
+ * Since: 1.4.8
+ **/
+CdTransformYcbcrMatrix
+cd_transform_get_ycbcr_matrix (CdTransform *transform)
+{
+	CdTransformPrivate *priv = GET_PRIVATE (transform);
+	g_return_val_if_fail (CD_IS_TRANSFORM (transform), CD_TRANSFORM_YCBCR_MATRIX_LAST);
+	return priv->ycbcr_matrix;
+}
+
+/**
+ * cd_transform_set_ycbcr_range:
+ * @transform: a #CdTransform instance.
+ * @ycbcr_range: a #CdTransformYcbcrRange, e.g. %CD_TRANSFORM_YCBCR_RANGE_LIMITED
+ *
+ * Sets the quantization range of Y'CbCr input.
+ *
+ * Since: 1.4.8
+ **/
+void
+cd_transform_set_ycbcr_range (CdTransform *transform,
+			      CdTransformYcbcrRange ycbcr_range)
+{
+	CdTransformPrivate *priv = GET_PRIVATE (transform);
+
+	g_return_if_fail (CD_IS_TRANSFORM (transform));
+	g_return_if_fail (ycbcr_range < CD_TRANSFORM_YCBCR_RANGE_LAST);
+
+	priv->ycbcr_range = ycbcr_range;
+	cd_transform_invalidate (transform);
+}
+
+/**
+ * cd_transform_get_ycbcr_range:
+ * @transform: a #CdTransform instance.
+ *
+ * Gets the quantization range of Y'CbCr input.
+ *
+ * Return value: a #CdTransformYcbcrRange, e.g. %CD_TRANSFORM_YCBCR_RANGE_LIMITED
+ *
+ * Since: 1.4.8
+ **/
+CdTransformYcbcrRange
+cd_transform_get_ycbcr_range (CdTransform *transform)
+{
+	CdTransformPrivate *priv = GET_PRIVATE (transform);
+	g_return_val_if_fail (CD_IS_TRANSFORM (transform), CD_TRANSFORM_YCBCR_RANGE_LAST);
+	return priv->ycbcr_range;
+}
+
+/**
+ * cd_transform_set_input_transfer:
+ * @transform: a #CdTransform instance.
+ * @input_transfer: a #CdTransformTransfer, e.g. %CD_TRANSFORM_TRANSFER_PQ
+ *
+ * Sets the transfer function used to encode the input.
+ *
+ * For HDR input the input profile only provides the primaries, and has to
+ * be a matrix-shaper profile. If no input profile is set then the ITU-R
+ * BT.2020 primaries are used. The decoded light is then tone mapped onto
+ * the target peak luminance.
+ *
+ * The linearisation and tone mapping are baked into the tone curves of the
+ * input profile, so lcms can optimise them into the same 1D shaper and 3D
+ * LUT it would use for SDR input.
+ *
+ * Since: 1.4.8
+ **/
+void
+cd_transform_set_input_transfer (CdTransform *transform,
+				 CdTransformTransfer input_transfer)
+{
+	CdTransformPrivate *priv = GET_PRIVATE (transform);
+
+	g_return_if_fail (CD_IS_TRANSFORM (transform));
+	g_return_if_fail (input_transfer < CD_TRANSFORM_TRANSFER_LAST);
+
+	priv->input_transfer = input_transfer;
+	cd_transform_invalidate (transform);
+}
+
+/**
+ * cd_transform_get_input_transfer:
+ * @transform: a #CdTransform instance.
+ *
+ * Gets the transfer function used to encode the input.
+ *
+ * Return value: a #CdTransformTransfer, e.g. %CD_TRANSFORM_TRANSFER_PQ
+ *
+ * Since: 1.4.8
+ **/
+CdTransformTransfer
+cd_transform_get_input_transfer (CdTransform *transform)
+{
+	CdTransformPrivate *priv = GET_PRIVATE (transform);
+	g_return_val_if_fail (CD_IS_TRANSFORM (transform), CD_TRANSFORM_TRANSFER_LAST);
+	return priv->input_transfer;
+}
+
+/**
+ * cd_transform_set_tone_map:
+ * @transform: a #CdTransform instance.
+ * @tone_map: a #CdTransformToneMap, e.g. %CD_TRANSFORM_TONE_MAP_BT2390
+ *
+ * Sets the operator used to map HDR input onto the target peak luminance.
+ * This is ignored for SDR input.
+ *
+ * Since: 1.4.8
+ **/
+void
+cd_transform_set_tone_map (CdTransform *transform, CdTransformToneMap tone_map)
+{
+	CdTransformPrivate *priv = GET_PRIVATE (transform);
+
+	g_return_if_fail (CD_IS_TRANSFORM (transform));
+	g_return_if_fail (tone_map < CD_TRANSFORM_TONE_MAP_LAST);
+
+	priv->tone_map = tone_map;
+	cd_transform_invalidate (transform);
+}
+
+/**
+ * cd_transform_get_tone_map:
+ * @transform: a #CdTransform instance.
+ *
+ * Gets the operator used to map HDR input onto the target peak luminance.
+ *
+ * Return value: a #CdTransformToneMap, e.g. %CD_TRANSFORM_TONE_MAP_BT2390
+ *
+ * Since: 1.4.8
+ **/
+CdTransformToneMap
+cd_transform_get_tone_map (CdTransform *transform)
+{
+	CdTransformPrivate *priv = GET_PRIVATE (transform);
+	g_return_val_if_fail (CD_IS_TRANSFORM (transform), CD_TRANSFORM_TONE_MAP_LAST);
+	return priv->tone_map;
+}
+
+/**
+ * cd_transform_set_source_peak:
+ * @transform: a #CdTransform instance.
+ * @source_peak: the luminance in cd/m², e.g. 1000
+ *
+ * Sets the peak luminance of HDR input. For PQ input this is the peak of
+ * the mastering display, and for HLG input it is the nominal peak of the
+ * display the OOTF is applied for.
+ *
+ * The source peak defaults to 1000 cd/m².
+ *
+ * Since: 1.4.8
+ **/
+void
+cd_transform_set_source_peak (CdTransform *transform, gdouble source_peak)
+{
+	CdTransformPrivate *priv = GET_PRIVATE (transform);
+
+	g_return_if_fail (CD_IS_TRANSFORM (transform));
+	g_return_if_fail (source_peak > 0.f && source_peak <= 10000.f);
+
+	priv->source_peak = source_peak;
+	cd_transform_invalidate (transform);
+}
+
+/**
+ * cd_transform_get_source_peak:
+ * @transform: a #CdTransform instance.
+ *
+ * Gets the peak luminance of HDR input.
+ *
+ * Return value: the luminance in cd/m²
+ *
+ * Since: 1.4.8
+ **/
+gdouble
+cd_transform_get_source_peak (CdTransform *transform)
+{
+	CdTransformPrivate *priv = GET_PRIVATE (transform);
+	g_return_val_if_fail (CD_IS_TRANSFORM (transform), 0.f);
+	return priv->source_peak;
+}
+
+/**
+ * cd_transform_set_target_peak:
+ * @transform: a #CdTransform instance.
+ * @target_peak: the luminance in cd/m², e.g. 100
+ *
+ * Sets the peak luminance that HDR input is tone mapped onto, which is
+ * encoded as the maximum value of the input profile.
+ *
+ * The target peak defaults to 100 cd/m².
+ *
+ * Since: 1.4.8
+ **/
+void
+cd_transform_set_target_peak (CdTransform *transform, gdouble target_peak)
+{
+	CdTransformPrivate *priv = GET_PRIVATE (transform);
+
+	g_return_if_fail (CD_IS_TRANSFORM (transform));
+	g_return_if_fail (target_peak > 0.f && target_peak <= 10000.f);
+
+	priv->target_peak = target_peak;
+	cd_transform_invalidate (transform);
+}
+
+/**
+ * cd_transform_get_target_peak:
+ * @transform: a #CdTransform instance.
+ *
+ * Gets the luminance that HDR input is mapped onto.
+ *
+ * Return value: the luminance in cd/m²
+ *
+ * Since: 1.4.8
+ **/
+gdouble
+cd_transform_get_target_peak (CdTransform *transform)
+{
+	CdTransformPrivate *priv = GET_PRIVATE (transform);
+	g_return_val_if_fail (CD_IS_TRANSFORM (transform), 0.f);
+	return priv->target_peak;
+}
+
+/* the parametric stages are applied to the output after lcms */
+static void
+cd_transform_update_post_lut (CdTransform *transform)
+{
+	CdTransformPrivate *priv = GET_PRIVATE (transform);
+	CdColorRGB wp;
+	gdouble gain[3];
+	gdouble gamma[3];
+	guint i, j;
+
+	/* identity, so skip the stage completely */
+	if (priv->temperature == 6500 &&
+	    priv->gain.R == 1.f && priv->gain.G == 1.f && priv->gain.B == 1.f &&
+	    priv->gamma.R == 1.f && priv->gamma.G == 1.f && priv->gamma.B == 1.f) {
+		priv->post_lut_enabled = FALSE;
+		return;
+	}
+
+	cd_color_get_blackbody_rgb_full (priv->temperature, &wp,
+					 CD_COLOR_BLACKBODY_FLAG_USE_PLANCKIAN);
+	gain[0] = priv->gain.R * wp.R;
+	gain[1] = priv->gain.G * wp.G;
+	gain[2] = priv->gain.B * wp.B;
+	gamma[0] = 1.f / priv->gamma.R;
+	gamma[1] = 1.f / priv->gamma.G;
+	gamma[2] = 1.f / priv->gamma.B;
+	for (j = 0; j < 3; j++) {
+		for (i = 0; i < 256; i++) {
+			gdouble tmp = pow ((gdouble) i / 255.f, gamma[j]) * gain[j];
+			priv->post_lut[j][i] = CLAMP (tmp * 255.f + 0.5f, 0, 255);
+		}
+	}
+	priv->post_lut_enabled = TRUE;
+}
+
+/* byte offsets of R, G and B, or FALSE if not 8 bit RGB */
+static gboolean
+cd_transform_get_rgb_offsets (CdPixelFormat format, guint offsets[3])
+{
+	switch (format) {
+	case CD_PIXEL_FORMAT_RGB24:
+	case CD_PIXEL_FORMAT_RGBA32:
+		offsets[0] = 0;
+		offsets[1] = 1;
+		offsets[2] = 2;
+		return TRUE;
+	case CD_PIXEL_FORMAT_ARGB32:
+		offsets[0] = 1;
+		offsets[1] = 2;
+		offsets[2] = 3;
+		return TRUE;
+	case CD_PIXEL_FORMAT_BGRA32:
+		offsets[0] = 2;
+		offsets[1] = 1;
+		offsets[2] = 0;
+		return TRUE;
+	default:
+		return FALSE;
+	}
+}
+
+static void
+cd_transform_apply_post_lut (CdTransform *transform, guint8 *p_out, guint width)
+{
+	CdTransformPrivate *priv = GET_PRIVATE (transform);
+	guint offsets[3];
+	guint i;
+
+	if (!priv->post_lut_enabled)
+		return;
+	if (!cd_transform_get_rgb_offsets (priv->output_pixel_format, offsets))
+		return;
+	for (i = 0; i < width; i++) {
+		p_out[offsets[0]] = priv->post_lut[0][p_out[offsets[0]]];
+		p_out[offsets[1]] = priv->post_lut[1][p_out[offsets[1]]];
+		p_out[offsets[2]] = priv->post_lut[2][p_out[offsets[2]]];
+		p_out += priv->bpp_output;
+	}
+}
+
+/**
+ * cd_transform_set_temperature:
+ * @transform: a #CdTransform instance.
+ * @temperature: the white point temperature in Kelvin, e.g. 6500
+ *
+ * Sets the color temperature of the white point, which is applied to the
+ * output of the transform. Changing this does not rebuild the transform, so
+ * it can be used for smooth fades.
+ *
+ * The temperature defaults to 6500K, which does not change the output.
+ *
+ * Since: 1.4.8
+ **/
+void
+cd_transform_set_temperature (CdTransform *transform, guint temperature)
+{
+	CdTransformPrivate *priv = GET_PRIVATE (transform);
+	g_return_if_fail (CD_IS_TRANSFORM (transform));
+	g_return_if_fail (temperature >= 1000 && temperature <= 10000);
+	if (priv->temperature == temperature)
+		return;
+	priv->temperature = temperature;
+	cd_transform_update_post_lut (transform);
+}
+
+/**
+ * cd_transform_get_temperature:
+ * @transform: a #CdTransform instance.
+ *
+ * Gets the color temperature of the white point.
+ *
+ * Return value: the temperature in Kelvin
+ *
+ * Since: 1.4.8
+ **/
+guint
+cd_transform_get_temperature (CdTransform *transform)
+{
+	CdTransformPrivate *priv = GET_PRIVATE (transform);
+	g_return_val_if_fail (CD_IS_TRANSFORM (transform), 0);
+	return priv->temperature;
+}
+
+/**
+ * cd_transform_set_gain:
+ * @transform: a #CdTransform instance.
+ * @gain: the gain of each channel, where 1.0 is unchanged
+ *
+ * Sets a gain that is applied to each output channel of the transform.
+ * Changing this does not rebuild the transform.
+ *
+ * Since: 1.4.8
+ **/
+void
+cd_transform_set_gain (CdTransform *transform, const CdColorRGB *gain)
+{
+	CdTransformPrivate *priv = GET_PRIVATE (transform);
+	g_return_if_fail (CD_IS_TRANSFORM (transform));
+	g_return_if_fail (gain != NULL);
+	cd_color_rgb_copy (gain, &priv->gain);
+	cd_transform_update_post_lut (transform);
+}
+
+/**
+ * cd_transform_get_gain:
+ * @transform: a #CdTransform instance.
+ *
+ * Gets the gain applied to each output channel.
+ *
+ * Return value: the gain of each channel
+ *
+ * Since: 1.4.8
+ **/
+const CdColorRGB *
+cd_transform_get_gain (CdTransform *transform)
+{
+	CdTransformPrivate *priv = GET_PRIVATE (transform);
+	g_return_val_if_fail (CD_IS_TRANSFORM (transform), NULL);
+	return &priv->gain;
+}
+
+/**
+ * cd_transform_set_gamma:
+ * @transform: a #CdTransform instance.
+ * @gamma: the gamma of each channel, where 1.0 is unchanged
+ *
+ * Sets a gamma adjustment that is applied to each output channel of the
+ * transform, where values above 1.0 make the output brighter.
+ * Changing this does not rebuild the transform.
+ *
+ * Since: 1.4.8
+ **/
+void
+cd_transform_set_gamma (CdTransform *transform, const CdColorRGB *gamma)
+{
+	CdTransformPrivate *priv = GET_PRIVATE (transform);
+	g_return_if_fail (CD_IS_TRANSFORM (transform));
+	g_return_if_fail (gamma != NULL);
+	g_return_if_fail (gamma->R > 0.f && gamma->G > 0.f && gamma->B > 0.f);
+	cd_color_rgb_copy (gamma, &priv->gamma);
+	cd_transform_update_post_lut (transform);
+}
+
+/**
+ * cd_transform_get_gamma:
+ * @transform: a #CdTransform instance.
+ *
+ * Gets the gamma adjustment applied to each output channel.
+ *
+ * Return value: the gamma of each channel
+ *
+ * Since: 1.4.8
+ **/
+const CdColorRGB *
+cd_transform_get_gamma (CdTransform *transform)
+{
+	CdTransformPrivate *priv = GET_PRIVATE (transform);
+	g_return_val_if_fail (CD_IS_TRANSFORM (transform), NULL);
+	return &priv->gamma;
+}
+
+/* map lcms intent to colord type */
+const struct {
+	gint					lcms;
+	CdRenderingIntent			colord;
+} map_rendering_intent[] = {
+	{ INTENT_PERCEPTUAL,		CD_RENDERING_INTENT_PERCEPTUAL },
+	{ INTENT_ABSOLUTE_COLORIMETRIC,	CD_RENDERING_INTENT_ABSOLUTE_COLORIMETRIC },
+	{ INTENT_RELATIVE_COLORIMETRIC,	CD_RENDERING_INTENT_RELATIVE_COLORIMETRIC },
+	{ INTENT_SATURATION,		CD_RENDERING_INTENT_SATURATION },
+	{ 0,				CD_RENDERING_INTENT_LAST }
+};
+
+static gint
+cd_transform_get_lcms_intent (CdRenderingIntent rendering_intent)
+{
+	guint i;
+	for (i = 0; map_rendering_intent[i].colord != CD_RENDERING_INTENT_LAST; i++) {
+		if (map_rendering_intent[i].colord == rendering_intent)
+			return map_rendering_intent[i].lcms;
+	}
+	return -1;
+}
+
+static guint
+cd_transform_get_bpp (CdPixelFormat format)
+{
+	switch (format) {
+	case CD_PIXEL_FORMAT_I420:
+	case CD_PIXEL_FORMAT_NV12:
+		return 1;
+	case CD_PIXEL_FORMAT_RGB24:
+		return 3;
+	case CD_PIXEL_FORMAT_ARGB32:
+	case CD_PIXEL_FORMAT_CMYK32:
+	case CD_PIXEL_FORMAT_BGRA32:
+	case CD_PIXEL_FORMAT_RGBA32:
+		return 4;
+	case CD_PIXEL_FORMAT_UNKNOWN:
+	default:
+		return 0;
+	}
+}
+
+static gboolean
+cd_transform_pixel_format_is_ycbcr (CdPixelFormat format)
+{
+	return format == CD_PIXEL_FORMAT_I420 || format == CD_PIXEL_FORMAT_NV12;
+}
+
+/* the chroma is upsampled a row at a time before lcms sees it */
+static cmsUInt32Number
+cd_transform_get_lcms_input_format (CdTransform *transform)
+{
+	CdTransformPrivate *priv = GET_PRIVATE (transform);
+	if (cd_transform_pixel_format_is_ycbcr (priv->input_pixel_format))
+		return TYPE_YCbCr_8;
+	return priv->input_pixel_format;
+}
+
+/* a device link that converts encoded Y'CbCr into encoded R'G'B' */
+static cmsHPROFILE
+cd_transform_create_ycbcr_link (CdTransform *transform)
+{
+	CdTransformPrivate *priv = GET_PRIVATE (transform);
+	cmsHPROFILE profile;
+	cmsPipeline *pipeline;
+	cmsStage *stage;
+	gdouble c_off, c_scale, y_off, y_scale;
+	gdouble kb, kg, kr;
+	gdouble rv, gu, gv, bu;
+	gdouble matrix[9];
+	gdouble offset[3];
+
+	switch (priv->ycbcr_matrix) {
+	case CD_TRANSFORM_YCBCR_MATRIX_BT601:
+		kr = 0.299;
+		kb = 0.114;
+		break;
+	case CD_TRANSFORM_YCBCR_MATRIX_BT2020:
+		kr = 0.2627;
+		kb = 0.0593;
+		break;
+	case CD_TRANSFORM_YCBCR_MATRIX_BT709:
+	default:
+		kr = 0.2126;
+		kb = 0.0722;
+		break;
+	}
+	kg = 1.f - kr - kb;
+
+	/* lcms normalises the 8 bit input to 0..1 */
+	if (priv->ycbcr_range == CD_TRANSFORM_YCBCR_RANGE_FULL) {
+		y_scale = 1.f;
+		y_off = 0.f;
+		c_scale = 1.f;
+		c_off = -128.f / 255.f;
+	} else {
+		y_scale = 255.f / 219.f;
+		y_off = -16.f / 219.f;
+		c_scale = 255.f / 224.f;
+		c_off = -128.f / 224.f;
+	}
+
+	/* R'G'B' from Y'PbPr */
+	rv = 2.f * (1.f - kr);
+	gu = -2.f * kb * (1.f - kb) / kg;
+	gv = -2.f * kr * (1.f - kr) / kg;
+	bu = 2.f * (1.f - kb);
+
+	/* fold the range expansion into the matrix */
+	matrix[0] = y_scale;
+	matrix[1] = 0.f;
+	matrix[2] = rv * c_scale;
+	matrix[3] = y_scale;
+	matrix[4] = gu * c_scale;
+	matrix[5] = gv * c_scale;
+	matrix[6] = y_scale;
+	matrix[7] = bu * c_scale;
+	matrix[8] = 0.f;
+	offset[0] = y_off + rv * c_off;
+	offset[1] = y_off + (gu + gv) * c_off;
+	offset[2] = y_off + bu * c_off;
+
+	profile = cmsCreateProfilePlaceholder (priv->context_lcms);
+	if (profile == NULL)
+		return NULL;
+	cmsSetProfileVersion (profile, 4.3);
+	cmsSetDeviceClass (profile, cmsSigLinkClass);
+	cmsSetColorSpace (profile, cmsSigYCbCrData);
+	cmsSetPCS (profile, cmsSigRgbData);
+	pipeline = cmsPipelineAlloc (priv->context_lcms, 3, 3);
+	if (pipeline == NULL) {
+		cmsCloseProfile (profile);
+		return NULL;
+	}
+	stage = cmsStageAllocMatrix (priv->context_lcms, 3, 3, matrix, offset);
+	if (stage == NULL ||
+	    !cmsPipelineInsertStage (pipeline, cmsAT_BEGIN, stage) ||
+	    !cmsWriteTag (profile, cmsSigAToB0Tag, pipeline)) {
+		cmsPipelineFree (pipeline);
+		cmsCloseProfile (profile);
+		return NULL;
+	}
+	cmsPipelineFree (pipeline);
+	return profile;
+}
+
+/* linear light relative to the target peak */
+static gdouble
+cd_transform_hdr_to_linear (CdTransform *transform, gdouble value)
+{
+	CdTransformPrivate *priv = GET_PRIVATE (transform);
+	gdouble gamma;
+	gdouble luminance;
+
+	switch (priv->input_transfer) {
+	case CD_TRANSFORM_TRANSFER_PQ:
+		luminance = cd_color_pq_to_luminance (value);
+		break;
+	case CD_TRANSFORM_TRANSFER_HLG:
+		/* the OOTF is applied to each channel rather than to Y */
+		gamma = 1.2f + 0.42f * log10 (priv->source_peak / 1000.f);
+		luminance = priv->source_peak *
+			    pow (cd_color_hlg_to_scene_linear (value), gamma);
+		break;
+	default:
+		return value;
+	}
+	if (priv->tone_map == CD_TRANSFORM_TONE_MAP_BT2390) {
+		luminance = cd_color_tone_map_bt2390 (luminance,
+						      priv->source_peak,
+						      priv->target_peak);
+	}
+	return CLAMP (luminance / priv->target_peak, 0.f, 1.f);
+}
+
+/* a copy of the input profile with tone curves that decode the HDR signal */
+static cmsHPROFILE
+cd_transform_create_hdr_profile (CdTransform *transform, GError **error)
+{
+	CdTransformPrivate *priv = GET_PRIVATE (transform);
+	cmsCIExyY d65 = { 0.3127, 0.3290, 1.0 };
+	cmsCIExyYTRIPLE bt2020 = {
+		{ 0.708, 0.292, 1.0 },
+		{ 0.170, 0.797, 1.0 },
+		{ 0.131, 0.046, 1.0 } };
+	cmsHPROFILE profile = NULL;
+	cmsHPROFILE profile_in;
+	cmsToneCurve *curve;
+	cmsToneCurve *curves[3];
+	const cmsTagSignature colorants[] = { cmsSigRedColorantTag,
+					      cmsSigGreenColorantTag,
+					      cmsSigBlueColorantTag,
+					      0 };
+	gpointer wtpt;
+	guint i;
+	g_autofree cmsUInt16Number *table = NULL;
+
+	table = g_new (cmsUInt16Number, CD_TRANSFORM_HDR_SHAPER_SIZE);
+	for (i = 0; i < CD_TRANSFORM_HDR_SHAPER_SIZE; i++) {
+		gdouble tmp = (gdouble) i / (CD_TRANSFORM_HDR_SHAPER_SIZE - 1);
+		tmp = cd_transform_hdr_to_linear (transform, tmp);
+		table[i] = tmp * 0xffff + 0.5f;
+	}
+	curve = cmsBuildTabulatedToneCurve16 (priv->context_lcms,
+					      CD_TRANSFORM_HDR_SHAPER_SIZE,
+					      table);
+	if (curve == NULL) {
+		g_set_error_literal (error,
+				     CD_TRANSFORM_ERROR,
+				     CD_TRANSFORM_ERROR_FAILED_TO_SETUP_TRANSFORM,
+				     "failed to create HDR tone curve");
+		return NULL;
+	}
+
+	/* HDR video is BT.2100 unless told otherwise */
+	if (priv->input_icc == NULL) {
+		curves[0] = curves[1] = curves[2] = curve;
+		profile = cmsCreateRGBProfileTHR (priv->context_lcms,
+						  &d65, &bt2020, curves);
+		goto out;
+	}
+
+	/* only the primaries of the input profile are used */
+	profile_in = cd_icc_get_handle (priv->input_icc);
+	if (cmsGetColorSpace (profile_in) != cmsSigRgbData ||
+	    !cmsIsMatrixShaper (profile_in)) {
+		g_set_error_literal (error,
+				     CD_TRANSFORM_ERROR,
+				     CD_TRANSFORM_ERROR_INVALID_COLORSPACE,
+				     "HDR input needs a matrix-shaper input profile");
+		goto out;
+	}
+	profile = cmsCreateProfilePlaceholder (priv->context_lcms);
+	if (profile == NULL)
+		goto out;
+	cmsSetProfileVersion (profile, 4.3);
+	cmsSetDeviceClass (profile, cmsSigDisplayClass);
+	cmsSetColorSpace (profile, cmsSigRgbData);
+	cmsSetPCS (profile, cmsSigXYZData);
+	wtpt = cmsReadTag (profile_in, cmsSigMediaWhitePointTag);
+	if (wtpt == NULL)
+		wtpt = (gpointer) cmsD50_XYZ ();
+	if (!cmsWriteTag (profile, cmsSigMediaWhitePointTag, wtpt))
+		goto fail;
+	for (i = 0; colorants[i] != 0; i++) {
+		gpointer tag = cmsReadTag (profile_in, colorants[i]);
+		if (tag == NULL || !cmsWriteTag (profile, colorants[i], tag))
+			goto fail;
+	}
+	if (!cmsWriteTag (profile, cmsSigRedTRCTag, curve) ||
+	    !cmsWriteTag (profile, cmsSigGreenTRCTag, curve) ||
+	    !cmsWriteTag (profile, cmsSigBlueTRCTag, curve))
+		goto fail;
+	goto out;
+fail:
+	cmsCloseProfile (profile);
+	profile = NULL;
+out:
+	if (profile == NULL && error != NULL && *error == NULL) {
+		g_set_error_literal (error,
+				     CD_TRANSFORM_ERROR,
+				     CD_TRANSFORM_ERROR_FAILED_TO_SETUP_TRANSFORM,
+				     "failed to create HDR input profile");
+	}
+	cmsFreeToneCurve (curve);
+	return profile;
+}
+
+static gchar *
+cd_transform_cache_get_dir (void)
+{
+	const gchar *tmp;
+
+	/* allow the self tests to override */
+	tmp = g_getenv ("COLORD_TRANSFORM_CACHE_DIR");
+	if (tmp != NULL)
+		return g_strdup (tmp);
+	return g_build_filename (g_get_user_cache_dir (),
+				 "colord", "transforms", NULL);
+}
+
+static gboolean
+cd_transform_cache_key_add_icc (GString *str, const gchar *kind, CdIcc *icc)
+{
+	cmsHPROFILE lcms_profile;
+	cmsUInt32Number len = 0;
+	g_autofree gchar *checksum = NULL;
+	g_autofree guint8 *data = NULL;
+
+	/* sRGB is built in */
+	if (icc == NULL) {
+		g_string_append_printf (str, "%s=sRGB;", kind);
+		return TRUE;
+	}
+
+	/* the checksum is only set when the profile is loaded, so it does not
+	 * change when the profile is modified; hash what lcms would use */
+	lcms_profile = cd_icc_get_handle (icc);
+	if (!cmsSaveProfileToMem (lcms_profile, NULL, &len) || len == 0)
+		return FALSE;
+	data = g_malloc (len);
+	if (!cmsSaveProfileToMem (lcms_profile, data, &len))
+		return FALSE;
+	checksum = g_compute_checksum_for_data (G_CHECKSUM_MD5, data, len);
+	g_string_append_printf (str, "%s=%s;", kind, checksum);
+	return TRUE;
+}
+
+static gchar *
+cd_transform_cache_get_filename (CdTransform *transform,
+				 gint lcms_intent,
+				 cmsUInt32Number lcms_flags)
+{
+	CdTransformPrivate *priv = GET_PRIVATE (transform);
+	g_autofree gchar *basename = NULL;
+	g_autofree gchar *cachedir = NULL;
+	g_autofree gchar *hash = NULL;
+	g_autoptr(GString) str = g_string_new (NULL);
+	guint i;
+
+	/* everything that affects the pipeline */
+	g_string_append_printf (str, "lcms=%i;", LCMS_VERSION);
+	if (!cd_transform_cache_key_add_icc (str, "input", priv->input_icc))
+		return NULL;
+	for (i = 0; i < priv->abstract_iccs->len; i++) {
+		CdIcc *icc = g_ptr_array_index (priv->abstract_iccs, i);
+		if (!cd_transform_cache_key_add_icc (str, "abstract", icc))
+			return NULL;
+	}
+	if (!cd_transform_cache_key_add_icc (str, "output", priv->output_icc))
+		return NULL;
+	g_string_append_printf (str, "intent=%i;flags=%u;format=%u:%u",
+				lcms_intent, lcms_flags,
+				priv->input_pixel_format,
+				priv->output_pixel_format);
+	if (cd_transform_pixel_format_is_ycbcr (priv->input_pixel_format)) {
+		g_string_append_printf (str, ";ycbcr=%u:%u",
+					priv->ycbcr_matrix,
+					priv->ycbcr_range);
+	}
+	if (priv->input_transfer != CD_TRANSFORM_TRANSFER_SDR) {
+		g_string_append_printf (str, ";transfer=%u:%u:%.17g:%.17g",
+					priv->input_transfer,
+					priv->tone_map,
+					priv->source_peak,
+					priv->target_peak);
+	}
+	if (priv->proof_icc != NULL) {
+		g_string_append (str, ";");
+		if (!cd_transform_cache_key_add_icc (str, "proof", priv->proof_icc))
+			return NULL;
+		g_string_append_printf (str, "proof-intent=%u",
+					priv->proof_rendering_intent);
+		if (priv->gamut_alarm_enabled) {
+			g_string_append_printf (str, ";alarm=%.4f,%.4f,%.4f",
+						priv->gamut_alarm.R,
+						priv->gamut_alarm.G,
+						priv->gamut_alarm.B);
+		}
+	}
+
+	hash = g_compute_checksum_for_string (G_CHECKSUM_SHA1, str->str, str->len);
+	basename = g_strdup_printf ("%s.icc", hash);
+	cachedir = cd_transform_cache_get_dir ();
+	return g_build_filename (cachedir, basename, NULL);
+}
+
+static cmsHTRANSFORM
+cd_transform_cache_load (CdTransform *transform,
+			 const gchar *filename,
+			 gint lcms_intent,
+			 cmsUInt32Number lcms_flags)
+{
+	CdTransformPrivate *priv = GET_PRIVATE (transform);
+	cmsHPROFILE devlink;
+	cmsHTRANSFORM lcms_transform;
+
+	if (!g_file_test (filename, G_FILE_TEST_EXISTS))
+		return NULL;
+
+	/* the device link has the whole pipeline, so no output profile */
+	devlink = cmsOpenProfileFromFileTHR (priv->context_lcms, filename, "r");
+	if (devlink == NULL) {
+		g_debug ("removing invalid cached transform %s", filename);
+		cd_context_lcms_error_clear (priv->context_lcms);
+		g_unlink (filename);
+		return NULL;
+	}
+	lcms_transform = cmsCreateTransformTHR (priv->context_lcms,
+						devlink,
+						cd_transform_get_lcms_input_format (transform),
+						NULL,
+						priv->output_pixel_format,
+						lcms_intent,
+						lcms_flags);
+	cmsCloseProfile (devlink);
+	if (lcms_transform == NULL) {
+		g_debug ("removing unusable cached transform %s", filename);
+		cd_context_lcms_error_clear (priv->context_lcms);
+		g_unlink (filename);
+		return NULL;
+	}
+
+	/* mark as recently used so it does not get evicted */
+	g_utime (filename, NULL);
+	g_debug ("using cached transform %s", filename);
+	return lcms_transform;
+}
+
+typedef struct {
+	gchar		*filename;
+	goffset		 size;
+	gint64		 mtime;
+} CdTransformCacheItem;
+
+static void
+cd_transform_cache_item_free (CdTransformCacheItem *item)
+{
+	g_free (item->filename);
+	g_free (item);
+}
+
+static gint
+cd_transform_cache_item_sort_cb (gconstpointer a, gconstpointer b)
 {
-	CdTransformPrivate *priv = GET_PRIVATE (transform);
-	g_return_val_if_fail (CD_IS_TRANSFORM (transform), CD_RENDERING_INTENT_UNKNOWN);
-	return priv->rendering_intent;
+	CdTransformCacheItem *item1 = *((CdTransformCacheItem **) a);
+	CdTransformCacheItem *item2 = *((CdTransformCacheItem **) b);
+	if (item1->mtime < item2->mtime)
+		return -1;
+	if (item1->mtime > item2->mtime)
+		return 1;
+	return 0;
 }
 
-/**
- * cd_transform_set_bpc:
- * @transform: a #CdTransform instance.
- * @bpc: black point compensation
- *
- * Sets if black point compensation should be used for the transform.
- *
- * Since: 1.0.0
- **/
-void
-cd_transform_set_bpc (CdTransform *transform, gboolean bpc)
+static void
+cd_transform_cache_evict (const gchar *cachedir)
 {
-	CdTransformPrivate *priv = GET_PRIVATE (transform);
+	CdTransformCacheItem *item;
+	GStatBuf stat_buf;
+	const gchar *tmp;
+	goffset total = 0;
+	guint i;
+	g_autoptr(GDir) dir = NULL;
+	g_autoptr(GPtrArray) items = NULL;
 
-	g_return_if_fail (CD_IS_TRANSFORM (transform));
+	dir = g_dir_open (cachedir, 0, NULL);
+	if (dir == NULL)
+		return;
+	items = g_ptr_array_new_with_free_func ((GDestroyNotify) cd_transform_cache_item_free);
+	while ((tmp = g_dir_read_name (dir)) != NULL) {
+		g_autofree gchar *filename = NULL;
+		if (!g_str_has_suffix (tmp, ".icc"))
+			continue;
+		filename = g_build_filename (cachedir, tmp, NULL);
+		if (g_stat (filename, &stat_buf) != 0)
+			continue;
+		item = g_new0 (CdTransformCacheItem, 1);
+		item->filename = g_steal_pointer (&filename);
+		item->size = stat_buf.st_size;
+		item->mtime = stat_buf.st_mtime;
+		g_ptr_array_add (items, item);
+		total += item->size;
+	}
 
-	priv->bpc = bpc;
-	cd_transform_invalidate (transform);
+	/* remove the least recently used until we fit */
+	g_ptr_array_sort (items, cd_transform_cache_item_sort_cb);
+	for (i = 0; i < items->len && total > CD_TRANSFORM_CACHE_SIZE_MAX; i++) {
+		item = g_ptr_array_index (items, i);
+		g_debug ("evicting cached transform %s", item->filename);
+		if (g_unlink (item->filename) == 0)
+			total -= item->size;
+	}
 }
 
-/**
- * cd_transform_get_bpc:
- * @transform: a #CdTransform instance.
- *
- * Gets the rendering bpc to use for the transform.
- *
- * Return value: If black point compensation should be used for the transform.
- *
- * Since: 1.0.0
- **/
-gboolean
-cd_transform_get_bpc (CdTransform *transform)
+static void
+cd_transform_cache_save (CdTransform *transform, const gchar *filename)
 {
 	CdTransformPrivate *priv = GET_PRIVATE (transform);
-	g_return_val_if_fail (CD_IS_TRANSFORM (transform), FALSE);
-	return priv->bpc;
+	cmsHPROFILE devlink;
+	cmsUInt32Number size = 0;
+	g_autofree gchar *cachedir = NULL;
+	g_autofree guint8 *data = NULL;
+	g_autoptr(GError) error_local = NULL;
+
+	/* get the optimised pipeline */
+	devlink = cmsTransform2DeviceLink (priv->lcms_transform, 4.3, 0);
+	if (devlink == NULL) {
+		g_debug ("failed to create device link for cache");
+		cd_context_lcms_error_clear (priv->context_lcms);
+		return;
+	}
+	if (!cmsSaveProfileToMem (devlink, NULL, &size) || size == 0) {
+		cmsCloseProfile (devlink);
+		cd_context_lcms_error_clear (priv->context_lcms);
+		return;
+	}
+	data = g_malloc (size);
+	if (!cmsSaveProfileToMem (devlink, data, &size)) {
+		cmsCloseProfile (devlink);
+		cd_context_lcms_error_clear (priv->context_lcms);
+		return;
+	}
+	cmsCloseProfile (devlink);
+
+	/* this is atomic, so other processes never see a partial file */
+	cachedir = g_path_get_dirname (filename);
+	if (g_mkdir_with_parents (cachedir, 0700) != 0) {
+		g_debug ("failed to create %s", cachedir);
+		return;
+	}
+	if (!g_file_set_contents (filename, (const gchar *) data, size, &error_local)) {
+		g_debug ("failed to save cached transform: %s",
+			 error_local->message);
+		return;
+	}
+	g_debug ("saved cached transform %s", filename);
+	cd_transform_cache_evict (cachedir);
 }
 
-/**
- * cd_transform_set_max_threads:
- * @transform: a #CdTransform instance.
- * @max_threads: number of threads, or 0 for the number of cores on the CPU
- *
- * Sets the maximum number of threads to be used for the transform.
- *
- * Since: 1.1.1
- **/
-void
-cd_transform_set_max_threads (CdTransform *transform, guint max_threads)
+static cmsInt32Number
+cd_transform_proof_sample_cb (const cmsUInt16Number in[],
+			      cmsUInt16Number out[],
+			      void *user_data)
 {
-	CdTransformPrivate *priv = GET_PRIVATE (transform);
-	g_return_if_fail (CD_IS_TRANSFORM (transform));
-	priv->max_threads = max_threads;
+	cmsDoTransform ((cmsHTRANSFORM) user_data, in, out, 1);
+	return TRUE;
 }
 
-/**
- * cd_transform_get_max_threads:
- * @transform: a #CdTransform instance.
- *
- * Gets the maximum number of threads to be used for the transform.
- *
- * Return value: number of threads
- *
- * Since: 1.1.1
- **/
-guint
-cd_transform_get_max_threads (CdTransform *transform)
+/* sample the proof and gamut check into one LUT, as lcms would otherwise
+ * evaluate the gamut check pipeline separately for every pixel */
+static cmsHTRANSFORM
+cd_transform_bake_gamut_check (CdTransform *transform,
+			       cmsHPROFILE *profiles,
+			       cmsBool *bpc,
+			       cmsUInt32Number *intents,
+			       cmsFloat64Number *adaptation,
+			       guint nr_profiles,
+			       guint gamut_position,
+			       cmsUInt32Number lcms_flags)
 {
 	CdTransformPrivate *priv = GET_PRIVATE (transform);
-	g_return_val_if_fail (CD_IS_TRANSFORM (transform), 0);
-	return priv->max_threads;
+	cmsHPROFILE devlink = NULL;
+	cmsHTRANSFORM lcms_transform = NULL;
+	cmsHTRANSFORM xform16;
+	cmsPipeline *pipeline = NULL;
+	cmsStage *stage;
+	cmsUInt16Number alarm_codes[cmsMAXCHANNELS] = { 0 };
+	cmsUInt32Number nr_in;
+	cmsUInt32Number nr_out;
+	const guint grid_points = 33;
+
+	/* this is per-context, so does not affect other transforms */
+	alarm_codes[0] = priv->gamut_alarm.R * 0xffff;
+	alarm_codes[1] = priv->gamut_alarm.G * 0xffff;
+	alarm_codes[2] = priv->gamut_alarm.B * 0xffff;
+	cmsSetAlarmCodesTHR (priv->context_lcms, alarm_codes);
+
+	xform16 = cmsCreateExtendedTransform (priv->context_lcms,
+					      nr_profiles,
+					      profiles,
+					      bpc,
+					      intents,
+					      adaptation,
+					      profiles[gamut_position],
+					      gamut_position,
+					      cmsFormatterForColorspaceOfProfile (profiles[0], 2, FALSE),
+					      cmsFormatterForColorspaceOfProfile (profiles[nr_profiles - 1], 2, FALSE),
+					      (lcms_flags & ~cmsFLAGS_BLACKPOINTCOMPENSATION) |
+					      cmsFLAGS_GAMUTCHECK | cmsFLAGS_NOCACHE);
+	if (xform16 == NULL)
+		return NULL;
+
+	/* a device link with just the sampled CLUT */
+	nr_in = cmsChannelsOf (cmsGetColorSpace (profiles[0]));
+	nr_out = cmsChannelsOf (cmsGetColorSpace (profiles[nr_profiles - 1]));
+	devlink = cmsCreateProfilePlaceholder (priv->context_lcms);
+	if (devlink == NULL)
+		goto out;
+	cmsSetProfileVersion (devlink, 4.3);
+	cmsSetDeviceClass (devlink, cmsSigLinkClass);
+	cmsSetColorSpace (devlink, cmsGetColorSpace (profiles[0]));
+	cmsSetPCS (devlink, cmsGetColorSpace (profiles[nr_profiles - 1]));
+	pipeline = cmsPipelineAlloc (priv->context_lcms, nr_in, nr_out);
+	if (pipeline == NULL)
+		goto out;
+	stage = cmsStageAllocCLut16bit (priv->context_lcms, grid_points,
+					nr_in, nr_out, NULL);
+	if (stage == NULL)
+		goto out;
+	if (!cmsStageSampleCLut16bit (stage, cd_transform_proof_sample_cb, xform16, 0) ||
+	    !cmsPipelineInsertStage (pipeline, cmsAT_BEGIN, stage)) {
+		cmsStageFree (stage);
+		goto out;
+	}
+	if (!cmsWriteTag (devlink, cmsSigAToB0Tag, pipeline))
+		goto out;
+	lcms_transform = cmsCreateTransformTHR (priv->context_lcms,
+						devlink,
+						cd_transform_get_lcms_input_format (transform),
+						NULL,
+						priv->output_pixel_format,
+						INTENT_PERCEPTUAL,
+						lcms_flags & ~cmsFLAGS_BLACKPOINTCOMPENSATION);
+out:
+	if (pipeline != NULL)
+		cmsPipelineFree (pipeline);
+	if (devlink != NULL)
+		cmsCloseProfile (devlink);
+	cmsDeleteTransform (xform16);
+	return lcms_transform;
 }
 
-/* map lcms intent to colord type */
-const struct {
-	gint					lcms;
-	CdRenderingIntent			colord;
-} map_rendering_intent[] = {
-	{ INTENT_PERCEPTUAL,		CD_RENDERING_INTENT_PERCEPTUAL },
-	{ INTENT_ABSOLUTE_COLORIMETRIC,	CD_RENDERING_INTENT_ABSOLUTE_COLORIMETRIC },
-	{ INTENT_RELATIVE_COLORIMETRIC,	CD_RENDERING_INTENT_RELATIVE_COLORIMETRIC },
-	{ INTENT_SATURATION,		CD_RENDERING_INTENT_SATURATION },
-	{ 0,				CD_RENDERING_INTENT_LAST }
-};
-
-static guint
-cd_transform_get_bpp (CdPixelFormat format)
+/* the simulated device is added as an output and then an input profile
+ * in the same way as cmsCreateProofingTransformTHR() does */
+static cmsHTRANSFORM
+cd_transform_setup_proofing (CdTransform *transform,
+			     cmsHPROFILE *profiles,
+			     guint nr_profiles,
+			     gint lcms_intent,
+			     cmsUInt32Number lcms_flags)
 {
-	switch (format) {
-	case CD_PIXEL_FORMAT_RGB24:
-		return 3;
-	case CD_PIXEL_FORMAT_ARGB32:
-	case CD_PIXEL_FORMAT_CMYK32:
-	case CD_PIXEL_FORMAT_BGRA32:
-	case CD_PIXEL_FORMAT_RGBA32:
-		return 4;
-	case CD_PIXEL_FORMAT_UNKNOWN:
-	default:
-		return 0;
+	CdTransformPrivate *priv = GET_PRIVATE (transform);
+	cmsHPROFILE profile_proof = cd_icc_get_handle (priv->proof_icc);
+	cmsFloat64Number adaptation_state;
+	gboolean bpc = (lcms_flags & cmsFLAGS_BLACKPOINTCOMPENSATION) > 0;
+	guint i;
+	guint nr = 0;
+	g_autofree cmsBool *bpcs = g_new0 (cmsBool, nr_profiles + 2);
+	g_autofree cmsFloat64Number *adaptation = g_new0 (cmsFloat64Number, nr_profiles + 2);
+	g_autofree cmsHPROFILE *chain = g_new0 (cmsHPROFILE, nr_profiles + 2);
+	g_autofree cmsUInt32Number *intents = g_new0 (cmsUInt32Number, nr_profiles + 2);
+
+	/* everything up to the output profile */
+	for (i = 0; i < nr_profiles - 1; i++) {
+		chain[nr] = profiles[i];
+		intents[nr] = lcms_intent;
+		bpcs[nr++] = bpc;
+	}
+
+	/* render into the simulated device, and back out again */
+	chain[nr] = profile_proof;
+	intents[nr] = lcms_intent;
+	bpcs[nr++] = bpc;
+	chain[nr] = profile_proof;
+	intents[nr] = INTENT_RELATIVE_COLORIMETRIC;
+	bpcs[nr++] = FALSE;
+	chain[nr] = profiles[nr_profiles - 1];
+	intents[nr] = cd_transform_get_lcms_intent (priv->proof_rendering_intent);
+	bpcs[nr++] = FALSE;
+	adaptation_state = cmsSetAdaptationStateTHR (priv->context_lcms, -1);
+	for (i = 0; i < nr; i++)
+		adaptation[i] = adaptation_state;
+
+	if (priv->gamut_alarm_enabled) {
+		return cd_transform_bake_gamut_check (transform, chain, bpcs,
+						      intents, adaptation, nr,
+						      nr_profiles - 1,
+						      lcms_flags);
 	}
+	return cmsCreateExtendedTransform (priv->context_lcms,
+					   nr,
+					   chain,
+					   bpcs,
+					   intents,
+					   adaptation,
+					   NULL,
+					   0,
+					   cd_transform_get_lcms_input_format (transform),
+					   priv->output_pixel_format,
+					   lcms_flags & ~cmsFLAGS_BLACKPOINTCOMPENSATION);
 }
 
 static gboolean
@@ -469,19 +1834,17 @@ cd_transform_setup (CdTransform *transform, GError **error)
 	CdTransformPrivate *priv = GET_PRIVATE (transform);
 	cmsHPROFILE profile_in;
 	cmsHPROFILE profile_out;
+	cmsHPROFILE profile_hdr = NULL;
+	cmsHPROFILE profile_ycbcr = NULL;
 	cmsUInt32Number lcms_flags = 0;
 	gboolean ret = TRUE;
 	gint lcms_intent = -1;
 	guint i;
+	g_autofree gchar *cache_filename = NULL;
 	g_autoptr(GError) error_local = NULL;
 
 	/* find native rendering intent */
-	for (i = 0; map_rendering_intent[i].colord != CD_RENDERING_INTENT_LAST; i++) {
-		if (map_rendering_intent[i].colord == priv->rendering_intent) {
-			lcms_intent = map_rendering_intent[i].lcms;
-			break;
-		}
-	}
+	lcms_intent = cd_transform_get_lcms_intent (priv->rendering_intent);
 	g_assert (lcms_intent != -1);
 
 	/* get input profile */
@@ -508,11 +1871,29 @@ cd_transform_setup (CdTransform *transform, GError **error)
 	if (priv->bpc)
 		lcms_flags |= cmsFLAGS_BLACKPOINTCOMPENSATION;
 
-	/* get abstract profile */
-	if (priv->abstract_icc != NULL) {
-		cmsHPROFILE profiles[3];
+	/* find the bpp value */
+	priv->bpp_input = cd_transform_get_bpp (priv->input_pixel_format);
+	priv->bpp_output = cd_transform_get_bpp (priv->output_pixel_format);
+
+	/* another process may have already done the hard work */
+	if (priv->use_cache) {
+		cache_filename = cd_transform_cache_get_filename (transform,
+								  lcms_intent,
+								  lcms_flags);
+	}
+	if (cache_filename != NULL) {
+		priv->lcms_transform = cd_transform_cache_load (transform,
+								cache_filename,
+								lcms_intent,
+								lcms_flags);
+		if (priv->lcms_transform != NULL)
+			goto out;
+	}
 
-		if (cd_icc_get_colorspace (priv->abstract_icc) != CD_COLORSPACE_LAB) {
+	/* check abstract profiles */
+	for (i = 0; i < priv->abstract_iccs->len; i++) {
+		CdIcc *icc = g_ptr_array_index (priv->abstract_iccs, i);
+		if (cd_icc_get_colorspace (icc) != CD_COLORSPACE_LAB) {
 			ret = FALSE;
 			g_set_error_literal (error,
 					     CD_TRANSFORM_ERROR,
@@ -520,15 +1901,58 @@ cd_transform_setup (CdTransform *transform, GError **error)
 					     "abstract colorspace has to be Lab");
 			goto out;
 		}
+	}
+
+	/* decode HDR input with the curves of the input profile */
+	if (priv->input_transfer != CD_TRANSFORM_TRANSFER_SDR) {
+		profile_hdr = cd_transform_create_hdr_profile (transform, error);
+		if (profile_hdr == NULL) {
+			ret = FALSE;
+			goto out;
+		}
+		profile_in = profile_hdr;
+	}
+
+	/* decode Y'CbCr in the same pipeline */
+	if (cd_transform_pixel_format_is_ycbcr (priv->input_pixel_format)) {
+		profile_ycbcr = cd_transform_create_ycbcr_link (transform);
+		if (profile_ycbcr == NULL) {
+			ret = FALSE;
+			g_set_error_literal (error,
+					     CD_TRANSFORM_ERROR,
+					     CD_TRANSFORM_ERROR_FAILED_TO_SETUP_TRANSFORM,
+					     "failed to create Y'CbCr device link");
+			goto out;
+		}
+	}
+
+	if (priv->abstract_iccs->len > 0 || profile_ycbcr != NULL ||
+	    priv->proof_icc != NULL) {
+		guint nr_profiles = 0;
+		g_autofree cmsHPROFILE *profiles = NULL;
 
 		/* generate a devicelink */
-		profiles[0] = profile_in;
-		profiles[1] = cd_icc_get_handle (priv->abstract_icc);
-		profiles[2] = profile_out;
+		profiles = g_new (cmsHPROFILE, priv->abstract_iccs->len + 3);
+		if (profile_ycbcr != NULL)
+			profiles[nr_profiles++] = profile_ycbcr;
+		profiles[nr_profiles++] = profile_in;
+		for (i = 0; i < priv->abstract_iccs->len; i++) {
+			CdIcc *icc = g_ptr_array_index (priv->abstract_iccs, i);
+			profiles[nr_profiles++] = cd_icc_get_handle (icc);
+		}
+		profiles[nr_profiles++] = profile_out;
+		if (priv->proof_icc != NULL) {
+			priv->lcms_transform = cd_transform_setup_proofing (transform,
+									    profiles,
+									    nr_profiles,
+									    lcms_intent,
+									    lcms_flags);
+			goto check;
+		}
 		priv->lcms_transform = cmsCreateMultiprofileTransformTHR (priv->context_lcms,
 									  profiles,
-									  3,
-									  priv->input_pixel_format,
+									  nr_profiles,
+									  cd_transform_get_lcms_input_format (transform),
 									  priv->output_pixel_format,
 									  lcms_intent,
 									  lcms_flags);
@@ -544,10 +1968,7 @@ cd_transform_setup (CdTransform *transform, GError **error)
 							      lcms_flags);
 	}
 
-	/* find the bpp value */
-	priv->bpp_input = cd_transform_get_bpp (priv->input_pixel_format);
-	priv->bpp_output = cd_transform_get_bpp (priv->input_pixel_format);
-
+check:
 	/* failed? */
 	if (priv->lcms_transform == NULL) {
 		ret = cd_context_lcms_error_check (priv->context_lcms, &error_local);
@@ -565,7 +1986,15 @@ cd_transform_setup (CdTransform *transform, GError **error)
 				     "failed to setup transform, unspecified error");
 		goto out;
 	}
+
+	/* save for next time */
+	if (cache_filename != NULL)
+		cd_transform_cache_save (transform, cache_filename);
 out:
+	if (profile_hdr != NULL)
+		cmsCloseProfile (profile_hdr);
+	if (profile_ycbcr != NULL)
+		cmsCloseProfile (profile_ycbcr);
 	return ret;
 }
 
@@ -575,8 +2004,60 @@ typedef struct {
 	guint	 width;
 	guint	 rowstride;
 	guint	 rows_to_process;
+	guint	 height;	/* Y'CbCr only */
+	guint	 row;		/* Y'CbCr only */
 } CdTransformJob;
 
+/*
+ * Planar data has the Y' plane of @rowstride * @height bytes, followed by
+ * the 2x2 subsampled chroma with a rowstride of half the luma rowstride,
+ * either as a U plane then a V plane, or as one interleaved UV plane.
+ */
+static void
+cd_transform_process_ycbcr (CdTransform *transform,
+			    const guint8 *data_in,
+			    guint8 *p_out,
+			    guint width,
+			    guint height,
+			    guint rowstride,
+			    guint row,
+			    guint rows_to_process)
+{
+	CdTransformPrivate *priv = GET_PRIVATE (transform);
+	const guint8 *plane_c;
+	const guint8 *p_u;
+	const guint8 *p_v;
+	const guint8 *p_y;
+	gsize chroma_height = (height + 1) / 2;
+	gsize chroma_stride = (rowstride + 1) / 2;
+	guint i, x;
+	g_autofree guint8 *tmp = g_new (guint8, width * 3);
+
+	plane_c = data_in + (gsize) rowstride * height;
+	for (i = row; i < row + rows_to_process; i++) {
+		p_y = data_in + (gsize) i * rowstride;
+		if (priv->input_pixel_format == CD_PIXEL_FORMAT_NV12) {
+			p_u = plane_c + (i / 2) * chroma_stride * 2;
+			for (x = 0; x < width; x++) {
+				tmp[x * 3 + 0] = p_y[x];
+				tmp[x * 3 + 1] = p_u[(x & ~1u) + 0];
+				tmp[x * 3 + 2] = p_u[(x & ~1u) + 1];
+			}
+		} else {
+			p_u = plane_c + (i / 2) * chroma_stride;
+			p_v = p_u + chroma_stride * chroma_height;
+			for (x = 0; x < width; x++) {
+				tmp[x * 3 + 0] = p_y[x];
+				tmp[x * 3 + 1] = p_u[x / 2];
+				tmp[x * 3 + 2] = p_v[x / 2];
+			}
+		}
+		cmsDoTransform (priv->lcms_transform, tmp, p_out, width);
+		cd_transform_apply_post_lut (transform, p_out, width);
+		p_out += rowstride * priv->bpp_output;
+	}
+}
+
 static void
 cd_transform_process_func (gpointer data, gpointer user_data)
 {
@@ -585,12 +2066,25 @@ cd_transform_process_func (gpointer data, gpointer user_data)
 	CdTransformPrivate *priv = GET_PRIVATE (transform);
 	guint i;
 
+	if (cd_transform_pixel_format_is_ycbcr (priv->input_pixel_format)) {
+		cd_transform_process_ycbcr (transform,
+					    job->p_in,
+					    job->p_out,
+					    job->width,
+					    job->height,
+					    job->rowstride,
+					    job->row,
+					    job->rows_to_process);
+		g_slice_free (CdTransformJob, job);
+		return;
+	}
 	for (i = 0; i < job->rows_to_process; i++) {
 		cmsDoTransformStride (priv->lcms_transform,
 				      job->p_in,
 				      job->p_out,
 				      job->width,
 				      job->rowstride);
+		cd_transform_apply_post_lut (transform, job->p_out, job->width);
 		job->p_in += job->rowstride;
 		job->p_out += job->rowstride;
 	}
@@ -640,6 +2134,11 @@ cd_transform_set_max_threads_default (CdTransform *transform, GError **error)
  * Once the transform has been setup it is cached and only re-created if any
  * of the formats, input, output or abstract profiles are changed.
  *
+ * If the input pixel format is %CD_PIXEL_FORMAT_I420 or %CD_PIXEL_FORMAT_NV12
+ * then @data_in is a whole frame, with the chroma planes following the luma
+ * plane and using half of @rowstride. In this case @data_out cannot be the
+ * same as @data_in.
+ *
  * Return value: %TRUE if the pixels were successfully transformed.
  *
  * Since: 0.1.34
@@ -689,6 +2188,30 @@ cd_transform_process (CdTransform *transform,
 		goto out;
 	}
 
+	/* the subsampled chroma is read after the output rows are written */
+	if (cd_transform_pixel_format_is_ycbcr (priv->input_pixel_format) &&
+	    data_in == data_out) {
+		ret = FALSE;
+		g_set_error_literal (error,
+				     CD_TRANSFORM_ERROR,
+				     CD_TRANSFORM_ERROR_FAILED_TO_SETUP_TRANSFORM,
+				     "subsampled input cannot be processed in place");
+		goto out;
+	}
+
+	/* parametric stages are only supported for 8 bit RGB */
+	if (priv->post_lut_enabled) {
+		guint offsets[3];
+		if (!cd_transform_get_rgb_offsets (priv->output_pixel_format, offsets)) {
+			ret = FALSE;
+			g_set_error_literal (error,
+					     CD_TRANSFORM_ERROR,
+					     CD_TRANSFORM_ERROR_INVALID_COLORSPACE,
+					     "temperature, gain and gamma need 8 bit RGB output");
+			goto out;
+		}
+	}
+
 	/* get the best number of threads */
 	if (priv->max_threads == 0) {
 		ret = cd_transform_set_max_threads_default (transform, error);
@@ -703,6 +2226,42 @@ cd_transform_process (CdTransform *transform,
 			goto out;
 	}
 
+	/* the chroma rows are shared between pairs of luma rows */
+	if (cd_transform_pixel_format_is_ycbcr (priv->input_pixel_format)) {
+		if (priv->max_threads == 1 || height < 2) {
+			cd_transform_process_ycbcr (transform, data_in, data_out,
+						    width, height, rowstride,
+						    0, height);
+			goto out;
+		}
+		pool = g_thread_pool_new (cd_transform_process_func,
+					  transform,
+					  priv->max_threads,
+					  TRUE,
+					  error);
+		if (pool == NULL)
+			goto out;
+		p_out = data_out;
+		rows_to_process = height / priv->max_threads;
+		if (rows_to_process == 0)
+			rows_to_process = 1;
+		for (i = 0; i < height; i += rows_to_process) {
+			job = g_slice_new0 (CdTransformJob);
+			job->p_in = data_in;
+			job->p_out = p_out;
+			job->width = width;
+			job->height = height;
+			job->rowstride = rowstride;
+			job->row = i;
+			job->rows_to_process = MIN (rows_to_process, height - i);
+			ret = g_thread_pool_push (pool, job, error);
+			if (!ret)
+				goto out;
+			p_out += rowstride * rows_to_process * priv->bpp_output;
+		}
+		goto out;
+	}
+
 	/* non-threaded conversion */
 	if (priv->max_threads == 1) {
 		p_in = data_in;
@@ -713,6 +2272,7 @@ cd_transform_process (CdTransform *transform,
 					      p_out,
 					      width,
 					      rowstride);
+			cd_transform_apply_post_lut (transform, p_out, width);
 			p_in += rowstride * priv->bpp_input;
 			p_out += rowstride * priv->bpp_output;
 		}
@@ -768,7 +2328,7 @@ cd_transform_get_property (GObject *object, guint prop_id, GValue *value, GParam
 		g_value_set_object (value, priv->output_icc);
 		break;
 	case PROP_ABSTRACT_ICC:
-		g_value_set_object (value, priv->abstract_icc);
+		g_value_set_object (value, cd_transform_get_abstract_icc (transform));
 		break;
 	case PROP_RENDERING_INTENT:
 		g_value_set_uint (value, priv->rendering_intent);
@@ -782,6 +2342,36 @@ cd_transform_get_property (GObject *object, guint prop_id, GValue *value, GParam
 	case PROP_OUTPUT_PIXEL_FORMAT:
 		g_value_set_uint (value, priv->output_pixel_format);
 		break;
+	case PROP_USE_CACHE:
+		g_value_set_boolean (value, priv->use_cache);
+		break;
+	case PROP_YCBCR_MATRIX:
+		g_value_set_uint (value, priv->ycbcr_matrix);
+		break;
+	case PROP_YCBCR_RANGE:
+		g_value_set_uint (value, priv->ycbcr_range);
+		break;
+	case PROP_TEMPERATURE:
+		g_value_set_uint (value, priv->temperature);
+		break;
+	case PROP_PROOF_ICC:
+		g_value_set_object (value, priv->proof_icc);
+		break;
+	case PROP_PROOF_RENDERING_INTENT:
+		g_value_set_uint (value, priv->proof_rendering_intent);
+		break;
+	case PROP_INPUT_TRANSFER:
+		g_value_set_uint (value, priv->input_transfer);
+		break;
+	case PROP_TONE_MAP:
+		g_value_set_uint (value, priv->tone_map);
+		break;
+	case PROP_SOURCE_PEAK:
+		g_value_set_double (value, priv->source_peak);
+		break;
+	case PROP_TARGET_PEAK:
+		g_value_set_double (value, priv->target_peak);
+		break;
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 		break;
@@ -814,6 +2404,36 @@ cd_transform_set_property (GObject *object, guint prop_id, const GValue *value,
 	case PROP_ABSTRACT_ICC:
 		cd_transform_set_abstract_icc (transform, g_value_get_object (value));
 		break;
+	case PROP_USE_CACHE:
+		cd_transform_set_use_cache (transform, g_value_get_boolean (value));
+		break;
+	case PROP_YCBCR_MATRIX:
+		cd_transform_set_ycbcr_matrix (transform, g_value_get_uint (value));
+		break;
+	case PROP_YCBCR_RANGE:
+		cd_transform_set_ycbcr_range (transform, g_value_get_uint (value));
+		break;
+	case PROP_TEMPERATURE:
+		cd_transform_set_temperature (transform, g_value_get_uint (value));
+		break;
+	case PROP_PROOF_ICC:
+		cd_transform_set_proof_icc (transform, g_value_get_object (value));
+		break;
+	case PROP_PROOF_RENDERING_INTENT:
+		cd_transform_set_proof_rendering_intent (transform, g_value_get_uint (value));
+		break;
+	case PROP_INPUT_TRANSFER:
+		cd_transform_set_input_transfer (transform, g_value_get_uint (value));
+		break;
+	case PROP_TONE_MAP:
+		cd_transform_set_tone_map (transform, g_value_get_uint (value));
+		break;
+	case PROP_SOURCE_PEAK:
+		cd_transform_set_source_peak (transform, g_value_get_double (value));
+		break;
+	case PROP_TARGET_PEAK:
+		cd_transform_set_target_peak (transform, g_value_get_double (value));
+		break;
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 		break;
@@ -885,6 +2505,91 @@ cd_transform_class_init (CdTransformClass *klass)
 				     CD_TYPE_ICC,
 				     G_PARAM_READWRITE);
 	g_object_class_install_property (object_class, PROP_ABSTRACT_ICC, pspec);
+
+	/**
+	 * CdTransform: use-cache:
+	 */
+	pspec = g_param_spec_boolean ("use-cache", NULL, NULL,
+				      TRUE,
+				      G_PARAM_READWRITE);
+	g_object_class_install_property (object_class, PROP_USE_CACHE, pspec);
+
+	/**
+	 * CdTransform: ycbcr-matrix:
+	 */
+	pspec = g_param_spec_uint ("ycbcr-matrix", NULL, NULL,
+				   0, CD_TRANSFORM_YCBCR_MATRIX_LAST - 1,
+				   CD_TRANSFORM_YCBCR_MATRIX_BT709,
+				   G_PARAM_READWRITE);
+	g_object_class_install_property (object_class, PROP_YCBCR_MATRIX, pspec);
+
+	/**
+	 * CdTransform: ycbcr-range:
+	 */
+	pspec = g_param_spec_uint ("ycbcr-range", NULL, NULL,
+				   0, CD_TRANSFORM_YCBCR_RANGE_LAST - 1,
+				   CD_TRANSFORM_YCBCR_RANGE_LIMITED,
+				   G_PARAM_READWRITE);
+	g_object_class_install_property (object_class, PROP_YCBCR_RANGE, pspec);
+
+	/**
+	 * CdTransform: temperature:
+	 */
+	pspec = g_param_spec_uint ("temperature", NULL, NULL,
+				   1000, 10000, 6500,
+				   G_PARAM_READWRITE);
+	g_object_class_install_property (object_class, PROP_TEMPERATURE, pspec);
+
+	/**
+	 * CdTransform: proof-icc:
+	 */
+	pspec = g_param_spec_object ("proof-icc", NULL, NULL,
+				     CD_TYPE_ICC,
+				     G_PARAM_READWRITE);
+	g_object_class_install_property (object_class, PROP_PROOF_ICC, pspec);
+
+	/**
+	 * CdTransform: proof-rendering-intent:
+	 */
+	pspec = g_param_spec_uint ("proof-rendering-intent", NULL, NULL,
+				   0, G_MAXUINT,
+				   CD_RENDERING_INTENT_RELATIVE_COLORIMETRIC,
+				   G_PARAM_READWRITE);
+	g_object_class_install_property (object_class, PROP_PROOF_RENDERING_INTENT, pspec);
+
+	/**
+	 * CdTransform: input-transfer:
+	 */
+	pspec = g_param_spec_uint ("input-transfer", NULL, NULL,
+				   0, CD_TRANSFORM_TRANSFER_LAST - 1,
+				   CD_TRANSFORM_TRANSFER_SDR,
+				   G_PARAM_READWRITE);
+	g_object_class_install_property (object_class, PROP_INPUT_TRANSFER, pspec);
+
+	/**
+	 * CdTransform: tone-map:
+	 */
+	pspec = g_param_spec_uint ("tone-map", NULL, NULL,
+				   0, CD_TRANSFORM_TONE_MAP_LAST - 1,
+				   CD_TRANSFORM_TONE_MAP_BT2390,
+				   G_PARAM_READWRITE);
+	g_object_class_install_property (object_class, PROP_TONE_MAP, pspec);
+
+	/**
+	 * CdTransform: source-peak:
+	 */
+	pspec = g_param_spec_double ("source-peak", NULL, NULL,
+				     G_MINDOUBLE, 10000.f, 1000.f,
+				     G_PARAM_READWRITE);
+	g_object_class_install_property (object_class, PROP_SOURCE_PEAK, pspec);
+
+	/**
+	 * CdTransform: target-peak:
+	 */
+	pspec = g_param_spec_double ("target-peak", NULL, NULL,
+				     G_MINDOUBLE, 10000.f, 100.f,
+				     G_PARAM_READWRITE);
+	g_object_class_install_property (object_class, PROP_TARGET_PEAK, pspec);
 }
 
 static void
@@ -897,6 +2602,18 @@ cd_transform_init (CdTransform *transform)
 	priv->output_pixel_format = CD_PIXEL_FORMAT_UNKNOWN;
 	priv->srgb = cmsCreate_sRGBProfileTHR (priv->context_lcms);
 	priv->max_threads = 1;
+	priv->use_cache = TRUE;
+	priv->abstract_iccs = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	priv->ycbcr_matrix = CD_TRANSFORM_YCBCR_MATRIX_BT709;
+	priv->ycbcr_range = CD_TRANSFORM_YCBCR_RANGE_LIMITED;
+	priv->input_transfer = CD_TRANSFORM_TRANSFER_SDR;
+	priv->tone_map = CD_TRANSFORM_TONE_MAP_BT2390;
+	priv->source_peak = 1000.f;
+	priv->target_peak = 100.f;
+	priv->temperature = 6500;
+	priv->proof_rendering_intent = CD_RENDERING_INTENT_RELATIVE_COLORIMETRIC;
+	cd_color_rgb_set (&priv->gain, 1.f, 1.f, 1.f);
+	cd_color_rgb_set (&priv->gamma, 1.f, 1.f, 1.f);
 }
 
 static void
@@ -910,8 +2627,9 @@ cd_transform_finalize (GObject *object)
 		g_object_unref (priv->input_icc);
 	if (priv->output_icc != NULL)
 		g_object_unref (priv->output_icc);
-	if (priv->abstract_icc != NULL)
-		g_object_unref (priv->abstract_icc);
+	g_ptr_array_unref (priv->abstract_iccs);
+	if (priv->proof_icc != NULL)
+		g_object_unref (priv->proof_icc);
 	if (priv->lcms_transform != NULL)
 		cmsDeleteTransform (priv->lcms_transform);
 	cd_context_lcms_free (priv->context_lcms);
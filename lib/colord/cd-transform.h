@@ -29,6 +29,7 @@
 #include <glib-object.h>
 #include <gio/gio.h>
 
+#include "cd-color.h"
 #include "cd-enum.h"
 #include "cd-icc.h"
 
@@ -55,6 +56,74 @@ typedef enum {
 	CD_TRANSFORM_ERROR_LAST
 } CdTransformError;
 
+/**
+ * CdTransformYcbcrMatrix:
+ * @CD_TRANSFORM_YCBCR_MATRIX_BT601:	ITU-R BT.601, used for SD video
+ * @CD_TRANSFORM_YCBCR_MATRIX_BT709:	ITU-R BT.709, used for HD video
+ * @CD_TRANSFORM_YCBCR_MATRIX_BT2020:	ITU-R BT.2020 non-constant luminance
+ *
+ * The matrix used to encode R'G'B' as Y'CbCr.
+ *
+ * Since: 1.4.8
+ **/
+typedef enum {
+	CD_TRANSFORM_YCBCR_MATRIX_BT601,
+	CD_TRANSFORM_YCBCR_MATRIX_BT709,
+	CD_TRANSFORM_YCBCR_MATRIX_BT2020,
+	/*< private >*/
+	CD_TRANSFORM_YCBCR_MATRIX_LAST
+} CdTransformYcbcrMatrix;
+
+/**
+ * CdTransformYcbcrRange:
+ * @CD_TRANSFORM_YCBCR_RANGE_LIMITED:	Y' is 16-235 and CbCr is 16-240
+ * @CD_TRANSFORM_YCBCR_RANGE_FULL:	All components use 0-255
+ *
+ * The quantization range of Y'CbCr data.
+ *
+ * Since: 1.4.8
+ **/
+typedef enum {
+	CD_TRANSFORM_YCBCR_RANGE_LIMITED,
+	CD_TRANSFORM_YCBCR_RANGE_FULL,
+	/*< private >*/
+	CD_TRANSFORM_YCBCR_RANGE_LAST
+} CdTransformYcbcrRange;
+
+/**
+ * CdTransformTransfer:
+ * @CD_TRANSFORM_TRANSFER_SDR:	Encoded using the curves of the input profile
+ * @CD_TRANSFORM_TRANSFER_PQ:	SMPTE ST 2084 perceptual quantizer, used for HDR10
+ * @CD_TRANSFORM_TRANSFER_HLG:	ITU-R BT.2100 hybrid log-gamma
+ *
+ * The transfer function used to encode the input.
+ *
+ * Since: 1.4.8
+ **/
+typedef enum {
+	CD_TRANSFORM_TRANSFER_SDR,
+	CD_TRANSFORM_TRANSFER_PQ,
+	CD_TRANSFORM_TRANSFER_HLG,
+	/*< private >*/
+	CD_TRANSFORM_TRANSFER_LAST
+} CdTransformTransfer;
+
+/**
+ * CdTransformToneMap:
+ * @CD_TRANSFORM_TONE_MAP_NONE:		Luminance above the target peak is clipped
+ * @CD_TRANSFORM_TONE_MAP_BT2390:	The ITU-R BT.2390 EETF
+ *
+ * The operator used to map HDR input onto the target peak luminance.
+ *
+ * Since: 1.4.8
+ **/
+typedef enum {
+	CD_TRANSFORM_TONE_MAP_NONE,
+	CD_TRANSFORM_TONE_MAP_BT2390,
+	/*< private >*/
+	CD_TRANSFORM_TONE_MAP_LAST
+} CdTransformToneMap;
+
 struct _CdTransformClass
 {
 	GObjectClass		 parent_class;
@@ -90,12 +159,54 @@ CdPixelFormat	 cd_transform_get_output_pixel_format	(CdTransform	*transform);
 void		 cd_transform_set_abstract_icc		(CdTransform	*transform,
 							 CdIcc		*icc);
 CdIcc		*cd_transform_get_abstract_icc		(CdTransform	*transform);
+void		 cd_transform_set_abstract_iccs		(CdTransform	*transform,
+							 GPtrArray	*iccs);
+GPtrArray	*cd_transform_get_abstract_iccs		(CdTransform	*transform);
+void		 cd_transform_set_proof_icc		(CdTransform	*transform,
+							 CdIcc		*icc);
+CdIcc		*cd_transform_get_proof_icc		(CdTransform	*transform);
+void		 cd_transform_set_proof_rendering_intent (CdTransform	*transform,
+							 CdRenderingIntent rendering_intent);
+CdRenderingIntent cd_transform_get_proof_rendering_intent (CdTransform	*transform);
+void		 cd_transform_set_gamut_alarm		(CdTransform	*transform,
+							 const CdColorRGB *color);
+const CdColorRGB *cd_transform_get_gamut_alarm		(CdTransform	*transform);
 void		 cd_transform_set_rendering_intent	(CdTransform	*transform,
 							 CdRenderingIntent rendering_intent);
 CdRenderingIntent cd_transform_get_rendering_intent	(CdTransform	*transform);
 void		 cd_transform_set_bpc			(CdTransform	*transform,
 							 gboolean	 bpc);
 gboolean	 cd_transform_get_bpc			(CdTransform	*transform);
+void		 cd_transform_set_use_cache		(CdTransform	*transform,
+							 gboolean	 use_cache);
+gboolean	 cd_transform_get_use_cache		(CdTransform	*transform);
+void		 cd_transform_set_ycbcr_matrix		(CdTransform	*transform,
+							 CdTransformYcbcrMatrix ycbcr_matrix);
+CdTransformYcbcrMatrix cd_transform_get_ycbcr_matrix	(CdTransform	*transform);
+void		 cd_transform_set_ycbcr_range		(CdTransform	*transform,
+							 CdTransformYcbcrRange ycbcr_range);
+CdTransformYcbcrRange cd_transform_get_ycbcr_range	(CdTransform	*transform);
+void		 cd_transform_set_input_transfer	(CdTransform	*transform,
+							 CdTransformTransfer input_transfer);
+CdTransformTransfer cd_transform_get_input_transfer	(CdTransform	*transform);
+void		 cd_transform_set_tone_map		(CdTransform	*transform,
+							 CdTransformToneMap tone_map);
+CdTransformToneMap cd_transform_get_tone_map		(CdTransform	*transform);
+void		 cd_transform_set_source_peak		(CdTransform	*transform,
+							 gdouble	 source_peak);
+gdouble		 cd_transform_get_source_peak		(CdTransform	*transform);
+void		 cd_transform_set_target_peak		(CdTransform	*transform,
+							 gdouble	 target_peak);
+gdouble		 cd_transform_get_target_peak		(CdTransform	*transform);
+void		 cd_transform_set_temperature		(CdTransform	*transform,
+							 guint		 temperature);
+guint		 cd_transform_get_temperature		(CdTransform	*transform);
+void		 cd_transform_set_gain			(CdTransform	*transform,
+							 const CdColorRGB *gain);
+const CdColorRGB *cd_transform_get_gain			(CdTransform	*transform);
+void		 cd_transform_set_gamma			(CdTransform	*transform,
+							 const CdColorRGB *gamma);
+const CdColorRGB *cd_transform_get_gamma		(CdTransform	*transform);
 void		 cd_transform_set_max_threads		(CdTransform	*transform,
 							 guint		 max_threads);
 guint		 cd_transform_get_max_threads		(CdTransform	*transform);
@@ -475,3 +475,78 @@ ch_device_mode_from_firmware (const guint8 *data, gsize data_len)
 	}
 	return CH_DEVICE_MODE_UNKNOWN;
 }
+
+/**
+ * ch_firmware_diff:
+ * @flash: (array length=len): the current flash contents
+ * @data: (array length=len): the new firmware image
+ * @len: size of @flash and @data
+ *
+ * Finds the erase blocks that have to be rewritten to change @flash into
+ * @data. The last block may be shorter than %CH_FLASH_ERASE_BLOCK_SIZE.
+ *
+ * Return value: (transfer full) (element-type guint): offsets of the blocks that differ
+ *
+ * Since: 1.4.8
+ **/
+GArray *
+ch_firmware_diff (const guint8 *flash, const guint8 *data, gsize len)
+{
+	GArray *blocks;
+	gsize block_len;
+	guint idx;
+
+	g_return_val_if_fail (flash != NULL, NULL);
+	g_return_val_if_fail (data != NULL, NULL);
+
+	blocks = g_array_new (FALSE, FALSE, sizeof (guint));
+	for (idx = 0; idx < len; idx += CH_FLASH_ERASE_BLOCK_SIZE) {
+		block_len = MIN (len - idx, CH_FLASH_ERASE_BLOCK_SIZE);
+		if (memcmp (flash + idx, data + idx, block_len) != 0)
+			g_array_append_val (blocks, idx);
+	}
+	return blocks;
+}
+
+/**
+ * ch_firmware_patch:
+ * @flash: (array length=len): the flash contents to update
+ * @data: (array length=len): the new firmware image
+ * @len: size of @flash and @data
+ * @blocks: (element-type guint): block offsets from ch_firmware_diff()
+ *
+ * Applies the blocks found by ch_firmware_diff() in the same way as the
+ * device does: each block is erased to 0xff and then written in chunks of
+ * %CH_FLASH_TRANSFER_BLOCK_SIZE, where writing can only clear bits.
+ *
+ * Return value: the number of erase and write commands used
+ *
+ * Since: 1.4.8
+ **/
+guint
+ch_firmware_patch (guint8 *flash, const guint8 *data, gsize len, GArray *blocks)
+{
+	gsize block_len;
+	guint commands = 0;
+	guint i;
+	guint idx;
+	guint j;
+
+	g_return_val_if_fail (flash != NULL, 0);
+	g_return_val_if_fail (data != NULL, 0);
+	g_return_val_if_fail (blocks != NULL, 0);
+
+	for (i = 0; i < blocks->len; i++) {
+		idx = g_array_index (blocks, guint, i);
+		g_return_val_if_fail (idx < len, commands);
+		block_len = MIN (len - idx, CH_FLASH_ERASE_BLOCK_SIZE);
+		memset (flash + idx, 0xff, block_len);
+		commands++;
+		for (j = 0; j < block_len; j++) {
+			if (j % CH_FLASH_TRANSFER_BLOCK_SIZE == 0)
+				commands++;
+			flash[idx + j] &= data[idx + j];
+		}
+	}
+	return commands;
+}
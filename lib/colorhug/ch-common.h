@@ -1519,6 +1519,13 @@ G_BEGIN_DECLS
 #define CH_INTEGRAL_TIME_VALUE_100MS		0x3a00
 #define CH_INTEGRAL_TIME_VALUE_200MS		0x7500
 #define CH_INTEGRAL_TIME_VALUE_MAX		0xffff
+#define CH_INTEGRAL_TIME_VALUE_PER_MS		149.76f
+#define CH_INTEGRAL_TIME_AUTO_DIVISOR		16	/* of the max for the pre-read */
+
+/* flicker detection */
+#define CH_FLICKER_SAMPLES_MAX			256
+#define CH_FLICKER_MODULATION_MIN		0.01f	/* of the mean */
+#define CH_FLICKER_CORRELATION_MIN		0.5f
 
 /* flash constants */
 #define	CH_FLASH_ERASE_BLOCK_SIZE		0x400	/* 1024 */
@@ -1657,6 +1664,13 @@ const gchar	*ch_measure_mode_to_string	(ChMeasureMode	 measure_mode);
 const gchar	*ch_device_mode_to_string	(ChDeviceMode	 device_mode);
 ChDeviceMode	 ch_device_mode_from_firmware	(const guint8	*data,
 						 gsize		 data_len);
+GArray		*ch_firmware_diff		(const guint8	*flash,
+						 const guint8	*data,
+						 gsize		 len);
+guint		 ch_firmware_patch		(guint8		*flash,
+						 const guint8	*data,
+						 gsize		 len,
+						 GArray		*blocks);
 
 G_END_DECLS
 
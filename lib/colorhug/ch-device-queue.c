@@ -30,6 +30,7 @@
 #include "ch-common.h"
 #include "ch-device.h"
 #include "ch-device-queue.h"
+#include "ch-hash.h"
 #include "ch-math.h"
 
 static void	ch_device_queue_finalize	(GObject     *object);
@@ -93,6 +94,21 @@ typedef struct {
 static guint signals[SIGNAL_LAST] = { 0 };
 
 static gboolean ch_device_queue_process_data (GTask *task, ChDeviceQueueData *data);
+static guint8 ch_device_queue_calculate_checksum (const guint8 *data, gsize len);
+static ChDeviceQueueData *ch_device_queue_write_flash_internal (ChDeviceQueue *device_queue,
+								GUsbDevice *device,
+								guint16 address,
+								const guint8 *data,
+								gsize len);
+static ChDeviceQueueData *ch_device_queue_verify_flash_internal (ChDeviceQueue *device_queue,
+								 GUsbDevice *device,
+								 guint16 address,
+								 const guint8 *data,
+								 gsize len);
+static ChDeviceQueueData *ch_device_queue_erase_flash_internal (ChDeviceQueue *device_queue,
+								GUsbDevice *device,
+								guint16 address,
+								gsize len);
 
 static void
 ch_device_queue_data_free (ChDeviceQueueData *data)
@@ -466,7 +482,7 @@ ch_device_queue_process (ChDeviceQueue	*device_queue,
 
 /**********************************************************************/
 
-static void
+static ChDeviceQueueData *
 ch_device_queue_add_internal (ChDeviceQueue		*device_queue,
 			      GUsbDevice		*device,
 			      guint8			 cmd,
@@ -482,8 +498,8 @@ ch_device_queue_add_internal (ChDeviceQueue		*device_queue,
 	ChDeviceQueueData *data;
 	ChDeviceQueuePrivate *priv = GET_PRIVATE (device_queue);
 
-	g_return_if_fail (CH_IS_DEVICE_QUEUE (device_queue));
-	g_return_if_fail (G_USB_IS_DEVICE (device));
+	g_return_val_if_fail (CH_IS_DEVICE_QUEUE (device_queue), NULL);
+	g_return_val_if_fail (G_USB_IS_DEVICE (device), NULL);
 
 	data = g_new0 (ChDeviceQueueData, 1);
 	data->state = CH_DEVICE_QUEUE_DATA_STATE_PENDING;
@@ -499,6 +515,7 @@ ch_device_queue_add_internal (ChDeviceQueue		*device_queue,
 	data->buffer_out_len = buffer_out_len;
 	data->buffer_out_destroy_func = buffer_out_destroy_func;
 	g_ptr_array_add (priv->data_array, data);
+	return data;
 }
 
 /**
@@ -1250,6 +1267,246 @@ ch_device_queue_verify_firmware (ChDeviceQueue	*device_queue,
 	} while (idx < len);
 }
 
+/* one erase block of the runcode, shared by all the commands that touch it */
+typedef struct {
+	guint16		 address;
+	gsize		 len;
+	guint8		*image;		/* the new image */
+	guint8		*data;		/* as read back from the device */
+	guint		 reads_pending;
+	GPtrArray	*writes;	/* of ChDeviceQueueData, not owned */
+} ChDeviceQueueFlashBlock;
+
+/* tiny helper */
+typedef struct {
+	ChDeviceQueueFlashBlock	*block;
+	guint16			 offset;
+	gsize			 len;
+} ChDeviceQueueFlashChunkHelper;
+
+static void
+ch_device_queue_flash_block_clear (ChDeviceQueueFlashBlock *block)
+{
+	g_free (block->image);
+	g_free (block->data);
+	g_ptr_array_unref (block->writes);
+}
+
+static void
+ch_device_queue_flash_chunk_helper_destroy (gpointer data)
+{
+	ChDeviceQueueFlashChunkHelper *helper = (ChDeviceQueueFlashChunkHelper *) data;
+	g_rc_box_release_full (helper->block,
+			       (GDestroyNotify) ch_device_queue_flash_block_clear);
+	g_free (helper);
+}
+
+static gboolean
+ch_device_queue_buffer_flash_block_cb (guint8 *output_buffer,
+				       gsize output_buffer_size,
+				       gpointer user_data,
+				       GError **error)
+{
+	ChDeviceQueueFlashChunkHelper *helper = (ChDeviceQueueFlashChunkHelper *) user_data;
+	ChDeviceQueueFlashBlock *block = helper->block;
+	ChDeviceQueueData *data;
+	guint i;
+	g_autoptr(GArray) changed = NULL;
+
+	/* check buffer size */
+	if (output_buffer_size != helper->len + 1) {
+		g_set_error (error, 1, 0,
+			     "Wrong output buffer size, expected %" G_GSIZE_FORMAT ", got %" G_GSIZE_FORMAT,
+			     helper->len + 1, output_buffer_size);
+		return FALSE;
+	}
+
+	/* verify checksum */
+	if (output_buffer[0] != ch_device_queue_calculate_checksum (output_buffer + 1,
+								    helper->len)) {
+		g_set_error (error, 1, 0,
+			     "Checksum @0x%04x invalid",
+			     (guint) (block->address + helper->offset));
+		return FALSE;
+	}
+	memcpy (block->data + helper->offset, output_buffer + 1, helper->len);
+
+	/* wait for the rest of the block */
+	if (--block->reads_pending > 0)
+		return TRUE;
+
+	/* the erase, writes and verifies are not required at all */
+	changed = ch_firmware_diff (block->data, block->image, block->len);
+	if (changed->len > 0) {
+		g_debug ("Block @0x%04x differs, rewriting", block->address);
+		return TRUE;
+	}
+	g_debug ("Block @0x%04x unchanged, skipping %u commands",
+		 block->address, block->writes->len);
+	for (i = 0; i < block->writes->len; i++) {
+		data = g_ptr_array_index (block->writes, i);
+		data->state = CH_DEVICE_QUEUE_DATA_STATE_COMPLETE;
+	}
+	return TRUE;
+}
+
+static ChDeviceQueueFlashBlock *
+ch_device_queue_flash_block_read (ChDeviceQueue *device_queue,
+				  GUsbDevice *device,
+				  guint16 address,
+				  const guint8 *data,
+				  gsize len)
+{
+	ChDeviceQueueFlashBlock *block;
+	ChDeviceQueueFlashChunkHelper *helper;
+	gsize chunk_len = 60;
+	guint16 addr_le;
+	guint8 buffer_tx[3];
+	guint idx;
+
+	block = g_rc_box_new0 (ChDeviceQueueFlashBlock);
+	block->address = address;
+	block->len = len;
+	block->data = g_new0 (guint8, len);
+	block->writes = g_ptr_array_new ();
+	block->image = g_memdup (data, len);
+
+	/* read in 60 byte chunks, each command holding a ref on the block */
+	for (idx = 0; idx < len; idx += chunk_len) {
+		if (idx + chunk_len > len)
+			chunk_len = len - idx;
+		addr_le = GUINT16_TO_LE (address + idx);
+		memcpy (buffer_tx + 0, &addr_le, 2);
+		buffer_tx[2] = chunk_len;
+		helper = g_new0 (ChDeviceQueueFlashChunkHelper, 1);
+		helper->block = g_rc_box_acquire (block);
+		helper->offset = idx;
+		helper->len = chunk_len;
+		block->reads_pending++;
+		ch_device_queue_add_internal (device_queue,
+					      device,
+					      CH_CMD_READ_FLASH,
+					      buffer_tx,
+					      sizeof(buffer_tx),
+					      g_new0 (guint8, chunk_len + 1),
+					      chunk_len + 1,
+					      g_free,
+					      ch_device_queue_buffer_flash_block_cb,
+					      helper,
+					      ch_device_queue_flash_chunk_helper_destroy);
+	}
+	return block;
+}
+
+static void
+ch_device_queue_flash_block_write (ChDeviceQueue *device_queue,
+				   GUsbDevice *device,
+				   ChDeviceQueueFlashBlock *block,
+				   const guint8 *data)
+{
+	ChDeviceQueueData *cmd;
+	gsize chunk_len;
+	guint idx;
+
+	/* erase the whole block, as flash cannot be erased in smaller pieces */
+	cmd = ch_device_queue_erase_flash_internal (device_queue, device,
+						    block->address,
+						    block->len);
+	g_ptr_array_add (block->writes, cmd);
+
+	/* write in 32 byte chunks */
+	chunk_len = CH_FLASH_TRANSFER_BLOCK_SIZE;
+	for (idx = 0; idx < block->len; idx += chunk_len) {
+		if (idx + chunk_len > block->len)
+			chunk_len = block->len - idx;
+		cmd = ch_device_queue_write_flash_internal (device_queue, device,
+							    block->address + idx,
+							    data + idx,
+							    chunk_len);
+		g_ptr_array_add (block->writes, cmd);
+	}
+
+	/* verify only what we wrote */
+	chunk_len = 60;
+	for (idx = 0; idx < block->len; idx += chunk_len) {
+		if (idx + chunk_len > block->len)
+			chunk_len = block->len - idx;
+		cmd = ch_device_queue_verify_flash_internal (device_queue, device,
+							     block->address + idx,
+							     data + idx,
+							     chunk_len);
+		g_ptr_array_add (block->writes, cmd);
+	}
+}
+
+/**
+ * ch_device_queue_write_firmware_differential:
+ * @device_queue:		A #ChDeviceQueue
+ * @device:			A #GUsbDevice
+ * @data: (array length=len):	Firmware binary data
+ * @len:			Size of @data
+ *
+ * Writes new firmware to the device, only erasing and writing the flash
+ * blocks that are different to the new image.
+ *
+ * Each erase block is read back and hashed before it is written, and the
+ * read of the next block is queued before the writes of the current one
+ * so the decision is never waited on. Only the blocks that were written
+ * are verified, so there is no need to also call
+ * ch_device_queue_verify_firmware().
+ *
+ * NOTE: This command is available on hardware version: 1 & 2
+ *
+ * Since: 1.4.8
+ **/
+void
+ch_device_queue_write_firmware_differential (ChDeviceQueue	*device_queue,
+					     GUsbDevice		*device,
+					     const guint8	*data,
+					     gsize		 len)
+{
+	ChDeviceQueueFlashBlock *block;
+	ChDeviceQueueFlashBlock *block_next = NULL;
+	gsize block_len;
+	guint idx;
+	guint16 runcode_addr;
+
+	g_return_if_fail (CH_IS_DEVICE_QUEUE (device_queue));
+	g_return_if_fail (G_USB_IS_DEVICE (device));
+	g_return_if_fail (data != NULL);
+	g_return_if_fail (len > 0);
+
+	/* read the first block */
+	runcode_addr = ch_device_get_runcode_address (device);
+	block_len = MIN (len, CH_FLASH_ERASE_BLOCK_SIZE);
+	block = ch_device_queue_flash_block_read (device_queue, device,
+						  runcode_addr,
+						  data, block_len);
+	for (idx = 0; idx < len; idx += CH_FLASH_ERASE_BLOCK_SIZE) {
+
+		/* prefetch the next block */
+		if (idx + CH_FLASH_ERASE_BLOCK_SIZE < len) {
+			block_len = MIN (len - idx - CH_FLASH_ERASE_BLOCK_SIZE,
+					 CH_FLASH_ERASE_BLOCK_SIZE);
+			block_next = ch_device_queue_flash_block_read (device_queue,
+								       device,
+								       runcode_addr + idx + CH_FLASH_ERASE_BLOCK_SIZE,
+								       data + idx + CH_FLASH_ERASE_BLOCK_SIZE,
+								       block_len);
+		}
+
+		/* these are cancelled if the read back matches */
+		g_debug ("Updating block at %04x size %" G_GSIZE_FORMAT,
+			 block->address, block->len);
+		ch_device_queue_flash_block_write (device_queue, device,
+						   block, data + idx);
+		g_rc_box_release_full (block,
+				       (GDestroyNotify) ch_device_queue_flash_block_clear);
+		block = block_next;
+		block_next = NULL;
+	}
+}
+
 /**
  * ch_device_queue_read_firmware:
  * @device_queue:		A #ChDeviceQueue
@@ -2348,6 +2605,195 @@ ch_device_queue_take_readings_xyz (ChDeviceQueue *device_queue,
 				     NULL);
 }
 
+/* shared by the commands of one auto-ranged reading */
+typedef struct {
+	CdColorXYZ		*value;
+	gdouble			 target;
+	gdouble			 flicker_period;
+	guint16			 integral_time_max;
+	guint16			 integral_time_pre;
+	guint16			 integral_time;		/* of the final reading */
+	ChDeviceQueueData	*set_integral_time;	/* not owned */
+	ChDeviceQueueData	*take_reading;		/* not owned */
+} ChDeviceQueueAutoHelper;
+
+static void
+ch_device_queue_auto_helper_unref (gpointer data)
+{
+	g_rc_box_release (data);
+}
+
+static void
+ch_device_queue_auto_scale (CdColorXYZ *value, guint16 integral_time)
+{
+	/* the readings are proportional to the integral time */
+	cd_color_xyz_set (value,
+			  value->X * CH_INTEGRAL_TIME_VALUE_MAX / integral_time,
+			  value->Y * CH_INTEGRAL_TIME_VALUE_MAX / integral_time,
+			  value->Z * CH_INTEGRAL_TIME_VALUE_MAX / integral_time);
+}
+
+static gboolean
+ch_device_queue_buffer_xyz_auto_pre_cb (guint8 *output_buffer,
+					gsize output_buffer_size,
+					gpointer user_data,
+					GError **error)
+{
+	ChDeviceQueueAutoHelper *helper = (ChDeviceQueueAutoHelper *) user_data;
+	CdColorXYZ pre;
+	gdouble ms;
+	guint16 integral_le;
+
+	if (!ch_device_queue_buffer_triple_xyz_cb (output_buffer,
+						   output_buffer_size,
+						   &pre, error))
+		return FALSE;
+
+	/* bright enough already, so the final reading is not required */
+	if (pre.Y >= helper->target) {
+		ch_device_queue_auto_scale (&pre, helper->integral_time_pre);
+		cd_color_xyz_copy (&pre, helper->value);
+		helper->set_integral_time->state = CH_DEVICE_QUEUE_DATA_STATE_COMPLETE;
+		helper->take_reading->state = CH_DEVICE_QUEUE_DATA_STATE_COMPLETE;
+		return TRUE;
+	}
+
+	/* integrate for long enough to reach the target */
+	ms = ch_integral_time_to_ms (helper->integral_time_max);
+	if (pre.Y > 0.f) {
+		ms = MIN (ch_integral_time_to_ms (helper->integral_time_pre) *
+			  helper->target / pre.Y, ms);
+	}
+	helper->integral_time = ch_flicker_get_integral_time (helper->flicker_period, ms);
+	helper->integral_time = MIN (helper->integral_time, helper->integral_time_max);
+	g_debug ("pre-read Y=%.3f so using integral time %.1fms",
+		 pre.Y, ch_integral_time_to_ms (helper->integral_time));
+	integral_le = GUINT16_TO_LE (helper->integral_time);
+	memcpy (helper->set_integral_time->buffer_in, &integral_le, sizeof (integral_le));
+	return TRUE;
+}
+
+static gboolean
+ch_device_queue_buffer_xyz_auto_cb (guint8 *output_buffer,
+				    gsize output_buffer_size,
+				    gpointer user_data,
+				    GError **error)
+{
+	ChDeviceQueueAutoHelper *helper = (ChDeviceQueueAutoHelper *) user_data;
+	if (!ch_device_queue_buffer_triple_xyz_cb (output_buffer,
+						   output_buffer_size,
+						   helper->value, error))
+		return FALSE;
+	ch_device_queue_auto_scale (helper->value, helper->integral_time);
+	return TRUE;
+}
+
+/**
+ * ch_device_queue_take_readings_xyz_auto:
+ * @device_queue:	A #ChDeviceQueue
+ * @device:		A #GUsbDevice
+ * @calibration_index:	The calibration slot, as for ch_device_queue_take_readings_xyz()
+ * @integral_time:	The longest integral time to use, e.g. %CH_INTEGRAL_TIME_VALUE_MAX
+ * @flicker_period:	The flicker period in ms, or 0 for a steady light
+ * @target:		The smallest Y reading that is precise enough
+ * @value:		The #CdColorXYZ for a given calibration slot
+ *
+ * Take an XYZ fully cooked reading from the sensor, choosing the
+ * integral time from a short pre-read.
+ *
+ * Bright samples only need the pre-read, and dim samples are integrated
+ * for just long enough that the reading reaches @target, up to
+ * @integral_time. As the hardware readings are proportional to the
+ * integral time, @value is scaled to what %CH_INTEGRAL_TIME_VALUE_MAX
+ * would have measured. The integral time is set back to @integral_time
+ * afterwards.
+ *
+ * NOTE: This command is available on hardware version: 1
+ *
+ * Since: 1.4.8
+ **/
+void
+ch_device_queue_take_readings_xyz_auto (ChDeviceQueue *device_queue,
+					GUsbDevice *device,
+					guint16 calibration_index,
+					guint16 integral_time,
+					gdouble flicker_period,
+					gdouble target,
+					CdColorXYZ *value)
+{
+	ChDeviceQueueAutoHelper *helper;
+	guint16 integral_le;
+
+	g_return_if_fail (CH_IS_DEVICE_QUEUE (device_queue));
+	g_return_if_fail (G_USB_IS_DEVICE (device));
+	g_return_if_fail (integral_time > 0);
+	g_return_if_fail (target > 0.f);
+	g_return_if_fail (value != NULL);
+
+	helper = g_rc_box_new0 (ChDeviceQueueAutoHelper);
+	helper->value = value;
+	helper->target = target;
+	helper->flicker_period = flicker_period;
+	helper->integral_time_max = integral_time;
+	helper->integral_time = integral_time;
+	helper->integral_time_pre =
+		ch_flicker_get_integral_time (flicker_period,
+					      ch_integral_time_to_ms (integral_time) /
+					      CH_INTEGRAL_TIME_AUTO_DIVISOR);
+	helper->integral_time_pre = MIN (helper->integral_time_pre, integral_time);
+
+	/* the pre-read decides what happens next */
+	integral_le = GUINT16_TO_LE (helper->integral_time_pre);
+	ch_device_queue_add (device_queue,
+			     device,
+			     CH_CMD_SET_INTEGRAL_TIME,
+			     (const guint8 *) &integral_le,
+			     sizeof(guint16),
+			     NULL,
+			     0);
+	ch_device_queue_add_internal (device_queue,
+				      device,
+				      CH_CMD_TAKE_READING_XYZ,
+				      (guint8 *) &calibration_index,
+				      sizeof(guint16),
+				      g_new0 (guint8, sizeof(ChPackedFloat) * 3),
+				      sizeof(ChPackedFloat) * 3,
+				      g_free,
+				      ch_device_queue_buffer_xyz_auto_pre_cb,
+				      g_rc_box_acquire (helper),
+				      ch_device_queue_auto_helper_unref);
+
+	/* these are changed or skipped by the pre-read */
+	integral_le = GUINT16_TO_LE (integral_time);
+	helper->set_integral_time =
+		ch_device_queue_add_internal (device_queue,
+					      device,
+					      CH_CMD_SET_INTEGRAL_TIME,
+					      (const guint8 *) &integral_le,
+					      sizeof(guint16),
+					      NULL,
+					      0,
+					      NULL,
+					      NULL,
+					      NULL,
+					      NULL);
+	helper->take_reading =
+		ch_device_queue_add_internal (device_queue,
+					      device,
+					      CH_CMD_TAKE_READING_XYZ,
+					      (guint8 *) &calibration_index,
+					      sizeof(guint16),
+					      g_new0 (guint8, sizeof(ChPackedFloat) * 3),
+					      sizeof(ChPackedFloat) * 3,
+					      g_free,
+					      ch_device_queue_buffer_xyz_auto_cb,
+					      helper,
+					      ch_device_queue_auto_helper_unref);
+
+	/* put things back how they were */
+	ch_device_queue_set_integral_time (device_queue, device, integral_time);
+}
+
 /**
  * ch_device_queue_reset:
  * @device_queue:	A #ChDeviceQueue
@@ -2386,6 +2832,36 @@ ch_device_queue_calculate_checksum (const guint8 *data,
 	return checksum;
 }
 
+static ChDeviceQueueData *
+ch_device_queue_write_flash_internal (ChDeviceQueue *device_queue,
+				      GUsbDevice *device,
+				      guint16 address,
+				      const guint8 *data,
+				      gsize len)
+{
+	guint16 addr_le;
+	guint8 buffer_tx[64];
+
+	/* set address, length, checksum, data */
+	addr_le = GUINT16_TO_LE (address);
+	memcpy (buffer_tx + 0, &addr_le, 2);
+	buffer_tx[2] = len;
+	buffer_tx[3] = ch_device_queue_calculate_checksum (data, len);
+	memcpy (buffer_tx + 4, data, len);
+
+	return ch_device_queue_add_internal (device_queue,
+					     device,
+					     CH_CMD_WRITE_FLASH,
+					     buffer_tx,
+					     len + 4,
+					     NULL,
+					     0,
+					     NULL,
+					     NULL,
+					     NULL,
+					     NULL);
+}
+
 /**
  * ch_device_queue_write_flash:
  * @device_queue:		A #ChDeviceQueue
@@ -2407,23 +2883,8 @@ ch_device_queue_write_flash (ChDeviceQueue *device_queue,
 			     const guint8 *data,
 			     gsize len)
 {
-	guint16 addr_le;
-	guint8 buffer_tx[64];
-
-	/* set address, length, checksum, data */
-	addr_le = GUINT16_TO_LE (address);
-	memcpy (buffer_tx + 0, &addr_le, 2);
-	buffer_tx[2] = len;
-	buffer_tx[3] = ch_device_queue_calculate_checksum (data, len);
-	memcpy (buffer_tx + 4, data, len);
-
-	ch_device_queue_add (device_queue,
-			     device,
-			     CH_CMD_WRITE_FLASH,
-			     buffer_tx,
-			     len + 4,
-			     NULL,
-			     0);
+	ch_device_queue_write_flash_internal (device_queue, device,
+					      address, data, len);
 }
 
 /* tiny helper */
@@ -2567,6 +3028,44 @@ ch_device_queue_verify_flash_helper_destroy (gpointer data)
 	g_free (helper);
 }
 
+static ChDeviceQueueData *
+ch_device_queue_verify_flash_internal (ChDeviceQueue *device_queue,
+				       GUsbDevice *device,
+				       guint16 address,
+				       const guint8 *data,
+				       gsize len)
+{
+	ChDeviceQueueReadFlashHelper *helper;
+	guint16 addr_le;
+	guint8 *buffer;
+	guint8 buffer_tx[3];
+
+	/* set address, length, checksum, data */
+	addr_le = GUINT16_TO_LE (address);
+	memcpy (buffer_tx + 0, &addr_le, 2);
+	buffer_tx[2] = len;
+
+	/* create a helper structure as the checksum needs an extra
+	 * byte for the checksum */
+	helper = g_new0 (ChDeviceQueueReadFlashHelper, 1);
+	helper->data = g_memdup (data, len);
+	helper->len = len;
+	helper->address = address;
+
+	buffer = g_new0 (guint8, len + 1);
+	return ch_device_queue_add_internal (device_queue,
+					     device,
+					     CH_CMD_READ_FLASH,
+					     buffer_tx,
+					     sizeof(buffer_tx),
+					     buffer,
+					     len + 1,
+					     g_free,
+					     ch_device_queue_buffer_verify_flash_cb,
+					     helper,
+					     ch_device_queue_verify_flash_helper_destroy);
+}
+
 /**
  * ch_device_queue_verify_flash:
  * @device_queue:		A #ChDeviceQueue
@@ -2588,35 +3087,37 @@ ch_device_queue_verify_flash (ChDeviceQueue *device_queue,
 			      const guint8 *data,
 			      gsize len)
 {
-	ChDeviceQueueReadFlashHelper *helper;
+	ch_device_queue_verify_flash_internal (device_queue, device,
+					       address, data, len);
+}
+
+static ChDeviceQueueData *
+ch_device_queue_erase_flash_internal (ChDeviceQueue *device_queue,
+				      GUsbDevice *device,
+				      guint16 address,
+				      gsize len)
+{
+	guint8 buffer_tx[4];
 	guint16 addr_le;
-	guint8 *buffer;
-	guint8 buffer_tx[3];
+	guint16 len_le;
 
 	/* set address, length, checksum, data */
 	addr_le = GUINT16_TO_LE (address);
 	memcpy (buffer_tx + 0, &addr_le, 2);
-	buffer_tx[2] = len;
-
-	/* create a helper structure as the checksum needs an extra
-	 * byte for the checksum */
-	helper = g_new0 (ChDeviceQueueReadFlashHelper, 1);
-	helper->data = g_memdup (data, len + 1);
-	helper->len = len;
-	helper->address = address;
+	len_le = GUINT16_TO_LE (len);
+	memcpy (buffer_tx + 2, &len_le, 2);
 
-	buffer = g_new0 (guint8, len + 1);
-	ch_device_queue_add_internal (device_queue,
-				      device,
-				      CH_CMD_READ_FLASH,
-				      buffer_tx,
-				      sizeof(buffer_tx),
-				      buffer,
-				      len + 1,
-				      g_free,
-				      ch_device_queue_buffer_verify_flash_cb,
-				      helper,
-				      ch_device_queue_verify_flash_helper_destroy);
+	return ch_device_queue_add_internal (device_queue,
+					     device,
+					     CH_CMD_ERASE_FLASH,
+					     buffer_tx,
+					     sizeof(buffer_tx),
+					     NULL,
+					     0,
+					     NULL,
+					     NULL,
+					     NULL,
+					     NULL);
 }
 
 /**
@@ -2638,23 +3139,8 @@ ch_device_queue_erase_flash (ChDeviceQueue *device_queue,
 			     guint16 address,
 			     gsize len)
 {
-	guint8 buffer_tx[4];
-	guint16 addr_le;
-	guint16 len_le;
-
-	/* set address, length, checksum, data */
-	addr_le = GUINT16_TO_LE (address);
-	memcpy (buffer_tx + 0, &addr_le, 2);
-	len_le = GUINT16_TO_LE (len);
-	memcpy (buffer_tx + 2, &len_le, 2);
-
-	ch_device_queue_add (device_queue,
-			     device,
-			     CH_CMD_ERASE_FLASH,
-			     buffer_tx,
-			     sizeof(buffer_tx),
-			     NULL,
-			     0);
+	ch_device_queue_erase_flash_internal (device_queue, device,
+					      address, len);
 }
 
 /**
@@ -215,6 +215,13 @@ void		 ch_device_queue_take_readings_xyz	(ChDeviceQueue	*device_queue,
 							 GUsbDevice	*device,
 							 guint16	 calibration_index,
 							 CdColorXYZ	*value);
+void		 ch_device_queue_take_readings_xyz_auto	(ChDeviceQueue	*device_queue,
+							 GUsbDevice	*device,
+							 guint16	 calibration_index,
+							 guint16	 integral_time,
+							 gdouble	 flicker_period,
+							 gdouble	 target,
+							 CdColorXYZ	*value);
 void		 ch_device_queue_reset			(ChDeviceQueue	*device_queue,
 							 GUsbDevice	*device);
 void		 ch_device_queue_boot_flash		(ChDeviceQueue	*device_queue,
@@ -310,6 +317,11 @@ void		 ch_device_queue_write_firmware		(ChDeviceQueue	*device_queue,
 							 GUsbDevice	*device,
 							 const guint8	*data,
 							 gsize		 len);
+void		 ch_device_queue_write_firmware_differential
+							(ChDeviceQueue	*device_queue,
+							 GUsbDevice	*device,
+							 const guint8	*data,
+							 gsize		 len);
 void		 ch_device_queue_verify_firmware	(ChDeviceQueue	*device_queue,
 							 GUsbDevice	*device,
 							 const guint8	*data,
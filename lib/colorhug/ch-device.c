@@ -23,6 +23,7 @@
 
 #include <glib.h>
 #include <gusb.h>
+#include <math.h>
 #include <string.h>
 #include <lcms2.h>
 
@@ -334,13 +335,297 @@ ch_device_request_cb (GObject *source_object,
 					       task);
 }
 
+/* the smallest step the emulated sensor can count */
+#define CH_DEVICE_EMULATE_XYZ_RESOLUTION	0.01f
+
+/* enough to cover the runcode of every bootloader */
+#define CH_DEVICE_EMULATE_FLASH_SIZE	0x10000
+
+static guint8 *
+ch_device_emulate_get_flash (GUsbDevice *device)
+{
+	guint8 *flash;
+
+	/* the flash contents live as long as the device object */
+	flash = g_object_get_data (G_OBJECT (device), "ChDeviceEmulateFlash");
+	if (flash == NULL) {
+		flash = g_malloc (CH_DEVICE_EMULATE_FLASH_SIZE);
+		memset (flash, 0xff, CH_DEVICE_EMULATE_FLASH_SIZE);
+		g_object_set_data_full (G_OBJECT (device),
+					"ChDeviceEmulateFlash",
+					flash, g_free);
+	}
+	return flash;
+}
+
+static guint8
+ch_device_emulate_checksum (const guint8 *data, gsize len)
+{
+	guint8 checksum = 0xff;
+	guint i;
+	for (i = 0; i < len; i++)
+		checksum ^= data[i];
+	return checksum;
+}
+
+static ChError
+ch_device_emulate_flash (GUsbDevice *device, ChDeviceTaskData *tdata)
+{
+	const guint8 *buf = tdata->buffer + CH_BUFFER_INPUT_DATA;
+	guint8 *flash = ch_device_emulate_get_flash (device);
+	guint16 addr;
+	guint16 len;
+	guint i;
+
+	addr = buf[0] | (buf[1] << 8);
+	switch (tdata->cmd) {
+	case CH_CMD_READ_FLASH:
+		len = buf[2];
+		if (len > 60 || tdata->buffer_out_len != (gsize) len + 1)
+			return CH_ERROR_INVALID_LENGTH;
+		if ((guint) addr + len > CH_DEVICE_EMULATE_FLASH_SIZE)
+			return CH_ERROR_INVALID_ADDRESS;
+		tdata->buffer_out[0] = ch_device_emulate_checksum (flash + addr, len);
+		memcpy (tdata->buffer_out + 1, flash + addr, len);
+		break;
+	case CH_CMD_WRITE_FLASH:
+		len = buf[2];
+		if (len > CH_FLASH_TRANSFER_BLOCK_SIZE)
+			return CH_ERROR_INVALID_LENGTH;
+		if ((guint) addr + len > CH_DEVICE_EMULATE_FLASH_SIZE)
+			return CH_ERROR_INVALID_ADDRESS;
+		if (buf[3] != ch_device_emulate_checksum (buf + 4, len))
+			return CH_ERROR_INVALID_CHECKSUM;
+		/* like real flash, writing can only clear bits */
+		for (i = 0; i < len; i++)
+			flash[addr + i] &= buf[4 + i];
+		break;
+	case CH_CMD_ERASE_FLASH:
+		len = buf[2] | (buf[3] << 8);
+		if (addr % CH_FLASH_ERASE_BLOCK_SIZE != 0)
+			return CH_ERROR_INVALID_ADDRESS;
+		if ((guint) addr + len > CH_DEVICE_EMULATE_FLASH_SIZE)
+			return CH_ERROR_INVALID_ADDRESS;
+		/* the hardware erases whole pages */
+		len = ((len + CH_FLASH_ERASE_BLOCK_SIZE - 1) /
+		       CH_FLASH_ERASE_BLOCK_SIZE) * CH_FLASH_ERASE_BLOCK_SIZE;
+		memset (flash + addr, 0xff, MIN (len, CH_DEVICE_EMULATE_FLASH_SIZE - addr));
+		break;
+	default:
+		g_assert_not_reached ();
+	}
+	return CH_ERROR_NONE;
+}
+
+static guint
+ch_device_emulate_get_latency (guint8 cmd)
+{
+	/* roughly what the bootloader takes, in ms */
+	switch (cmd) {
+	case CH_CMD_READ_FLASH:
+		return 2;
+	case CH_CMD_WRITE_FLASH:
+		return 4;
+	case CH_CMD_ERASE_FLASH:
+		return 10;
+	case CH_CMD_GET_INTEGRAL_TIME:
+	case CH_CMD_SET_INTEGRAL_TIME:
+	case CH_CMD_TAKE_READING_RAW:
+	case CH_CMD_TAKE_READING_ARRAY:
+	case CH_CMD_TAKE_READING_XYZ:
+		/* the integration time is counted, not waited for */
+		return 2;
+	default:
+		break;
+	}
+	return 20;
+}
+
+static gdouble
+ch_device_emulate_get_on_time (gdouble t, gdouble period, gdouble duty)
+{
+	gdouble cycles = floor (t / period);
+	return cycles * period * duty + MIN (t - cycles * period, period * duty);
+}
+
+/* COLORHUG_EMULATE_FLICKER is "HZ[:DUTY]" */
+static gdouble
+ch_device_emulate_get_flicker (gdouble *duty)
+{
+	const gchar *tmp;
+	gchar *endptr = NULL;
+	gdouble hz;
+
+	*duty = 0.5f;
+	tmp = g_getenv ("COLORHUG_EMULATE_FLICKER");
+	if (tmp == NULL)
+		return 0.f;
+	hz = g_ascii_strtod (tmp, &endptr);
+	if (endptr != NULL && *endptr == ':')
+		*duty = CLAMP (g_ascii_strtod (endptr + 1, NULL), 0.f, 1.f);
+	return hz;
+}
+
+/* the light seen between @start and @start+@duration as a fraction of
+ * fully on */
+static gdouble
+ch_device_emulate_get_light (gdouble start, gdouble duration)
+{
+	gdouble duty;
+	gdouble hz;
+	gdouble period;
+
+	/* a steady light */
+	hz = ch_device_emulate_get_flicker (&duty);
+	if (hz <= 0.f || duration <= 0.f)
+		return duty;
+
+	/* PWM square wave */
+	period = 1000.f / hz;
+	return (ch_device_emulate_get_on_time (start + duration, period, duty) -
+		ch_device_emulate_get_on_time (start, period, duty)) / duration;
+}
+
+static gdouble
+ch_device_emulate_get_integral_time (GUsbDevice *device)
+{
+	guint16 integral_time;
+	integral_time = GPOINTER_TO_UINT (g_object_get_data (G_OBJECT (device),
+							     "ChDeviceEmulateIntegralTime"));
+	if (integral_time == 0)
+		integral_time = CH_INTEGRAL_TIME_VALUE_MAX;
+	return ch_integral_time_to_ms (integral_time);
+}
+
+static void
+ch_device_emulate_add_time (GUsbDevice *device, gdouble ms)
+{
+	guint us;
+
+	/* keep track of how long was spent integrating */
+	us = GPOINTER_TO_UINT (g_object_get_data (G_OBJECT (device),
+						  "ChDeviceEmulateIntegrationTime"));
+	g_object_set_data (G_OBJECT (device),
+			   "ChDeviceEmulateIntegrationTime",
+			   GUINT_TO_POINTER (us + (guint) (ms * 1000.f)));
+}
+
+/* COLORHUG_EMULATE_XYZ is "X,Y,Z" as measured at the max integral time */
+static void
+ch_device_emulate_take_reading_xyz (GUsbDevice *device,
+				    ChDeviceTaskData *tdata,
+				    gdouble now,
+				    gdouble duration)
+{
+	ChPackedFloat pf;
+	const gchar *tmp;
+	gdouble duty;
+	gdouble scale;
+	gdouble xyz[3] = { 0.f, 0.f, 0.f };
+	gchar *endptr = NULL;
+	guint i;
+
+	tmp = g_getenv ("COLORHUG_EMULATE_XYZ");
+	for (i = 0; tmp != NULL && i < 3; i++) {
+		xyz[i] = g_ascii_strtod (tmp, &endptr);
+		tmp = *endptr == ',' ? endptr + 1 : NULL;
+	}
+
+	/* each channel is integrated one after the other, and counted in
+	 * whole units of CH_DEVICE_EMULATE_XYZ_RESOLUTION */
+	ch_device_emulate_get_flicker (&duty);
+	for (i = 0; i < 3; i++) {
+		scale = duration / ch_integral_time_to_ms (CH_INTEGRAL_TIME_VALUE_MAX);
+		scale *= ch_device_emulate_get_light (now + i * duration, duration) / duty;
+		ch_double_to_packed_float (floor (xyz[i] * scale / CH_DEVICE_EMULATE_XYZ_RESOLUTION) *
+					   CH_DEVICE_EMULATE_XYZ_RESOLUTION, &pf);
+		memcpy (tdata->buffer_out + i * sizeof (ChPackedFloat), &pf, sizeof (pf));
+	}
+	ch_device_emulate_add_time (device, duration * 3);
+}
+
+static void
+ch_device_emulate_sensor (GUsbDevice *device, ChDeviceTaskData *tdata)
+{
+	gdouble duration = ch_device_emulate_get_integral_time (device);
+	gdouble now = g_get_monotonic_time () / 1000.f;
+	guint16 integral_le;
+	guint32 reading;
+	guint i;
+
+	switch (tdata->cmd) {
+	case CH_CMD_GET_INTEGRAL_TIME:
+		integral_le = GUINT16_TO_LE (ch_integral_time_from_ms (duration));
+		memcpy (tdata->buffer_out, &integral_le, sizeof (integral_le));
+		break;
+	case CH_CMD_SET_INTEGRAL_TIME:
+		memcpy (&integral_le, tdata->buffer + CH_BUFFER_INPUT_DATA, 2);
+		g_object_set_data (G_OBJECT (device),
+				   "ChDeviceEmulateIntegralTime",
+				   GUINT_TO_POINTER (GUINT16_FROM_LE (integral_le)));
+		break;
+	case CH_CMD_TAKE_READING_RAW:
+		/* about 100 counts per ms when fully on */
+		reading = ch_device_emulate_get_light (now, duration) * duration * 100.f;
+		reading = GUINT32_TO_LE (reading);
+		memcpy (tdata->buffer_out, &reading, sizeof (reading));
+		ch_device_emulate_add_time (device, duration);
+		break;
+	case CH_CMD_TAKE_READING_ARRAY:
+		/* back-to-back samples, each lasting the integral time */
+		for (i = 0; i < tdata->buffer_out_len; i++) {
+			tdata->buffer_out[i] = 0xff * ch_device_emulate_get_light (now + i * duration,
+										   duration);
+		}
+		ch_device_emulate_add_time (device, duration * tdata->buffer_out_len);
+		break;
+	case CH_CMD_TAKE_READING_XYZ:
+		ch_device_emulate_take_reading_xyz (device, tdata, now, duration);
+		break;
+	default:
+		g_assert_not_reached ();
+	}
+}
+
 static gboolean
 ch_device_emulate_cb (gpointer user_data)
 {
 	GTask *task = G_TASK (user_data);
 	ChDeviceTaskData *tdata = g_task_get_task_data (task);
+	GUsbDevice *device = G_USB_DEVICE (g_task_get_source_object (task));
+	ChError error_enum;
+	guint transfers;
+
+	/* keep track of how many commands were sent */
+	transfers = GPOINTER_TO_UINT (g_object_get_data (G_OBJECT (device),
+							 "ChDeviceEmulateTransfers"));
+	g_object_set_data (G_OBJECT (device),
+			   "ChDeviceEmulateTransfers",
+			   GUINT_TO_POINTER (transfers + 1));
 
 	switch (tdata->cmd) {
+	case CH_CMD_READ_FLASH:
+	case CH_CMD_WRITE_FLASH:
+	case CH_CMD_ERASE_FLASH:
+		error_enum = ch_device_emulate_flash (device, tdata);
+		if (error_enum != CH_ERROR_NONE) {
+			g_task_return_new_error (task,
+						 CH_DEVICE_ERROR,
+						 error_enum,
+						 "Emulated %s failed: %s",
+						 ch_command_to_string (tdata->cmd),
+						 ch_strerror (error_enum));
+			g_object_unref (task);
+			return G_SOURCE_REMOVE;
+		}
+		break;
+	case CH_CMD_GET_INTEGRAL_TIME:
+	case CH_CMD_SET_INTEGRAL_TIME:
+	case CH_CMD_TAKE_READING_RAW:
+	case CH_CMD_TAKE_READING_ARRAY:
+	case CH_CMD_TAKE_READING_XYZ:
+		ch_device_emulate_sensor (device, tdata);
+		break;
 	case CH_CMD_GET_SERIAL_NUMBER:
 		tdata->buffer_out[6] = 42;
 		break;
@@ -606,7 +891,8 @@ ch_device_write_command_async (GUsbDevice *device,
 
 	/* dummy hardware */
 	if (g_getenv ("COLORHUG_EMULATE") != NULL) {
-		g_timeout_add (20, ch_device_emulate_cb, tdata);
+		g_timeout_add (ch_device_emulate_get_latency (cmd),
+			       ch_device_emulate_cb, task);
 		return;
 	}
 
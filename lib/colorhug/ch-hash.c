@@ -92,3 +92,46 @@ ch_sha1_parse (const gchar *value, ChSha1 *sha1, GError **error)
 	}
 	return TRUE;
 }
+
+/**
+ * ch_sha1_compute:
+ * @data: (array length=len): Binary data
+ * @len: The length of @data
+ * @sha1: A %ChSha1
+ *
+ * Computes the SHA1 hash of some binary data.
+ *
+ * Since: 1.4.8
+ **/
+void
+ch_sha1_compute (const guint8 *data, gsize len, ChSha1 *sha1)
+{
+	gsize digest_len = sizeof(sha1->bytes);
+	g_autoptr(GChecksum) checksum = NULL;
+
+	g_return_if_fail (data != NULL || len == 0);
+	g_return_if_fail (sha1 != NULL);
+
+	checksum = g_checksum_new (G_CHECKSUM_SHA1);
+	g_checksum_update (checksum, data, len);
+	g_checksum_get_digest (checksum, sha1->bytes, &digest_len);
+}
+
+/**
+ * ch_sha1_equal:
+ * @sha1a: A %ChSha1
+ * @sha1b: A %ChSha1
+ *
+ * Compares two SHA1 hashes.
+ *
+ * Return value: %TRUE if the hashes are identical
+ *
+ * Since: 1.4.8
+ **/
+gboolean
+ch_sha1_equal (const ChSha1 *sha1a, const ChSha1 *sha1b)
+{
+	g_return_val_if_fail (sha1a != NULL, FALSE);
+	g_return_val_if_fail (sha1b != NULL, FALSE);
+	return memcmp (sha1a->bytes, sha1b->bytes, sizeof(sha1a->bytes)) == 0;
+}
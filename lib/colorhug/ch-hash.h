@@ -39,6 +39,11 @@ gchar		*ch_sha1_to_string		(const ChSha1		*sha1);
 gboolean	 ch_sha1_parse			(const gchar		*value,
 						 ChSha1			*sha1,
 						 GError			**error);
+void		 ch_sha1_compute		(const guint8		*data,
+						 gsize			 len,
+						 ChSha1			*sha1);
+gboolean	 ch_sha1_equal			(const ChSha1		*sha1a,
+						 const ChSha1		*sha1b);
 
 G_END_DECLS
 
@@ -22,7 +22,6 @@
 #include "config.h"
 
 #include <glib.h>
-#include <stdio.h>
 #include <string.h>
 
 #include "ch-inhx32.h"
@@ -31,157 +30,243 @@
 #define	CH_RECORD_TYPE_EOF		1
 #define	CH_RECORD_TYPE_EXTENDED		4
 
-static guint8
-ch_inhx32_parse_uint8 (const gchar *data, guint pos)
+/* the highest address the bootloader will accept */
+#define	CH_INHX32_ADDR_MAX		0xfff0
+
+/* nibble value for each ASCII char, or 0xff if not a hex digit */
+static const guint8 ch_inhx32_nibble[256] = {
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+};
+
+/* returns -1 if either char is not a hex digit */
+static inline gint
+ch_inhx32_parse_uint8 (const guint8 *data)
 {
-	gchar buffer[3];
-	buffer[0] = data[pos+0];
-	buffer[1] = data[pos+1];
-	buffer[2] = '\0';
-	return g_ascii_strtoull (buffer, NULL, 16);
+	guint8 hi = ch_inhx32_nibble[data[0]];
+	guint8 lo = ch_inhx32_nibble[data[1]];
+	if ((hi | lo) & 0xf0)
+		return -1;
+	return (hi << 4) | lo;
 }
 
 /**
- * ch_inhx32_to_bin_full:
- * @in_buffer: A %NULL terminated Intel hex byte string
- * @out_buffer: The output byte buffer
- * @out_size: The size of @out_buffer
+ * ch_inhx32_parse_bytes:
+ * @blob: An Intel hex file, which does not need to be %NULL terminated
  * @runcode_addr: The runcode address of the firmware
  * @error: A #GError or %NULL
  *
- * Converts the Intel hex byte string into a binary packed
- * representation suitable for direct flashing the ColorHug.
+ * Converts the Intel hex data into a binary packed representation
+ * suitable for direct flashing the ColorHug.
  *
- * Return value: packed value to host byte order
+ * The input is parsed in place without copying, so a file can be loaded
+ * with g_mapped_file_get_bytes() rather than read into memory. Any
+ * syntax or checksum error includes the byte offset into @blob.
  *
- * Since: 1.2.9
+ * Return value: (transfer full): the binary firmware, or %NULL for error
+ *
+ * Since: 1.4.8
  **/
-gboolean
-ch_inhx32_to_bin_full (const gchar *in_buffer,
-		       guint8 **out_buffer,
-		       gsize *out_size,
+GBytes *
+ch_inhx32_parse_bytes (GBytes *blob,
 		       guint16 runcode_addr,
 		       GError **error)
 {
-	gboolean verbose;
-	gchar *ptr;
-	gint checksum;
-	gint end;
-	gint i;
-	gint offset = 0;
-	guint8 data_tmp;
-	guint addr32 = 0;
-	guint addr32_last = 0;
+	const guint8 *data;
+	const guint8 *ptr;
+	gint tmp;
+	gsize offset = 0;
+	gsize out_alloc;
+	gsize out_len;
+	gsize sz = 0;
+	guint8 checksum;
+	guint8 rec[4 + 255 + 1];
+	guint addr;
 	guint addr_high = 0;
-	guint addr_low = 0;
-	guint j;
+	guint addr_first = G_MAXUINT;
+	guint addr_last = 0;
+	guint i;
 	guint len_tmp;
-	guint type;
-	g_autoptr(GString) string = NULL;
+	g_autofree guint8 *out = NULL;
 
-	g_return_val_if_fail (in_buffer != NULL, FALSE);
-	g_return_val_if_fail (runcode_addr > 0, FALSE);
+	g_return_val_if_fail (blob != NULL, NULL);
+	g_return_val_if_fail (runcode_addr > 0, NULL);
+
+	/* everything we keep lands inside this window, so allocate it once
+	 * and drop bytes straight into place; holes are left as 0x00 as
+	 * we can't write 0xffff to pic14 */
+	out_alloc = MAX ((gsize) (CH_INHX32_ADDR_MAX - runcode_addr),
+			 (gsize) runcode_addr);
+	out = g_malloc0 (out_alloc);
 
-	/* only if set */
-	verbose = g_getenv ("VERBOSE") != NULL;
-	string = g_string_new ("");
+	data = g_bytes_get_data (blob, &sz);
+	ptr = memchr (data, ':', sz);
+	if (ptr == NULL) {
+		g_set_error_literal (error, 1, 0,
+				     "invalid inhx32 syntax: no records");
+		return NULL;
+	}
+	offset = ptr - data;
 	while (TRUE) {
 
 		/* length, 16-bit address, type */
-		if (sscanf (&in_buffer[offset], ":%02x%04x%02x",
-			    &len_tmp, &addr_low, &type) != 3) {
-			g_set_error_literal (error, 1, 0,
-					     "invalid inhx32 syntax");
-			return FALSE;
+		if (offset + 11 > sz) {
+			g_set_error (error, 1, 0,
+				     "invalid inhx32 syntax: truncated record "
+				     "at offset %" G_GSIZE_FORMAT, offset);
+			return NULL;
+		}
+		tmp = ch_inhx32_parse_uint8 (data + offset + 1);
+		if (tmp < 0) {
+			g_set_error (error, 1, 0,
+				     "invalid inhx32 syntax at offset %" G_GSIZE_FORMAT,
+				     offset + 1);
+			return NULL;
+		}
+		len_tmp = tmp;
+		if (offset + 11 + len_tmp * 2 > sz) {
+			g_set_error (error, 1, 0,
+				     "invalid inhx32 syntax: truncated record "
+				     "at offset %" G_GSIZE_FORMAT, offset);
+			return NULL;
 		}
 
-		/* position of checksum */
-		end = offset + 9 + len_tmp * 2;
-
-		/* verify checksum */
+		/* decode the whole record, including the checksum */
 		checksum = 0;
-		for (i = offset + 1; i < end; i += 2) {
-			data_tmp = ch_inhx32_parse_uint8 (in_buffer, i);
-			checksum = (checksum + (0x100 - data_tmp)) & 0xff;
+		for (i = 0; i < len_tmp + 5; i++) {
+			tmp = ch_inhx32_parse_uint8 (data + offset + 1 + i * 2);
+			if (tmp < 0) {
+				g_set_error (error, 1, 0,
+					     "invalid inhx32 syntax at offset %" G_GSIZE_FORMAT,
+					     offset + 1 + i * 2);
+				return NULL;
+			}
+			rec[i] = tmp;
+			checksum += rec[i];
 		}
-		if (ch_inhx32_parse_uint8 (in_buffer, end) != checksum)  {
-			g_set_error_literal (error, 1, 0,
-					     "invalid checksum");
-			return FALSE;
+		if (checksum != 0) {
+			g_set_error (error, 1, 0,
+				     "invalid checksum at offset %" G_GSIZE_FORMAT,
+				     offset + 9 + len_tmp * 2);
+			return NULL;
 		}
 
 		/* process different record types */
-		switch (type) {
+		switch (rec[3]) {
 		case CH_RECORD_TYPE_DATA:
-			/* if not contiguous with previous record,
-			 * issue accumulated hex data (if any) and start anew. */
-			if ((addr_high + addr_low) != addr32)
-				addr32 = addr_high + addr_low;
-
-			/* Parse bytes from line into hexBuf */
-			for (i = offset + 9; i < end; i += 2) {
-				if (addr32 >= runcode_addr &&
-				    addr32 < 0xfff0) {
-
-					/* find out if there are any
-					 * holes in the hex record */
-					len_tmp = addr32 - addr32_last;
-					if (addr32_last > 0x0 && len_tmp > 1) {
-						for (j = 1; j < len_tmp; j++) {
-							if (verbose) {
-								g_debug ("Filling address 0x%04x",
-									 addr32_last + j);
-							}
-							/* although 0xff might be clearer,
-							 * we can't write 0xffff to pic14 */
-							g_string_append_c (string, 0x00);
-						}
-					}
-					data_tmp = ch_inhx32_parse_uint8 (in_buffer, i);
-					g_string_append_c (string, data_tmp);
-					if (verbose)
-						g_debug ("Writing address 0x%04x", addr32);
-					addr32_last = addr32;
-				} else {
-					if (verbose)
-						g_debug ("Ignoring address 0x%04x", addr32);
-				}
-				addr32++;
+			addr = addr_high + ((rec[1] << 8) | rec[2]);
+			for (i = 0; i < len_tmp; i++, addr++) {
+				if (addr < runcode_addr || addr >= CH_INHX32_ADDR_MAX)
+					continue;
+				out[addr - runcode_addr] = rec[4 + i];
+				addr_first = MIN (addr_first, addr);
+				addr_last = MAX (addr_last, addr);
 			}
 			break;
 		case CH_RECORD_TYPE_EOF:
 			break;
 		case CH_RECORD_TYPE_EXTENDED:
-			if (sscanf (&in_buffer[offset+9], "%04x", &addr_high) != 1) {
-				g_set_error_literal (error, 1, 0,
-						     "invalid hex syntax");
-				return FALSE;
+			if (len_tmp != 2) {
+				g_set_error (error, 1, 0,
+					     "invalid hex syntax at offset %" G_GSIZE_FORMAT,
+					     offset + 9);
+				return NULL;
 			}
-			addr_high <<= 16;
-			addr32 = addr_high + addr_low;
+			addr_high = ((guint) rec[4] << 24) | ((guint) rec[5] << 16);
 			break;
 		default:
-			g_set_error_literal (error, 1, 0,
-					     "invalid record type");
-			return FALSE;
+			g_set_error (error, 1, 0,
+				     "invalid record type at offset %" G_GSIZE_FORMAT,
+				     offset + 7);
+			return NULL;
 		}
+		if (rec[3] == CH_RECORD_TYPE_EOF)
+			break;
 
 		/* advance to start of next line */
-		ptr = strchr (&in_buffer[end+2], ':');
+		offset += 11 + len_tmp * 2;
+		ptr = memchr (data + offset, ':', sz - offset);
 		if (ptr == NULL)
 			break;
-		offset = ptr - in_buffer;
+		offset = ptr - data;
+	}
+
+	/* the image starts at the first byte that was written */
+	if (addr_first == G_MAXUINT) {
+		out_len = 0;
+	} else {
+		out_len = addr_last - addr_first + 1;
+		if (addr_first > runcode_addr) {
+			memmove (out, out + addr_first - runcode_addr, out_len);
+			memset (out + out_len, 0x00, out_alloc - out_len);
+		}
+		g_debug ("Using 0x%04x to 0x%04x", addr_first, addr_last);
 	}
 
 	/* pad out to device size so we can read back a verifiable blob */
-	for (i = string->len; i < runcode_addr; i++)
-		g_string_append_len (string, "\0", 1);
+	if (out_len < runcode_addr)
+		out_len = runcode_addr;
+	return g_bytes_new_take (g_steal_pointer (&out), out_len);
+}
+
+/**
+ * ch_inhx32_to_bin_full:
+ * @in_buffer: A %NULL terminated Intel hex byte string
+ * @out_buffer: The output byte buffer
+ * @out_size: The size of @out_buffer
+ * @runcode_addr: The runcode address of the firmware
+ * @error: A #GError or %NULL
+ *
+ * Converts the Intel hex byte string into a binary packed
+ * representation suitable for direct flashing the ColorHug.
+ *
+ * Return value: packed value to host byte order
+ *
+ * Since: 1.2.9
+ **/
+gboolean
+ch_inhx32_to_bin_full (const gchar *in_buffer,
+		       guint8 **out_buffer,
+		       gsize *out_size,
+		       guint16 runcode_addr,
+		       GError **error)
+{
+	gsize sz = 0;
+	guint8 *tmp;
+	g_autoptr(GBytes) blob = NULL;
+	g_autoptr(GBytes) out = NULL;
+
+	g_return_val_if_fail (in_buffer != NULL, FALSE);
+	g_return_val_if_fail (runcode_addr > 0, FALSE);
+
+	/* no copy of the input is made */
+	blob = g_bytes_new_static (in_buffer, strlen (in_buffer));
+	out = ch_inhx32_parse_bytes (blob, runcode_addr, error);
+	if (out == NULL)
+		return FALSE;
 
-	/* save data */
+	/* save data, which is not copied as we hold the only ref */
+	tmp = g_bytes_unref_to_data (g_steal_pointer (&out), &sz);
 	if (out_size != NULL)
-		*out_size = string->len;
+		*out_size = sz;
 	if (out_buffer != NULL)
-		*out_buffer = g_memdup (string->str, string->len);
+		*out_buffer = tmp;
+	else
+		g_free (tmp);
 	return TRUE;
 }
 
@@ -43,6 +43,10 @@ gboolean	 ch_inhx32_to_bin_full		(const gchar	*in_buffer,
 						 guint16	 runcode_addr,
 						 GError		**error)
 						 G_GNUC_WARN_UNUSED_RESULT;
+GBytes		*ch_inhx32_parse_bytes		(GBytes		*blob,
+						 guint16	 runcode_addr,
+						 GError		**error)
+						 G_GNUC_WARN_UNUSED_RESULT;
 
 G_END_DECLS
 
@@ -190,3 +190,196 @@ ch_packed_float_multiply (const ChPackedFloat *pf1,
 	ch_packed_float_set_value (result, tmp);
 	return CH_ERROR_NONE;
 }
+
+/**
+ * ch_integral_time_from_ms:
+ * @ms: the integration time in milliseconds
+ *
+ * Converts a time to the value used by %CH_CMD_SET_INTEGRAL_TIME.
+ *
+ * Return value: the integral time, clamped to the range the hardware supports
+ *
+ * Since: 1.4.8
+ **/
+guint16
+ch_integral_time_from_ms (gdouble ms)
+{
+	gdouble tmp = ms * CH_INTEGRAL_TIME_VALUE_PER_MS;
+	if (tmp < 1.f)
+		return 1;
+	if (tmp > CH_INTEGRAL_TIME_VALUE_MAX)
+		return CH_INTEGRAL_TIME_VALUE_MAX;
+	return (guint16) (tmp + 0.5f);
+}
+
+/**
+ * ch_integral_time_to_ms:
+ * @integral_time: the value used by %CH_CMD_SET_INTEGRAL_TIME
+ *
+ * Converts an integral time to milliseconds.
+ *
+ * Return value: the integration time in milliseconds
+ *
+ * Since: 1.4.8
+ **/
+gdouble
+ch_integral_time_to_ms (guint16 integral_time)
+{
+	return (gdouble) integral_time / CH_INTEGRAL_TIME_VALUE_PER_MS;
+}
+
+static gdouble
+ch_flicker_get_difference (const gdouble *samples, guint n_samples, gdouble lag)
+{
+	gdouble sum = 0.f;
+	guint cnt = 0;
+	guint i;
+
+	/* compare each sample with the one @lag later, interpolating */
+	for (i = 0; (gdouble) i + lag <= (gdouble) (n_samples - 1); i++) {
+		gdouble pos = (gdouble) i + lag;
+		guint j = (guint) pos;
+		gdouble tmp = samples[j];
+		if (pos > j)
+			tmp += (samples[j + 1] - samples[j]) * (pos - j);
+		sum += (samples[i] - tmp) * (samples[i] - tmp);
+		cnt++;
+	}
+	return sum / cnt;
+}
+
+/**
+ * ch_flicker_estimate_period:
+ * @samples: readings taken back-to-back
+ * @n_samples: the number of readings, at least 8
+ * @interval: the time between each reading, e.g. in milliseconds
+ *
+ * Estimates the dominant period of a flickering light source, for
+ * instance a PWM-dimmed backlight, using the autocorrelation of the
+ * readings. The period can be found if it is between two samples and
+ * half of the total sampling time.
+ *
+ * Return value: the period in the units of @interval, or 0 if the light
+ * is steady or no single period dominates
+ *
+ * Since: 1.4.8
+ **/
+gdouble
+ch_flicker_estimate_period (const gdouble *samples,
+			    guint n_samples,
+			    gdouble interval)
+{
+	gdouble delta = 0.f;
+	gdouble denom;
+	gdouble mean = 0.f;
+	gdouble period;
+	gdouble var = 0.f;
+	gdouble r[CH_FLICKER_SAMPLES_MAX / 2 + 2];
+	guint cycles;
+	guint i;
+	guint k;
+	guint max_lag;
+	guint peak = 0;
+
+	g_return_val_if_fail (samples != NULL, 0.f);
+	g_return_val_if_fail (interval > 0.f, 0.f);
+
+	/* not enough to be useful */
+	if (n_samples < 8)
+		return 0.f;
+	n_samples = MIN (n_samples, CH_FLICKER_SAMPLES_MAX);
+	max_lag = n_samples / 2;
+
+	/* too dark or too steady to measure */
+	for (i = 0; i < n_samples; i++)
+		mean += samples[i];
+	mean /= n_samples;
+	for (i = 0; i < n_samples; i++)
+		var += (samples[i] - mean) * (samples[i] - mean);
+	var /= n_samples;
+	if (mean <= 0.f || sqrt (var) < mean * CH_FLICKER_MODULATION_MIN)
+		return 0.f;
+
+	/* normalized autocorrelation for each lag */
+	for (k = 0; k <= max_lag + 1; k++) {
+		gdouble sum = 0.f;
+		for (i = 0; i + k < n_samples; i++)
+			sum += (samples[i] - mean) * (samples[i + k] - mean);
+		r[k] = sum / ((n_samples - k) * var);
+	}
+
+	/* the first strong peak after the correlation goes negative */
+	for (k = 1; k <= max_lag; k++) {
+		if (r[k] < 0.f)
+			break;
+	}
+	for (; k <= max_lag; k++) {
+		if (r[k] < CH_FLICKER_CORRELATION_MIN)
+			continue;
+		if (r[k] >= r[k - 1] && r[k] >= r[k + 1]) {
+			peak = k;
+			break;
+		}
+	}
+	if (peak == 0)
+		return 0.f;
+
+	/* interpolate between samples */
+	denom = r[peak - 1] - 2.f * r[peak] + r[peak + 1];
+	if (denom < 0.f)
+		delta = 0.5f * (r[peak - 1] - r[peak + 1]) / denom;
+	period = (gdouble) peak + delta;
+
+	/* refine using as many whole cycles as will fit, as this divides
+	 * the error by the number of cycles */
+	cycles = (guint) ((n_samples - max_lag / 2) / period);
+	if (cycles > 0) {
+		gdouble best = G_MAXDOUBLE;
+		gdouble lag;
+		gdouble lag_best = period * cycles;
+		gdouble lag_max = MIN (lag_best + 1.f, n_samples - 2);
+		gdouble lag_min = MAX (lag_best - 1.f, 1.f);
+		for (lag = lag_min; lag <= lag_max; lag += 0.01f) {
+			gdouble tmp = ch_flicker_get_difference (samples, n_samples, lag);
+			if (tmp < best) {
+				best = tmp;
+				lag_best = lag;
+			}
+		}
+		period = lag_best / cycles;
+	}
+	return period * interval;
+}
+
+/**
+ * ch_flicker_get_integral_time:
+ * @period: the flicker period in milliseconds, or 0 for a steady light
+ * @target: the preferred integration time in milliseconds
+ *
+ * Chooses an integration time close to @target that is a whole
+ * multiple of @period, so that each reading sees exactly the same
+ * number of flicker cycles whatever the phase it started at.
+ *
+ * Return value: the value to use for %CH_CMD_SET_INTEGRAL_TIME
+ *
+ * Since: 1.4.8
+ **/
+guint16
+ch_flicker_get_integral_time (gdouble period, gdouble target)
+{
+	gdouble max = ch_integral_time_to_ms (CH_INTEGRAL_TIME_VALUE_MAX);
+	guint n;
+
+	/* nothing to line up with */
+	if (period <= 0.f)
+		return ch_integral_time_from_ms (target);
+
+	/* longer than the hardware can integrate */
+	if (period > max)
+		return CH_INTEGRAL_TIME_VALUE_MAX;
+
+	n = MAX ((guint) (target / period + 0.5f), 1);
+	while (n > 1 && n * period > max)
+		n--;
+	return ch_integral_time_from_ms (n * period);
+}
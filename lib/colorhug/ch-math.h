@@ -63,6 +63,15 @@ ChError		 ch_packed_float_multiply	(const ChPackedFloat	*pf1,
 						 const ChPackedFloat	*pf2,
 						 ChPackedFloat		*result);
 
+guint16		 ch_integral_time_from_ms	(gdouble		 ms);
+gdouble		 ch_integral_time_to_ms		(guint16		 integral_time);
+
+gdouble		 ch_flicker_estimate_period	(const gdouble		*samples,
+						 guint			 n_samples,
+						 gdouble		 interval);
+guint16		 ch_flicker_get_integral_time	(gdouble		 period,
+						 gdouble		 target);
+
 G_END_DECLS
 
 #endif /* __CH_MATH_H */
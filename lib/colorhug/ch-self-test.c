@@ -32,6 +32,7 @@
 #include "ch-hash.h"
 #include "ch-device.h"
 #include "ch-device-queue.h"
+#include "ch-inhx32.h"
 
 static void
 ch_test_hash_func (void)
@@ -1254,6 +1255,561 @@ ch_test_firmware_func (void)
 	g_assert_cmpint (device_mode, ==, CH_DEVICE_MODE_FIRMWARE2);
 }
 
+static void
+ch_test_inhx32_append_record (GString *str,
+			      guint8 type,
+			      guint16 addr,
+			      const guint8 *data,
+			      guint8 len)
+{
+	guint8 checksum;
+	guint i;
+
+	checksum = len + (addr >> 8) + (addr & 0xff) + type;
+	g_string_append_printf (str, ":%02X%04X%02X", len, addr, type);
+	for (i = 0; i < len; i++) {
+		g_string_append_printf (str, "%02X", data[i]);
+		checksum += data[i];
+	}
+	g_string_append_printf (str, "%02X\r\n", (guint8) (0x100 - checksum));
+}
+
+static GString *
+ch_test_inhx32_create (guint segments)
+{
+	GString *str = g_string_new (NULL);
+	guint8 data[16];
+	guint addr;
+	guint i;
+	guint seg;
+
+	for (seg = 0; seg < segments; seg++) {
+		data[0] = seg >> 8;
+		data[1] = seg & 0xff;
+		ch_test_inhx32_append_record (str, 0x04, 0x0000, data, 2);
+		for (addr = 0; addr < 0x10000; addr += sizeof(data)) {
+			for (i = 0; i < sizeof(data); i++)
+				data[i] = (addr + i + seg) & 0xff;
+			ch_test_inhx32_append_record (str, 0x00, addr,
+						      data, sizeof(data));
+		}
+	}
+	ch_test_inhx32_append_record (str, 0x01, 0x0000, NULL, 0);
+	return str;
+}
+
+static void
+ch_test_inhx32_func (void)
+{
+	const guint8 *out;
+	gboolean ret;
+	gsize len = 0;
+	guint i;
+	const guint repeats = 10;
+	g_autofree guint8 *data = NULL;
+	g_autoptr(GBytes) blob = NULL;
+	g_autoptr(GBytes) bin = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GString) str = NULL;
+	g_autoptr(GTimer) timer = NULL;
+
+	/* simple file with a hole in it */
+	ret = ch_inhx32_to_bin_full (":0440000001020304B2\n"
+				     ":024006000506AD\n"
+				     ":00000001FF\n",
+				     &data, &len, 0x4000, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpint (len, ==, 0x4000);
+	g_assert_cmpint (data[0], ==, 0x01);
+	g_assert_cmpint (data[3], ==, 0x04);
+	g_assert_cmpint (data[4], ==, 0x00);
+	g_assert_cmpint (data[5], ==, 0x00);
+	g_assert_cmpint (data[6], ==, 0x05);
+	g_assert_cmpint (data[7], ==, 0x06);
+
+	/* invalid checksum on the second record */
+	blob = g_bytes_new_static (":0440000001020304B2\n:024006000506AC\n", 36);
+	bin = ch_inhx32_parse_bytes (blob, 0x4000, &error);
+	g_assert_error (error, 1, 0);
+	g_assert (bin == NULL);
+	g_assert (g_strstr_len (error->message, -1, "offset 33") != NULL);
+	g_clear_error (&error);
+	g_bytes_unref (blob);
+
+	/* invalid hex digit */
+	blob = g_bytes_new_static (":04400000010X0304B2\n", 20);
+	bin = ch_inhx32_parse_bytes (blob, 0x4000, &error);
+	g_assert_error (error, 1, 0);
+	g_assert (bin == NULL);
+	g_assert (g_strstr_len (error->message, -1, "offset 11") != NULL);
+	g_clear_error (&error);
+	g_bytes_unref (blob);
+
+	/* lots of segments, although only part of the first is used */
+	str = ch_test_inhx32_create (32);
+	blob = g_bytes_new_static (str->str, str->len);
+	timer = g_timer_new ();
+	for (i = 0; i < repeats; i++) {
+		g_clear_pointer (&bin, g_bytes_unref);
+		bin = ch_inhx32_parse_bytes (blob, 0x4000, &error);
+		g_assert_no_error (error);
+		g_assert (bin != NULL);
+	}
+	g_print ("%.1fMB = %.2fms\n", (gdouble) str->len / (1024 * 1024),
+		 g_timer_elapsed (timer, NULL) * 1000 / repeats);
+	out = g_bytes_get_data (bin, &len);
+	g_assert_cmpint (len, ==, 0xfff0 - 0x4000);
+	g_assert_cmpint (out[0x0000], ==, 0x00);
+	g_assert_cmpint (out[0x0123], ==, 0x23);
+	g_assert_cmpint (out[len - 1], ==, 0xef);
+}
+
+static guint
+ch_test_get_emulated_transfers (GUsbDevice *device)
+{
+	return GPOINTER_TO_UINT (g_object_get_data (G_OBJECT (device),
+						    "ChDeviceEmulateTransfers"));
+}
+
+static void
+ch_test_firmware_diff_func (void)
+{
+	gsize len = CH_FLASH_ERASE_BLOCK_SIZE * 4 + 100;
+	guint commands;
+	guint i;
+	g_autofree guint8 *data = NULL;
+	g_autofree guint8 *flash = NULL;
+	g_autoptr(GArray) blocks = NULL;
+
+	/* something predictable, with a short last block */
+	data = g_malloc (len);
+	for (i = 0; i < len; i++)
+		data[i] = i % 251;
+
+	/* blank flash, so everything has to be written */
+	flash = g_malloc (len);
+	memset (flash, 0xff, len);
+	blocks = ch_firmware_diff (flash, data, len);
+	g_assert_cmpint (blocks->len, ==, 5);
+	g_assert_cmpint (g_array_index (blocks, guint, 4), ==, CH_FLASH_ERASE_BLOCK_SIZE * 4);
+	commands = ch_firmware_patch (flash, data, len, blocks);
+	g_assert_cmpint (commands, ==, 4 * (1 + 32) + 1 + 4);
+	g_assert (memcmp (flash, data, len) == 0);
+	g_array_unref (blocks);
+
+	/* same image again, so nothing is written */
+	blocks = ch_firmware_diff (flash, data, len);
+	g_assert_cmpint (blocks->len, ==, 0);
+	g_assert_cmpint (ch_firmware_patch (flash, data, len, blocks), ==, 0);
+	g_array_unref (blocks);
+
+	/* change one byte in one block, and set bits that writing cannot */
+	data[CH_FLASH_ERASE_BLOCK_SIZE * 2 + 10] ^= 0x5a;
+	flash[CH_FLASH_ERASE_BLOCK_SIZE * 4 + 50] = 0x00;
+	data[CH_FLASH_ERASE_BLOCK_SIZE * 4 + 50] = 0xff;
+	blocks = ch_firmware_diff (flash, data, len);
+	g_assert_cmpint (blocks->len, ==, 2);
+	g_assert_cmpint (g_array_index (blocks, guint, 0), ==, CH_FLASH_ERASE_BLOCK_SIZE * 2);
+	g_assert_cmpint (g_array_index (blocks, guint, 1), ==, CH_FLASH_ERASE_BLOCK_SIZE * 4);
+	commands = ch_firmware_patch (flash, data, len, blocks);
+	g_assert_cmpint (commands, ==, (1 + 32) + (1 + 4));
+	g_assert (memcmp (flash, data, len) == 0);
+	g_array_unref (blocks);
+
+	/* blocks that are not listed are left alone */
+	data[10] ^= 0xff;
+	data[CH_FLASH_ERASE_BLOCK_SIZE + 10] ^= 0xff;
+	blocks = g_array_new (FALSE, FALSE, sizeof (guint));
+	i = CH_FLASH_ERASE_BLOCK_SIZE;
+	g_array_append_val (blocks, i);
+	ch_firmware_patch (flash, data, len, blocks);
+	g_assert_cmpint (flash[10], !=, data[10]);
+	g_assert_cmpint (flash[CH_FLASH_ERASE_BLOCK_SIZE + 10], ==, data[CH_FLASH_ERASE_BLOCK_SIZE + 10]);
+}
+
+static void
+ch_test_firmware_differential_func (void)
+{
+	gboolean ret;
+	gdouble elapsed_full;
+	gdouble elapsed_diff;
+	gsize len = CH_FLASH_ERASE_BLOCK_SIZE * 4;
+	guint i;
+	guint transfers_full;
+	guint transfers_diff;
+	guint transfers_nop;
+	guint8 *data_read = NULL;
+	g_autofree guint8 *data = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GPtrArray) devices = NULL;
+	g_autoptr(GTimer) timer = g_timer_new ();
+	g_autoptr(GUsbContext) usb_ctx = NULL;
+	g_autoptr(ChDeviceQueue) device_queue = NULL;
+	GUsbDevice *device;
+
+	/* any device will do, as the hardware is never touched */
+	if (!g_test_slow ()) {
+		g_test_skip ("needs a USB device, run with -m slow");
+		return;
+	}
+	usb_ctx = g_usb_context_new (NULL);
+	if (usb_ctx == NULL) {
+		g_test_skip ("no USB context");
+		return;
+	}
+	devices = g_usb_context_get_devices (usb_ctx);
+	if (devices->len == 0) {
+		g_test_skip ("no USB devices to emulate with");
+		return;
+	}
+	device = g_ptr_array_index (devices, 0);
+	g_setenv ("COLORHUG_EMULATE", "1", TRUE);
+
+	/* something predictable */
+	data = g_malloc (len);
+	for (i = 0; i < len; i++)
+		data[i] = i % 251;
+
+	/* blank flash, so everything has to be written */
+	device_queue = ch_device_queue_new ();
+	g_timer_reset (timer);
+	ch_device_queue_write_firmware_differential (device_queue, device, data, len);
+	ret = ch_device_queue_process (device_queue,
+				       CH_DEVICE_QUEUE_PROCESS_FLAGS_NONE,
+				       NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	elapsed_full = g_timer_elapsed (timer, NULL);
+	transfers_full = ch_test_get_emulated_transfers (device);
+	g_object_unref (device_queue);
+
+	/* same image again, so only the reads are required */
+	device_queue = ch_device_queue_new ();
+	ch_device_queue_write_firmware_differential (device_queue, device, data, len);
+	ret = ch_device_queue_process (device_queue,
+				       CH_DEVICE_QUEUE_PROCESS_FLAGS_NONE,
+				       NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	transfers_nop = ch_test_get_emulated_transfers (device) - transfers_full;
+	g_object_unref (device_queue);
+
+	/* change one byte in one block */
+	data[CH_FLASH_ERASE_BLOCK_SIZE * 2 + 10] ^= 0x5a;
+	device_queue = ch_device_queue_new ();
+	g_timer_reset (timer);
+	ch_device_queue_write_firmware_differential (device_queue, device, data, len);
+	ret = ch_device_queue_process (device_queue,
+				       CH_DEVICE_QUEUE_PROCESS_FLAGS_NONE,
+				       NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	elapsed_diff = g_timer_elapsed (timer, NULL);
+	transfers_diff = ch_test_get_emulated_transfers (device) -
+			 transfers_full - transfers_nop;
+	g_object_unref (device_queue);
+	g_debug ("full flash: %u transfers in %.2fs, one block: %u transfers in %.2fs",
+		 transfers_full, elapsed_full, transfers_diff, elapsed_diff);
+
+	/* 18 reads for each block, plus 1 erase, 32 writes and 18 verifies */
+	g_assert_cmpint (transfers_full, ==, 4 * (18 + 1 + 32 + 18));
+	g_assert_cmpint (transfers_nop, ==, 4 * 18);
+	g_assert_cmpint (transfers_diff, ==, 4 * 18 + 1 + 32 + 18);
+	g_assert_cmpfloat (elapsed_diff, <, elapsed_full);
+
+	/* check the flash really has the new image */
+	device_queue = ch_device_queue_new ();
+	data_read = g_malloc0 (len);
+	for (i = 0; i < len; i += 32) {
+		ch_device_queue_read_flash (device_queue, device,
+					    ch_device_get_runcode_address (device) + i,
+					    data_read + i, 32);
+	}
+	ret = ch_device_queue_process (device_queue,
+				       CH_DEVICE_QUEUE_PROCESS_FLAGS_NONE,
+				       NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert (memcmp (data, data_read, len) == 0);
+	g_free (data_read);
+
+	g_unsetenv ("COLORHUG_EMULATE");
+}
+
+/* a PWM waveform averaged over each reading, like the sensor sees it */
+static gdouble
+ch_test_flicker_get_light (gdouble start, gdouble duration,
+			   gdouble period, gdouble duty)
+{
+	gdouble c1 = floor (start / period);
+	gdouble c2 = floor ((start + duration) / period);
+	gdouble on1 = c1 * period * duty + MIN (start - c1 * period, period * duty);
+	gdouble on2 = c2 * period * duty + MIN (start + duration - c2 * period, period * duty);
+	return (on2 - on1) / duration;
+}
+
+static gdouble
+ch_test_flicker_get_noise (gdouble integral_time, gdouble period, gdouble duty)
+{
+	gdouble mean = 0.f;
+	gdouble var = 0.f;
+	gdouble tmp;
+	guint i;
+
+	/* the relative spread of readings started at different phases */
+	for (i = 0; i < 100; i++) {
+		tmp = ch_test_flicker_get_light (i * 7.3f, integral_time, period, duty);
+		mean += tmp;
+		var += tmp * tmp;
+	}
+	mean /= 100;
+	return sqrt (var / 100 - mean * mean) / mean;
+}
+
+static void
+ch_test_flicker_func (void)
+{
+	const gdouble interval = 3.f;
+	const gdouble hz[] = { 24.f, 30.f, 50.f, 60.f, 0.f };
+	const gdouble duty[] = { 0.2f, 0.5f, 0.5f, 0.5f, 0.f };
+	gdouble period;
+	gdouble samples[30];
+	gdouble tuned;
+	guint16 integral_time;
+	guint i;
+	guint j;
+
+	/* steady light */
+	for (i = 0; i < G_N_ELEMENTS (samples); i++)
+		samples[i] = 100.f;
+	period = ch_flicker_estimate_period (samples, G_N_ELEMENTS (samples), interval);
+	g_assert_cmpfloat (period, ==, 0.f);
+	integral_time = ch_flicker_get_integral_time (period, 50.f);
+	g_assert_cmpint (integral_time, ==, ch_integral_time_from_ms (50.f));
+
+	/* a whole number of periods that fits in the hardware */
+	integral_time = ch_flicker_get_integral_time (20.f, 1000.f);
+	g_assert_cmpfloat (fabs (ch_integral_time_to_ms (integral_time) - 420.f), <, 0.1f);
+	integral_time = ch_flicker_get_integral_time (1000.f, 50.f);
+	g_assert_cmpint (integral_time, ==, CH_INTEGRAL_TIME_VALUE_MAX);
+
+	/* 8 bit samples of PWM backlights and slow refresh rates */
+	for (j = 0; hz[j] > 0.f; j++) {
+		for (i = 0; i < G_N_ELEMENTS (samples); i++) {
+			samples[i] = floor (0xff * ch_test_flicker_get_light (1.f + i * interval,
+									      interval,
+									      1000.f / hz[j],
+									      duty[j]));
+		}
+		period = ch_flicker_estimate_period (samples,
+						     G_N_ELEMENTS (samples),
+						     interval);
+		g_debug ("%.0fHz: period %.3fms", hz[j], period);
+		g_assert_cmpfloat (fabs (period * hz[j] / 1000.f - 1.f), <, 0.01f);
+
+		/* readings are far more stable than with the old fixed time */
+		integral_time = ch_flicker_get_integral_time (period, 1000.f);
+		tuned = ch_test_flicker_get_noise (ch_integral_time_to_ms (integral_time),
+						   1000.f / hz[j], duty[j]);
+		g_assert_cmpfloat (tuned * 3, <,
+				   ch_test_flicker_get_noise (ch_integral_time_to_ms (CH_INTEGRAL_TIME_VALUE_MAX),
+							      1000.f / hz[j], duty[j]));
+	}
+}
+
+static void
+ch_test_flicker_emulate_func (void)
+{
+	gboolean ret;
+	gdouble mean = 0.f;
+	gdouble period;
+	gdouble samples[30];
+	gdouble var = 0.f;
+	guint16 integral_time;
+	guint32 readings[10];
+	guint8 reading_array[30];
+	guint i;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GPtrArray) devices = NULL;
+	g_autoptr(GUsbContext) usb_ctx = NULL;
+	g_autoptr(ChDeviceQueue) device_queue = NULL;
+	GUsbDevice *device;
+
+	/* any device will do, as the hardware is never touched */
+	usb_ctx = g_usb_context_new (NULL);
+	if (usb_ctx == NULL)
+		return;
+	devices = g_usb_context_get_devices (usb_ctx);
+	if (devices->len == 0) {
+		g_test_skip ("no USB devices to emulate with");
+		return;
+	}
+	device = g_ptr_array_index (devices, 0);
+	g_setenv ("COLORHUG_EMULATE", "1", TRUE);
+	g_setenv ("COLORHUG_EMULATE_FLICKER", "60:0.3", TRUE);
+
+	/* sample quickly */
+	device_queue = ch_device_queue_new ();
+	ch_device_queue_set_integral_time (device_queue, device,
+					   ch_integral_time_from_ms (3.f));
+	ch_device_queue_take_reading_array (device_queue, device, reading_array);
+	ret = ch_device_queue_process (device_queue,
+				       CH_DEVICE_QUEUE_PROCESS_FLAGS_NONE,
+				       NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	for (i = 0; i < G_N_ELEMENTS (samples); i++)
+		samples[i] = reading_array[i];
+	period = ch_flicker_estimate_period (samples, G_N_ELEMENTS (samples),
+					     ch_integral_time_to_ms (ch_integral_time_from_ms (3.f)));
+	g_assert_cmpfloat (fabs (period - 16.667f), <, 0.2f);
+
+	/* the readings should now not depend on the phase */
+	integral_time = ch_flicker_get_integral_time (period, 1000.f);
+	ch_device_queue_set_integral_time (device_queue, device, integral_time);
+	for (i = 0; i < G_N_ELEMENTS (readings); i++)
+		ch_device_queue_take_reading_raw (device_queue, device, &readings[i]);
+	ret = ch_device_queue_process (device_queue,
+				       CH_DEVICE_QUEUE_PROCESS_FLAGS_NONE,
+				       NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	for (i = 0; i < G_N_ELEMENTS (readings); i++)
+		mean += readings[i];
+	mean /= G_N_ELEMENTS (readings);
+	for (i = 0; i < G_N_ELEMENTS (readings); i++)
+		var += (readings[i] - mean) * (readings[i] - mean);
+	var /= G_N_ELEMENTS (readings);
+	g_debug ("%u readings: mean %.0f, relative noise %.5f",
+		 (guint) G_N_ELEMENTS (readings), mean, sqrt (var) / mean);
+	g_assert_cmpfloat (sqrt (var) / mean, <, 0.01f);
+
+	g_unsetenv ("COLORHUG_EMULATE_FLICKER");
+	g_unsetenv ("COLORHUG_EMULATE");
+}
+
+static guint
+ch_test_get_emulated_integration_time (GUsbDevice *device)
+{
+	return GPOINTER_TO_UINT (g_object_get_data (G_OBJECT (device),
+						    "ChDeviceEmulateIntegrationTime"));
+}
+
+static void
+ch_test_auto_range_func (void)
+{
+	CdColorXYZ xyz;
+	const gdouble target = 5.f;
+	gboolean ret;
+	gdouble err_auto;
+	gdouble err_fixed;
+	guint i;
+	guint time_auto = 0;
+	guint time_fixed = 0;
+	guint time_tmp;
+	guint16 integral_time = 0;
+	g_autofree gchar *filename = NULL;
+	g_autoptr(CdIt8) it8 = cd_it8_new ();
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GFile) file = NULL;
+	g_autoptr(GPtrArray) devices = NULL;
+	g_autoptr(GUsbContext) usb_ctx = NULL;
+	g_autoptr(ChDeviceQueue) device_queue = NULL;
+	GUsbDevice *device;
+
+	/* any device will do, as the hardware is never touched */
+	usb_ctx = g_usb_context_new (NULL);
+	if (usb_ctx == NULL)
+		return;
+	devices = g_usb_context_get_devices (usb_ctx);
+	if (devices->len == 0) {
+		g_test_skip ("no USB devices to emulate with");
+		return;
+	}
+	if (g_getenv ("TESTDATADIR") == NULL) {
+		g_test_skip ("no TESTDATADIR");
+		return;
+	}
+	device = g_ptr_array_index (devices, 0);
+	g_setenv ("COLORHUG_EMULATE", "1", TRUE);
+
+	/* the patches of a normal display profile */
+	filename = g_build_filename (g_getenv ("TESTDATADIR"), "display-normal.ti1", NULL);
+	file = g_file_new_for_path (filename);
+	ret = cd_it8_load_from_file (it8, file, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+
+	device_queue = ch_device_queue_new ();
+	for (i = 0; i < cd_it8_get_data_size (it8); i++) {
+		CdColorRGB rgb;
+		CdColorXYZ xyz_fixed;
+		CdColorXYZ xyz_patch;
+		g_autofree gchar *tmp = NULL;
+
+		/* an sRGB-like display where white is 100 */
+		ret = cd_it8_get_data_item (it8, i, &rgb, NULL);
+		g_assert (ret);
+		rgb.R = pow (rgb.R, 2.2f);
+		rgb.G = pow (rgb.G, 2.2f);
+		rgb.B = pow (rgb.B, 2.2f);
+		cd_color_xyz_set (&xyz_patch,
+				  0.5f + 41.24f * rgb.R + 35.76f * rgb.G + 18.05f * rgb.B,
+				  0.5f + 21.26f * rgb.R + 71.52f * rgb.G + 7.22f * rgb.B,
+				  0.5f + 1.93f * rgb.R + 11.92f * rgb.G + 95.05f * rgb.B);
+		tmp = g_strdup_printf ("%f,%f,%f", xyz_patch.X, xyz_patch.Y, xyz_patch.Z);
+		g_setenv ("COLORHUG_EMULATE_XYZ", tmp, TRUE);
+
+		/* the old way */
+		time_tmp = ch_test_get_emulated_integration_time (device);
+		ch_device_queue_set_integral_time (device_queue, device,
+						   CH_INTEGRAL_TIME_VALUE_MAX);
+		ch_device_queue_take_readings_xyz (device_queue, device,
+						   CH_CALIBRATION_INDEX_LCD,
+						   &xyz_fixed);
+		ret = ch_device_queue_process (device_queue,
+					       CH_DEVICE_QUEUE_PROCESS_FLAGS_NONE,
+					       NULL, &error);
+		g_assert_no_error (error);
+		g_assert (ret);
+		time_fixed += ch_test_get_emulated_integration_time (device) - time_tmp;
+
+		/* auto-ranged */
+		time_tmp = ch_test_get_emulated_integration_time (device);
+		ch_device_queue_take_readings_xyz_auto (device_queue, device,
+							CH_CALIBRATION_INDEX_LCD,
+							CH_INTEGRAL_TIME_VALUE_MAX,
+							0.f, target, &xyz);
+		ret = ch_device_queue_process (device_queue,
+					       CH_DEVICE_QUEUE_PROCESS_FLAGS_NONE,
+					       NULL, &error);
+		g_assert_no_error (error);
+		g_assert (ret);
+		time_auto += ch_test_get_emulated_integration_time (device) - time_tmp;
+
+		/* never worse than the target precision */
+		err_fixed = fabs (xyz_fixed.Y - xyz_patch.Y) / xyz_patch.Y;
+		err_auto = fabs (xyz.Y - xyz_patch.Y) / xyz_patch.Y;
+		g_assert_cmpfloat (err_auto, <=, MAX (err_fixed, 0.01f / target) + 0.0001f);
+	}
+	g_print ("%u patches: %.1fs fixed, %.1fs auto-ranged ",
+		 cd_it8_get_data_size (it8), time_fixed / 1e6, time_auto / 1e6);
+	g_assert_cmpint (time_auto, <, time_fixed / 2);
+
+	/* the integral time is put back */
+	ch_device_queue_get_integral_time (device_queue, device, &integral_time);
+	ret = ch_device_queue_process (device_queue,
+				       CH_DEVICE_QUEUE_PROCESS_FLAGS_NONE,
+				       NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpint (integral_time, ==, CH_INTEGRAL_TIME_VALUE_MAX);
+
+	g_unsetenv ("COLORHUG_EMULATE_XYZ");
+	g_unsetenv ("COLORHUG_EMULATE");
+}
+
 int
 main (int argc, char **argv)
 {
@@ -1264,6 +1820,7 @@ main (int argc, char **argv)
 
 	/* tests go here */
 	g_test_add_func ("/ColorHug/hash", ch_test_hash_func);
+	g_test_add_func ("/ColorHug/inhx32", ch_test_inhx32_func);
 	g_test_add_func ("/ColorHug/device-queue", ch_test_device_queue_func);
 	g_test_add_func ("/ColorHug/math-convert", ch_test_math_convert_func);
 	g_test_add_func ("/ColorHug/math-add", ch_test_math_add_func);
@@ -1274,6 +1831,11 @@ main (int argc, char **argv)
 	g_test_add_func ("/ColorHug/reading-xyz", ch_test_reading_xyz_func);
 	g_test_add_func ("/ColorHug/device-incomplete-request", ch_test_incomplete_request_func);
 	g_test_add_func ("/ColorHug/firmware", ch_test_firmware_func);
+	g_test_add_func ("/ColorHug/firmware-diff", ch_test_firmware_diff_func);
+	g_test_add_func ("/ColorHug/firmware-differential", ch_test_firmware_differential_func);
+	g_test_add_func ("/ColorHug/flicker", ch_test_flicker_func);
+	g_test_add_func ("/ColorHug/flicker-emulate", ch_test_flicker_emulate_func);
+	g_test_add_func ("/ColorHug/auto-range", ch_test_auto_range_func);
 
 	return g_test_run ();
 }
@@ -35,6 +35,53 @@
 
 #include "cd-compat-edid.h"
 
+/* the shared client is only ever used from cd_edid_context, which is
+ * iterated with cd_edid_client held */
+G_LOCK_DEFINE_STATIC (cd_edid_client);
+static CdClient *cd_edid_client = NULL;
+static GMainContext *cd_edid_context = NULL;
+static GHashTable *cd_edid_cache = NULL;	/* md5 : CdEdidCacheItem */
+static guint cd_edid_cache_generation = 0;
+static gint cd_edid_generation = 0;		/* atomic */
+
+typedef struct {
+	CdEdidError	 rc;
+	gchar		*filename;
+} CdEdidCacheItem;
+
+typedef struct {
+	GMainLoop	*loop;
+	guint		 pending;
+} CdEdidBatch;
+
+typedef struct {
+	CdEdidBatch	*batch;
+	gchar		*md5;
+	CdEdidError	 rc;
+	gchar		*filename;
+} CdEdidLookup;
+
+static void
+cd_edid_cache_item_free (CdEdidCacheItem *item)
+{
+	g_free (item->filename);
+	g_free (item);
+}
+
+static void
+cd_edid_lookup_free (CdEdidLookup *lookup)
+{
+	g_free (lookup->md5);
+	g_free (lookup->filename);
+	g_free (lookup);
+}
+
+static void
+cd_edid_invalidate (void)
+{
+	g_atomic_int_inc (&cd_edid_generation);
+}
+
 /**
  * cd_edid_install_profile:
  * @scope: where to install the profile, e.g. %CD_EDID_SCOPE_USER
@@ -170,6 +217,7 @@ cd_edid_install_profile (unsigned char *edid,
 			return CD_EDID_ERROR_PROFILE_COPY;
 		}
 	}
+	cd_edid_invalidate ();
 	return CD_EDID_ERROR_OK;
 }
 
@@ -266,90 +314,317 @@ cd_edid_remove_profile (unsigned char *edid,
 			    error->message);
 		return CD_EDID_ERROR_SET_CONFIG;
 	}
+	cd_edid_invalidate ();
 	return CD_EDID_ERROR_OK;
 }
 
+static void
+cd_edid_client_changed_cb (CdClient *client, gpointer object, gpointer user_data)
+{
+	cd_edid_invalidate ();
+}
+
+static void
+cd_edid_connect_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	GAsyncResult **result = (GAsyncResult **) user_data;
+	*result = g_object_ref (res);
+}
+
+/* called with cd_edid_client held */
+static CdClient *
+cd_edid_get_client (GError **error)
+{
+	g_autoptr(CdClient) client = NULL;
+	g_autoptr(GAsyncResult) res = NULL;
+
+	if (cd_edid_client != NULL)
+		return cd_edid_client;
+
+	/* everything is dispatched in a private context so that a lookup
+	 * never depends on the caller iterating the default one */
+	if (cd_edid_context == NULL) {
+		cd_edid_context = g_main_context_new ();
+		cd_edid_cache = g_hash_table_new_full (g_str_hash, g_str_equal,
+						       g_free,
+						       (GDestroyNotify) cd_edid_cache_item_free);
+	}
+	g_main_context_push_thread_default (cd_edid_context);
+
+	/* not cd_client_new(), as the application may have its own singleton
+	 * that is connected in the default context */
+	client = g_object_new (CD_TYPE_CLIENT, NULL);
+	cd_client_connect (client, NULL, cd_edid_connect_cb, &res);
+	while (res == NULL)
+		g_main_context_iteration (cd_edid_context, TRUE);
+	g_main_context_pop_thread_default (cd_edid_context);
+	if (!cd_client_connect_finish (client, res, error))
+		return NULL;
+
+	/* anything that could change the device to profile mapping */
+	g_signal_connect (client, "device-added",
+			  G_CALLBACK (cd_edid_client_changed_cb), NULL);
+	g_signal_connect (client, "device-removed",
+			  G_CALLBACK (cd_edid_client_changed_cb), NULL);
+	g_signal_connect (client, "device-changed",
+			  G_CALLBACK (cd_edid_client_changed_cb), NULL);
+	g_signal_connect (client, "profile-removed",
+			  G_CALLBACK (cd_edid_client_changed_cb), NULL);
+	g_signal_connect (client, "profile-changed",
+			  G_CALLBACK (cd_edid_client_changed_cb), NULL);
+	cd_edid_client = g_steal_pointer (&client);
+	cd_edid_invalidate ();
+	return cd_edid_client;
+}
+
+static void
+cd_edid_lookup_done (CdEdidLookup *lookup, CdEdidError rc)
+{
+	lookup->rc = rc;
+	if (--lookup->batch->pending == 0)
+		g_main_loop_quit (lookup->batch->loop);
+}
+
+static void
+cd_edid_profile_connect_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	CdEdidLookup *lookup = (CdEdidLookup *) user_data;
+	CdProfile *profile = CD_PROFILE (source);
+	g_autoptr(GError) error = NULL;
+
+	if (!cd_profile_connect_finish (profile, res, &error)) {
+		g_printerr ("profile disappeared: %s", error->message);
+		cd_edid_lookup_done (lookup, CD_EDID_ERROR_ACCESS_CONFIG);
+		return;
+	}
+	if (cd_profile_get_filename (profile) == NULL) {
+		cd_edid_lookup_done (lookup, CD_EDID_ERROR_INVALID_PROFILE);
+		return;
+	}
+	lookup->filename = g_strdup (cd_profile_get_filename (profile));
+	cd_edid_lookup_done (lookup, CD_EDID_ERROR_OK);
+}
+
+static void
+cd_edid_device_connect_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	CdEdidLookup *lookup = (CdEdidLookup *) user_data;
+	CdDevice *device = CD_DEVICE (source);
+	g_autoptr(CdProfile) profile = NULL;
+	g_autoptr(GError) error = NULL;
+
+	if (!cd_device_connect_finish (device, res, &error)) {
+		g_printerr ("device disappeared: %s", error->message);
+		cd_edid_lookup_done (lookup, CD_EDID_ERROR_ACCESS_CONFIG);
+		return;
+	}
+
+	/* get the default profile for the device */
+	profile = cd_device_get_default_profile (device);
+	if (profile == NULL) {
+		cd_edid_lookup_done (lookup, CD_EDID_ERROR_NO_PROFILE);
+		return;
+	}
+	cd_profile_connect (profile, NULL, cd_edid_profile_connect_cb, lookup);
+}
+
+static void
+cd_edid_find_device_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	CdEdidLookup *lookup = (CdEdidLookup *) user_data;
+	g_autoptr(CdDevice) device = NULL;
+	g_autoptr(GError) error = NULL;
+
+	device = cd_client_find_device_by_property_finish (CD_CLIENT (source),
+							   res, &error);
+	if (device == NULL) {
+		cd_edid_lookup_done (lookup, CD_EDID_ERROR_MONITOR_NOT_FOUND);
+		return;
+	}
+	cd_device_connect (device, NULL, cd_edid_device_connect_cb, lookup);
+}
+
 /**
- * cd_edid_get_profile:
- * @edid: the EDID data, typically just 128 bytes in size
- * @edid_len: the size in bytes of @edid_len
- * @profile_fn: the returned profile filename, use free() when done
+ * cd_edid_get_profiles:
+ * @edids: the EDID data for each output
+ * @edid_lens: the size in bytes of each of @edids
+ * @n_edids: the number of outputs
+ * @profile_fns: the returned profile filenames, or %NULL for none;
+ *  use free() on each when done
+ * @results: the %CdEdidError for each output
  *
- * Get an associated monitor profile.
+ * Get the associated monitor profiles for several outputs at once.
  *
- * Return value: a %CdEdidError, e.g. %CD_EDID_ERROR_OK
+ * The connection to the daemon is kept open between calls and the results
+ * are cached until the daemon reports that a device or profile has
+ * changed. Any outputs that are not cached are looked up in parallel.
  *
- * Since: 0.1.34
+ * Return value: a %CdEdidError, e.g. %CD_EDID_ERROR_OK if the daemon
+ *  could be queried, in which case the result for each output is set
+ *
+ * Since: 1.4.8
  **/
 CdEdidError
-cd_edid_get_profile (unsigned char *edid,
-		     int edid_len,
-		     char **profile_fn)
+cd_edid_get_profiles (unsigned char **edids,
+		      const int *edid_lens,
+		      int n_edids,
+		      char **profile_fns,
+		      CdEdidError *results)
 {
-	const gchar *filename;
-	gboolean ret;
+	CdClient *client;
+	CdEdidBatch batch = { NULL, 0 };
+	CdEdidError rc = CD_EDID_ERROR_OK;
+	guint generation;
 	g_autoptr(GError) error = NULL;
-	g_autofree gchar *md5 = NULL;
-	g_autoptr(CdClient) client = NULL;
-	g_autoptr(CdDevice) device = NULL;
-	g_autoptr(CdProfile) profile = NULL;
+	g_autoptr(GHashTable) lookups = NULL;
+	g_autoptr(GPtrArray) md5s = NULL;
+
+	g_return_val_if_fail (profile_fns != NULL, CD_EDID_ERROR_RESOURCE);
+	g_return_val_if_fail (results != NULL, CD_EDID_ERROR_RESOURCE);
 
 	/* bad input */
-	if (edid == NULL || edid_len == 0)
+	if (edids == NULL || edid_lens == NULL || n_edids <= 0)
 		return CD_EDID_ERROR_NO_DATA;
 
+	G_LOCK (cd_edid_client);
+
 	/* connect to daemon */
-	client = cd_client_new ();
-	ret = cd_client_connect_sync (client, NULL, &error);
-	if (!ret) {
+	client = cd_edid_get_client (&error);
+	if (client == NULL) {
 		g_printerr ("Failed to connect to colord: %s", error->message);
-		return CD_EDID_ERROR_ACCESS_CONFIG;
+		rc = CD_EDID_ERROR_ACCESS_CONFIG;
+		goto out;
 	}
 
-	/* find device that matches the output EDID */
-	md5 = g_compute_checksum_for_string (G_CHECKSUM_MD5,
-					     (const gchar *)edid,
-					     (gssize) edid_len);
-	device = cd_client_find_device_by_property_sync (client,
-							 CD_DEVICE_METADATA_OUTPUT_EDID_MD5,
-							 md5,
-							 NULL,
-							 &error);
-	if (device == NULL) {
-		g_printerr ("Failed to find device that matches %s: %s",
-			    md5, error->message);
-		return CD_EDID_ERROR_MONITOR_NOT_FOUND;
+	/* process any change signals before trusting the cache */
+	while (g_main_context_iteration (cd_edid_context, FALSE));
+	generation = (guint) g_atomic_int_get (&cd_edid_generation);
+	if (generation != cd_edid_cache_generation) {
+		g_hash_table_remove_all (cd_edid_cache);
+		cd_edid_cache_generation = generation;
 	}
 
-	/* read device properties */
-	ret = cd_device_connect_sync (device, NULL, &error);
-	if (!ret) {
-		g_printerr ("device disappeared: %s", error->message);
-		return CD_EDID_ERROR_ACCESS_CONFIG;
-	}
+	/* start a lookup for each output that is not cached */
+	lookups = g_hash_table_new_full (g_str_hash, g_str_equal, NULL,
+					 (GDestroyNotify) cd_edid_lookup_free);
+	md5s = g_ptr_array_new_with_free_func (g_free);
+	batch.loop = g_main_loop_new (cd_edid_context, FALSE);
+	g_main_context_push_thread_default (cd_edid_context);
+	for (gint i = 0; i < n_edids; i++) {
+		CdEdidLookup *lookup;
+		gchar *md5;
+
+		if (edids[i] == NULL || edid_lens[i] <= 0) {
+			g_ptr_array_add (md5s, NULL);
+			continue;
+		}
 
-	/* get the default profile for the device */
-	profile = cd_device_get_default_profile (device);
-	if (profile == NULL) {
-		g_printerr ("No profile for %s",
-			    cd_device_get_id (device));
-		return CD_EDID_ERROR_NO_PROFILE;
+		/* find device that matches the output EDID */
+		md5 = g_compute_checksum_for_data (G_CHECKSUM_MD5,
+						   edids[i],
+						   (gsize) edid_lens[i]);
+		g_ptr_array_add (md5s, md5);
+		if (g_hash_table_contains (cd_edid_cache, md5) ||
+		    g_hash_table_contains (lookups, md5))
+			continue;
+		lookup = g_new0 (CdEdidLookup, 1);
+		lookup->batch = &batch;
+		lookup->md5 = g_strdup (md5);
+		g_hash_table_insert (lookups, lookup->md5, lookup);
+		batch.pending++;
+		cd_client_find_device_by_property (client,
+						   CD_DEVICE_METADATA_OUTPUT_EDID_MD5,
+						   lookup->md5,
+						   NULL,
+						   cd_edid_find_device_cb,
+						   lookup);
+	}
+	if (batch.pending > 0)
+		g_main_loop_run (batch.loop);
+	g_main_context_pop_thread_default (cd_edid_context);
+	g_main_loop_unref (batch.loop);
+
+	/* save everything that is not a transient failure */
+	if (generation == (guint) g_atomic_int_get (&cd_edid_generation)) {
+		GHashTableIter iter;
+		CdEdidLookup *lookup;
+		g_hash_table_iter_init (&iter, lookups);
+		while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &lookup)) {
+			CdEdidCacheItem *item;
+			if (lookup->rc == CD_EDID_ERROR_ACCESS_CONFIG)
+				continue;
+			item = g_new0 (CdEdidCacheItem, 1);
+			item->rc = lookup->rc;
+			item->filename = g_strdup (lookup->filename);
+			g_hash_table_insert (cd_edid_cache,
+					     g_strdup (lookup->md5), item);
+		}
 	}
 
-	/* read profile properties */
-	ret = cd_profile_connect_sync (profile, NULL, &error);
-	if (!ret) {
-		g_printerr ("profile disappeared: %s", error->message);
-		return CD_EDID_ERROR_ACCESS_CONFIG;
+	/* return filename of each profile */
+	for (gint i = 0; i < n_edids; i++) {
+		const gchar *filename = NULL;
+		const gchar *md5 = g_ptr_array_index (md5s, i);
+		CdEdidCacheItem *item;
+		CdEdidLookup *lookup;
+
+		profile_fns[i] = NULL;
+		if (md5 == NULL) {
+			results[i] = CD_EDID_ERROR_NO_DATA;
+			continue;
+		}
+		lookup = g_hash_table_lookup (lookups, md5);
+		if (lookup != NULL) {
+			results[i] = lookup->rc;
+			filename = lookup->filename;
+		} else {
+			item = g_hash_table_lookup (cd_edid_cache, md5);
+			results[i] = item->rc;
+			filename = item->filename;
+		}
+		if (results[i] == CD_EDID_ERROR_MONITOR_NOT_FOUND)
+			g_printerr ("Failed to find device that matches %s", md5);
+		if (filename != NULL)
+			profile_fns[i] = strdup (filename);
 	}
+out:
+	G_UNLOCK (cd_edid_client);
+	return rc;
+}
 
-	/* get filename */
-	filename = cd_profile_get_filename (profile);
-	if (filename == NULL)
-		return CD_EDID_ERROR_INVALID_PROFILE;
+/**
+ * cd_edid_get_profile:
+ * @edid: the EDID data, typically just 128 bytes in size
+ * @edid_len: the size in bytes of @edid_len
+ * @profile_fn: the returned profile filename, use free() when done
+ *
+ * Get an associated monitor profile.
+ *
+ * Return value: a %CdEdidError, e.g. %CD_EDID_ERROR_OK
+ *
+ * Since: 0.1.34
+ **/
+CdEdidError
+cd_edid_get_profile (unsigned char *edid,
+		     int edid_len,
+		     char **profile_fn)
+{
+	CdEdidError rc;
+	CdEdidError result = CD_EDID_ERROR_OK;
+	char *filename = NULL;
+
+	/* bad input */
+	if (edid == NULL || edid_len <= 0)
+		return CD_EDID_ERROR_NO_DATA;
+
+	rc = cd_edid_get_profiles (&edid, &edid_len, 1, &filename, &result);
+	if (rc != CD_EDID_ERROR_OK)
+		return rc;
 
 	/* return filename of profile */
 	if (profile_fn != NULL)
-		*profile_fn = strdup (filename);
-	return CD_EDID_ERROR_OK;
+		*profile_fn = filename;
+	else
+		free (filename);
+	return result;
 }
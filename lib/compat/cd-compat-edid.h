@@ -77,6 +77,11 @@ CdEdidError	 cd_edid_remove_profile		(unsigned char	*edid,
 CdEdidError	 cd_edid_get_profile		(unsigned char	*edid,
 						 int		 edid_len,
 						 char		**profile_fn);
+CdEdidError	 cd_edid_get_profiles		(unsigned char	**edids,
+						 const int	*edid_lens,
+						 int		 n_edids,
+						 char		**profile_fns,
+						 CdEdidError	*results);
 
 G_END_DECLS
 
@@ -30,7 +30,12 @@ int
 main (int argc, char *argv[])
 {
 	CdEdidError rc;
+	CdEdidError results[2];
 	char *profile = NULL;
+	char *profiles[2];
+	int edid_lens[2];
+	int i;
+	unsigned char *edids[2];
 	gboolean ret;
 	gchar *edid;
 	GError *error = NULL;
@@ -54,5 +59,18 @@ main (int argc, char *argv[])
 	printf("Profile to use is %s\n", profile);
 	free(profile);
 
+	/* the same output twice, as when mirrored */
+	edids[0] = edids[1] = (unsigned char *) edid;
+	edid_lens[0] = edid_lens[1] = edid_len;
+	rc = cd_edid_get_profiles (edids, edid_lens, 2, profiles, results);
+	if (rc != CD_EDID_ERROR_OK) {
+		printf("Failed to get profiles, error is %i\n", rc);
+		return EXIT_FAILURE;
+	}
+	for (i = 0; i < 2; i++) {
+		printf("Profile %i is %s (%i)\n", i, profiles[i], results[i]);
+		free(profiles[i]);
+	}
+
 	return EXIT_SUCCESS;
 }
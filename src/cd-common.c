@@ -69,6 +69,21 @@ cd_main_get_sender_uid (GDBusConnection *connection,
 	guint uid = G_MAXUINT;
 	g_autoptr(GVariant) value = NULL;
 
+	/* a peer-to-peer connection has no bus daemon to ask */
+	if (sender == NULL) {
+		GCredentials *credentials;
+		credentials = g_dbus_connection_get_peer_credentials (connection);
+		if (credentials == NULL) {
+			g_set_error_literal (error,
+					     CD_CLIENT_ERROR,
+					     CD_CLIENT_ERROR_INTERNAL,
+					     "no peer credentials");
+			return G_MAXUINT;
+		}
+		uid = g_credentials_get_unix_user (credentials, error);
+		return uid != (guint) -1 ? uid : G_MAXUINT;
+	}
+
 	/* call into DBus to get the user ID that issued the request */
 	value = g_dbus_connection_call_sync (connection,
 					     "org.freedesktop.DBus",
@@ -95,6 +110,22 @@ cd_main_get_sender_pid (GDBusConnection *connection,
 	guint pid = G_MAXUINT;
 	g_autoptr(GVariant) value = NULL;
 
+	/* a peer-to-peer connection has no bus daemon to ask */
+	if (sender == NULL) {
+		GCredentials *credentials;
+		pid_t pid_tmp;
+		credentials = g_dbus_connection_get_peer_credentials (connection);
+		if (credentials == NULL) {
+			g_set_error_literal (error,
+					     CD_CLIENT_ERROR,
+					     CD_CLIENT_ERROR_INTERNAL,
+					     "no peer credentials");
+			return G_MAXUINT;
+		}
+		pid_tmp = g_credentials_get_unix_pid (credentials, error);
+		return pid_tmp != -1 ? (guint) pid_tmp : G_MAXUINT;
+	}
+
 	/* call into DBus to get the user ID that issued the request */
 	value = g_dbus_connection_call_sync (connection,
 					     "org.freedesktop.DBus",
@@ -165,7 +196,21 @@ cd_main_sender_authenticated (GDBusConnection *connection,
 	}
 
 	/* do authorization async */
-	subject = polkit_system_bus_name_new (sender);
+	if (sender == NULL) {
+		guint pid = cd_main_get_sender_pid (connection, NULL, &error_local);
+		if (pid == G_MAXUINT) {
+			g_set_error (error,
+				     CD_CLIENT_ERROR,
+				     CD_CLIENT_ERROR_FAILED_TO_AUTHENTICATE,
+				     "could not get pid to authenticate %s: %s",
+				     action_id,
+				     error_local->message);
+			return FALSE;
+		}
+		subject = polkit_unix_process_new_for_owner (pid, 0, uid);
+	} else {
+		subject = polkit_system_bus_name_new (sender);
+	}
 	result = polkit_authority_check_authorization_sync (authority, subject,
 			action_id,
 			NULL,
@@ -206,3 +251,217 @@ cd_main_mkdir_with_parents (const gchar *filename, GError **error)
 	}
 	return TRUE;
 }
+
+/* the string is stored inline after the refcount */
+typedef struct {
+	guint		 refcount;
+	gchar		 str[];
+} CdStringPoolItem;
+
+/* string:CdStringPoolItem, shared by every object in the daemon */
+static GHashTable *cd_string_pool = NULL;
+static guint cd_string_pool_refs = 0;
+static guint cd_string_pool_copies = 0;
+static gboolean cd_string_pool_disabled = FALSE;
+G_LOCK_DEFINE_STATIC (cd_string_pool);
+
+/* refcount of an unshared copy returned while the pool is disabled */
+#define CD_STRING_POOL_COPY		G_MAXUINT
+
+/*
+ * Only used by the self tests to compare against unshared strings; while
+ * disabled every call to cd_main_string_pool_intern() returns a new copy.
+ */
+void
+cd_main_string_pool_set_enabled (gboolean enabled)
+{
+	G_LOCK (cd_string_pool);
+	cd_string_pool_disabled = !enabled;
+	G_UNLOCK (cd_string_pool);
+}
+
+/*
+ * Returns a shared copy of @str which must be released using
+ * cd_main_string_pool_release() rather than g_free().
+ */
+const gchar *
+cd_main_string_pool_intern (const gchar *str)
+{
+	CdStringPoolItem *item;
+	gsize len;
+
+	if (str == NULL)
+		return NULL;
+
+	G_LOCK (cd_string_pool);
+	if (cd_string_pool_disabled) {
+		len = strlen (str);
+		item = g_malloc (sizeof (CdStringPoolItem) + len + 1);
+		item->refcount = CD_STRING_POOL_COPY;
+		memcpy (item->str, str, len + 1);
+		cd_string_pool_copies++;
+		G_UNLOCK (cd_string_pool);
+		return item->str;
+	}
+	if (cd_string_pool == NULL)
+		cd_string_pool = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, g_free);
+	item = g_hash_table_lookup (cd_string_pool, str);
+	if (item == NULL) {
+		len = strlen (str);
+		item = g_malloc (sizeof (CdStringPoolItem) + len + 1);
+		item->refcount = 0;
+		memcpy (item->str, str, len + 1);
+		g_hash_table_insert (cd_string_pool, item->str, item);
+	}
+	item->refcount++;
+	cd_string_pool_refs++;
+	G_UNLOCK (cd_string_pool);
+	return item->str;
+}
+
+void
+cd_main_string_pool_release (const gchar *str)
+{
+	CdStringPoolItem *item;
+
+	if (str == NULL)
+		return;
+
+	G_LOCK (cd_string_pool);
+	item = cd_string_pool != NULL ? g_hash_table_lookup (cd_string_pool, str) : NULL;
+	if ((item == NULL || item->str != str) && cd_string_pool_copies > 0) {
+		item = (CdStringPoolItem *) (str - G_STRUCT_OFFSET (CdStringPoolItem, str));
+		g_assert (item->refcount == CD_STRING_POOL_COPY);
+		cd_string_pool_copies--;
+		G_UNLOCK (cd_string_pool);
+		g_free (item);
+		return;
+	}
+	if (item == NULL) {
+		G_UNLOCK (cd_string_pool);
+		g_critical ("%s was not interned", str);
+		return;
+	}
+	cd_string_pool_refs--;
+	if (--item->refcount == 0)
+		g_hash_table_remove (cd_string_pool, str);
+	G_UNLOCK (cd_string_pool);
+}
+
+/* replaces the interned string at @ptr, which may be the same string */
+void
+cd_main_string_pool_set (const gchar **ptr, const gchar *str)
+{
+	const gchar *tmp = cd_main_string_pool_intern (str);
+	cd_main_string_pool_release (*ptr);
+	*ptr = tmp;
+}
+
+void
+cd_main_string_pool_get_stats (guint *strings, guint *refs, gsize *bytes)
+{
+	GHashTableIter iter;
+	gpointer key;
+	gsize bytes_tmp = 0;
+	guint strings_tmp = 0;
+
+	G_LOCK (cd_string_pool);
+	if (cd_string_pool != NULL) {
+		strings_tmp = g_hash_table_size (cd_string_pool);
+		g_hash_table_iter_init (&iter, cd_string_pool);
+		while (g_hash_table_iter_next (&iter, &key, NULL)) {
+			bytes_tmp += sizeof (CdStringPoolItem) + strlen (key) + 1;
+			bytes_tmp += CD_MAIN_HASH_TABLE_ENTRY_SIZE;
+		}
+	}
+	if (strings != NULL)
+		*strings = strings_tmp;
+	if (refs != NULL)
+		*refs = cd_string_pool_refs;
+	if (bytes != NULL)
+		*bytes = bytes_tmp;
+	G_UNLOCK (cd_string_pool);
+}
+
+/* keys and values are both interned */
+GHashTable *
+cd_main_string_pool_hash_new (void)
+{
+	return g_hash_table_new_full (g_str_hash, g_str_equal,
+				      (GDestroyNotify) cd_main_string_pool_release,
+				      (GDestroyNotify) cd_main_string_pool_release);
+}
+
+void
+cd_main_string_pool_hash_insert (GHashTable *hash,
+				 const gchar *key,
+				 const gchar *value)
+{
+	g_hash_table_insert (hash,
+			     (gpointer) cd_main_string_pool_intern (key),
+			     (gpointer) cd_main_string_pool_intern (value));
+}
+
+/* approximate, as the strings themselves are owned by the pool */
+gsize
+cd_main_string_pool_hash_get_size (GHashTable *hash)
+{
+	return sizeof (GHashTable) +
+		g_hash_table_size (hash) * CD_MAIN_HASH_TABLE_ENTRY_SIZE;
+}
+
+static gboolean cd_property_cache_disabled = FALSE;
+
+/*
+ * Only used by the self tests to benchmark against building every
+ * property again; while disabled nothing is added to any cache.
+ */
+void
+cd_main_property_cache_set_enabled (gboolean enabled)
+{
+	cd_property_cache_disabled = !enabled;
+}
+
+GHashTable *
+cd_main_property_cache_new (void)
+{
+	return g_hash_table_new_full (g_str_hash, g_str_equal,
+				      (GDestroyNotify) cd_main_string_pool_release,
+				      (GDestroyNotify) g_variant_unref);
+}
+
+/* returns a new reference, as GDBus takes ownership of the return value */
+GVariant *
+cd_main_property_cache_lookup (GHashTable *cache, const gchar *property_name)
+{
+	GVariant *value;
+	if (cd_property_cache_disabled)
+		return NULL;
+	value = g_hash_table_lookup (cache, property_name);
+	if (value == NULL)
+		return NULL;
+	return g_variant_ref (value);
+}
+
+GVariant *
+cd_main_property_cache_add (GHashTable *cache,
+			    const gchar *property_name,
+			    GVariant *value)
+{
+	if (cd_property_cache_disabled)
+		return g_variant_ref_sink (value);
+	g_hash_table_insert (cache,
+			     (gpointer) cd_main_string_pool_intern (property_name),
+			     g_variant_ref_sink (value));
+	return g_variant_ref (value);
+}
+
+void
+cd_main_property_cache_invalidate (GHashTable *cache, const gchar *property_name)
+{
+	if (property_name == NULL) {
+		g_hash_table_remove_all (cache);
+		return;
+	}
+	g_hash_table_remove (cache, property_name);
+}
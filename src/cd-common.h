@@ -40,6 +40,9 @@
 
 #define CD_CLIENT_ERROR			cd_client_error_quark()
 
+/* key, value and hash in the GHashTable arrays */
+#define CD_MAIN_HASH_TABLE_ENTRY_SIZE	(2 * sizeof (gpointer) + sizeof (guint))
+
 GQuark		 cd_client_error_quark		(void);
 gboolean	 cd_main_sender_authenticated	(GDBusConnection *connection,
 						 const gchar	*sender,
@@ -58,6 +61,28 @@ gchar		*cd_main_ensure_dbus_path	(const gchar	*object_path);
 gboolean	 cd_main_mkdir_with_parents	(const gchar	*filename,
 						 GError		**error)
 						 G_GNUC_WARN_UNUSED_RESULT;
+const gchar	*cd_main_string_pool_intern	(const gchar	*str);
+void		 cd_main_string_pool_release	(const gchar	*str);
+void		 cd_main_string_pool_set	(const gchar	**ptr,
+						 const gchar	*str);
+void		 cd_main_string_pool_set_enabled (gboolean	 enabled);
+void		 cd_main_string_pool_get_stats	(guint		*strings,
+						 guint		*refs,
+						 gsize		*bytes);
+GHashTable	*cd_main_string_pool_hash_new	(void);
+void		 cd_main_string_pool_hash_insert (GHashTable	*hash,
+						 const gchar	*key,
+						 const gchar	*value);
+gsize		 cd_main_string_pool_hash_get_size (GHashTable	*hash);
+void		 cd_main_property_cache_set_enabled (gboolean	 enabled);
+GHashTable	*cd_main_property_cache_new	(void);
+GVariant	*cd_main_property_cache_lookup	(GHashTable	*cache,
+						 const gchar	*property_name);
+GVariant	*cd_main_property_cache_add	(GHashTable	*cache,
+						 const gchar	*property_name,
+						 GVariant	*value);
+void		 cd_main_property_cache_invalidate (GHashTable	*cache,
+						 const gchar	*property_name);
 
 #endif /* __CD_COMMON_H__ */
 
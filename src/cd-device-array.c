@@ -157,6 +157,29 @@ cd_device_array_get_by_kind (CdDeviceArray *device_array,
 	return array_tmp;
 }
 
+void
+cd_device_array_get_memory_stats (CdDeviceArray *device_array,
+				  guint *count,
+				  gsize *bytes)
+{
+	CdDeviceArrayPrivate *priv = GET_PRIVATE (device_array);
+	CdDevice *device_tmp;
+	gsize bytes_tmp;
+	guint i;
+
+	g_return_if_fail (CD_IS_DEVICE_ARRAY (device_array));
+
+	bytes_tmp = sizeof (GPtrArray) + priv->array->len * sizeof (gpointer);
+	for (i = 0; i < priv->array->len; i++) {
+		device_tmp = g_ptr_array_index (priv->array, i);
+		bytes_tmp += cd_device_get_memory_size (device_tmp);
+	}
+	if (count != NULL)
+		*count = priv->array->len;
+	if (bytes != NULL)
+		*bytes = bytes_tmp;
+}
+
 static void
 cd_device_array_class_init (CdDeviceArrayClass *klass)
 {
@@ -60,6 +60,9 @@ CdDevice	*cd_device_array_get_by_property	(CdDeviceArray	*device_array,
 GPtrArray	*cd_device_array_get_array		(CdDeviceArray	*device_array);
 GPtrArray	*cd_device_array_get_by_kind		(CdDeviceArray	*device_array,
 							 CdDeviceKind	 kind);
+void		 cd_device_array_get_memory_stats	(CdDeviceArray	*device_array,
+							 guint		*count,
+							 gsize		*bytes);
 
 G_END_DECLS
 
@@ -36,6 +36,8 @@
 #include "cd-profile-array.h"
 #include "cd-profile.h"
 #include "cd-inhibit.h"
+#include "cd-quota.h"
+#include "cd-signal-scope.h"
 
 static void cd_device_finalize			 (GObject *object);
 static void cd_device_dbus_emit_property_changed (CdDevice *device,
@@ -53,12 +55,12 @@ typedef struct
 	CdDeviceDb			*device_db;
 	CdInhibit			*inhibit;
 	gchar				*id;
-	gchar				*model;
+	const gchar			*model;		/* interned */
 	gchar				*serial;
-	gchar				*vendor;
-	gchar				*colorspace;
-	gchar				*format;
-	gchar				*mode;
+	const gchar			*vendor;	/* interned */
+	const gchar			*colorspace;	/* interned */
+	const gchar			*format;	/* interned */
+	const gchar			*mode;		/* interned */
 	CdDeviceKind			 kind;
 	gchar				*object_path;
 	GDBusConnection			*connection;
@@ -74,6 +76,9 @@ typedef struct
 	GHashTable			*metadata;
 	guint				 owner;
 	gchar				*seat;
+	GHashTable			*property_cache;	/* name:GVariant */
+	CdSignalScope			*signal_scope;
+	CdQuota				*quota;
 } CdDevicePrivate;
 
 enum {
@@ -127,6 +132,8 @@ cd_device_set_scope (CdDevice *device, CdObjectScope object_scope)
 	CdDevicePrivate *priv = GET_PRIVATE (device);
 	g_return_if_fail (CD_IS_DEVICE (device));
 	priv->object_scope = object_scope;
+	cd_main_property_cache_invalidate (priv->property_cache,
+					   CD_DEVICE_PROPERTY_SCOPE);
 }
 
 guint
@@ -143,6 +150,8 @@ cd_device_set_owner (CdDevice *device, guint owner)
 	CdDevicePrivate *priv = GET_PRIVATE (device);
 	g_return_if_fail (CD_IS_DEVICE (device));
 	priv->owner = owner;
+	cd_main_property_cache_invalidate (priv->property_cache,
+					   CD_DEVICE_PROPERTY_OWNER);
 }
 
 const gchar *
@@ -159,6 +168,8 @@ cd_device_set_seat (CdDevice *device, const gchar *seat)
 	CdDevicePrivate *priv = GET_PRIVATE (device);
 	g_return_if_fail (CD_IS_DEVICE (device));
 	priv->seat = g_strdup (seat);
+	cd_main_property_cache_invalidate (priv->property_cache,
+					   CD_DEVICE_PROPERTY_SEAT);
 }
 
 static const gchar *
@@ -186,8 +197,9 @@ cd_device_set_mode (CdDevice *device, CdDeviceMode mode)
 {
 	CdDevicePrivate *priv = GET_PRIVATE (device);
 	g_return_if_fail (CD_IS_DEVICE (device));
-	g_free (priv->mode);
-	priv->mode = g_strdup (_cd_device_mode_to_string (mode));
+	cd_main_string_pool_set (&priv->mode, _cd_device_mode_to_string (mode));
+	cd_main_property_cache_invalidate (priv->property_cache,
+					   CD_DEVICE_PROPERTY_MODE);
 }
 
 CdDeviceMode
@@ -237,6 +249,8 @@ cd_device_set_kind (CdDevice *device, CdDeviceKind kind)
 	g_return_if_fail (CD_IS_DEVICE (device));
 	g_return_if_fail (kind != CD_DEVICE_KIND_UNKNOWN);
 	priv->kind = kind;
+	cd_main_property_cache_invalidate (priv->property_cache,
+					   CD_DEVICE_PROPERTY_KIND);
 }
 
 static void
@@ -290,6 +304,9 @@ cd_device_set_id (CdDevice *device, const gchar *id)
 	g_free (priv->id);
 	priv->id = g_strdup (id);
 
+	/* this also changes the enabled state */
+	cd_main_property_cache_invalidate (priv->property_cache, NULL);
+
 	/* now calculate this again */
 	cd_device_set_object_path (device);
 
@@ -313,6 +330,8 @@ cd_device_reset_modified (CdDevice *device)
 	g_debug ("CdDevice: set device Modified");
 	priv->modified = g_get_real_time ();
 	priv->require_modified_signal = TRUE;
+	cd_main_property_cache_invalidate (priv->property_cache,
+					   CD_DEVICE_PROPERTY_MODIFIED);
 }
 
 static void
@@ -324,6 +343,9 @@ cd_device_dbus_emit_property_changed (CdDevice *device,
 	GVariantBuilder builder;
 	GVariantBuilder invalidated_builder;
 
+	/* the value has changed */
+	cd_main_property_cache_invalidate (priv->property_cache, property_name);
+
 	/* not yet connected */
 	if (priv->connection == NULL)
 		return;
@@ -342,16 +364,18 @@ cd_device_dbus_emit_property_changed (CdDevice *device,
 				       g_variant_new_uint64 (priv->modified));
 		priv->require_modified_signal = FALSE;
 	}
-	g_dbus_connection_emit_signal (priv->connection,
-				       NULL,
-				       priv->object_path,
-				       "org.freedesktop.DBus.Properties",
-				       "PropertiesChanged",
-				       g_variant_new ("(sa{sv}as)",
-				       COLORD_DBUS_INTERFACE_DEVICE,
-				       &builder,
-				       &invalidated_builder),
-				       NULL);
+	cd_signal_scope_emit (priv->signal_scope,
+			      priv->connection,
+			      priv->object_path,
+			      "org.freedesktop.DBus.Properties",
+			      "PropertiesChanged",
+			      g_variant_new ("(sa{sv}as)",
+			      COLORD_DBUS_INTERFACE_DEVICE,
+			      &builder,
+			      &invalidated_builder),
+			      priv->seat,
+			      priv->owner,
+			      NULL);
 	g_variant_builder_clear (&builder);
 	g_variant_builder_clear (&invalidated_builder);
 }
@@ -368,24 +392,28 @@ cd_device_dbus_emit_device_changed (CdDevice *device)
 	/* emit signal */
 	g_debug ("CdDevice: emit Changed on %s",
 		 cd_device_get_object_path (device));
-	g_dbus_connection_emit_signal (priv->connection,
-				       NULL,
-				       cd_device_get_object_path (device),
-				       COLORD_DBUS_INTERFACE_DEVICE,
-				       "Changed",
-				       NULL,
-				       NULL);
+	cd_signal_scope_emit (priv->signal_scope,
+			      priv->connection,
+			      cd_device_get_object_path (device),
+			      COLORD_DBUS_INTERFACE_DEVICE,
+			      "Changed",
+			      NULL,
+			      priv->seat,
+			      priv->owner,
+			      NULL);
 
 	/* emit signal */
 	g_debug ("CdDevice: emit Changed");
-	g_dbus_connection_emit_signal (priv->connection,
-				       NULL,
-				       COLORD_DBUS_PATH,
-				       COLORD_DBUS_INTERFACE,
-				       "DeviceChanged",
-				       g_variant_new ("(o)",
-							    cd_device_get_object_path (device)),
-				       NULL);
+	cd_signal_scope_emit (priv->signal_scope,
+			      priv->connection,
+			      COLORD_DBUS_PATH,
+			      COLORD_DBUS_INTERFACE,
+			      "DeviceChanged",
+			      g_variant_new ("(o)",
+					     cd_device_get_object_path (device)),
+			      priv->seat,
+			      priv->owner,
+			      NULL);
 }
 
 static gboolean
@@ -769,8 +797,10 @@ static void
 cd_device_set_vendor (CdDevice *device, const gchar *vendor)
 {
 	CdDevicePrivate *priv = GET_PRIVATE (device);
-	g_free (priv->vendor);
-	priv->vendor = cd_quirk_vendor_name (vendor);
+	g_autofree gchar *tmp = cd_quirk_vendor_name (vendor);
+	cd_main_string_pool_set (&priv->vendor, tmp);
+	cd_main_property_cache_invalidate (priv->property_cache,
+					   CD_DEVICE_PROPERTY_VENDOR);
 }
 
 static void
@@ -791,8 +821,10 @@ cd_device_set_model (CdDevice *device, const gchar *model)
 	}
 
 	/* okay, we're done now */
-	g_free (priv->model);
-	priv->model = g_string_free (tmp, FALSE);
+	cd_main_string_pool_set (&priv->model, tmp->str);
+	g_string_free (tmp, TRUE);
+	cd_main_property_cache_invalidate (priv->property_cache,
+					   CD_DEVICE_PROPERTY_MODEL);
 }
 
 static GVariant *
@@ -811,6 +843,8 @@ cd_device_set_serial (CdDevice *device, const gchar *value)
 
 	/* CUPS likes to hand us a serial with a URI prepended */
 	g_free (priv->serial);
+	cd_main_property_cache_invalidate (priv->property_cache,
+					   CD_DEVICE_PROPERTY_SERIAL);
 	tmp = g_strstr_len (value, -1, "?serial=");
 	if (tmp != NULL) {
 		priv->serial = g_strdup (tmp + 8);
@@ -856,14 +890,11 @@ cd_device_set_property_internal (CdDevice *device,
 	} else if (g_strcmp0 (property, CD_DEVICE_PROPERTY_SERIAL) == 0) {
 		cd_device_set_serial (device, value);
 	} else if (g_strcmp0 (property, CD_DEVICE_PROPERTY_COLORSPACE) == 0) {
-		g_free (priv->colorspace);
-		priv->colorspace = g_strdup (value);
+		cd_main_string_pool_set (&priv->colorspace, value);
 	} else if (g_strcmp0 (property, CD_DEVICE_PROPERTY_FORMAT) == 0) {
-		g_free (priv->format);
-		priv->format = g_strdup (value);
+		cd_main_string_pool_set (&priv->format, value);
 	} else if (g_strcmp0 (property, CD_DEVICE_PROPERTY_MODE) == 0) {
-		g_free (priv->mode);
-		priv->mode = g_strdup (value);
+		cd_main_string_pool_set (&priv->mode, value);
 	} else if (g_strcmp0 (property, CD_DEVICE_PROPERTY_SEAT) == 0) {
 		g_free (priv->seat);
 		priv->seat = g_strdup (value);
@@ -872,9 +903,7 @@ cd_device_set_property_internal (CdDevice *device,
 	} else {
 		/* add to metadata */
 		is_metadata = TRUE;
-		g_hash_table_insert (priv->metadata,
-				     g_strdup (property),
-				     g_strdup (value));
+		cd_main_string_pool_hash_insert (priv->metadata, property, value);
 		cd_device_dbus_emit_property_changed (device,
 						      CD_DEVICE_PROPERTY_METADATA,
 						      cd_device_get_metadata_as_variant (device));
@@ -910,6 +939,33 @@ cd_device_get_metadata (CdDevice *device, const gchar *key)
 	return g_hash_table_lookup (priv->metadata, key);
 }
 
+static gsize
+cd_device_strsize (const gchar *str)
+{
+	return str != NULL ? strlen (str) + 1 : 0;
+}
+
+/* approximate, not including the interned strings or the profiles */
+gsize
+cd_device_get_memory_size (CdDevice *device)
+{
+	CdDevicePrivate *priv = GET_PRIVATE (device);
+	gsize bytes;
+
+	g_return_val_if_fail (CD_IS_DEVICE (device), 0);
+
+	bytes = sizeof (CdDevice) + sizeof (CdDevicePrivate);
+	bytes += cd_device_strsize (priv->id);
+	bytes += cd_device_strsize (priv->serial);
+	bytes += cd_device_strsize (priv->seat);
+	bytes += cd_device_strsize (priv->object_path);
+	bytes += sizeof (GPtrArray) +
+		 priv->profiles->len * (sizeof (gpointer) + sizeof (CdDeviceProfileItem));
+	bytes += cd_main_string_pool_hash_get_size (priv->metadata);
+	bytes += cd_main_string_pool_hash_get_size (priv->property_cache);
+	return bytes;
+}
+
 gboolean
 cd_device_make_default (CdDevice *device,
 		        const gchar *profile_object_path,
@@ -1020,6 +1076,20 @@ cd_device_dbus_method_call (GDBusConnection *connection, const gchar *sender,
 	guint i = 0;
 	g_autoptr(GError) error = NULL;
 
+	/* stop one sender flooding the daemon with changes */
+	if (g_strcmp0 (method_name, "AddProfile") == 0 ||
+	    g_strcmp0 (method_name, "RemoveProfile") == 0 ||
+	    g_strcmp0 (method_name, "MakeProfileDefault") == 0 ||
+	    g_strcmp0 (method_name, "SetEnabled") == 0 ||
+	    g_strcmp0 (method_name, "SetProperty") == 0 ||
+	    g_strcmp0 (method_name, "ProfilingInhibit") == 0) {
+		ret = cd_quota_check_rate (priv->quota, connection, sender, &error);
+		if (!ret) {
+			g_dbus_method_invocation_return_gerror (invocation, error);
+			return;
+		}
+	}
+
 	/* return '' */
 	if (g_strcmp0 (method_name, "AddProfile") == 0) {
 
@@ -1416,12 +1486,10 @@ cd_device_inhibit_changed_cb (CdInhibit *inhibit,
 }
 
 static GVariant *
-cd_device_dbus_get_property (GDBusConnection *connection_, const gchar *sender,
-			     const gchar *object_path, const gchar *interface_name,
-			     const gchar *property_name, GError **error,
-			     gpointer user_data)
+cd_device_dbus_get_property_uncached (CdDevice *device,
+				      const gchar *property_name,
+				      GError **error)
 {
-	CdDevice *device = CD_DEVICE (user_data);
 	CdDevicePrivate *priv = GET_PRIVATE (device);
 	g_auto(GStrv) bus_names = NULL;
 
@@ -1473,27 +1541,53 @@ cd_device_dbus_get_property (GDBusConnection *connection_, const gchar *sender,
 	return NULL;
 }
 
-gboolean
-cd_device_register_object (CdDevice *device,
-			   GDBusConnection *connection,
-			   GDBusInterfaceInfo *info,
-			   GError **error)
+static GVariant *
+cd_device_dbus_get_property (GDBusConnection *connection_, const gchar *sender,
+			     const gchar *object_path, const gchar *interface_name,
+			     const gchar *property_name, GError **error,
+			     gpointer user_data)
 {
+	CdDevice *device = CD_DEVICE (user_data);
 	CdDevicePrivate *priv = GET_PRIVATE (device);
-	g_autoptr(GError) error_local = NULL;
+	GVariant *value;
 
+	/* only serialize the value again if it has changed */
+	value = cd_main_property_cache_lookup (priv->property_cache, property_name);
+	if (value != NULL)
+		return value;
+	value = cd_device_dbus_get_property_uncached (device, property_name, error);
+	if (value == NULL)
+		return NULL;
+	return cd_main_property_cache_add (priv->property_cache, property_name, value);
+}
+
+/* also used for the peer-to-peer connections */
+const GDBusInterfaceVTable *
+cd_device_get_interface_vtable (void)
+{
 	static const GDBusInterfaceVTable interface_vtable = {
 		cd_device_dbus_method_call,
 		cd_device_dbus_get_property,
 		NULL
 	};
+	return &interface_vtable;
+}
+
+gboolean
+cd_device_register_object (CdDevice *device,
+			   GDBusConnection *connection,
+			   GDBusInterfaceInfo *info,
+			   GError **error)
+{
+	CdDevicePrivate *priv = GET_PRIVATE (device);
+	g_autoptr(GError) error_local = NULL;
 
 	priv->connection = connection;
 	priv->registration_id = g_dbus_connection_register_object (
 		connection,
 		priv->object_path,
 		info,
-		&interface_vtable,
+		cd_device_get_interface_vtable (),
 		device,  /* user_data */
 		NULL,  /* user_data_free_func */
 		&error_local); /* GError** */
@@ -1624,6 +1718,9 @@ cd_device_init (CdDevice *device)
 {
 	CdDevicePrivate *priv = GET_PRIVATE (device);
 	priv->profiles = g_ptr_array_new_with_free_func ((GDestroyNotify) cd_device_profiles_item_free);
+	priv->property_cache = cd_main_property_cache_new ();
+	priv->signal_scope = cd_signal_scope_new ();
+	priv->quota = cd_quota_new ();
 	priv->profile_array = cd_profile_array_new ();
 	priv->created = g_get_real_time ();
 	priv->modified = g_get_real_time ();
@@ -1634,10 +1731,7 @@ cd_device_init (CdDevice *device)
 			  "changed",
 			  G_CALLBACK (cd_device_inhibit_changed_cb),
 			  device);
-	priv->metadata = g_hash_table_new_full (g_str_hash,
-							 g_str_equal,
-							 g_free,
-							 g_free);
+	priv->metadata = cd_main_string_pool_hash_new ();
 }
 
 static void
@@ -1656,11 +1750,11 @@ cd_device_finalize (GObject *object)
 						     priv->registration_id);
 	}
 	g_free (priv->id);
-	g_free (priv->model);
-	g_free (priv->vendor);
-	g_free (priv->colorspace);
-	g_free (priv->format);
-	g_free (priv->mode);
+	cd_main_string_pool_release (priv->model);
+	cd_main_string_pool_release (priv->vendor);
+	cd_main_string_pool_release (priv->colorspace);
+	cd_main_string_pool_release (priv->format);
+	cd_main_string_pool_release (priv->mode);
 	g_free (priv->serial);
 	g_free (priv->seat);
 	g_free (priv->object_path);
@@ -1670,6 +1764,9 @@ cd_device_finalize (GObject *object)
 	g_object_unref (priv->device_db);
 	g_object_unref (priv->inhibit);
 	g_hash_table_unref (priv->metadata);
+	g_hash_table_unref (priv->property_cache);
+	g_object_unref (priv->signal_scope);
+	g_object_unref (priv->quota);
 
 	G_OBJECT_CLASS (cd_device_parent_class)->finalize (object);
 }
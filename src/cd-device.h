@@ -83,6 +83,7 @@ gboolean	 cd_device_register_object		(CdDevice	*device,
 							 GDBusInterfaceInfo *info,
 							 GError		**error)
 							 G_GNUC_WARN_UNUSED_RESULT;
+const GDBusInterfaceVTable *cd_device_get_interface_vtable (void);
 void		 cd_device_watch_sender			(CdDevice	*device,
 							 const gchar	*sender);
 gboolean	 cd_device_set_property_internal	(CdDevice	*device,
@@ -92,6 +93,7 @@ gboolean	 cd_device_set_property_internal	(CdDevice	*device,
 							 GError		**error);
 const gchar	*cd_device_get_metadata			(CdDevice	*device,
 							 const gchar	*key);
+gsize		 cd_device_get_memory_size		(CdDevice	*device);
 
 G_END_DECLS
 
@@ -22,7 +22,9 @@
 #include "config.h"
 
 #include <stdlib.h>
+#include <string.h>
 #include <gio/gio.h>
+#include <glib/gstdio.h>
 #ifdef __unix__
 #include <gio/gunixfdlist.h>
 #endif
@@ -45,6 +47,9 @@
 #include "cd-profile.h"
 #include "cd-icc-store.h"
 #include "cd-sensor-client.h"
+#include "cd-sensor-registry.h"
+#include "cd-quota.h"
+#include "cd-signal-scope.h"
 
 #include "colord-resources.h"
 
@@ -61,8 +66,14 @@ typedef struct {
 	CdDeviceDb		*device_db;
 	CdProfileDb		*profile_db;
 	CdSensorClient		*sensor_client;
+	CdSensorRegistry	*sensor_registry;
+	CdSignalScope		*signal_scope;
+	CdQuota			*quota;
 	GPtrArray		*sensors;
 	GPtrArray		*plugins;
+	GDBusServer		*peer_server;
+	GPtrArray		*peer_connections;
+	gchar			*peer_socket;
 	GMainLoop		*loop;
 	gboolean		 create_dummy_sensor;
 	gboolean		 always_use_xrandr_name;
@@ -82,6 +93,7 @@ cd_main_profile_removed (CdMainPrivate *priv, CdProfile *profile)
 	/* remove from the array before emitting */
 	object_path_tmp = g_strdup (cd_profile_get_object_path (profile));
 	cd_profile_array_remove (priv->profiles_array, profile);
+	cd_quota_remove_object (priv->quota, object_path_tmp);
 
 	/* try to remove this profile from all devices */
 	devices = cd_device_array_get_array (priv->devices_array);
@@ -103,14 +115,16 @@ cd_main_profile_removed (CdMainPrivate *priv, CdProfile *profile)
 	/* emit signal */
 	g_debug ("CdMain: Emitting ProfileRemoved(%s)", object_path_tmp);
 	g_info ("Profile removed: %s", cd_profile_get_id (profile));
-	g_dbus_connection_emit_signal (priv->connection,
-				       NULL,
-				       COLORD_DBUS_PATH,
-				       COLORD_DBUS_INTERFACE,
-				       "ProfileRemoved",
-				       g_variant_new ("(o)",
-						      object_path_tmp),
-				       NULL);
+	cd_signal_scope_emit (priv->signal_scope,
+			      priv->connection,
+			      COLORD_DBUS_PATH,
+			      COLORD_DBUS_INTERFACE,
+			      "ProfileRemoved",
+			      g_variant_new ("(o)",
+					     object_path_tmp),
+			      NULL,
+			      cd_profile_get_owner (profile),
+			      NULL);
 }
 
 static void
@@ -135,6 +149,7 @@ cd_main_device_removed (CdMainPrivate *priv, CdDevice *device)
 	object_path_tmp = g_strdup (cd_device_get_object_path (device));
 	g_debug ("CdMain: Removing device %s", object_path_tmp);
 	cd_device_array_remove (priv->devices_array, device);
+	cd_quota_remove_object (priv->quota, object_path_tmp);
 
 	/* remove from the device database */
 	if (cd_device_get_scope (device) == CD_OBJECT_SCOPE_DISK) {
@@ -152,14 +167,16 @@ cd_main_device_removed (CdMainPrivate *priv, CdDevice *device)
 	/* emit signal */
 	g_debug ("CdMain: Emitting DeviceRemoved(%s)", object_path_tmp);
 	g_info ("device removed: %s", cd_device_get_id (device));
-	g_dbus_connection_emit_signal (priv->connection,
-				       NULL,
-				       COLORD_DBUS_PATH,
-				       COLORD_DBUS_INTERFACE,
-				       "DeviceRemoved",
-				       g_variant_new ("(o)",
-						      object_path_tmp),
-				       &error);
+	cd_signal_scope_emit (priv->signal_scope,
+			      priv->connection,
+			      COLORD_DBUS_PATH,
+			      COLORD_DBUS_INTERFACE,
+			      "DeviceRemoved",
+			      g_variant_new ("(o)",
+					     object_path_tmp),
+			      cd_device_get_seat (device),
+			      cd_device_get_owner (device),
+			      &error);
 }
 
 static void
@@ -428,14 +445,16 @@ cd_main_device_register_on_bus (CdMainPrivate *priv,
 	g_debug ("CdMain: Emitting DeviceAdded(%s)",
 		 cd_device_get_object_path (device));
 	g_info ("Device added: %s", cd_device_get_id (device));
-	g_dbus_connection_emit_signal (priv->connection,
-				       NULL,
-				       COLORD_DBUS_PATH,
-				       COLORD_DBUS_INTERFACE,
-				       "DeviceAdded",
-				       g_variant_new ("(o)",
-						      cd_device_get_object_path (device)),
-				       NULL);
+	cd_signal_scope_emit (priv->signal_scope,
+			      priv->connection,
+			      COLORD_DBUS_PATH,
+			      COLORD_DBUS_INTERFACE,
+			      "DeviceAdded",
+			      g_variant_new ("(o)",
+					     cd_device_get_object_path (device)),
+			      cd_device_get_seat (device),
+			      cd_device_get_owner (device),
+			      NULL);
 	return TRUE;
 }
 
@@ -717,14 +736,16 @@ cd_main_profile_register_on_bus (CdMainPrivate *priv,
 		 cd_profile_get_object_path (profile));
 	if ((logging & CD_LOGGING_FLAG_SYSLOG) > 0)
 		g_info ("Profile added: %s", cd_profile_get_id (profile));
-	g_dbus_connection_emit_signal (priv->connection,
-				       NULL,
-				       COLORD_DBUS_PATH,
-				       COLORD_DBUS_INTERFACE,
-				       "ProfileAdded",
-				       g_variant_new ("(o)",
-						      cd_profile_get_object_path (profile)),
-				       NULL);
+	cd_signal_scope_emit (priv->signal_scope,
+			      priv->connection,
+			      COLORD_DBUS_PATH,
+			      COLORD_DBUS_INTERFACE,
+			      "ProfileAdded",
+			      g_variant_new ("(o)",
+					     cd_profile_get_object_path (profile)),
+			      NULL,
+			      cd_profile_get_owner (profile),
+			      NULL);
 	return TRUE;
 }
 
@@ -857,6 +878,19 @@ cd_main_daemon_method_call (GDBusConnection *connection, const gchar *sender,
 		return;
 	}
 
+	/* stop one sender flooding the daemon with changes */
+	if (g_strcmp0 (method_name, "CreateDevice") == 0 ||
+	    g_strcmp0 (method_name, "DeleteDevice") == 0 ||
+	    g_strcmp0 (method_name, "CreateProfile") == 0 ||
+	    g_strcmp0 (method_name, "CreateProfileWithFd") == 0 ||
+	    g_strcmp0 (method_name, "DeleteProfile") == 0) {
+		ret = cd_quota_check_rate (priv->quota, connection, sender, &error);
+		if (!ret) {
+			g_dbus_method_invocation_return_gerror (invocation, error);
+			return;
+		}
+	}
+
 	/* return 'as' */
 	if (g_strcmp0 (method_name, "GetDevices") == 0) {
 
@@ -882,6 +916,48 @@ cd_main_daemon_method_call (GDBusConnection *connection, const gchar *sender,
 		return;
 	}
 
+	/* return 'a(sut)' */
+	if (g_strcmp0 (method_name, "GetMemoryStats") == 0) {
+		GTypeQuery query;
+		GVariantBuilder builder;
+		gsize bytes = 0;
+		guint count = 0;
+
+		g_debug ("CdMain: %s:GetMemoryStats()", sender);
+
+		g_variant_builder_init (&builder, G_VARIANT_TYPE ("a(sut)"));
+		cd_device_array_get_memory_stats (priv->devices_array,
+						  &count, &bytes);
+		g_variant_builder_add (&builder, "(sut)",
+				       "devices", count, (guint64) bytes);
+		cd_profile_array_get_memory_stats (priv->profiles_array,
+						   &count, &bytes);
+		g_variant_builder_add (&builder, "(sut)",
+				       "profiles", count, (guint64) bytes);
+		g_type_query (CD_TYPE_SENSOR, &query);
+		g_variant_builder_add (&builder, "(sut)",
+				       "sensors", priv->sensors->len,
+				       (guint64) priv->sensors->len * query.instance_size);
+		cd_main_string_pool_get_stats (&count, NULL, &bytes);
+		g_variant_builder_add (&builder, "(sut)",
+				       "string-pool", count, (guint64) bytes);
+		g_dbus_method_invocation_return_value (invocation,
+						       g_variant_new ("(a(sut))", &builder));
+		return;
+	}
+
+	/* return 'a(suuu)' */
+	if (g_strcmp0 (method_name, "GetSenderStats") == 0) {
+
+		g_debug ("CdMain: %s:GetSenderStats()", sender);
+
+		/* format the value */
+		value = cd_quota_get_variant (priv->quota);
+		tuple = g_variant_new_tuple (&value, 1);
+		g_dbus_method_invocation_return_value (invocation, tuple);
+		return;
+	}
+
 	/* return 'as' */
 	if (g_strcmp0 (method_name, "GetDevicesByKind") == 0) {
 
@@ -1209,6 +1285,16 @@ cd_main_daemon_method_call (GDBusConnection *connection, const gchar *sender,
 			}
 		}
 
+		/* check the sender is allowed another object */
+		if (register_on_bus) {
+			ret = cd_quota_check_objects (priv->quota, sender, &error);
+			if (!ret) {
+				g_dbus_method_invocation_return_gerror (invocation,
+									error);
+				return;
+			}
+		}
+
 		/* get the process that sent the message */
 		pid = cd_main_get_sender_pid (connection, sender, &error);
 		if (pid == G_MAXUINT) {
@@ -1282,6 +1368,8 @@ cd_main_daemon_method_call (GDBusConnection *connection, const gchar *sender,
 									error);
 				return;
 			}
+			cd_quota_add_object (priv->quota, sender,
+					     cd_device_get_object_path (device));
 		}
 
 		/* format the value */
@@ -1334,6 +1422,39 @@ cd_main_daemon_method_call (GDBusConnection *connection, const gchar *sender,
 	}
 
 	/* return 's' */
+	if (g_strcmp0 (method_name, "RegisterSignalScope") == 0) {
+
+		/* only send signals this client cares about */
+		g_variant_get (parameters, "(@a{sv})", &dict);
+		g_debug ("CdMain: %s:RegisterSignalScope()", sender);
+		ret = cd_signal_scope_add_peer (priv->signal_scope,
+						connection,
+						sender,
+						dict,
+						&error);
+		if (!ret) {
+			g_dbus_method_invocation_return_gerror (invocation, error);
+			return;
+		}
+		g_dbus_method_invocation_return_value (invocation, NULL);
+		return;
+	}
+
+	if (g_strcmp0 (method_name, "UnregisterSignalScope") == 0) {
+
+		g_debug ("CdMain: %s:UnregisterSignalScope()", sender);
+		if (!cd_signal_scope_remove_peer (priv->signal_scope, sender)) {
+			g_dbus_method_invocation_return_error (invocation,
+							       CD_CLIENT_ERROR,
+							       CD_CLIENT_ERROR_NOT_FOUND,
+							       "no scope registered for %s",
+							       sender);
+			return;
+		}
+		g_dbus_method_invocation_return_value (invocation, NULL);
+		return;
+	}
+
 	if (g_strcmp0 (method_name, "DeleteProfile") == 0) {
 
 		/* require auth */
@@ -1444,6 +1565,11 @@ cd_main_daemon_method_call (GDBusConnection *connection, const gchar *sender,
 							       scope_tmp);
 			return;
 		}
+		ret = cd_quota_check_objects (priv->quota, sender, &error);
+		if (!ret) {
+			g_dbus_method_invocation_return_gerror (invocation, error);
+			return;
+		}
 		profile = cd_main_create_profile (priv,
 						  sender,
 						  device_id,
@@ -1541,6 +1667,8 @@ cd_main_daemon_method_call (GDBusConnection *connection, const gchar *sender,
 			g_dbus_method_invocation_return_gerror (invocation, error);
 			return;
 		}
+		cd_quota_add_object (priv->quota, sender,
+				     cd_profile_get_object_path (profile));
 
 		/* format the value */
 		value = g_variant_new_object_path (cd_profile_get_object_path (profile));
@@ -1601,6 +1729,362 @@ cd_main_on_bus_acquired_cb (GDBusConnection *connection,
 	g_assert (registration_id > 0);
 }
 
+/* only methods that do not change any state are exported to peers */
+static gboolean
+cd_main_peer_method_allowed (const gchar *method_name)
+{
+	if (g_str_has_prefix (method_name, "Find"))
+		return TRUE;
+	if (g_strcmp0 (method_name, "GetSample") == 0 ||
+	    g_strcmp0 (method_name, "GetSpectrum") == 0)
+		return FALSE;
+	return g_str_has_prefix (method_name, "Get");
+}
+
+static void
+cd_main_peer_method_call (GDBusConnection *connection, const gchar *sender,
+			  const gchar *object_path, const gchar *interface_name,
+			  const gchar *method_name, GVariant *parameters,
+			  GDBusMethodInvocation *invocation, gpointer user_data)
+{
+	if (!cd_main_peer_method_allowed (method_name)) {
+		g_dbus_method_invocation_return_error (invocation,
+						       CD_CLIENT_ERROR,
+						       CD_CLIENT_ERROR_NOT_SUPPORTED,
+						       "%s is only available on the system bus",
+						       method_name);
+		return;
+	}
+	cd_main_daemon_method_call (connection, sender, object_path,
+				    interface_name, method_name, parameters,
+				    invocation, user_data);
+}
+
+static const GDBusInterfaceVTable *
+cd_main_peer_get_object_vtable (GObject *object)
+{
+	if (CD_IS_DEVICE (object))
+		return cd_device_get_interface_vtable ();
+	if (CD_IS_PROFILE (object))
+		return cd_profile_get_interface_vtable ();
+	return cd_sensor_get_interface_vtable ();
+}
+
+static void
+cd_main_peer_object_method_call (GDBusConnection *connection, const gchar *sender,
+				 const gchar *object_path, const gchar *interface_name,
+				 const gchar *method_name, GVariant *parameters,
+				 GDBusMethodInvocation *invocation, gpointer user_data)
+{
+	const GDBusInterfaceVTable *vtable;
+	if (!cd_main_peer_method_allowed (method_name)) {
+		g_dbus_method_invocation_return_error (invocation,
+						       CD_CLIENT_ERROR,
+						       CD_CLIENT_ERROR_NOT_SUPPORTED,
+						       "%s is only available on the system bus",
+						       method_name);
+		return;
+	}
+	vtable = cd_main_peer_get_object_vtable (G_OBJECT (user_data));
+	vtable->method_call (connection, sender, object_path,
+			     interface_name, method_name, parameters,
+			     invocation, user_data);
+}
+
+static GVariant *
+cd_main_peer_object_get_property (GDBusConnection *connection, const gchar *sender,
+				  const gchar *object_path, const gchar *interface_name,
+				  const gchar *property_name, GError **error,
+				  gpointer user_data)
+{
+	const GDBusInterfaceVTable *vtable;
+	vtable = cd_main_peer_get_object_vtable (G_OBJECT (user_data));
+	return vtable->get_property (connection, sender, object_path,
+				     interface_name, property_name, error,
+				     user_data);
+}
+
+/* the object is owned by the device, profile or sensor array */
+static GObject *
+cd_main_peer_find_object (CdMainPrivate *priv,
+			  const gchar *object_path,
+			  GDBusInterfaceInfo **info)
+{
+	CdSensor *sensor_tmp;
+	guint i;
+	g_autoptr(CdDevice) device = NULL;
+	g_autoptr(CdProfile) profile = NULL;
+
+	device = cd_device_array_get_by_object_path (priv->devices_array,
+						     object_path);
+	if (device != NULL) {
+		*info = priv->introspection_device->interfaces[0];
+		return G_OBJECT (device);
+	}
+	profile = cd_profile_array_get_by_object_path (priv->profiles_array,
+						       object_path);
+	if (profile != NULL) {
+		*info = priv->introspection_profile->interfaces[0];
+		return G_OBJECT (profile);
+	}
+	for (i = 0; i < priv->sensors->len; i++) {
+		sensor_tmp = g_ptr_array_index (priv->sensors, i);
+		if (g_strcmp0 (cd_sensor_get_object_path (sensor_tmp), object_path) == 0) {
+			*info = priv->introspection_sensor->interfaces[0];
+			return G_OBJECT (sensor_tmp);
+		}
+	}
+	return NULL;
+}
+
+static void
+cd_main_peer_enumerate_add (GPtrArray *nodes,
+			    const gchar *object_path,
+			    const gchar *object_path_child)
+{
+	gsize len = strlen (object_path);
+	if (strncmp (object_path_child, object_path, len) != 0)
+		return;
+	if (object_path_child[len] != '/')
+		return;
+	g_ptr_array_add (nodes, g_strdup (object_path_child + len + 1));
+}
+
+static gchar **
+cd_main_peer_subtree_enumerate (GDBusConnection *connection,
+				const gchar *sender,
+				const gchar *object_path,
+				gpointer user_data)
+{
+	CdMainPrivate *priv = (CdMainPrivate *) user_data;
+	GPtrArray *nodes = g_ptr_array_new ();
+	guint i;
+	g_autoptr(GPtrArray) devices = NULL;
+	g_autoptr(GPtrArray) profiles = NULL;
+
+	devices = cd_device_array_get_array (priv->devices_array);
+	for (i = 0; i < devices->len; i++) {
+		CdDevice *device_tmp = g_ptr_array_index (devices, i);
+		cd_main_peer_enumerate_add (nodes, object_path,
+					    cd_device_get_object_path (device_tmp));
+	}
+	profiles = cd_profile_array_get_array (priv->profiles_array);
+	for (i = 0; i < profiles->len; i++) {
+		CdProfile *profile_tmp = g_ptr_array_index (profiles, i);
+		cd_main_peer_enumerate_add (nodes, object_path,
+					    cd_profile_get_object_path (profile_tmp));
+	}
+	for (i = 0; i < priv->sensors->len; i++) {
+		CdSensor *sensor_tmp = g_ptr_array_index (priv->sensors, i);
+		cd_main_peer_enumerate_add (nodes, object_path,
+					    cd_sensor_get_object_path (sensor_tmp));
+	}
+	g_ptr_array_add (nodes, NULL);
+	return (gchar **) g_ptr_array_free (nodes, FALSE);
+}
+
+static GDBusInterfaceInfo **
+cd_main_peer_subtree_introspect (GDBusConnection *connection,
+				 const gchar *sender,
+				 const gchar *object_path,
+				 const gchar *node,
+				 gpointer user_data)
+{
+	CdMainPrivate *priv = (CdMainPrivate *) user_data;
+	GDBusInterfaceInfo *info = NULL;
+	GDBusInterfaceInfo **infos;
+	g_autofree gchar *object_path_child = NULL;
+
+	if (node == NULL)
+		return NULL;
+	object_path_child = g_build_path ("/", object_path, node, NULL);
+	if (cd_main_peer_find_object (priv, object_path_child, &info) == NULL)
+		return NULL;
+	infos = g_new0 (GDBusInterfaceInfo *, 2);
+	infos[0] = g_dbus_interface_info_ref (info);
+	return infos;
+}
+
+static const GDBusInterfaceVTable *
+cd_main_peer_subtree_dispatch (GDBusConnection *connection,
+			       const gchar *sender,
+			       const gchar *object_path,
+			       const gchar *interface_name,
+			       const gchar *node,
+			       gpointer *out_user_data,
+			       gpointer user_data)
+{
+	CdMainPrivate *priv = (CdMainPrivate *) user_data;
+	GDBusInterfaceInfo *info = NULL;
+	GObject *object;
+	g_autofree gchar *object_path_child = NULL;
+	static const GDBusInterfaceVTable interface_vtable = {
+		cd_main_peer_object_method_call,
+		cd_main_peer_object_get_property,
+		NULL
+	};
+
+	if (node == NULL)
+		return NULL;
+	object_path_child = g_build_path ("/", object_path, node, NULL);
+	object = cd_main_peer_find_object (priv, object_path_child, &info);
+	if (object == NULL)
+		return NULL;
+	if (g_strcmp0 (info->name, interface_name) != 0)
+		return NULL;
+	*out_user_data = object;
+	return &interface_vtable;
+}
+
+static void
+cd_main_peer_closed_cb (GDBusConnection *connection,
+			gboolean remote_peer_vanished,
+			GError *error,
+			gpointer user_data)
+{
+	CdMainPrivate *priv = (CdMainPrivate *) user_data;
+	g_debug ("CdMain: peer connection closed");
+	g_ptr_array_remove (priv->peer_connections, connection);
+}
+
+static gboolean
+cd_main_peer_new_connection_cb (GDBusServer *server,
+				GDBusConnection *connection,
+				gpointer user_data)
+{
+	CdMainPrivate *priv = (CdMainPrivate *) user_data;
+	const gchar *subtrees[] = { "devices", "profiles", "sensors", NULL };
+	guint i;
+	g_autoptr(GError) error = NULL;
+	static const GDBusInterfaceVTable interface_vtable = {
+		cd_main_peer_method_call,
+		cd_main_daemon_get_property,
+		NULL
+	};
+	static const GDBusSubtreeVTable subtree_vtable = {
+		cd_main_peer_subtree_enumerate,
+		cd_main_peer_subtree_introspect,
+		cd_main_peer_subtree_dispatch
+	};
+
+	/* export the same object tree as on the system bus */
+	if (g_dbus_connection_register_object (connection,
+					       COLORD_DBUS_PATH,
+					       priv->introspection_daemon->interfaces[0],
+					       &interface_vtable,
+					       priv,  /* user_data */
+					       NULL,  /* user_data_free_func */
+					       &error) == 0) {
+		g_warning ("CdMain: failed to register peer object: %s",
+			   error->message);
+		return FALSE;
+	}
+	for (i = 0; subtrees[i] != NULL; i++) {
+		g_autofree gchar *object_path = NULL;
+		object_path = g_build_path ("/", COLORD_DBUS_PATH, subtrees[i], NULL);
+		if (g_dbus_connection_register_subtree (connection,
+							object_path,
+							&subtree_vtable,
+							G_DBUS_SUBTREE_FLAGS_DISPATCH_TO_UNENUMERATED_NODES,
+							priv,  /* user_data */
+							NULL,  /* user_data_free_func */
+							&error) == 0) {
+			g_warning ("CdMain: failed to register peer subtree: %s",
+				   error->message);
+			return FALSE;
+		}
+	}
+
+	/* keep the connection alive until the peer goes away */
+	g_signal_connect (connection, "closed",
+			  G_CALLBACK (cd_main_peer_closed_cb), priv);
+	g_ptr_array_add (priv->peer_connections, g_object_ref (connection));
+	g_debug ("CdMain: new peer connection");
+	return TRUE;
+}
+
+static gboolean
+cd_main_peer_allow_mechanism_cb (GDBusAuthObserver *observer,
+				 const gchar *mechanism,
+				 gpointer user_data)
+{
+	/* only trust credentials that come from the kernel */
+	return g_strcmp0 (mechanism, "EXTERNAL") == 0;
+}
+
+static gboolean
+cd_main_peer_authorize_cb (GDBusAuthObserver *observer,
+			   GIOStream *stream,
+			   GCredentials *credentials,
+			   gpointer user_data)
+{
+	uid_t uid;
+	g_autoptr(GError) error = NULL;
+
+	/* these are from SO_PEERCRED, and are used for each method call */
+	if (credentials == NULL) {
+		g_debug ("CdMain: refusing peer with no credentials");
+		return FALSE;
+	}
+	uid = g_credentials_get_unix_user (credentials, &error);
+	if (uid == (uid_t) -1) {
+		g_debug ("CdMain: refusing peer: %s", error->message);
+		return FALSE;
+	}
+	g_debug ("CdMain: authorized peer with uid %u", (guint) uid);
+	return TRUE;
+}
+
+static gboolean
+cd_main_peer_server_start (CdMainPrivate *priv,
+			   const gchar *socket_path,
+			   GError **error)
+{
+	g_autofree gchar *address = NULL;
+	g_autofree gchar *dirname = NULL;
+	g_autofree gchar *escaped = NULL;
+	g_autofree gchar *guid = NULL;
+	g_autoptr(GDBusAuthObserver) observer = NULL;
+
+	/* remove any socket left over from a previous instance */
+	dirname = g_path_get_dirname (socket_path);
+	if (!cd_main_mkdir_with_parents (dirname, error))
+		return FALSE;
+	g_unlink (socket_path);
+
+	observer = g_dbus_auth_observer_new ();
+	g_signal_connect (observer, "allow-mechanism",
+			  G_CALLBACK (cd_main_peer_allow_mechanism_cb), priv);
+	g_signal_connect (observer, "authorize-authenticated-peer",
+			  G_CALLBACK (cd_main_peer_authorize_cb), priv);
+	escaped = g_dbus_address_escape_value (socket_path);
+	address = g_strdup_printf ("unix:path=%s", escaped);
+	guid = g_dbus_generate_guid ();
+	priv->peer_server = g_dbus_server_new_sync (address,
+						    G_DBUS_SERVER_FLAGS_NONE,
+						    guid,
+						    observer,
+						    NULL,
+						    error);
+	if (priv->peer_server == NULL)
+		return FALSE;
+	g_signal_connect (priv->peer_server, "new-connection",
+			  G_CALLBACK (cd_main_peer_new_connection_cb), priv);
+	g_dbus_server_start (priv->peer_server);
+
+	/* any local user can connect, as the credentials are checked per-call */
+	if (g_chmod (socket_path, 0666) < 0) {
+		g_set_error (error,
+			     CD_CLIENT_ERROR,
+			     CD_CLIENT_ERROR_INTERNAL,
+			     "failed to set permissions on %s",
+			     socket_path);
+		return FALSE;
+	}
+	g_debug ("CdMain: listening for peers on %s", socket_path);
+	return TRUE;
+}
+
 static void
 cd_main_icc_store_added_cb (CdIccStore *icc_store,
 			    CdIcc *icc,
@@ -1763,14 +2247,16 @@ cd_main_sensor_register_on_bus (CdMainPrivate *priv,
 	g_debug ("CdMain: Emitting SensorAdded(%s)",
 		 cd_sensor_get_object_path (sensor));
 	g_info ("Sensor added: %s", cd_sensor_get_id (sensor));
-	g_dbus_connection_emit_signal (priv->connection,
-				       NULL,
-				       COLORD_DBUS_PATH,
-				       COLORD_DBUS_INTERFACE,
-				       "SensorAdded",
-				       g_variant_new ("(o)",
-						      cd_sensor_get_object_path (sensor)),
-				       NULL);
+	cd_signal_scope_emit (priv->signal_scope,
+			      priv->connection,
+			      COLORD_DBUS_PATH,
+			      COLORD_DBUS_INTERFACE,
+			      "SensorAdded",
+			      g_variant_new ("(o)",
+					     cd_sensor_get_object_path (sensor)),
+			      NULL,
+			      0,
+			      NULL);
 	return TRUE;
 }
 
@@ -1923,6 +2409,16 @@ cd_main_on_name_acquired_cb (GDBusConnection *connection,
 			cd_main_add_sensor (priv, sensor);
 		}
 	}
+
+	/* let trusted local clients skip the bus daemon */
+	if (priv->peer_socket != NULL && priv->peer_socket[0] != '\0') {
+		ret = cd_main_peer_server_start (priv, priv->peer_socket, &error);
+		if (!ret) {
+			g_warning ("CdMain: failed to start peer server: %s",
+				    error->message);
+			g_clear_error (&error);
+		}
+	}
 }
 
 static void
@@ -1956,14 +2452,16 @@ cd_main_client_sensor_removed_cb (CdSensorClient *sensor_client_,
 	g_debug ("CdMain: Emitting SensorRemoved(%s)",
 		 cd_sensor_get_object_path (sensor));
 	g_info ("Sensor removed: %s", cd_sensor_get_id (sensor));
-	g_dbus_connection_emit_signal (priv->connection,
-				       NULL,
-				       COLORD_DBUS_PATH,
-				       COLORD_DBUS_INTERFACE,
-				       "SensorRemoved",
-				       g_variant_new ("(o)",
-						      cd_sensor_get_object_path (sensor)),
-				       NULL);
+	cd_signal_scope_emit (priv->signal_scope,
+			      priv->connection,
+			      COLORD_DBUS_PATH,
+			      COLORD_DBUS_INTERFACE,
+			      "SensorRemoved",
+			      g_variant_new ("(o)",
+					     cd_sensor_get_object_path (sensor)),
+			      NULL,
+			      0,
+			      NULL);
 	g_ptr_array_remove (priv->sensors, sensor);
 }
 
@@ -2346,6 +2844,13 @@ main (int argc, char *argv[])
 	gboolean create_dummy_sensor = FALSE;
 	gboolean ret;
 	gboolean timed_exit = FALSE;
+	gdouble sender_rate = 0.f;
+	gint sender_burst = 0;
+	gint sender_max_objects = 0;
+	g_autofree gchar *database_dir = NULL;
+	g_autofree gchar *mapping_db = NULL;
+	g_autofree gchar *peer_socket = NULL;
+	g_autofree gchar *storage_db = NULL;
 	GOptionContext *context;
 	guint owner_id = 0;
 	guint retval = 1;
@@ -2359,6 +2864,21 @@ main (int argc, char *argv[])
 		{ "create-dummy-sensor", '\0', 0, G_OPTION_ARG_NONE, &create_dummy_sensor,
 		  /* TRANSLATORS: exit straight away, used for automatic profiling */
 		  _("Create a dummy sensor for testing"), NULL },
+		{ "peer-socket", '\0', 0, G_OPTION_ARG_FILENAME, &peer_socket,
+		  /* TRANSLATORS: clients can connect here without using the bus */
+		  _("Socket for direct client connections, or empty to disable"), NULL },
+		{ "database-dir", '\0', 0, G_OPTION_ARG_FILENAME, &database_dir,
+		  /* TRANSLATORS: where the device and profile databases are kept */
+		  _("Directory for the databases, used for testing"), NULL },
+		{ "sender-rate", '\0', 0, G_OPTION_ARG_DOUBLE, &sender_rate,
+		  /* TRANSLATORS: rate limit for each client, 0 is unlimited */
+		  _("Changes each client can make per second"), NULL },
+		{ "sender-burst", '\0', 0, G_OPTION_ARG_INT, &sender_burst,
+		  /* TRANSLATORS: changes allowed back-to-back before the rate applies */
+		  _("Changes each client can make in a burst"), NULL },
+		{ "sender-max-objects", '\0', 0, G_OPTION_ARG_INT, &sender_max_objects,
+		  /* TRANSLATORS: 0 is unlimited */
+		  _("Devices and profiles each client can create"), NULL },
 		{ NULL}
 	};
 	g_autoptr(GError) error = NULL;
@@ -2385,9 +2905,15 @@ main (int argc, char *argv[])
 	/* create new objects */
 	priv = g_new0 (CdMainPrivate, 1);
 	priv->create_dummy_sensor = create_dummy_sensor;
+	priv->peer_socket = g_strdup (peer_socket != NULL ? peer_socket : CD_PEER_SOCKET);
+	priv->peer_connections = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
 	priv->loop = g_main_loop_new (NULL, FALSE);
 	priv->devices_array = cd_device_array_new ();
 	priv->profiles_array = cd_profile_array_new ();
+	priv->signal_scope = cd_signal_scope_new ();
+	priv->quota = cd_quota_new ();
+	cd_quota_set_rate (priv->quota, MAX (sender_rate, 0.f), MAX (sender_burst, 0));
+	cd_quota_set_max_objects (priv->quota, MAX (sender_max_objects, 0));
 	priv->sensors = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
 	priv->sensor_client = cd_sensor_client_new ();
 	g_signal_connect (priv->sensor_client, "sensor-added",
@@ -2397,11 +2923,23 @@ main (int argc, char *argv[])
 			  G_CALLBACK (cd_main_client_sensor_removed_cb),
 			  priv);
 
+	/* open the sensor drivers once, rather than for each hotplug */
+	priv->sensor_registry = cd_sensor_registry_new ();
+	if (!cd_sensor_registry_load (priv->sensor_registry,
+				      LIBDIR "/colord-sensors",
+				      &error)) {
+		g_warning ("CdMain: failed to load sensor drivers: %s",
+			   error->message);
+		g_clear_error (&error);
+	}
+
 	/* connect to the mapping db */
+	if (database_dir == NULL)
+		database_dir = g_build_filename (LOCALSTATEDIR, "lib", "colord", NULL);
+	mapping_db = g_build_filename (database_dir, "mapping.db", NULL);
+	storage_db = g_build_filename (database_dir, "storage.db", NULL);
 	priv->mapping_db = cd_mapping_db_new ();
-	ret = cd_mapping_db_load (priv->mapping_db,
-				  LOCALSTATEDIR "/lib/colord/mapping.db",
-				  &error);
+	ret = cd_mapping_db_load (priv->mapping_db, mapping_db, &error);
 	if (!ret) {
 		g_warning ("CdMain: failed to load mapping database: %s",
 			   error->message);
@@ -2410,9 +2948,7 @@ main (int argc, char *argv[])
 
 	/* connect to the device db */
 	priv->device_db = cd_device_db_new ();
-	ret = cd_device_db_load (priv->device_db,
-				 LOCALSTATEDIR "/lib/colord/storage.db",
-				 &error);
+	ret = cd_device_db_load (priv->device_db, storage_db, &error);
 	if (!ret) {
 		g_warning ("CdMain: failed to load device database: %s",
 			   error->message);
@@ -2421,9 +2957,7 @@ main (int argc, char *argv[])
 
 	/* connect to the profile db */
 	priv->profile_db = cd_profile_db_new ();
-	ret = cd_profile_db_load (priv->profile_db,
-				  LOCALSTATEDIR "/lib/colord/storage.db",
-				  &error);
+	ret = cd_profile_db_load (priv->profile_db, storage_db, &error);
 	if (!ret) {
 		g_warning ("CdMain: failed to load profile database: %s",
 			   error->message);
@@ -2518,8 +3052,18 @@ out:
 			g_ptr_array_unref (priv->sensors);
 		if (priv->plugins != NULL)
 			g_ptr_array_unref (priv->plugins);
+		if (priv->peer_server != NULL) {
+			g_dbus_server_stop (priv->peer_server);
+			g_object_unref (priv->peer_server);
+			g_unlink (priv->peer_socket);
+		}
+		if (priv->peer_connections != NULL)
+			g_ptr_array_unref (priv->peer_connections);
+		g_free (priv->peer_socket);
 		if (priv->sensor_client != NULL)
 			g_object_unref (priv->sensor_client);
+		if (priv->sensor_registry != NULL)
+			g_object_unref (priv->sensor_registry);
 		if (priv->icc_store != NULL)
 			g_object_unref (priv->icc_store);
 		if (priv->mapping_db != NULL)
@@ -2532,6 +3076,10 @@ out:
 			g_object_unref (priv->devices_array);
 		if (priv->profiles_array != NULL)
 			g_object_unref (priv->profiles_array);
+		if (priv->signal_scope != NULL)
+			g_object_unref (priv->signal_scope);
+		if (priv->quota != NULL)
+			g_object_unref (priv->quota);
 		if (priv->connection != NULL)
 			g_object_unref (priv->connection);
 		if (priv->introspection_daemon != NULL)
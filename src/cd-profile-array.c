@@ -213,6 +213,13 @@ cd_profile_array_get_by_object_path (CdProfileArray *profile_array,
 	return profile;
 }
 
+GPtrArray *
+cd_profile_array_get_array (CdProfileArray *profile_array)
+{
+	CdProfileArrayPrivate *priv = GET_PRIVATE (profile_array);
+	return g_ptr_array_ref (priv->array);
+}
+
 GVariant *
 cd_profile_array_get_variant (CdProfileArray *profile_array)
 {
@@ -234,6 +241,29 @@ cd_profile_array_get_variant (CdProfileArray *profile_array)
 				    priv->array->len);
 }
 
+void
+cd_profile_array_get_memory_stats (CdProfileArray *profile_array,
+				   guint *count,
+				   gsize *bytes)
+{
+	CdProfileArrayPrivate *priv = GET_PRIVATE (profile_array);
+	CdProfile *profile_tmp;
+	gsize bytes_tmp;
+	guint i;
+
+	g_return_if_fail (CD_IS_PROFILE_ARRAY (profile_array));
+
+	bytes_tmp = sizeof (GPtrArray) + priv->array->len * sizeof (gpointer);
+	for (i = 0; i < priv->array->len; i++) {
+		profile_tmp = g_ptr_array_index (priv->array, i);
+		bytes_tmp += cd_profile_get_memory_size (profile_tmp);
+	}
+	if (count != NULL)
+		*count = priv->array->len;
+	if (bytes != NULL)
+		*bytes = bytes_tmp;
+}
+
 static void
 cd_profile_array_class_init (CdProfileArrayClass *klass)
 {
@@ -57,7 +57,11 @@ GPtrArray	*cd_profile_array_get_by_kind		(CdProfileArray	*profile_array,
 GPtrArray	*cd_profile_array_get_by_metadata	(CdProfileArray	*profile_array,
 							 const gchar	*key,
 							 const gchar	*value);
+GPtrArray	*cd_profile_array_get_array		(CdProfileArray	*profile_array);
 GVariant	*cd_profile_array_get_variant		(CdProfileArray	*profile_array);
+void		 cd_profile_array_get_memory_stats	(CdProfileArray	*profile_array,
+							 guint		*count,
+							 gsize		*bytes);
 
 G_END_DECLS
 
@@ -34,6 +34,8 @@
 #include "cd-common.h"
 #include "cd-profile.h"
 #include "cd-profile-db.h"
+#include "cd-quota.h"
+#include "cd-signal-scope.h"
 
 #include "colord-resources.h"
 
@@ -49,8 +51,8 @@ typedef struct
 	gchar				*filename;
 	gchar				*id;
 	gchar				*object_path;
-	gchar				*qualifier;
-	gchar				*format;
+	const gchar			*qualifier;	/* interned */
+	const gchar			*format;	/* interned */
 	gchar				*checksum;
 	gchar				*title;
 	GDBusConnection			*connection;
@@ -67,6 +69,9 @@ typedef struct
 	GMappedFile			*mapped_file;
 	guint				 score;
 	CdProfileDb			*db;
+	GHashTable			*property_cache;	/* name:GVariant */
+	CdSignalScope			*signal_scope;
+	CdQuota				*quota;
 } CdProfilePrivate;
 
 enum {
@@ -117,6 +122,8 @@ cd_profile_set_scope (CdProfile *profile, CdObjectScope object_scope)
 	CdProfilePrivate *priv = GET_PRIVATE (profile);
 	g_return_if_fail (CD_IS_PROFILE (profile));
 	priv->object_scope = object_scope;
+	cd_main_property_cache_invalidate (priv->property_cache,
+					   CD_PROFILE_PROPERTY_SCOPE);
 }
 
 guint
@@ -133,6 +140,8 @@ cd_profile_set_owner (CdProfile *profile, guint owner)
 	CdProfilePrivate *priv = GET_PRIVATE (profile);
 	g_return_if_fail (CD_IS_PROFILE (profile));
 	priv->owner = owner;
+	cd_main_property_cache_invalidate (priv->property_cache,
+					   CD_PROFILE_PROPERTY_OWNER);
 }
 
 void
@@ -141,6 +150,8 @@ cd_profile_set_is_system_wide (CdProfile *profile, gboolean is_system_wide)
 	CdProfilePrivate *priv = GET_PRIVATE (profile);
 	g_return_if_fail (CD_IS_PROFILE (profile));
 	priv->is_system_wide = is_system_wide;
+	cd_main_property_cache_invalidate (priv->property_cache,
+					   CD_PROFILE_PROPERTY_IS_SYSTEM_WIDE);
 
 	/* by default, prefer systemwide profiles over user profiles */
 	priv->score += 1;
@@ -219,9 +230,9 @@ cd_profile_set_metadata (CdProfile *profile,
 	/* i1Profiler sets this */
 	if (g_strcmp0 (property, "CreatorApp") == 0)
 		property = CD_PROFILE_METADATA_CMF_PRODUCT;
-	g_hash_table_insert (priv->metadata,
-			     g_strdup (property),
-			     g_strdup (value));
+	cd_main_string_pool_hash_insert (priv->metadata, property, value);
+	cd_main_property_cache_invalidate (priv->property_cache,
+					   CD_PROFILE_PROPERTY_METADATA);
 }
 
 void
@@ -235,6 +246,8 @@ cd_profile_set_id (CdProfile *profile, const gchar *id)
 
 	g_free (priv->id);
 	priv->id = g_strdup (id);
+	cd_main_property_cache_invalidate (priv->property_cache,
+					   CD_PROFILE_PROPERTY_ID);
 
 	/* all profiles have a score initially */
 	priv->score = 1;
@@ -307,6 +320,9 @@ cd_profile_dbus_emit_property_changed (CdProfile *profile,
 	GVariantBuilder builder;
 	GVariantBuilder invalidated_builder;
 
+	/* the value has changed */
+	cd_main_property_cache_invalidate (priv->property_cache, property_name);
+
 	/* not yet connected */
 	if (priv->connection == NULL)
 		return;
@@ -318,16 +334,18 @@ cd_profile_dbus_emit_property_changed (CdProfile *profile,
 			       "{sv}",
 			       property_name,
 			       property_value);
-	g_dbus_connection_emit_signal (priv->connection,
-				       NULL,
-				       priv->object_path,
-				       "org.freedesktop.DBus.Properties",
-				       "PropertiesChanged",
-				       g_variant_new ("(sa{sv}as)",
-				       COLORD_DBUS_INTERFACE_PROFILE,
-				       &builder,
-				       &invalidated_builder),
-				       NULL);
+	cd_signal_scope_emit (priv->signal_scope,
+			      priv->connection,
+			      priv->object_path,
+			      "org.freedesktop.DBus.Properties",
+			      "PropertiesChanged",
+			      g_variant_new ("(sa{sv}as)",
+			      COLORD_DBUS_INTERFACE_PROFILE,
+			      &builder,
+			      &invalidated_builder),
+			      NULL,
+			      priv->owner,
+			      NULL);
 	g_variant_builder_clear (&builder);
 	g_variant_builder_clear (&invalidated_builder);
 }
@@ -344,24 +362,28 @@ cd_profile_dbus_emit_profile_changed (CdProfile *profile)
 	/* emit signal */
 	g_debug ("CdProfile: emit Changed on %s",
 		 cd_profile_get_object_path (profile));
-	g_dbus_connection_emit_signal (priv->connection,
-				       NULL,
-				       cd_profile_get_object_path (profile),
-				       COLORD_DBUS_INTERFACE_PROFILE,
-				       "Changed",
-				       NULL,
-				       NULL);
+	cd_signal_scope_emit (priv->signal_scope,
+			      priv->connection,
+			      cd_profile_get_object_path (profile),
+			      COLORD_DBUS_INTERFACE_PROFILE,
+			      "Changed",
+			      NULL,
+			      NULL,
+			      priv->owner,
+			      NULL);
 
 	/* emit signal */
 	g_debug ("CdProfile: emit Changed");
-	g_dbus_connection_emit_signal (priv->connection,
-				       NULL,
-				       COLORD_DBUS_PATH,
-				       COLORD_DBUS_INTERFACE,
-				       "ProfileChanged",
-				       g_variant_new ("(o)",
-						      cd_profile_get_object_path (profile)),
-				       NULL);
+	cd_signal_scope_emit (priv->signal_scope,
+			      priv->connection,
+			      COLORD_DBUS_PATH,
+			      COLORD_DBUS_INTERFACE,
+			      "ProfileChanged",
+			      g_variant_new ("(o)",
+					     cd_profile_get_object_path (profile)),
+			      NULL,
+			      priv->owner,
+			      NULL);
 }
 
 static gboolean
@@ -585,6 +607,16 @@ cd_profile_dbus_method_call (GDBusConnection *connection, const gchar *sender,
 	const gchar *property_value = NULL;
 	g_autoptr(GError) error = NULL;
 
+	/* stop one sender flooding the daemon with changes */
+	if (g_strcmp0 (method_name, "SetProperty") == 0 ||
+	    g_strcmp0 (method_name, "InstallSystemWide") == 0) {
+		ret = cd_quota_check_rate (priv->quota, connection, sender, &error);
+		if (!ret) {
+			g_dbus_method_invocation_return_gerror (invocation, error);
+			return;
+		}
+	}
+
 	/* return '' */
 	if (g_strcmp0 (method_name, "SetProperty") == 0) {
 
@@ -674,31 +706,12 @@ cd_profile_dbus_method_call (GDBusConnection *connection, const gchar *sender,
 }
 
 static GVariant *
-cd_profile_dbus_get_property (GDBusConnection *connection, const gchar *sender,
-			     const gchar *object_path, const gchar *interface_name,
-			     const gchar *property_name, GError **error,
-			     gpointer user_data)
+cd_profile_dbus_get_property_uncached (CdProfile *profile,
+				       const gchar *property_name,
+				       GError **error)
 {
-	CdProfile *profile = CD_PROFILE (user_data);
 	CdProfilePrivate *priv = GET_PRIVATE (profile);
-	gboolean ret;
-
-	if (g_strcmp0 (property_name, CD_PROFILE_PROPERTY_TITLE) == 0) {
-		guint uid;
-		g_autofree gchar *title_db = NULL;
 
-		uid = cd_main_get_sender_uid (connection, sender, error);
-		if (uid == G_MAXUINT)
-			return NULL;
-		ret = cd_profile_db_get_property (priv->db, priv->id,
-						  property_name, uid,
-						  &title_db, error);
-		if (!ret)
-			return NULL;
-		if (title_db != NULL)
-			return cd_profile_get_nullable_for_string (title_db);
-		return cd_profile_get_nullable_for_string (priv->title);
-	}
 	if (g_strcmp0 (property_name, CD_PROFILE_PROPERTY_ID) == 0)
 		return cd_profile_get_nullable_for_string (priv->id);
 	if (g_strcmp0 (property_name, CD_PROFILE_PROPERTY_QUALIFIER) == 0)
@@ -740,27 +753,72 @@ cd_profile_dbus_get_property (GDBusConnection *connection, const gchar *sender,
 	return NULL;
 }
 
-gboolean
-cd_profile_register_object (CdProfile *profile,
-			    GDBusConnection *connection,
-			    GDBusInterfaceInfo *info,
-			    GError **error)
+static GVariant *
+cd_profile_dbus_get_property (GDBusConnection *connection, const gchar *sender,
+			     const gchar *object_path, const gchar *interface_name,
+			     const gchar *property_name, GError **error,
+			     gpointer user_data)
 {
+	CdProfile *profile = CD_PROFILE (user_data);
 	CdProfilePrivate *priv = GET_PRIVATE (profile);
-	g_autoptr(GError) error_local = NULL;
+	GVariant *value;
+	gboolean ret;
 
+	/* this depends on the caller, so cannot be cached */
+	if (g_strcmp0 (property_name, CD_PROFILE_PROPERTY_TITLE) == 0) {
+		guint uid;
+		g_autofree gchar *title_db = NULL;
+
+		uid = cd_main_get_sender_uid (connection, sender, error);
+		if (uid == G_MAXUINT)
+			return NULL;
+		ret = cd_profile_db_get_property (priv->db, priv->id,
+						  property_name, uid,
+						  &title_db, error);
+		if (!ret)
+			return NULL;
+		if (title_db != NULL)
+			return cd_profile_get_nullable_for_string (title_db);
+		return cd_profile_get_nullable_for_string (priv->title);
+	}
+
+	/* only serialize the value again if it has changed */
+	value = cd_main_property_cache_lookup (priv->property_cache, property_name);
+	if (value != NULL)
+		return value;
+	value = cd_profile_dbus_get_property_uncached (profile, property_name, error);
+	if (value == NULL)
+		return NULL;
+	return cd_main_property_cache_add (priv->property_cache, property_name, value);
+}
+
+/* also used for the peer-to-peer connections */
+const GDBusInterfaceVTable *
+cd_profile_get_interface_vtable (void)
+{
 	static const GDBusInterfaceVTable interface_vtable = {
 		cd_profile_dbus_method_call,
 		cd_profile_dbus_get_property,
 		NULL
 	};
+	return &interface_vtable;
+}
+
+gboolean
+cd_profile_register_object (CdProfile *profile,
+			    GDBusConnection *connection,
+			    GDBusInterfaceInfo *info,
+			    GError **error)
+{
+	CdProfilePrivate *priv = GET_PRIVATE (profile);
+	g_autoptr(GError) error_local = NULL;
 
 	priv->connection = connection;
 	priv->registration_id = g_dbus_connection_register_object (
 		connection,
 		priv->object_path,
 		info,
-		&interface_vtable,
+		cd_profile_get_interface_vtable (),
 		profile,  /* user_data */
 		NULL,  /* user_data_free_func */
 		&error_local); /* GError** */
@@ -827,6 +885,9 @@ cd_profile_set_from_profile (CdProfile *profile, CdIcc *icc, GError **error)
 	g_autoptr(GHashTable) metadata = NULL;
 	g_autoptr(GList) keys = NULL;
 
+	/* most of the exported properties are about to change */
+	cd_main_property_cache_invalidate (priv->property_cache, NULL);
+
 	/* get the description as the title */
 	value = cd_icc_get_description (icc, NULL, error);
 	if (value == NULL)
@@ -844,9 +905,7 @@ cd_profile_set_from_profile (CdProfile *profile, CdIcc *icc, GError **error)
 		key = l->data;
 		value = g_hash_table_lookup (metadata, key);
 		g_debug ("Adding metadata %s=%s", key, value);
-		g_hash_table_insert (priv->metadata,
-				     g_strdup (key),
-				     g_strdup (value));
+		cd_main_string_pool_hash_insert (priv->metadata, key, value);
 	}
 
 	/* set the format from the metadata */
@@ -1079,8 +1138,9 @@ cd_profile_set_qualifier (CdProfile *profile, const gchar *qualifier)
 {
 	CdProfilePrivate *priv = GET_PRIVATE (profile);
 	g_return_if_fail (CD_IS_PROFILE (profile));
-	g_free (priv->qualifier);
-	priv->qualifier = g_strdup (qualifier);
+	cd_main_string_pool_set (&priv->qualifier, qualifier);
+	cd_main_property_cache_invalidate (priv->property_cache,
+					   CD_PROFILE_PROPERTY_QUALIFIER);
 }
 
 void
@@ -1088,8 +1148,9 @@ cd_profile_set_format (CdProfile *profile, const gchar *format)
 {
 	CdProfilePrivate *priv = GET_PRIVATE (profile);
 	g_return_if_fail (CD_IS_PROFILE (profile));
-	g_free (priv->format);
-	priv->format = g_strdup (format);
+	cd_main_string_pool_set (&priv->format, format);
+	cd_main_property_cache_invalidate (priv->property_cache,
+					   CD_PROFILE_PROPERTY_FORMAT);
 }
 
 static void
@@ -1099,6 +1160,8 @@ cd_profile_set_filename (CdProfile *profile, const gchar *filename)
 	g_return_if_fail (CD_IS_PROFILE (profile));
 	g_free (priv->filename);
 	priv->filename = g_strdup (filename);
+	cd_main_property_cache_invalidate (priv->property_cache,
+					   CD_PROFILE_PROPERTY_FILENAME);
 }
 
 const gchar *
@@ -1125,6 +1188,37 @@ cd_profile_get_metadata_item (CdProfile *profile, const gchar *key)
 	return g_hash_table_lookup (priv->metadata, key);
 }
 
+static gsize
+cd_profile_strsize (const gchar *str)
+{
+	return str != NULL ? strlen (str) + 1 : 0;
+}
+
+/* approximate, not including the interned strings or the mapped file */
+gsize
+cd_profile_get_memory_size (CdProfile *profile)
+{
+	CdProfilePrivate *priv = GET_PRIVATE (profile);
+	gsize bytes;
+	guint i;
+
+	g_return_val_if_fail (CD_IS_PROFILE (profile), 0);
+
+	bytes = sizeof (CdProfile) + sizeof (CdProfilePrivate);
+	bytes += cd_profile_strsize (priv->filename);
+	bytes += cd_profile_strsize (priv->id);
+	bytes += cd_profile_strsize (priv->object_path);
+	bytes += cd_profile_strsize (priv->checksum);
+	bytes += cd_profile_strsize (priv->title);
+	if (priv->warnings != NULL) {
+		for (i = 0; priv->warnings[i] != NULL; i++)
+			bytes += sizeof (gchar *) + cd_profile_strsize (priv->warnings[i]);
+	}
+	bytes += cd_main_string_pool_hash_get_size (priv->metadata);
+	bytes += cd_main_string_pool_hash_get_size (priv->property_cache);
+	return bytes;
+}
+
 /**
  * cd_profile_get_score:
  *
@@ -1279,10 +1373,10 @@ cd_profile_init (CdProfile *profile)
 {
 	CdProfilePrivate *priv = GET_PRIVATE (profile);
 	priv->db = cd_profile_db_new ();
-	priv->metadata = g_hash_table_new_full (g_str_hash,
-							 g_str_equal,
-							 g_free,
-							 g_free);
+	priv->property_cache = cd_main_property_cache_new ();
+	priv->signal_scope = cd_signal_scope_new ();
+	priv->quota = cd_quota_new ();
+	priv->metadata = cd_main_string_pool_hash_new ();
 }
 
 static void
@@ -1300,8 +1394,8 @@ cd_profile_finalize (GObject *object)
 	if (priv->mapped_file != NULL)
 		g_mapped_file_unref (priv->mapped_file);
 	g_free (priv->filename);
-	g_free (priv->qualifier);
-	g_free (priv->format);
+	cd_main_string_pool_release (priv->qualifier);
+	cd_main_string_pool_release (priv->format);
 	g_free (priv->title);
 	g_free (priv->id);
 	g_free (priv->checksum);
@@ -1309,6 +1403,9 @@ cd_profile_finalize (GObject *object)
 	g_object_unref (priv->db);
 	g_strfreev (priv->warnings);
 	g_hash_table_unref (priv->metadata);
+	g_hash_table_unref (priv->property_cache);
+	g_object_unref (priv->signal_scope);
+	g_object_unref (priv->quota);
 
 	G_OBJECT_CLASS (cd_profile_parent_class)->finalize (object);
 }
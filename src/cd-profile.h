@@ -73,6 +73,7 @@ gboolean	 cd_profile_register_object		(CdProfile	*profile,
 							 GDBusInterfaceInfo *info,
 							 GError		**error)
 							 G_GNUC_WARN_UNUSED_RESULT;
+const GDBusInterfaceVTable *cd_profile_get_interface_vtable (void);
 const gchar	*cd_profile_get_qualifier		(CdProfile	*profile);
 void		 cd_profile_set_qualifier		(CdProfile	*profile,
 							 const gchar	*qualifier);
@@ -84,6 +85,7 @@ const gchar	*cd_profile_get_object_path		(CdProfile	*profile);
 GHashTable	*cd_profile_get_metadata		(CdProfile	*profile);
 const gchar	*cd_profile_get_metadata_item		(CdProfile	*profile,
 							 const gchar	*key);
+gsize		 cd_profile_get_memory_size		(CdProfile	*profile);
 CdProfileKind	 cd_profile_get_kind			(CdProfile	*profile);
 guint		 cd_profile_get_score			(CdProfile	*profile);
 CdColorspace	 cd_profile_get_colorspace		(CdProfile	*profile);
@@ -0,0 +1,310 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2014 Richard Hughes <richard@hughsie.com>
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "config.h"
+
+#include <glib-object.h>
+
+#include "cd-common.h"
+#include "cd-quota.h"
+
+static void     cd_quota_finalize	(GObject     *object);
+
+#define GET_PRIVATE(o) (cd_quota_get_instance_private (o))
+
+typedef struct
+{
+	GHashTable			*senders;	/* sender:CdQuotaSender */
+	GHashTable			*objects;	/* object_path:sender */
+	gdouble				 rate;		/* calls per second, or 0 */
+	gdouble				 burst;
+	guint				 max_objects;	/* or 0 for no limit */
+} CdQuotaPrivate;
+
+typedef struct {
+	gdouble				 tokens;
+	gint64				 last_refill;	/* us */
+	guint				 calls;
+	guint				 rejected;
+	guint				 objects;
+	guint				 watcher_id;
+} CdQuotaSender;
+
+G_DEFINE_TYPE_WITH_PRIVATE (CdQuota, cd_quota, G_TYPE_OBJECT)
+
+static gpointer cd_quota_object = NULL;
+
+static void
+cd_quota_sender_free (CdQuotaSender *item)
+{
+	if (item->watcher_id != 0)
+		g_bus_unwatch_name (item->watcher_id);
+	g_free (item);
+}
+
+void
+cd_quota_set_rate (CdQuota *quota, gdouble rate, guint burst)
+{
+	CdQuotaPrivate *priv = GET_PRIVATE (quota);
+	g_return_if_fail (CD_IS_QUOTA (quota));
+	priv->rate = rate;
+
+	/* the burst defaults to one second of calls */
+	priv->burst = burst > 0 ? burst : MAX (rate, 1.f);
+}
+
+void
+cd_quota_set_max_objects (CdQuota *quota, guint max_objects)
+{
+	CdQuotaPrivate *priv = GET_PRIVATE (quota);
+	g_return_if_fail (CD_IS_QUOTA (quota));
+	priv->max_objects = max_objects;
+}
+
+static void
+cd_quota_name_vanished_cb (GDBusConnection *connection,
+			   const gchar *name,
+			   gpointer user_data)
+{
+	CdQuota *quota = CD_QUOTA (user_data);
+	g_debug ("CdQuota: %s has vanished, removing counters", name);
+	cd_quota_remove_sender (quota, name);
+}
+
+static CdQuotaSender *
+cd_quota_ensure_sender (CdQuota *quota,
+			GDBusConnection *connection,
+			const gchar *sender)
+{
+	CdQuotaPrivate *priv = GET_PRIVATE (quota);
+	CdQuotaSender *item;
+
+	item = g_hash_table_lookup (priv->senders, sender);
+	if (item != NULL)
+		return item;
+
+	/* a new sender starts with a full bucket */
+	item = g_new0 (CdQuotaSender, 1);
+	item->tokens = priv->burst;
+	item->last_refill = g_get_monotonic_time ();
+
+	/* drop the counters when the client goes away */
+	if (connection != NULL) {
+		item->watcher_id = g_bus_watch_name_on_connection (connection,
+								   sender,
+								   G_BUS_NAME_WATCHER_FLAGS_NONE,
+								   NULL,
+								   cd_quota_name_vanished_cb,
+								   quota,
+								   NULL);
+	}
+	g_hash_table_insert (priv->senders, g_strdup (sender), item);
+	return item;
+}
+
+gboolean
+cd_quota_check_rate (CdQuota *quota,
+		     GDBusConnection *connection,
+		     const gchar *sender,
+		     GError **error)
+{
+	CdQuotaPrivate *priv = GET_PRIVATE (quota);
+	CdQuotaSender *item;
+	gint64 now;
+
+	g_return_val_if_fail (CD_IS_QUOTA (quota), FALSE);
+
+	/* peer-to-peer connections have no unique name */
+	if (sender == NULL)
+		return TRUE;
+
+	/* refill the bucket for the time since the last call */
+	item = cd_quota_ensure_sender (quota, connection, sender);
+	if (priv->rate > 0.f) {
+		now = g_get_monotonic_time ();
+		item->tokens += (gdouble) (now - item->last_refill) *
+				priv->rate / G_USEC_PER_SEC;
+		item->tokens = MIN (item->tokens, priv->burst);
+		item->last_refill = now;
+		if (item->tokens < 1.f) {
+			item->rejected++;
+			g_set_error (error,
+				     CD_CLIENT_ERROR,
+				     CD_CLIENT_ERROR_LIMIT_EXCEEDED,
+				     "%s exceeded %.1f calls per second",
+				     sender, priv->rate);
+			return FALSE;
+		}
+		item->tokens -= 1.f;
+	}
+	item->calls++;
+	return TRUE;
+}
+
+gboolean
+cd_quota_check_objects (CdQuota *quota, const gchar *sender, GError **error)
+{
+	CdQuotaPrivate *priv = GET_PRIVATE (quota);
+	CdQuotaSender *item;
+
+	g_return_val_if_fail (CD_IS_QUOTA (quota), FALSE);
+
+	if (sender == NULL || priv->max_objects == 0)
+		return TRUE;
+	item = g_hash_table_lookup (priv->senders, sender);
+	if (item == NULL || item->objects < priv->max_objects)
+		return TRUE;
+	item->rejected++;
+	g_set_error (error,
+		     CD_CLIENT_ERROR,
+		     CD_CLIENT_ERROR_LIMIT_EXCEEDED,
+		     "%s already owns %u objects",
+		     sender, item->objects);
+	return FALSE;
+}
+
+void
+cd_quota_add_object (CdQuota *quota,
+		     const gchar *sender,
+		     const gchar *object_path)
+{
+	CdQuotaPrivate *priv = GET_PRIVATE (quota);
+	CdQuotaSender *item;
+
+	g_return_if_fail (CD_IS_QUOTA (quota));
+	g_return_if_fail (object_path != NULL);
+
+	if (sender == NULL)
+		return;
+	if (g_hash_table_contains (priv->objects, object_path))
+		return;
+	item = cd_quota_ensure_sender (quota, NULL, sender);
+	item->objects++;
+	g_hash_table_insert (priv->objects,
+			     g_strdup (object_path),
+			     g_strdup (sender));
+}
+
+gboolean
+cd_quota_remove_object (CdQuota *quota, const gchar *object_path)
+{
+	CdQuotaPrivate *priv = GET_PRIVATE (quota);
+	CdQuotaSender *item;
+	const gchar *sender;
+
+	g_return_val_if_fail (CD_IS_QUOTA (quota), FALSE);
+
+	sender = g_hash_table_lookup (priv->objects, object_path);
+	if (sender == NULL)
+		return FALSE;
+	item = g_hash_table_lookup (priv->senders, sender);
+	if (item != NULL && item->objects > 0)
+		item->objects--;
+	return g_hash_table_remove (priv->objects, object_path);
+}
+
+static gboolean
+cd_quota_object_owned_by_cb (gpointer key, gpointer value, gpointer user_data)
+{
+	return g_strcmp0 (value, user_data) == 0;
+}
+
+gboolean
+cd_quota_remove_sender (CdQuota *quota, const gchar *sender)
+{
+	CdQuotaPrivate *priv = GET_PRIVATE (quota);
+	g_return_val_if_fail (CD_IS_QUOTA (quota), FALSE);
+
+	/* objects that outlive the sender no longer count against anyone */
+	g_hash_table_foreach_remove (priv->objects,
+				     cd_quota_object_owned_by_cb,
+				     (gpointer) sender);
+	return g_hash_table_remove (priv->senders, sender);
+}
+
+GVariant *
+cd_quota_get_variant (CdQuota *quota)
+{
+	CdQuotaPrivate *priv = GET_PRIVATE (quota);
+	CdQuotaSender *item;
+	GList *l;
+	GVariantBuilder builder;
+	g_autoptr(GList) senders = NULL;
+
+	g_return_val_if_fail (CD_IS_QUOTA (quota), NULL);
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a(suuu)"));
+	senders = g_hash_table_get_keys (priv->senders);
+	senders = g_list_sort (senders, (GCompareFunc) g_strcmp0);
+	for (l = senders; l != NULL; l = l->next) {
+		item = g_hash_table_lookup (priv->senders, l->data);
+		g_variant_builder_add (&builder, "(suuu)",
+				       l->data,
+				       item->calls,
+				       item->rejected,
+				       item->objects);
+	}
+	return g_variant_builder_end (&builder);
+}
+
+static void
+cd_quota_class_init (CdQuotaClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+	object_class->finalize = cd_quota_finalize;
+}
+
+static void
+cd_quota_init (CdQuota *quota)
+{
+	CdQuotaPrivate *priv = GET_PRIVATE (quota);
+	priv->burst = 1.f;
+	priv->senders = g_hash_table_new_full (g_str_hash, g_str_equal,
+					       g_free,
+					       (GDestroyNotify) cd_quota_sender_free);
+	priv->objects = g_hash_table_new_full (g_str_hash, g_str_equal,
+					       g_free, g_free);
+}
+
+static void
+cd_quota_finalize (GObject *object)
+{
+	CdQuota *quota = CD_QUOTA (object);
+	CdQuotaPrivate *priv = GET_PRIVATE (quota);
+
+	g_hash_table_unref (priv->senders);
+	g_hash_table_unref (priv->objects);
+
+	G_OBJECT_CLASS (cd_quota_parent_class)->finalize (object);
+}
+
+CdQuota *
+cd_quota_new (void)
+{
+	if (cd_quota_object != NULL) {
+		g_object_ref (cd_quota_object);
+	} else {
+		cd_quota_object = g_object_new (CD_TYPE_QUOTA, NULL);
+		g_object_add_weak_pointer (cd_quota_object,
+					   &cd_quota_object);
+	}
+	return CD_QUOTA (cd_quota_object);
+}
@@ -0,0 +1,62 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2014 Richard Hughes <richard@hughsie.com>
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __CD_QUOTA_H
+#define __CD_QUOTA_H
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+#define CD_TYPE_QUOTA (cd_quota_get_type ())
+G_DECLARE_DERIVABLE_TYPE (CdQuota, cd_quota, CD, QUOTA, GObject)
+
+struct _CdQuotaClass
+{
+	GObjectClass		 parent_class;
+};
+
+CdQuota		*cd_quota_new				(void);
+
+void		 cd_quota_set_rate			(CdQuota	*quota,
+							 gdouble	 rate,
+							 guint		 burst);
+void		 cd_quota_set_max_objects		(CdQuota	*quota,
+							 guint		 max_objects);
+gboolean	 cd_quota_check_rate			(CdQuota	*quota,
+							 GDBusConnection *connection,
+							 const gchar	*sender,
+							 GError		**error);
+gboolean	 cd_quota_check_objects			(CdQuota	*quota,
+							 const gchar	*sender,
+							 GError		**error);
+void		 cd_quota_add_object			(CdQuota	*quota,
+							 const gchar	*sender,
+							 const gchar	*object_path);
+gboolean	 cd_quota_remove_object			(CdQuota	*quota,
+							 const gchar	*object_path);
+gboolean	 cd_quota_remove_sender			(CdQuota	*quota,
+							 const gchar	*sender);
+GVariant	*cd_quota_get_variant			(CdQuota	*quota);
+
+G_END_DECLS
+
+#endif /* __CD_QUOTA_H */
@@ -28,6 +28,7 @@
 #include <glib-object.h>
 #include <sqlite3.h>
 #include <glib/gstdio.h>
+#include <gmodule.h>
 
 #include "cd-common.h"
 #include "cd-device-array.h"
@@ -37,6 +38,10 @@
 #include "cd-profile-array.h"
 #include "cd-profile-db.h"
 #include "cd-profile.h"
+#include "cd-quota.h"
+#include "cd-sensor.h"
+#include "cd-sensor-registry.h"
+#include "cd-signal-scope.h"
 
 static void
 colord_common_func (void)
@@ -59,6 +64,364 @@ colord_common_func (void)
 	g_free (tmp);
 }
 
+static void
+colord_property_cache_func (void)
+{
+	GHashTable *cache;
+	GVariant *value;
+	GVariant *value2;
+
+	cache = cd_main_property_cache_new ();
+
+	/* nothing cached yet */
+	value = cd_main_property_cache_lookup (cache, "Title");
+	g_assert (value == NULL);
+
+	/* floating value is sunk and a new ref returned */
+	value = cd_main_property_cache_add (cache, "Title",
+					    g_variant_new_string ("dave"));
+	g_assert (!g_variant_is_floating (value));
+	g_variant_unref (value);
+
+	/* same instance is returned, not a copy */
+	value = cd_main_property_cache_lookup (cache, "Title");
+	value2 = cd_main_property_cache_lookup (cache, "Title");
+	g_assert (value != NULL);
+	g_assert (value == value2);
+	g_assert_cmpstr (g_variant_get_string (value, NULL), ==, "dave");
+	g_variant_unref (value);
+	g_variant_unref (value2);
+
+	/* invalidate a single property */
+	value = cd_main_property_cache_add (cache, "Kind",
+					    g_variant_new_string ("display"));
+	g_variant_unref (value);
+	cd_main_property_cache_invalidate (cache, "Title");
+	g_assert (cd_main_property_cache_lookup (cache, "Title") == NULL);
+	value = cd_main_property_cache_lookup (cache, "Kind");
+	g_assert (value != NULL);
+	g_variant_unref (value);
+
+	/* invalidate everything */
+	cd_main_property_cache_invalidate (cache, NULL);
+	g_assert (cd_main_property_cache_lookup (cache, "Kind") == NULL);
+
+	g_hash_table_unref (cache);
+}
+
+/* what GDBus does for org.freedesktop.DBus.Properties.GetAll, except the
+ * caller-specific Title which needs a connection */
+static GVariant *
+colord_property_cache_get_all (CdProfile *profile)
+{
+	const GDBusInterfaceVTable *vtable = cd_profile_get_interface_vtable ();
+	const gchar *names[] = {
+		CD_PROFILE_PROPERTY_ID,
+		CD_PROFILE_PROPERTY_QUALIFIER,
+		CD_PROFILE_PROPERTY_FORMAT,
+		CD_PROFILE_PROPERTY_FILENAME,
+		CD_PROFILE_PROPERTY_KIND,
+		CD_PROFILE_PROPERTY_COLORSPACE,
+		CD_PROFILE_PROPERTY_HAS_VCGT,
+		CD_PROFILE_PROPERTY_IS_SYSTEM_WIDE,
+		CD_PROFILE_PROPERTY_METADATA,
+		CD_PROFILE_PROPERTY_CREATED,
+		CD_PROFILE_PROPERTY_SCOPE,
+		CD_PROFILE_PROPERTY_OWNER,
+		CD_PROFILE_PROPERTY_WARNINGS,
+		NULL };
+	GVariantBuilder builder;
+	GVariant *value;
+	guint i;
+	g_autoptr(GError) error = NULL;
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sv}"));
+	for (i = 0; names[i] != NULL; i++) {
+		value = vtable->get_property (NULL, NULL,
+					      cd_profile_get_object_path (profile),
+					      COLORD_DBUS_INTERFACE_PROFILE,
+					      names[i], &error, profile);
+		g_assert_no_error (error);
+		g_assert (value != NULL);
+		g_variant_builder_add (&builder, "{sv}", names[i], value);
+		g_variant_unref (value);
+	}
+	value = g_variant_ref_sink (g_variant_builder_end (&builder));
+
+	/* serialize, as when sending the reply */
+	g_assert (g_variant_get_data (value) != NULL);
+	return value;
+}
+
+static void
+colord_property_cache_get_all_func (void)
+{
+	CdProfile *profile;
+	const guint loops = 10000;
+	gboolean ret;
+	gdouble elapsed_cached;
+	gdouble elapsed_uncached;
+	guint i;
+	g_autoptr(CdIcc) icc = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GTimer) timer = g_timer_new ();
+	g_autoptr(GVariant) value_cached = NULL;
+	g_autoptr(GVariant) value_uncached = NULL;
+
+	/* a profile with typical metadata */
+	icc = cd_icc_new ();
+	ret = cd_icc_create_default (icc, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	cd_icc_add_metadata (icc, CD_PROFILE_METADATA_DATA_SOURCE, "edid");
+	cd_icc_add_metadata (icc, CD_PROFILE_METADATA_EDID_VENDOR, "Hewlett Packard");
+	cd_icc_add_metadata (icc, CD_PROFILE_METADATA_EDID_MODEL, "LP2480zx");
+	cd_icc_add_metadata (icc, CD_PROFILE_METADATA_CMF_PRODUCT, "colord");
+	cd_icc_add_metadata (icc, CD_PROFILE_METADATA_LICENSE, "CC0");
+	profile = cd_profile_new ();
+	cd_profile_set_id (profile, "dave");
+	ret = cd_profile_load_from_icc (profile, icc, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+
+	/* build every property each time */
+	cd_main_property_cache_set_enabled (FALSE);
+	g_timer_reset (timer);
+	for (i = 0; i < loops; i++) {
+		g_autoptr(GVariant) value = colord_property_cache_get_all (profile);
+		if (i == 0)
+			value_uncached = g_variant_ref (value);
+	}
+	elapsed_uncached = g_timer_elapsed (timer, NULL);
+	cd_main_property_cache_set_enabled (TRUE);
+
+	/* reuse the cached values */
+	g_timer_reset (timer);
+	for (i = 0; i < loops; i++) {
+		g_autoptr(GVariant) value = colord_property_cache_get_all (profile);
+		if (i == 0)
+			value_cached = g_variant_ref (value);
+	}
+	elapsed_cached = g_timer_elapsed (timer, NULL);
+	g_assert (g_variant_equal (value_cached, value_uncached));
+	g_print ("GetAll: %.0f/s uncached, %.0f/s cached ",
+		 loops / elapsed_uncached, loops / elapsed_cached);
+	if (g_test_perf ())
+		g_assert_cmpfloat (elapsed_cached, <, elapsed_uncached);
+
+	g_object_unref (profile);
+}
+
+static gint
+colord_signal_scope_sort_cb (gconstpointer a, gconstpointer b)
+{
+	return g_strcmp0 (*((const gchar **) a), *((const gchar **) b));
+}
+
+static void
+colord_signal_scope_func (void)
+{
+	CdSignalScope *signal_scope;
+	GError *error = NULL;
+	GPtrArray *array;
+	GVariant *parameters;
+	GVariantBuilder builder;
+	gboolean ret;
+	guint i;
+	const gchar *paths[] = { "/org/freedesktop/ColorManager/devices/dave", NULL };
+
+	signal_scope = cd_signal_scope_new ();
+
+	/* one peer per type of scope */
+	g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+	g_variant_builder_add (&builder, "{sv}", "Seat",
+			       g_variant_new_string ("seat0"));
+	ret = cd_signal_scope_add_peer (signal_scope, NULL, ":1.1",
+					g_variant_builder_end (&builder), &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+	g_variant_builder_add (&builder, "{sv}", "Uid",
+			       g_variant_new_uint32 (1000));
+	ret = cd_signal_scope_add_peer (signal_scope, NULL, ":1.2",
+					g_variant_builder_end (&builder), &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+	g_variant_builder_add (&builder, "{sv}", "ObjectPaths",
+			       g_variant_new_objv (paths, -1));
+	ret = cd_signal_scope_add_peer (signal_scope, NULL, ":1.3",
+					g_variant_builder_end (&builder), &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+
+	/* unknown keys are rejected */
+	g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+	g_variant_builder_add (&builder, "{sv}", "Seat",
+			       g_variant_new_uint32 (0));
+	ret = cd_signal_scope_add_peer (signal_scope, NULL, ":1.4",
+					g_variant_builder_end (&builder), &error);
+	g_assert_error (error, CD_CLIENT_ERROR, CD_CLIENT_ERROR_INPUT_INVALID);
+	g_assert (!ret);
+	g_clear_error (&error);
+
+	/* too many object paths are rejected */
+	g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+	g_variant_builder_open (&builder, G_VARIANT_TYPE ("{sv}"));
+	g_variant_builder_add (&builder, "s", "ObjectPaths");
+	g_variant_builder_open (&builder, G_VARIANT_TYPE_VARIANT);
+	g_variant_builder_open (&builder, G_VARIANT_TYPE_OBJECT_PATH_ARRAY);
+	for (i = 0; i < 2000; i++) {
+		g_autofree gchar *tmp = NULL;
+		tmp = g_strdup_printf ("/org/freedesktop/ColorManager/devices/dev%u", i);
+		g_variant_builder_add (&builder, "o", tmp);
+	}
+	g_variant_builder_close (&builder);
+	g_variant_builder_close (&builder);
+	g_variant_builder_close (&builder);
+	ret = cd_signal_scope_add_peer (signal_scope, NULL, ":1.5",
+					g_variant_builder_end (&builder), &error);
+	g_assert_error (error, CD_CLIENT_ERROR, CD_CLIENT_ERROR_INPUT_INVALID);
+	g_assert (!ret);
+	g_clear_error (&error);
+
+	/* a user device on another seat */
+	array = cd_signal_scope_get_destinations (signal_scope,
+						  paths[0], NULL,
+						  "seat1", 1001);
+	g_assert_cmpint (array->len, ==, 1);
+	g_assert_cmpstr (g_ptr_array_index (array, 0), ==, ":1.3");
+	g_ptr_array_unref (array);
+
+	/* a system device added on seat0, using the object in the argument */
+	parameters = g_variant_new ("(o)", "/org/freedesktop/ColorManager/devices/other");
+	g_variant_ref_sink (parameters);
+	array = cd_signal_scope_get_destinations (signal_scope,
+						  "/org/freedesktop/ColorManager",
+						  parameters,
+						  "seat0", 0);
+	g_variant_unref (parameters);
+	g_ptr_array_sort (array, colord_signal_scope_sort_cb);
+	g_assert_cmpint (array->len, ==, 2);
+	g_assert_cmpstr (g_ptr_array_index (array, 0), ==, ":1.1");
+	g_assert_cmpstr (g_ptr_array_index (array, 1), ==, ":1.2");
+	g_ptr_array_unref (array);
+
+	/* remove a peer */
+	g_assert (cd_signal_scope_remove_peer (signal_scope, ":1.1"));
+	g_assert (!cd_signal_scope_remove_peer (signal_scope, ":1.1"));
+	array = cd_signal_scope_get_destinations (signal_scope,
+						  paths[0], NULL,
+						  "seat0", 0);
+	g_assert_cmpint (array->len, ==, 2);
+	g_ptr_array_unref (array);
+
+	g_object_unref (signal_scope);
+}
+
+static void
+colord_quota_func (void)
+{
+	CdQuota *quota;
+	GError *error = NULL;
+	GTimer *timer;
+	GVariant *stats;
+	gboolean ret;
+	guint i;
+	guint calls = 0;
+	guint rejected = 0;
+	guint objects = 0;
+	const gchar *sender = NULL;
+	const guint loops = 100000;
+
+	quota = cd_quota_new ();
+
+	/* no limit by default, but the calls are still counted */
+	for (i = 0; i < 10; i++) {
+		ret = cd_quota_check_rate (quota, NULL, ":1.1", &error);
+		g_assert_no_error (error);
+		g_assert (ret);
+	}
+
+	/* the flooding client uses up its burst */
+	cd_quota_set_rate (quota, 20.f, 5);
+	for (i = 0; i < 5; i++) {
+		ret = cd_quota_check_rate (quota, NULL, ":1.2", &error);
+		g_assert_no_error (error);
+		g_assert (ret);
+	}
+	ret = cd_quota_check_rate (quota, NULL, ":1.2", &error);
+	g_assert_error (error, CD_CLIENT_ERROR, CD_CLIENT_ERROR_LIMIT_EXCEEDED);
+	g_assert (!ret);
+	g_clear_error (&error);
+
+	/* another client is not affected */
+	ret = cd_quota_check_rate (quota, NULL, ":1.3", &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+
+	/* the bucket refills over time */
+	g_usleep (G_USEC_PER_SEC / 10);
+	ret = cd_quota_check_rate (quota, NULL, ":1.2", &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+
+	/* peer-to-peer connections are never limited */
+	ret = cd_quota_check_rate (quota, NULL, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+
+	/* cap the number of objects */
+	cd_quota_set_max_objects (quota, 2);
+	cd_quota_add_object (quota, ":1.3", "/org/freedesktop/ColorManager/devices/dave");
+	cd_quota_add_object (quota, ":1.3", "/org/freedesktop/ColorManager/profiles/dave");
+	cd_quota_add_object (quota, ":1.3", "/org/freedesktop/ColorManager/profiles/dave");
+	ret = cd_quota_check_objects (quota, ":1.3", &error);
+	g_assert_error (error, CD_CLIENT_ERROR, CD_CLIENT_ERROR_LIMIT_EXCEEDED);
+	g_assert (!ret);
+	g_clear_error (&error);
+	g_assert (cd_quota_remove_object (quota, "/org/freedesktop/ColorManager/profiles/dave"));
+	g_assert (!cd_quota_remove_object (quota, "/org/freedesktop/ColorManager/profiles/dave"));
+	ret = cd_quota_check_objects (quota, ":1.3", &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+
+	/* check the counters */
+	stats = cd_quota_get_variant (quota);
+	g_variant_ref_sink (stats);
+	g_assert_cmpint (g_variant_n_children (stats), ==, 3);
+	g_variant_get_child (stats, 1, "(&suuu)", &sender, &calls, &rejected, &objects);
+	g_assert_cmpstr (sender, ==, ":1.2");
+	g_assert_cmpint (calls, ==, 6);
+	g_assert_cmpint (rejected, ==, 1);
+	g_assert_cmpint (objects, ==, 0);
+	g_variant_get_child (stats, 2, "(&suuu)", &sender, &calls, &rejected, &objects);
+	g_assert_cmpstr (sender, ==, ":1.3");
+	g_assert_cmpint (calls, ==, 1);
+	g_assert_cmpint (rejected, ==, 1);
+	g_assert_cmpint (objects, ==, 1);
+	g_variant_unref (stats);
+
+	/* the objects of a vanished sender no longer count */
+	g_assert (cd_quota_remove_sender (quota, ":1.3"));
+	g_assert (!cd_quota_remove_object (quota, "/org/freedesktop/ColorManager/devices/dave"));
+
+	/* a flood is rejected without much work */
+	timer = g_timer_new ();
+	for (i = 0; i < loops; i++) {
+		if (!cd_quota_check_rate (quota, NULL, ":1.4", &error))
+			g_clear_error (&error);
+	}
+	g_print ("check per call: %.3fus ",
+		 g_timer_elapsed (timer, NULL) * G_USEC_PER_SEC / loops);
+	g_timer_destroy (timer);
+
+	/* back to no limit for the other tests */
+	cd_quota_set_rate (quota, 0.f, 0);
+	cd_quota_set_max_objects (quota, 0);
+	g_object_unref (quota);
+}
+
 static void
 colord_profile_func (void)
 {
@@ -542,6 +905,267 @@ cd_profile_db_func (void)
 	g_object_unref (pdb);
 }
 
+static void
+colord_sensor_registry_func (void)
+{
+	CdSensorRegistry *registry;
+	CdSensorRegistry *registry2;
+	CdSensor *sensor;
+	const gchar *sensordir = g_getenv ("SENSORDIR");
+	gboolean ret;
+	guint i;
+	guint loops = 100;
+	GError *error = NULL;
+	GTimer *timer;
+	const CdSensorIface *iface;
+	gdouble elapsed;
+	gdouble elapsed_open;
+	g_autofree gchar *filename = NULL;
+
+	if (sensordir == NULL) {
+		g_test_skip ("no SENSORDIR set");
+		return;
+	}
+
+	/* load the dummy driver */
+	registry = cd_sensor_registry_new ();
+	g_assert (!cd_sensor_registry_get_loaded (registry));
+	ret = cd_sensor_registry_load (registry, sensordir, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert (cd_sensor_registry_get_loaded (registry));
+	iface = cd_sensor_registry_get_iface (registry, CD_SENSOR_KIND_DUMMY);
+	g_assert (iface != NULL);
+	g_assert (iface->coldplug != NULL);
+	g_assert (cd_sensor_registry_get_iface (registry, CD_SENSOR_KIND_HUEY) == NULL);
+
+	/* the same instance and iface is shared by every sensor */
+	registry2 = cd_sensor_registry_new ();
+	g_assert (registry == registry2);
+	g_assert (cd_sensor_registry_get_iface (registry2, CD_SENSOR_KIND_DUMMY) == iface);
+	g_object_unref (registry2);
+
+	/* opening the module for each hotplug, as was done before */
+	filename = g_module_build_path (sensordir, "colord_sensor_dummy");
+	timer = g_timer_new ();
+	for (i = 0; i < loops; i++) {
+		GModule *module;
+		gpointer coldplug = NULL;
+		module = g_module_open (filename, G_MODULE_BIND_LOCAL);
+		g_assert (module != NULL);
+		g_assert (g_module_symbol (module, "cd_sensor_coldplug", &coldplug));
+		g_module_close (module);
+	}
+	elapsed_open = g_timer_elapsed (timer, NULL);
+	g_print ("open per hotplug: %.3fms, ", elapsed_open * 1000.f / loops);
+
+	/* add and remove a sensor using the preloaded driver */
+	g_timer_reset (timer);
+	for (i = 0; i < loops; i++) {
+		sensor = cd_sensor_new ();
+		cd_sensor_set_kind (sensor, CD_SENSOR_KIND_DUMMY);
+		ret = cd_sensor_load (sensor, &error);
+		g_assert_no_error (error);
+		g_assert (ret);
+		g_assert_cmpstr (cd_sensor_get_id (sensor), ==, "dummy");
+		g_object_unref (sensor);
+	}
+	elapsed = g_timer_elapsed (timer, NULL);
+	g_print ("registry per hotplug: %.3fms ", elapsed * 1000.f / loops);
+	if (g_test_perf ()) {
+		g_assert_cmpfloat (elapsed * 1000.f / loops, <, 1.f);
+		g_assert_cmpfloat (elapsed, <, elapsed_open);
+	}
+
+	/* no driver for this kind */
+	sensor = cd_sensor_new ();
+	cd_sensor_set_kind (sensor, CD_SENSOR_KIND_HUEY);
+	ret = cd_sensor_load (sensor, &error);
+	g_assert_error (error, 1, 0);
+	g_assert (!ret);
+	g_clear_error (&error);
+	g_object_unref (sensor);
+
+	g_timer_destroy (timer);
+	g_object_unref (registry);
+}
+
+/* in bytes, or 0 if not supported */
+static gsize
+colord_get_rss (void)
+{
+	gchar *tmp;
+	g_autofree gchar *data = NULL;
+
+	if (!g_file_get_contents ("/proc/self/status", &data, NULL, NULL))
+		return 0;
+	tmp = g_strstr_len (data, -1, "\nVmRSS:");
+	if (tmp == NULL)
+		return 0;
+	return g_ascii_strtoull (tmp + 7, NULL, 10) * 1024;
+}
+
+static GPtrArray *
+colord_string_pool_create_profiles (CdIcc *icc, guint number)
+{
+	CdProfile *profile;
+	GPtrArray *profiles;
+	gboolean ret;
+	guint i;
+	g_autoptr(GError) error = NULL;
+
+	profiles = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	for (i = 0; i < number; i++) {
+		g_autofree gchar *checksum = g_strdup_printf ("%032x", i);
+		cd_icc_add_metadata (icc, CD_PROFILE_METADATA_FILE_CHECKSUM, checksum);
+		profile = cd_profile_new ();
+		ret = cd_profile_load_from_icc (profile, icc, &error);
+		g_assert_no_error (error);
+		g_assert (ret);
+		g_ptr_array_add (profiles, profile);
+	}
+	return profiles;
+}
+
+static void
+colord_string_pool_func (void)
+{
+	GHashTable *hash;
+	const gchar *str1;
+	const gchar *str2;
+	const gchar *keys[] = {
+		CD_PROFILE_METADATA_MAPPING_FORMAT,
+		CD_PROFILE_METADATA_MAPPING_QUALIFIER,
+		CD_PROFILE_METADATA_CMF_PRODUCT,
+		CD_PROFILE_METADATA_CMF_BINARY,
+		CD_PROFILE_METADATA_CMF_VERSION,
+		CD_PROFILE_METADATA_DATA_SOURCE,
+		CD_PROFILE_METADATA_EDID_VENDOR,
+		CD_PROFILE_METADATA_EDID_MODEL,
+		CD_PROFILE_METADATA_LICENSE,
+		NULL };
+	const gchar *values[] = {
+		"ColorSpace.Paper.Resolution",
+		"RGB.Plain.300dpi",
+		"colord",
+		"colord-session",
+		"1.4.8",
+		"edid",
+		"Hewlett Packard",
+		"LP2480zx",
+		"CC0",
+		NULL };
+	gboolean ret;
+	gsize bytes;
+	gsize bytes_interned = 0;
+	gsize bytes_old = 0;
+	gsize bytes_tmp;
+	gsize rss_interned;
+	gsize rss_old;
+	gsize rss_tmp;
+	guint i;
+	guint j;
+	guint refs;
+	guint strings;
+	guint strings_old;
+	GError *error = NULL;
+	g_autoptr(CdIcc) icc = NULL;
+	g_autoptr(GPtrArray) hashes = NULL;
+	g_autoptr(GPtrArray) profiles = NULL;
+	g_autoptr(GPtrArray) profiles_old = NULL;
+
+	/* the same string is shared */
+	cd_main_string_pool_get_stats (&strings_old, NULL, NULL);
+	str1 = cd_main_string_pool_intern (CD_PROFILE_METADATA_FILE_CHECKSUM);
+	str2 = cd_main_string_pool_intern (CD_PROFILE_METADATA_FILE_CHECKSUM);
+	g_assert (str1 == str2);
+	g_assert_cmpstr (str1, ==, CD_PROFILE_METADATA_FILE_CHECKSUM);
+	cd_main_string_pool_get_stats (&strings, &refs, &bytes);
+	g_assert_cmpint (strings, ==, strings_old + 1);
+	g_assert_cmpint (bytes, >, 0);
+	cd_main_string_pool_release (str1);
+	cd_main_string_pool_release (str2);
+	cd_main_string_pool_get_stats (&strings, NULL, NULL);
+	g_assert_cmpint (strings, ==, strings_old);
+
+	/* replacing with the same value does not drop the last reference */
+	hash = cd_main_string_pool_hash_new ();
+	cd_main_string_pool_hash_insert (hash, "EDID_md5", "deadbeef");
+	cd_main_string_pool_hash_insert (hash, "EDID_md5", "deadbeef");
+	g_assert_cmpstr (g_hash_table_lookup (hash, "EDID_md5"), ==, "deadbeef");
+	cd_main_string_pool_get_stats (&strings, NULL, NULL);
+	g_assert_cmpint (strings, ==, strings_old + 2);
+	g_hash_table_unref (hash);
+	cd_main_string_pool_get_stats (&strings, NULL, NULL);
+	g_assert_cmpint (strings, ==, strings_old);
+
+	/* 1000 synthetic profiles only add the unique checksums */
+	icc = cd_icc_new ();
+	ret = cd_icc_create_default (icc, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	for (j = 0; keys[j] != NULL; j++)
+		cd_icc_add_metadata (icc, keys[j], values[j]);
+	profiles = colord_string_pool_create_profiles (icc, 1000);
+	cd_main_string_pool_get_stats (&strings, &refs, &bytes);
+	g_assert_cmpint (strings, <, strings_old + 1000 + 50);
+	g_assert_cmpint (refs, >, 1000 * 10 * 2);
+	g_print ("pool: %u strings, %u refs, %" G_GSIZE_FORMAT " bytes, ",
+		 strings, refs, bytes);
+	g_clear_pointer (&profiles, g_ptr_array_unref);
+
+	/* compare the memory used against duplicating every string */
+	cd_main_string_pool_get_stats (NULL, NULL, &bytes_tmp);
+	hashes = g_ptr_array_new_with_free_func ((GDestroyNotify) g_hash_table_unref);
+	for (i = 0; i < 1000; i++) {
+		g_autofree gchar *checksum = g_strdup_printf ("%032x", i);
+		hash = cd_main_string_pool_hash_new ();
+		for (j = 0; keys[j] != NULL; j++) {
+			cd_main_string_pool_hash_insert (hash, keys[j], values[j]);
+			bytes_old += strlen (keys[j]) + strlen (values[j]) + 2;
+		}
+		cd_main_string_pool_hash_insert (hash,
+						 CD_PROFILE_METADATA_FILE_CHECKSUM,
+						 checksum);
+		bytes_old += strlen (CD_PROFILE_METADATA_FILE_CHECKSUM) +
+			     strlen (checksum) + 2;
+		bytes_old += cd_main_string_pool_hash_get_size (hash);
+		bytes_interned += cd_main_string_pool_hash_get_size (hash);
+		g_ptr_array_add (hashes, hash);
+	}
+	cd_main_string_pool_get_stats (NULL, NULL, &bytes);
+	g_assert_cmpint (bytes, >=, bytes_tmp);
+	bytes_interned += bytes - bytes_tmp;
+	g_print ("per 1000 profiles: %" G_GSIZE_FORMAT "kB duplicated, "
+		 "%" G_GSIZE_FORMAT "kB interned ",
+		 bytes_old / 1024, bytes_interned / 1024);
+	g_assert_cmpint (bytes_interned, <, bytes_old);
+	g_ptr_array_set_size (hashes, 0);
+
+	/* compare the RSS of 1000 profiles without and with interning, with
+	 * the unshared profiles created first so they get any free pages */
+	rss_tmp = colord_get_rss ();
+	if (rss_tmp == 0) {
+		g_test_skip ("no VmRSS information");
+		return;
+	}
+	cd_main_string_pool_set_enabled (FALSE);
+	profiles_old = colord_string_pool_create_profiles (icc, 1000);
+	cd_main_string_pool_set_enabled (TRUE);
+	rss_old = colord_get_rss ();
+	g_assert_cmpint (rss_old, >=, rss_tmp);
+	rss_old -= rss_tmp;
+	rss_tmp = colord_get_rss ();
+	profiles = colord_string_pool_create_profiles (icc, 1000);
+	rss_interned = colord_get_rss ();
+	g_assert_cmpint (rss_interned, >=, rss_tmp);
+	rss_interned -= rss_tmp;
+	g_print ("VmRSS per 1000 profiles: %" G_GSIZE_FORMAT "kB unshared, "
+		 "%" G_GSIZE_FORMAT "kB interned ",
+		 rss_old / 1024, rss_interned / 1024);
+	g_assert_cmpint (rss_interned, <, rss_old);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -552,6 +1176,12 @@ main (int argc, char **argv)
 
 	/* tests go here */
 	g_test_add_func ("/colord/common", colord_common_func);
+	g_test_add_func ("/colord/property-cache", colord_property_cache_func);
+	g_test_add_func ("/colord/property-cache{get-all}", colord_property_cache_get_all_func);
+	g_test_add_func ("/colord/string-pool", colord_string_pool_func);
+	g_test_add_func ("/colord/signal-scope", colord_signal_scope_func);
+	g_test_add_func ("/colord/quota", colord_quota_func);
+	g_test_add_func ("/colord/sensor-registry", colord_sensor_registry_func);
 	g_test_add_func ("/colord/mapping-db{alter}", cd_mapping_db_alter_func);
 	g_test_add_func ("/colord/mapping-db{convert}", cd_mapping_db_convert_func);
 	g_test_add_func ("/colord/mapping-db", cd_mapping_db_func);
@@ -0,0 +1,256 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2014 Richard Hughes <richard@hughsie.com>
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "config.h"
+
+#include <glib-object.h>
+#include <gmodule.h>
+
+#include "cd-sensor-registry.h"
+
+static void     cd_sensor_registry_finalize	(GObject     *object);
+
+#define GET_PRIVATE(o) (cd_sensor_registry_get_instance_private (o))
+
+typedef struct
+{
+	GPtrArray			*modules;	/* of GModule */
+	GPtrArray			*ifaces;	/* of CdSensorIface */
+	GHashTable			*kinds;		/* kind:CdSensorIface */
+	const CdSensorIface		*fallback;
+	gboolean			 loaded;
+} CdSensorRegistryPrivate;
+
+typedef const CdSensorKind *(*CdSensorGetKindsFunc)	(void);
+typedef gboolean (*CdSensorGetIsFallbackFunc)		(void);
+
+G_DEFINE_TYPE_WITH_PRIVATE (CdSensorRegistry, cd_sensor_registry, G_TYPE_OBJECT)
+
+static gpointer cd_sensor_registry_object = NULL;
+
+static void
+cd_sensor_registry_add_kinds (GHashTable *kinds,
+			      const CdSensorKind *supported,
+			      CdSensorIface *desc,
+			      const gchar *module_name)
+{
+	guint i;
+
+	if (supported == NULL)
+		return;
+	for (i = 0; supported[i] != CD_SENSOR_KIND_UNKNOWN; i++) {
+		gpointer key = GUINT_TO_POINTER (supported[i]);
+		if (g_hash_table_contains (kinds, key)) {
+			g_warning ("%s also supports %s, ignoring",
+				   module_name,
+				   cd_sensor_kind_to_string (supported[i]));
+			continue;
+		}
+		g_hash_table_insert (kinds, key, desc);
+	}
+}
+
+static gboolean
+cd_sensor_registry_add_module (CdSensorRegistry *registry,
+			       const gchar *filename,
+			       GError **error)
+{
+	CdSensorRegistryPrivate *priv = GET_PRIVATE (registry);
+	CdSensorGetIsFallbackFunc get_is_fallback = NULL;
+	CdSensorGetKindsFunc get_kinds = NULL;
+	CdSensorIface *desc;
+	GModule *handle;
+	const gchar *module_name;
+
+	handle = g_module_open (filename, G_MODULE_BIND_LOCAL);
+	if (handle == NULL) {
+		g_set_error (error, 1, 0,
+			     "opening module %s failed : %s",
+			     filename, g_module_error ());
+		return FALSE;
+	}
+
+	/* the driver has to say what it supports */
+	module_name = g_module_name (handle);
+	g_module_symbol (handle, "cd_sensor_get_kinds", (gpointer *) &get_kinds);
+	g_module_symbol (handle, "cd_sensor_get_is_fallback", (gpointer *) &get_is_fallback);
+	if (get_kinds == NULL && get_is_fallback == NULL) {
+		g_set_error (error, 1, 0,
+			     "module %s does not declare any sensor kinds",
+			     module_name);
+		g_module_close (handle);
+		return FALSE;
+	}
+
+	/* connect up exported methods */
+	desc = g_new0 (CdSensorIface, 1);
+	g_module_symbol (handle, "cd_sensor_get_sample_async", (gpointer *)&desc->get_sample_async);
+	g_module_symbol (handle, "cd_sensor_get_sample_finish", (gpointer *)&desc->get_sample_finish);
+	g_module_symbol (handle, "cd_sensor_get_spectrum_async", (gpointer *)&desc->get_spectrum_async);
+	g_module_symbol (handle, "cd_sensor_get_spectrum_finish", (gpointer *)&desc->get_spectrum_finish);
+	g_module_symbol (handle, "cd_sensor_set_options_async", (gpointer *)&desc->set_options_async);
+	g_module_symbol (handle, "cd_sensor_set_options_finish", (gpointer *)&desc->set_options_finish);
+	g_module_symbol (handle, "cd_sensor_coldplug", (gpointer *)&desc->coldplug);
+	g_module_symbol (handle, "cd_sensor_dump_device", (gpointer *)&desc->dump_device);
+	g_module_symbol (handle, "cd_sensor_lock_async", (gpointer *)&desc->lock_async);
+	g_module_symbol (handle, "cd_sensor_lock_finish", (gpointer *)&desc->lock_finish);
+	g_module_symbol (handle, "cd_sensor_unlock_async", (gpointer *)&desc->unlock_async);
+	g_module_symbol (handle, "cd_sensor_unlock_finish", (gpointer *)&desc->unlock_finish);
+	g_ptr_array_add (priv->ifaces, desc);
+	g_ptr_array_add (priv->modules, handle);
+
+	/* a native driver always wins over a fallback one */
+	if (get_kinds != NULL) {
+		cd_sensor_registry_add_kinds (priv->kinds, get_kinds (),
+					      desc, module_name);
+	}
+	if (get_is_fallback != NULL && get_is_fallback ()) {
+		if (priv->fallback != NULL) {
+			g_warning ("%s is also a fallback driver, ignoring",
+				   module_name);
+		} else {
+			priv->fallback = desc;
+		}
+	}
+	return TRUE;
+}
+
+/**
+ * cd_sensor_registry_load:
+ * @registry: a #CdSensorRegistry
+ * @path: the directory of sensor drivers, e.g. LIBDIR "/colord-sensors"
+ * @error: a #GError, or %NULL
+ *
+ * Opens every sensor driver in @path and resolves the exported symbols,
+ * so that sensors can be added without opening the module again.
+ * Drivers that cannot be loaded are skipped.
+ *
+ * Return value: %TRUE if the directory was read
+ **/
+gboolean
+cd_sensor_registry_load (CdSensorRegistry *registry,
+			 const gchar *path,
+			 GError **error)
+{
+	CdSensorRegistryPrivate *priv = GET_PRIVATE (registry);
+	const gchar *filename_tmp;
+	g_autoptr(GDir) dir = NULL;
+
+	g_return_val_if_fail (CD_IS_SENSOR_REGISTRY (registry), FALSE);
+	g_return_val_if_fail (path != NULL, FALSE);
+
+	/* only ever done once */
+	if (priv->loaded)
+		return TRUE;
+	dir = g_dir_open (path, 0, error);
+	if (dir == NULL)
+		return FALSE;
+	g_debug ("searching for sensor drivers in %s", path);
+	while ((filename_tmp = g_dir_read_name (dir)) != NULL) {
+		g_autofree gchar *filename = NULL;
+		g_autoptr(GError) error_local = NULL;
+		if (!g_str_has_suffix (filename_tmp, "." G_MODULE_SUFFIX))
+			continue;
+		filename = g_build_filename (path, filename_tmp, NULL);
+		if (!cd_sensor_registry_add_module (registry, filename, &error_local)) {
+			g_warning ("CdSensorRegistry: %s", error_local->message);
+			continue;
+		}
+		g_debug ("loaded sensor driver %s", filename_tmp);
+	}
+	priv->loaded = TRUE;
+	return TRUE;
+}
+
+gboolean
+cd_sensor_registry_get_loaded (CdSensorRegistry *registry)
+{
+	CdSensorRegistryPrivate *priv = GET_PRIVATE (registry);
+	g_return_val_if_fail (CD_IS_SENSOR_REGISTRY (registry), FALSE);
+	return priv->loaded;
+}
+
+/**
+ * cd_sensor_registry_get_iface:
+ * @registry: a #CdSensorRegistry
+ * @kind: the sensor kind, e.g %CD_SENSOR_KIND_HUEY
+ *
+ * Gets the driver for a sensor kind, or the fallback driver if no native
+ * driver supports it. The iface is shared by all sensors of any kind that
+ * use the same driver, and must not be modified.
+ *
+ * Return value: the driver iface, or %NULL if no driver supports @kind
+ **/
+const CdSensorIface *
+cd_sensor_registry_get_iface (CdSensorRegistry *registry, CdSensorKind kind)
+{
+	CdSensorRegistryPrivate *priv = GET_PRIVATE (registry);
+	const CdSensorIface *desc;
+
+	g_return_val_if_fail (CD_IS_SENSOR_REGISTRY (registry), NULL);
+
+	desc = g_hash_table_lookup (priv->kinds, GUINT_TO_POINTER (kind));
+	if (desc != NULL)
+		return desc;
+	return priv->fallback;
+}
+
+static void
+cd_sensor_registry_class_init (CdSensorRegistryClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+	object_class->finalize = cd_sensor_registry_finalize;
+}
+
+static void
+cd_sensor_registry_init (CdSensorRegistry *registry)
+{
+	CdSensorRegistryPrivate *priv = GET_PRIVATE (registry);
+	priv->modules = g_ptr_array_new_with_free_func ((GDestroyNotify) g_module_close);
+	priv->ifaces = g_ptr_array_new_with_free_func (g_free);
+	priv->kinds = g_hash_table_new (g_direct_hash, g_direct_equal);
+}
+
+static void
+cd_sensor_registry_finalize (GObject *object)
+{
+	CdSensorRegistry *registry = CD_SENSOR_REGISTRY (object);
+	CdSensorRegistryPrivate *priv = GET_PRIVATE (registry);
+
+	g_hash_table_unref (priv->kinds);
+	g_ptr_array_unref (priv->ifaces);
+	g_ptr_array_unref (priv->modules);
+
+	G_OBJECT_CLASS (cd_sensor_registry_parent_class)->finalize (object);
+}
+
+CdSensorRegistry *
+cd_sensor_registry_new (void)
+{
+	if (cd_sensor_registry_object != NULL) {
+		g_object_ref (cd_sensor_registry_object);
+	} else {
+		cd_sensor_registry_object = g_object_new (CD_TYPE_SENSOR_REGISTRY, NULL);
+		g_object_add_weak_pointer (cd_sensor_registry_object,
+					   &cd_sensor_registry_object);
+	}
+	return CD_SENSOR_REGISTRY (cd_sensor_registry_object);
+}
@@ -0,0 +1,99 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2014 Richard Hughes <richard@hughsie.com>
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __CD_SENSOR_REGISTRY_H
+#define __CD_SENSOR_REGISTRY_H
+
+#include <glib-object.h>
+#include <gio/gio.h>
+#include <colord-private.h>
+
+#include "cd-sensor.h"
+
+G_BEGIN_DECLS
+
+#define CD_TYPE_SENSOR_REGISTRY (cd_sensor_registry_get_type ())
+G_DECLARE_DERIVABLE_TYPE (CdSensorRegistry, cd_sensor_registry, CD, SENSOR_REGISTRY, GObject)
+
+struct _CdSensorRegistryClass
+{
+	GObjectClass		 parent_class;
+};
+
+/* the symbols exported by a sensor driver, shared by all the sensors */
+typedef struct {
+	void		 (*get_sample_async)	(CdSensor		*sensor,
+						 CdSensorCap		 cap,
+						 GCancellable		*cancellable,
+						 GAsyncReadyCallback	 callback,
+						 gpointer		 user_data);
+	CdColorXYZ	*(*get_sample_finish)	(CdSensor		*sensor,
+						 GAsyncResult		*res,
+						 GError			**error);
+	void		 (*get_spectrum_async)	(CdSensor		*sensor,
+						 CdSensorCap		 cap,
+						 GCancellable		*cancellable,
+						 GAsyncReadyCallback	 callback,
+						 gpointer		 user_data);
+	CdSpectrum	*(*get_spectrum_finish)	(CdSensor		*sensor,
+						 GAsyncResult		*res,
+						 GError			**error);
+	gboolean	 (*coldplug)		(CdSensor		*sensor,
+						 GError			**error);
+	gboolean	 (*dump_device)		(CdSensor		*sensor,
+						 GString		*data,
+						 GError			**error);
+	void		 (*lock_async)		(CdSensor		*sensor,
+						 GCancellable		*cancellable,
+						 GAsyncReadyCallback	 callback,
+						 gpointer		 user_data);
+	gboolean	 (*lock_finish)		(CdSensor		*sensor,
+						 GAsyncResult		*res,
+						 GError			**error);
+	void		 (*unlock_async)	(CdSensor		*sensor,
+						 GCancellable		*cancellable,
+						 GAsyncReadyCallback	 callback,
+						 gpointer		 user_data);
+	gboolean	 (*unlock_finish)	(CdSensor		*sensor,
+						 GAsyncResult		*res,
+						 GError			**error);
+	void		 (*set_options_async)	(CdSensor		*sensor,
+						 GHashTable		*options,
+						 GCancellable		*cancellable,
+						 GAsyncReadyCallback	 callback,
+						 gpointer		 user_data);
+	gboolean	 (*set_options_finish)	(CdSensor		*sensor,
+						 GAsyncResult		*res,
+						 GError			**error);
+} CdSensorIface;
+
+CdSensorRegistry	*cd_sensor_registry_new		(void);
+
+gboolean		 cd_sensor_registry_load	(CdSensorRegistry	*registry,
+							 const gchar		*path,
+							 GError			**error);
+gboolean		 cd_sensor_registry_get_loaded	(CdSensorRegistry	*registry);
+const CdSensorIface	*cd_sensor_registry_get_iface	(CdSensorRegistry	*registry,
+							 CdSensorKind		 kind);
+
+G_END_DECLS
+
+#endif /* __CD_SENSOR_REGISTRY_H */
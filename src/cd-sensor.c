@@ -24,62 +24,17 @@
 #include <glib-object.h>
 #include <gio/gio.h>
 #include <sys/time.h>
-#include <gmodule.h>
 #include <colord-private.h>
 
 #include "cd-common.h"
 #include "cd-sensor.h"
+#include "cd-sensor-registry.h"
+#include "cd-signal-scope.h"
 
 static void cd_sensor_finalize			 (GObject *object);
 
 #define GET_PRIVATE(o) (cd_sensor_get_instance_private (o))
 
-typedef struct {
-	void		 (*get_sample_async)	(CdSensor		*sensor,
-						 CdSensorCap		 cap,
-						 GCancellable		*cancellable,
-						 GAsyncReadyCallback	 callback,
-						 gpointer		 user_data);
-	CdColorXYZ	*(*get_sample_finish)	(CdSensor		*sensor,
-						 GAsyncResult		*res,
-						 GError			**error);
-	void		 (*get_spectrum_async)	(CdSensor		*sensor,
-						 CdSensorCap		 cap,
-						 GCancellable		*cancellable,
-						 GAsyncReadyCallback	 callback,
-						 gpointer		 user_data);
-	CdSpectrum	*(*get_spectrum_finish)	(CdSensor		*sensor,
-						 GAsyncResult		*res,
-						 GError			**error);
-	gboolean	 (*coldplug)		(CdSensor		*sensor,
-						 GError			**error);
-	gboolean	 (*dump_device)		(CdSensor		*sensor,
-						 GString		*data,
-						 GError			**error);
-	void		 (*lock_async)		(CdSensor		*sensor,
-						 GCancellable		*cancellable,
-						 GAsyncReadyCallback	 callback,
-						 gpointer		 user_data);
-	gboolean	 (*lock_finish)		(CdSensor		*sensor,
-						 GAsyncResult		*res,
-						 GError			**error);
-	void		 (*unlock_async)	(CdSensor		*sensor,
-						 GCancellable		*cancellable,
-						 GAsyncReadyCallback	 callback,
-						 gpointer		 user_data);
-	gboolean	 (*unlock_finish)	(CdSensor		*sensor,
-						 GAsyncResult		*res,
-						 GError			**error);
-	void		 (*set_options_async)	(CdSensor		*sensor,
-						 GHashTable		*options,
-						 GCancellable		*cancellable,
-						 GAsyncReadyCallback	 callback,
-						 gpointer		 user_data);
-	gboolean	 (*set_options_finish)	(CdSensor		*sensor,
-						 GAsyncResult		*res,
-						 GError			**error);
-} CdSensorIface;
-
 typedef struct
 {
 	gchar				*id;
@@ -100,10 +55,13 @@ typedef struct
 	GDBusConnection			*connection;
 	guint				 registration_id;
 	guint				 set_state_id;
-	CdSensorIface			*desc;
+	CdSensorRegistry		*registry;
+	const CdSensorIface		*desc;
 	GHashTable			*options;
 	GHashTable			*metadata;
 	GUsbContext			*usb_ctx;
+	GHashTable			*property_cache;	/* name:GVariant */
+	CdSignalScope			*signal_scope;
 } CdSensorPrivate;
 
 enum {
@@ -172,6 +130,7 @@ cd_sensor_set_id (CdSensor *sensor, const gchar *id)
 						      id_tmp,
 						      NULL);
 	priv->id = g_strdup (id);
+	cd_main_property_cache_invalidate (priv->property_cache, NULL);
 }
 
 static void
@@ -183,6 +142,9 @@ cd_sensor_dbus_emit_property_changed (CdSensor *sensor,
 	GVariantBuilder builder;
 	GVariantBuilder invalidated_builder;
 
+	/* the cached value is now stale */
+	cd_main_property_cache_invalidate (priv->property_cache, property_name);
+
 	/* not yet connected */
 	if (priv->connection == NULL)
 		return;
@@ -195,16 +157,18 @@ cd_sensor_dbus_emit_property_changed (CdSensor *sensor,
 			       property_name,
 			       property_value);
 	g_debug ("CdSensor: emit PropertiesChanged(%s)", property_name);
-	g_dbus_connection_emit_signal (priv->connection,
-				       NULL,
-				       priv->object_path,
-				       "org.freedesktop.DBus.Properties",
-				       "PropertiesChanged",
-				       g_variant_new ("(sa{sv}as)",
-				       COLORD_DBUS_INTERFACE_SENSOR,
-				       &builder,
-				       &invalidated_builder),
-				       NULL);
+	cd_signal_scope_emit (priv->signal_scope,
+			      priv->connection,
+			      priv->object_path,
+			      "org.freedesktop.DBus.Properties",
+			      "PropertiesChanged",
+			      g_variant_new ("(sa{sv}as)",
+			      COLORD_DBUS_INTERFACE_SENSOR,
+			      &builder,
+			      &invalidated_builder),
+			      NULL,
+			      0,
+			      NULL);
 	g_variant_builder_clear (&builder);
 	g_variant_builder_clear (&invalidated_builder);
 }
@@ -221,13 +185,15 @@ cd_sensor_button_pressed (CdSensor *sensor)
 	/* emit signal */
 	g_debug ("CdSensor: emit ButtonPressed on %s",
 		 priv->object_path);
-	g_dbus_connection_emit_signal (priv->connection,
-				       NULL,
-				       priv->object_path,
-				       COLORD_DBUS_INTERFACE_SENSOR,
-				       "ButtonPressed",
-				       NULL,
-				       NULL);
+	cd_signal_scope_emit (priv->signal_scope,
+			      priv->connection,
+			      priv->object_path,
+			      COLORD_DBUS_INTERFACE_SENSOR,
+			      "ButtonPressed",
+			      NULL,
+			      NULL,
+			      0,
+			      NULL);
 }
 
 /**
@@ -283,75 +249,38 @@ cd_sensor_get_is_embedded (CdSensor *sensor)
 /**
  * cd_sensor_load:
  * @sensor: a valid #CdSensor instance
- * @kind: the sensor kind, e.g %CD_SENSOR_KIND_HUEY
+ * @error: a #GError, or %NULL
  *
- * Sets the device kind.
+ * Connects the sensor to the driver for its kind, which was loaded when the
+ * sensor registry was first used.
  **/
 gboolean
 cd_sensor_load (CdSensor *sensor, GError **error)
 {
 	CdSensorPrivate *priv = GET_PRIVATE (sensor);
-	CdSensorIface *desc;
-	GModule *handle;
-	const gchar *module_name;
-	g_autofree gchar *backend_name = NULL;
-	g_autofree gchar *path_fallback = NULL;
+	const CdSensorIface *desc;
 	g_autofree gchar *path = NULL;
 
 	/* no module */
 	if (priv->kind == CD_SENSOR_KIND_UNKNOWN)
 		return TRUE;
 
-	/* some modules are shared */
-	switch (priv->kind) {
-	case CD_SENSOR_KIND_COLORHUG:
-	case CD_SENSOR_KIND_COLORHUG2:
-		module_name = "colorhug";
-		break;
-	default:
-		module_name = cd_sensor_kind_to_string (priv->kind);
-		break;
+	/* the daemon normally does this at startup */
+	if (!cd_sensor_registry_get_loaded (priv->registry)) {
+		path = g_build_filename (LIBDIR, "colord-sensors", NULL);
+		if (!cd_sensor_registry_load (priv->registry, path, error))
+			return FALSE;
 	}
 
-	/* can we load a module? */
-	backend_name = g_strdup_printf ("libcolord_sensor_%s." G_MODULE_SUFFIX,
-					module_name);
-	path = g_build_filename (LIBDIR, "colord-sensors", backend_name, NULL);
-	g_debug ("Trying to load sensor driver: %s", path);
-	handle = g_module_open (path, G_MODULE_BIND_LOCAL);
-	if (handle == NULL) {
-		g_debug ("opening module %s failed : %s",
-			 backend_name, g_module_error ());
-		g_debug ("Trying to fall back to : libcolord_sensor_argyll");
-		path_fallback = g_build_filename (LIBDIR,
-						  "colord-sensors",
-						  "libcolord_sensor_argyll.so",
-						  NULL);
-		handle = g_module_open (path_fallback, G_MODULE_BIND_LOCAL);
-	}
-	if (handle == NULL) {
+	/* find the driver */
+	desc = cd_sensor_registry_get_iface (priv->registry, priv->kind);
+	if (desc == NULL) {
 		g_set_error (error, 1, 0,
-			     "opening module %s (and fallback) failed : %s",
-			     backend_name, g_module_error ());
+			     "no sensor driver for %s",
+			     cd_sensor_kind_to_string (priv->kind));
 		return FALSE;
 	}
-
-	/* dlload module if it exists */
-	desc = priv->desc = g_new0 (CdSensorIface, 1);
-
-	/* connect up exported methods */
-	g_module_symbol (handle, "cd_sensor_get_sample_async", (gpointer *)&desc->get_sample_async);
-	g_module_symbol (handle, "cd_sensor_get_sample_finish", (gpointer *)&desc->get_sample_finish);
-	g_module_symbol (handle, "cd_sensor_get_spectrum_async", (gpointer *)&desc->get_spectrum_async);
-	g_module_symbol (handle, "cd_sensor_get_spectrum_finish", (gpointer *)&desc->get_spectrum_finish);
-	g_module_symbol (handle, "cd_sensor_set_options_async", (gpointer *)&desc->set_options_async);
-	g_module_symbol (handle, "cd_sensor_set_options_finish", (gpointer *)&desc->set_options_finish);
-	g_module_symbol (handle, "cd_sensor_coldplug", (gpointer *)&desc->coldplug);
-	g_module_symbol (handle, "cd_sensor_dump_device", (gpointer *)&desc->dump_device);
-	g_module_symbol (handle, "cd_sensor_lock_async", (gpointer *)&desc->lock_async);
-	g_module_symbol (handle, "cd_sensor_lock_finish", (gpointer *)&desc->lock_finish);
-	g_module_symbol (handle, "cd_sensor_unlock_async", (gpointer *)&desc->unlock_async);
-	g_module_symbol (handle, "cd_sensor_unlock_finish", (gpointer *)&desc->unlock_finish);
+	priv->desc = desc;
 
 	/* coldplug with data */
 	if (desc->coldplug != NULL)
@@ -1144,12 +1073,10 @@ cd_sensor_get_variant_for_caps (guint64 caps)
 }
 
 static GVariant *
-cd_sensor_dbus_get_property (GDBusConnection *connection_, const gchar *sender,
-			     const gchar *object_path, const gchar *interface_name,
-			     const gchar *property_name, GError **error,
-			     gpointer user_data)
+cd_sensor_dbus_get_property_uncached (CdSensor *sensor,
+				      const gchar *property_name,
+				      GError **error)
 {
-	CdSensor *sensor = CD_SENSOR (user_data);
 	CdSensorPrivate *priv = GET_PRIVATE (sensor);
 
 	if (g_strcmp0 (property_name, CD_SENSOR_PROPERTY_ID) == 0)
@@ -1188,27 +1115,53 @@ cd_sensor_dbus_get_property (GDBusConnection *connection_, const gchar *sender,
 	return NULL;
 }
 
-gboolean
-cd_sensor_register_object (CdSensor *sensor,
-			   GDBusConnection *connection,
-			   GDBusInterfaceInfo *info,
-			   GError **error)
+static GVariant *
+cd_sensor_dbus_get_property (GDBusConnection *connection_, const gchar *sender,
+			     const gchar *object_path, const gchar *interface_name,
+			     const gchar *property_name, GError **error,
+			     gpointer user_data)
 {
+	CdSensor *sensor = CD_SENSOR (user_data);
 	CdSensorPrivate *priv = GET_PRIVATE (sensor);
-	g_autoptr(GError) error_local = NULL;
+	GVariant *value;
 
+	/* only serialize the value again if it has changed */
+	value = cd_main_property_cache_lookup (priv->property_cache, property_name);
+	if (value != NULL)
+		return value;
+	value = cd_sensor_dbus_get_property_uncached (sensor, property_name, error);
+	if (value == NULL)
+		return NULL;
+	return cd_main_property_cache_add (priv->property_cache, property_name, value);
+}
+
+/* also used for the peer-to-peer connections */
+const GDBusInterfaceVTable *
+cd_sensor_get_interface_vtable (void)
+{
 	static const GDBusInterfaceVTable interface_vtable = {
 		cd_sensor_dbus_method_call,
 		cd_sensor_dbus_get_property,
 		NULL
 	};
+	return &interface_vtable;
+}
+
+gboolean
+cd_sensor_register_object (CdSensor *sensor,
+			   GDBusConnection *connection,
+			   GDBusInterfaceInfo *info,
+			   GError **error)
+{
+	CdSensorPrivate *priv = GET_PRIVATE (sensor);
+	g_autoptr(GError) error_local = NULL;
 
 	priv->connection = connection;
 	priv->registration_id = g_dbus_connection_register_object (
 		connection,
 		priv->object_path,
 		info,
-		&interface_vtable,
+		cd_sensor_get_interface_vtable (),
 		sensor,  /* user_data */
 		NULL,  /* user_data_free_func */
 		&error_local); /* GError** */
@@ -1298,6 +1251,8 @@ cd_sensor_set_model (CdSensor *sensor,
 	if (g_strcmp0 (model, "colormunki") == 0)
 		model = "ColorMunki";
 	priv->model = g_strdup (model);
+	cd_main_property_cache_invalidate (priv->property_cache,
+					   CD_SENSOR_PROPERTY_MODEL);
 }
 
 gboolean
@@ -1408,6 +1363,9 @@ cd_sensor_set_from_device (CdSensor *sensor,
 	priv->usb_path = g_strdup_printf ("/dev/bus/usb/%03i/%03i",
 					  busnum, devnum);
 
+	/* vendor, kind, caps and metadata were set directly */
+	cd_main_property_cache_invalidate (priv->property_cache, NULL);
+
 	/* success */
 	return TRUE;
 }
@@ -1529,6 +1487,7 @@ cd_sensor_set_property (GObject *object, guint prop_id, const GValue *value, GPa
 		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 		break;
 	}
+	cd_main_property_cache_invalidate (priv->property_cache, NULL);
 }
 
 static void
@@ -1628,6 +1587,9 @@ cd_sensor_init (CdSensor *sensor)
 						g_str_equal,
 						g_free,
 						g_free);
+	priv->property_cache = cd_main_property_cache_new ();
+	priv->signal_scope = cd_signal_scope_new ();
+	priv->registry = cd_sensor_registry_new ();
 }
 
 static void
@@ -1635,6 +1597,7 @@ cd_sensor_finalize (GObject *object)
 {
 	CdSensor *sensor = CD_SENSOR (object);
 	CdSensorPrivate *priv = GET_PRIVATE (sensor);
+	CdSensorRegistry *registry = priv->registry;
 
 	if (priv->registration_id > 0) {
 		g_debug ("CdSensor: Unregister interface %u on %s",
@@ -1655,11 +1618,16 @@ cd_sensor_finalize (GObject *object)
 	g_free (priv->usb_path);
 	g_hash_table_unref (priv->options);
 	g_hash_table_unref (priv->metadata);
+	g_hash_table_unref (priv->property_cache);
+	g_object_unref (priv->signal_scope);
 	g_object_unref (priv->usb_ctx);
 	if (priv->device != NULL)
 		g_object_unref (priv->device);
 
 	G_OBJECT_CLASS (cd_sensor_parent_class)->finalize (object);
+
+	/* the driver data is only freed by the parent */
+	g_object_unref (registry);
 }
 
 CdSensor *
@@ -66,6 +66,7 @@ gboolean	 cd_sensor_register_object	(CdSensor		*sensor,
 						 GDBusConnection	*connection,
 						 GDBusInterfaceInfo	*info,
 						 GError			**error);
+const GDBusInterfaceVTable *cd_sensor_get_interface_vtable (void);
 gboolean	 cd_sensor_set_from_device	(CdSensor		*sensor,
 						 GUdevDevice		*device,
 						 GError			**error);
@@ -102,6 +103,8 @@ void		 cd_sensor_add_cap		(CdSensor		*sensor,
 						 CdSensorCap		 cap);
 
 /* GModule */
+const CdSensorKind *cd_sensor_get_kinds		(void);
+gboolean	 cd_sensor_get_is_fallback	(void);
 void		 cd_sensor_get_sample_async	(CdSensor		*sensor,
 						 CdSensorCap		 cap,
 						 GCancellable		*cancellable,
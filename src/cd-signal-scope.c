@@ -0,0 +1,319 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2010-2014 Richard Hughes <richard@hughsie.com>
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "config.h"
+
+#include <glib-object.h>
+
+#include "cd-common.h"
+#include "cd-signal-scope.h"
+
+static void     cd_signal_scope_finalize	(GObject     *object);
+
+/* a scope is a filter, not a subscription list */
+#define CD_SIGNAL_SCOPE_MAX_OBJECT_PATHS	1024
+
+#define GET_PRIVATE(o) (cd_signal_scope_get_instance_private (o))
+
+typedef struct
+{
+	GHashTable			*peers;		/* sender:CdSignalScopePeer */
+} CdSignalScopePrivate;
+
+typedef struct {
+	gchar				*seat;
+	guint				 uid;
+	GHashTable			*object_paths;	/* or NULL for all */
+	guint				 watcher_id;
+} CdSignalScopePeer;
+
+G_DEFINE_TYPE_WITH_PRIVATE (CdSignalScope, cd_signal_scope, G_TYPE_OBJECT)
+
+static gpointer cd_signal_scope_object = NULL;
+
+static void
+cd_signal_scope_peer_free (CdSignalScopePeer *peer)
+{
+	if (peer->watcher_id != 0)
+		g_bus_unwatch_name (peer->watcher_id);
+	if (peer->object_paths != NULL)
+		g_hash_table_unref (peer->object_paths);
+	g_free (peer->seat);
+	g_free (peer);
+}
+
+static void
+cd_signal_scope_name_vanished_cb (GDBusConnection *connection,
+				  const gchar *name,
+				  gpointer user_data)
+{
+	CdSignalScope *signal_scope = CD_SIGNAL_SCOPE (user_data);
+	g_debug ("CdSignalScope: %s has vanished, removing scope", name);
+	cd_signal_scope_remove_peer (signal_scope, name);
+}
+
+gboolean
+cd_signal_scope_add_peer (CdSignalScope *signal_scope,
+			  GDBusConnection *connection,
+			  const gchar *sender,
+			  GVariant *scope,
+			  GError **error)
+{
+	CdSignalScopePrivate *priv = GET_PRIVATE (signal_scope);
+	CdSignalScopePeer *peer;
+	GVariantIter iter;
+	GVariant *value;
+	const gchar *key;
+	const gchar *object_path;
+
+	g_return_val_if_fail (CD_IS_SIGNAL_SCOPE (signal_scope), FALSE);
+	g_return_val_if_fail (sender != NULL, FALSE);
+
+	peer = g_new0 (CdSignalScopePeer, 1);
+	peer->uid = G_MAXUINT;
+	g_variant_iter_init (&iter, scope);
+	while (g_variant_iter_next (&iter, "{&sv}", &key, &value)) {
+		if (g_strcmp0 (key, "Seat") == 0 &&
+		    g_variant_is_of_type (value, G_VARIANT_TYPE_STRING)) {
+			g_free (peer->seat);
+			peer->seat = g_variant_dup_string (value, NULL);
+		} else if (g_strcmp0 (key, "Uid") == 0 &&
+			   g_variant_is_of_type (value, G_VARIANT_TYPE_UINT32)) {
+			peer->uid = g_variant_get_uint32 (value);
+		} else if (g_strcmp0 (key, "ObjectPaths") == 0 &&
+			   g_variant_is_of_type (value, G_VARIANT_TYPE_OBJECT_PATH_ARRAY)) {
+			GVariantIter iter_paths;
+			if (g_variant_n_children (value) > CD_SIGNAL_SCOPE_MAX_OBJECT_PATHS) {
+				g_set_error (error,
+					     CD_CLIENT_ERROR,
+					     CD_CLIENT_ERROR_INPUT_INVALID,
+					     "scope has %" G_GSIZE_FORMAT " object paths, "
+					     "maximum is %i",
+					     g_variant_n_children (value),
+					     CD_SIGNAL_SCOPE_MAX_OBJECT_PATHS);
+				g_variant_unref (value);
+				cd_signal_scope_peer_free (peer);
+				return FALSE;
+			}
+			if (peer->object_paths == NULL) {
+				peer->object_paths = g_hash_table_new_full (g_str_hash,
+									    g_str_equal,
+									    g_free,
+									    NULL);
+			}
+			g_variant_iter_init (&iter_paths, value);
+			while (g_variant_iter_next (&iter_paths, "&o", &object_path)) {
+				g_hash_table_add (peer->object_paths,
+						  g_strdup (object_path));
+			}
+		} else {
+			g_set_error (error,
+				     CD_CLIENT_ERROR,
+				     CD_CLIENT_ERROR_INPUT_INVALID,
+				     "scope key %s of type %s not supported",
+				     key, g_variant_get_type_string (value));
+			g_variant_unref (value);
+			cd_signal_scope_peer_free (peer);
+			return FALSE;
+		}
+		g_variant_unref (value);
+	}
+
+	/* drop the scope when the client goes away */
+	if (connection != NULL) {
+		peer->watcher_id = g_bus_watch_name_on_connection (connection,
+								   sender,
+								   G_BUS_NAME_WATCHER_FLAGS_NONE,
+								   NULL,
+								   cd_signal_scope_name_vanished_cb,
+								   signal_scope,
+								   NULL);
+	}
+
+	/* replaces any existing scope for this sender */
+	g_debug ("CdSignalScope: adding scope for %s [seat:%s uid:%u paths:%u]",
+		 sender, peer->seat, peer->uid,
+		 peer->object_paths != NULL ? g_hash_table_size (peer->object_paths) : 0);
+	g_hash_table_insert (priv->peers, g_strdup (sender), peer);
+	return TRUE;
+}
+
+gboolean
+cd_signal_scope_remove_peer (CdSignalScope *signal_scope, const gchar *sender)
+{
+	CdSignalScopePrivate *priv = GET_PRIVATE (signal_scope);
+	g_return_val_if_fail (CD_IS_SIGNAL_SCOPE (signal_scope), FALSE);
+	return g_hash_table_remove (priv->peers, sender);
+}
+
+static gboolean
+cd_signal_scope_peer_matches (CdSignalScopePeer *peer,
+			      const gchar *subject,
+			      const gchar *seat,
+			      guint owner)
+{
+	/* objects without a seat are shared by all seats */
+	if (peer->seat != NULL && seat != NULL &&
+	    g_strcmp0 (peer->seat, seat) != 0)
+		return FALSE;
+
+	/* objects owned by root are shared by all users */
+	if (peer->uid != G_MAXUINT && owner != 0 && owner != peer->uid)
+		return FALSE;
+
+	/* only specific objects */
+	if (peer->object_paths != NULL &&
+	    !g_hash_table_contains (peer->object_paths, subject))
+		return FALSE;
+	return TRUE;
+}
+
+GPtrArray *
+cd_signal_scope_get_destinations (CdSignalScope *signal_scope,
+				  const gchar *object_path,
+				  GVariant *parameters,
+				  const gchar *seat,
+				  guint owner)
+{
+	CdSignalScopePrivate *priv = GET_PRIVATE (signal_scope);
+	CdSignalScopePeer *peer;
+	GHashTableIter iter;
+	GPtrArray *array;
+	const gchar *sender;
+	const gchar *subject = object_path;
+
+	g_return_val_if_fail (CD_IS_SIGNAL_SCOPE (signal_scope), NULL);
+
+	/* signals like DeviceAdded are about the object in the argument */
+	if (parameters != NULL &&
+	    g_variant_is_of_type (parameters, G_VARIANT_TYPE ("(o)")))
+		g_variant_get (parameters, "(&o)", &subject);
+
+	array = g_ptr_array_new_with_free_func (g_free);
+	g_hash_table_iter_init (&iter, priv->peers);
+	while (g_hash_table_iter_next (&iter, (gpointer *) &sender, (gpointer *) &peer)) {
+		if (!cd_signal_scope_peer_matches (peer, subject, seat, owner))
+			continue;
+		g_ptr_array_add (array, g_strdup (sender));
+	}
+	return array;
+}
+
+gboolean
+cd_signal_scope_emit (CdSignalScope *signal_scope,
+		      GDBusConnection *connection,
+		      const gchar *object_path,
+		      const gchar *interface_name,
+		      const gchar *signal_name,
+		      GVariant *parameters,
+		      const gchar *seat,
+		      guint owner,
+		      GError **error)
+{
+	CdSignalScopePrivate *priv = GET_PRIVATE (signal_scope);
+	const gchar *destination;
+	guint i;
+	g_autoptr(GPtrArray) destinations = NULL;
+	g_autoptr(GVariant) parameters_ref = NULL;
+
+	g_return_val_if_fail (CD_IS_SIGNAL_SCOPE (signal_scope), FALSE);
+
+	/* the same message body is sent to each peer */
+	if (parameters != NULL)
+		parameters_ref = g_variant_ref_sink (parameters);
+
+	/* legacy clients listen for everything */
+	if (!g_dbus_connection_emit_signal (connection,
+					    NULL,
+					    object_path,
+					    interface_name,
+					    signal_name,
+					    parameters_ref,
+					    error))
+		return FALSE;
+
+	/* clients only match object signals for the objects they use, but
+	 * scoped clients drop the match for the manager and rely on us */
+	if (g_strcmp0 (object_path, COLORD_DBUS_PATH) != 0)
+		return TRUE;
+	if (g_hash_table_size (priv->peers) == 0)
+		return TRUE;
+	destinations = cd_signal_scope_get_destinations (signal_scope,
+							 object_path,
+							 parameters_ref,
+							 seat,
+							 owner);
+	for (i = 0; i < destinations->len; i++) {
+		g_autoptr(GError) error_local = NULL;
+		destination = g_ptr_array_index (destinations, i);
+		if (!g_dbus_connection_emit_signal (connection,
+						    destination,
+						    object_path,
+						    interface_name,
+						    signal_name,
+						    parameters_ref,
+						    &error_local)) {
+			g_debug ("CdSignalScope: failed to send %s to %s: %s",
+				 signal_name, destination, error_local->message);
+		}
+	}
+	return TRUE;
+}
+
+static void
+cd_signal_scope_class_init (CdSignalScopeClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+	object_class->finalize = cd_signal_scope_finalize;
+}
+
+static void
+cd_signal_scope_init (CdSignalScope *signal_scope)
+{
+	CdSignalScopePrivate *priv = GET_PRIVATE (signal_scope);
+	priv->peers = g_hash_table_new_full (g_str_hash, g_str_equal,
+					     g_free,
+					     (GDestroyNotify) cd_signal_scope_peer_free);
+}
+
+static void
+cd_signal_scope_finalize (GObject *object)
+{
+	CdSignalScope *signal_scope = CD_SIGNAL_SCOPE (object);
+	CdSignalScopePrivate *priv = GET_PRIVATE (signal_scope);
+
+	g_hash_table_unref (priv->peers);
+
+	G_OBJECT_CLASS (cd_signal_scope_parent_class)->finalize (object);
+}
+
+CdSignalScope *
+cd_signal_scope_new (void)
+{
+	if (cd_signal_scope_object != NULL) {
+		g_object_ref (cd_signal_scope_object);
+	} else {
+		cd_signal_scope_object = g_object_new (CD_TYPE_SIGNAL_SCOPE, NULL);
+		g_object_add_weak_pointer (cd_signal_scope_object,
+					   &cd_signal_scope_object);
+	}
+	return CD_SIGNAL_SCOPE (cd_signal_scope_object);
+}
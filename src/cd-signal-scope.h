@@ -0,0 +1,63 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2010-2014 Richard Hughes <richard@hughsie.com>
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __CD_SIGNAL_SCOPE_H
+#define __CD_SIGNAL_SCOPE_H
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+#define CD_TYPE_SIGNAL_SCOPE (cd_signal_scope_get_type ())
+G_DECLARE_DERIVABLE_TYPE (CdSignalScope, cd_signal_scope, CD, SIGNAL_SCOPE, GObject)
+
+struct _CdSignalScopeClass
+{
+	GObjectClass		 parent_class;
+};
+
+CdSignalScope	*cd_signal_scope_new			(void);
+
+gboolean	 cd_signal_scope_add_peer		(CdSignalScope	*signal_scope,
+							 GDBusConnection *connection,
+							 const gchar	*sender,
+							 GVariant	*scope,
+							 GError		**error);
+gboolean	 cd_signal_scope_remove_peer		(CdSignalScope	*signal_scope,
+							 const gchar	*sender);
+GPtrArray	*cd_signal_scope_get_destinations	(CdSignalScope	*signal_scope,
+							 const gchar	*object_path,
+							 GVariant	*parameters,
+							 const gchar	*seat,
+							 guint		 owner);
+gboolean	 cd_signal_scope_emit			(CdSignalScope	*signal_scope,
+							 GDBusConnection *connection,
+							 const gchar	*object_path,
+							 const gchar	*interface_name,
+							 const gchar	*signal_name,
+							 GVariant	*parameters,
+							 const gchar	*seat,
+							 guint		 owner,
+							 GError		**error);
+
+G_END_DECLS
+
+#endif /* __CD_SIGNAL_SCOPE_H */
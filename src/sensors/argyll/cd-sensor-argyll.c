@@ -467,6 +467,13 @@ cd_sensor_unlock_async (CdSensor *sensor,
 	}
 }
 
+/* used for every kind without a native driver */
+gboolean
+cd_sensor_get_is_fallback (void)
+{
+	return TRUE;
+}
+
 gboolean
 cd_sensor_coldplug (CdSensor *sensor, GError **error)
 {
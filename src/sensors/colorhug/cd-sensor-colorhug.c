@@ -33,12 +33,20 @@ typedef struct
 {
 	GUsbDevice			*device;
 	ChDeviceQueue			*device_queue;
+	guint8				 flicker_samples[30];
+	gdouble				 flicker_period;
+	guint16				 integral_time;
+	gdouble				 auto_range;
 } CdSensorColorhugPrivate;
 
+/* fast enough to see 24Hz to 160Hz flicker in the 30 samples */
+#define CD_SENSOR_COLORHUG_FLICKER_INTERVAL	3.f	/* ms */
+
 /* async task for the sensor readings */
 typedef struct {
 	CdSensor			*sensor;
 	CdColorXYZ			 xyz;
+	guint16				 integral_time;
 	guint32				 serial_number;
 	ChSha1				 sha1;
 } CdSensorTaskData;
@@ -58,6 +66,20 @@ cd_sensor_task_data_free (CdSensorTaskData *data)
 	g_free (data);
 }
 
+/* the calibration matrices assume the longest integral time, but the
+ * flicker lock picks a shorter whole number of periods and the readings
+ * are proportional to the integral time, or zero for the device default */
+static void
+cd_sensor_colorhug_scale_reading (CdColorXYZ *xyz, guint16 integral_time)
+{
+	if (integral_time == 0 || integral_time == CH_INTEGRAL_TIME_VALUE_MAX)
+		return;
+	cd_color_xyz_set (xyz,
+			  xyz->X * CH_INTEGRAL_TIME_VALUE_MAX / integral_time,
+			  xyz->Y * CH_INTEGRAL_TIME_VALUE_MAX / integral_time,
+			  xyz->Z * CH_INTEGRAL_TIME_VALUE_MAX / integral_time);
+}
+
 static void
 cd_sensor_colorhug_get_sample_cb (GObject *object,
 				  GAsyncResult *res,
@@ -79,6 +101,8 @@ cd_sensor_colorhug_get_sample_cb (GObject *object,
 	g_debug ("finished values: red=%0.6lf, green=%0.6lf, blue=%0.6lf",
 		 data->xyz.X, data->xyz.Y, data->xyz.Z);
 
+	cd_sensor_colorhug_scale_reading (&data->xyz, data->integral_time);
+
 	/* save result */
 	g_task_return_pointer (task,
 			       cd_color_xyz_dup (&data->xyz),
@@ -135,10 +159,22 @@ cd_sensor_get_sample_async (CdSensor *sensor,
 
 	/* request */
 	cd_sensor_set_state (sensor, CD_SENSOR_STATE_STARTING);
-	ch_device_queue_take_readings_xyz (priv->device_queue,
-					   priv->device,
-					   calibration_index,
-					   &data->xyz);
+	if (priv->integral_time > 0 && priv->auto_range > 0.f) {
+		ch_device_queue_take_readings_xyz_auto (priv->device_queue,
+							priv->device,
+							calibration_index,
+							priv->integral_time,
+							priv->flicker_period,
+							priv->auto_range,
+							&data->xyz);
+	} else {
+		/* scaled when the reading completes */
+		data->integral_time = priv->integral_time;
+		ch_device_queue_take_readings_xyz (priv->device_queue,
+						   priv->device,
+						   calibration_index,
+						   &data->xyz);
+	}
 	ch_device_queue_process_async (priv->device_queue,
 				       CH_DEVICE_QUEUE_PROCESS_FLAGS_NONE,
 				       g_task_get_cancellable (task),
@@ -153,6 +189,52 @@ cd_sensor_get_sample_finish (CdSensor *sensor, GAsyncResult *res, GError **error
 	return g_task_propagate_pointer (G_TASK (res), error);
 }
 
+/* queue enough rapid samples to find the period of any flicker */
+static void
+cd_sensor_colorhug_queue_flicker_detect (CdSensor *sensor)
+{
+	CdSensorColorhugPrivate *priv = cd_sensor_colorhug_get_private (sensor);
+	guint16 integral_time;
+
+	integral_time = ch_integral_time_from_ms (CD_SENSOR_COLORHUG_FLICKER_INTERVAL);
+	memset (priv->flicker_samples, 0, sizeof (priv->flicker_samples));
+	ch_device_queue_set_integral_time (priv->device_queue,
+					   priv->device,
+					   integral_time);
+	ch_device_queue_take_reading_array (priv->device_queue,
+					    priv->device,
+					    priv->flicker_samples);
+}
+
+/* queue the longest integration time that is a whole number of cycles */
+static void
+cd_sensor_colorhug_queue_flicker_integral_time (CdSensor *sensor)
+{
+	CdSensorColorhugPrivate *priv = cd_sensor_colorhug_get_private (sensor);
+	gdouble samples[G_N_ELEMENTS (priv->flicker_samples)];
+	guint16 integral_time;
+	guint i;
+
+	for (i = 0; i < G_N_ELEMENTS (samples); i++)
+		samples[i] = priv->flicker_samples[i];
+	integral_time = ch_integral_time_from_ms (CD_SENSOR_COLORHUG_FLICKER_INTERVAL);
+	priv->flicker_period = ch_flicker_estimate_period (samples,
+							   G_N_ELEMENTS (samples),
+							   ch_integral_time_to_ms (integral_time));
+	integral_time = ch_flicker_get_integral_time (priv->flicker_period,
+						      ch_integral_time_to_ms (CH_INTEGRAL_TIME_VALUE_MAX));
+	g_debug ("flicker period %.3fms, using integral time %.1fms",
+		 priv->flicker_period, ch_integral_time_to_ms (integral_time));
+	priv->integral_time = integral_time;
+	ch_device_queue_set_integral_time (priv->device_queue,
+					   priv->device,
+					   integral_time);
+	cd_sensor_add_option (sensor, "flicker-period",
+			      g_variant_new_double (priv->flicker_period));
+	cd_sensor_add_option (sensor, "integration-time",
+			      g_variant_new_double (ch_integral_time_to_ms (integral_time)));
+}
+
 static void
 cd_sensor_colorhug_get_remote_hash_cb (GObject *object,
 				       GAsyncResult *res,
@@ -176,6 +258,36 @@ cd_sensor_colorhug_get_remote_hash_cb (GObject *object,
 	g_task_return_boolean (task, TRUE);
 }
 
+static void
+cd_sensor_colorhug_flicker_cb (GObject *object,
+			       GAsyncResult *res,
+			       gpointer user_data)
+{
+	GTask *task = G_TASK (user_data);
+	CdSensorTaskData *data = g_task_get_task_data (task);
+	CdSensor *sensor = data->sensor;
+	CdSensorColorhugPrivate *priv = cd_sensor_colorhug_get_private (sensor);
+	ChDeviceQueue *device_queue = CH_DEVICE_QUEUE (object);
+	g_autoptr(GError) error = NULL;
+
+	/* older firmware may not support the reading array */
+	if (!ch_device_queue_process_finish (device_queue, res, &error)) {
+		g_warning ("ignoring error: %s", error->message);
+		memset (priv->flicker_samples, 0, sizeof (priv->flicker_samples));
+	}
+	cd_sensor_colorhug_queue_flicker_integral_time (sensor);
+
+	/* get the optional remote hash */
+	ch_device_queue_get_remote_hash (priv->device_queue,
+				         priv->device,
+				         &data->sha1);
+	ch_device_queue_process_async (priv->device_queue,
+				       CH_DEVICE_QUEUE_PROCESS_FLAGS_NONE,
+				       g_task_get_cancellable (task),
+				       cd_sensor_colorhug_get_remote_hash_cb,
+				       task);
+}
+
 static void
 cd_sensor_colorhug_startup_cb (GObject *object,
 			       GAsyncResult *res,
@@ -206,6 +318,17 @@ cd_sensor_colorhug_startup_cb (GObject *object,
 	cd_sensor_set_serial (sensor, serial_number_tmp);
 	g_debug ("Serial number: %s", serial_number_tmp);
 
+	/* line the integration time up with any flicker */
+	if (cd_sensor_get_kind (sensor) == CD_SENSOR_KIND_COLORHUG) {
+		cd_sensor_colorhug_queue_flicker_detect (sensor);
+		ch_device_queue_process_async (priv->device_queue,
+					       CH_DEVICE_QUEUE_PROCESS_FLAGS_NONE,
+					       g_task_get_cancellable (task),
+					       cd_sensor_colorhug_flicker_cb,
+					       task);
+		return;
+	}
+
 	/* get the optional remote hash */
 	ch_device_queue_get_remote_hash (priv->device_queue,
 				         priv->device,
@@ -225,8 +348,9 @@ cd_sensor_colorhug_startup_cb (GObject *object,
  * - Connect to the USB device
  * - Flash the LEDs
  * - Get the serial number
- * - Set the integral time to 50ms
  * - Turn the sensor on to 100%
+ * - Find the period of any flicker from rapid samples
+ * - Set the integral time to a whole number of flicker periods
  * - Gets the remote profile hash
  **/
 void
@@ -272,9 +396,6 @@ cd_sensor_lock_async (CdSensor *sensor,
 					   priv->device,
 					   &data->serial_number);
 	if (cd_sensor_get_kind (sensor) == CD_SENSOR_KIND_COLORHUG) {
-		ch_device_queue_set_integral_time (priv->device_queue,
-						   priv->device,
-						   CH_INTEGRAL_TIME_VALUE_MAX);
 		ch_device_queue_set_multiplier (priv->device_queue,
 						priv->device,
 						CH_FREQ_SCALE_100);
@@ -364,6 +485,35 @@ cd_sensor_colorhug_set_options_cb (GObject *object,
 	cd_sensor_set_next_option (task);
 }
 
+static void
+cd_sensor_colorhug_set_flicker_cb (GObject *object,
+				   GAsyncResult *res,
+				   gpointer user_data)
+{
+	ChDeviceQueue *device_queue = CH_DEVICE_QUEUE (object);
+	GTask *task = G_TASK (user_data);
+	CdSensor *sensor = CD_SENSOR (g_task_get_source_object (task));
+	CdSensorColorhugPrivate *priv = cd_sensor_colorhug_get_private (sensor);
+	g_autoptr(GError) error = NULL;
+
+	/* get data */
+	if (!ch_device_queue_process_finish (device_queue, res, &error)) {
+		g_task_return_new_error (task,
+					 CD_SENSOR_ERROR,
+					 CD_SENSOR_ERROR_INTERNAL,
+					 "%s", error->message);
+		return;
+	}
+
+	/* use the new period */
+	cd_sensor_colorhug_queue_flicker_integral_time (sensor);
+	ch_device_queue_process_async (priv->device_queue,
+				       CH_DEVICE_QUEUE_PROCESS_FLAGS_NONE,
+				       g_task_get_cancellable (task),
+				       cd_sensor_colorhug_set_options_cb,
+				       task);
+}
+
 static void
 cd_sensor_colorhug_write_eeprom_cb (GObject *object,
 				   GAsyncResult *res,
@@ -399,6 +549,8 @@ cd_sensor_set_next_option (GTask *task)
 	const gchar *magic = "Un1c0rn2";
 	gboolean ret;
 	GVariant *value;
+	gdouble integration_time;
+	guint16 integral_time;
 	g_autoptr(GError) error = NULL;
 	g_autoptr(GList) keys = NULL;
 
@@ -447,6 +599,61 @@ cd_sensor_set_next_option (GTask *task)
 					       g_task_get_cancellable (task),
 					       cd_sensor_colorhug_set_options_cb,
 					       task);
+	} else if (g_strcmp0 (key, "integration-time") == 0 &&
+		   cd_sensor_get_kind (sensor) == CD_SENSOR_KIND_COLORHUG) {
+
+		/* in ms, where zero means matching any flicker */
+		if (!g_variant_is_of_type (value, G_VARIANT_TYPE_DOUBLE)) {
+			g_task_return_new_error (task,
+						 CD_SENSOR_ERROR,
+						 CD_SENSOR_ERROR_INTERNAL,
+						 "Sensor option %s has to be a double",
+						 key);
+			g_hash_table_remove (options, key);
+			return;
+		}
+		integration_time = g_variant_get_double (value);
+		g_hash_table_remove (options, key);
+		if (integration_time <= 0.f) {
+			cd_sensor_colorhug_queue_flicker_detect (sensor);
+			ch_device_queue_process_async (priv->device_queue,
+						       CH_DEVICE_QUEUE_PROCESS_FLAGS_NONE,
+						       g_task_get_cancellable (task),
+						       cd_sensor_colorhug_set_flicker_cb,
+						       task);
+			return;
+		}
+		integral_time = ch_integral_time_from_ms (integration_time);
+		g_debug ("setting integration time %.1fms", integration_time);
+		cd_sensor_add_option (sensor, "integration-time",
+				      g_variant_new_double (ch_integral_time_to_ms (integral_time)));
+		priv->integral_time = integral_time;
+		ch_device_queue_set_integral_time (priv->device_queue,
+						   priv->device,
+						   integral_time);
+		ch_device_queue_process_async (priv->device_queue,
+					       CH_DEVICE_QUEUE_PROCESS_FLAGS_NONE,
+					       g_task_get_cancellable (task),
+					       cd_sensor_colorhug_set_options_cb,
+					       task);
+	} else if (g_strcmp0 (key, "auto-range") == 0 &&
+		   cd_sensor_get_kind (sensor) == CD_SENSOR_KIND_COLORHUG) {
+
+		/* the smallest reading that is precise enough, or zero */
+		if (!g_variant_is_of_type (value, G_VARIANT_TYPE_DOUBLE)) {
+			g_task_return_new_error (task,
+						 CD_SENSOR_ERROR,
+						 CD_SENSOR_ERROR_INTERNAL,
+						 "Sensor option %s has to be a double",
+						 key);
+			g_hash_table_remove (options, key);
+			return;
+		}
+		priv->auto_range = MAX (g_variant_get_double (value), 0.f);
+		g_debug ("setting auto-range target %.3f", priv->auto_range);
+		cd_sensor_add_option (sensor, key, value);
+		g_hash_table_remove (options, key);
+		cd_sensor_set_next_option (task);
 	} else {
 		g_task_return_new_error (task,
 					 CD_SENSOR_ERROR,
@@ -491,6 +698,15 @@ cd_sensor_unref_private (CdSensorColorhugPrivate *priv)
 	g_free (priv);
 }
 
+const CdSensorKind *
+cd_sensor_get_kinds (void)
+{
+	static const CdSensorKind kinds[] = { CD_SENSOR_KIND_COLORHUG,
+						  CD_SENSOR_KIND_COLORHUG2,
+						  CD_SENSOR_KIND_UNKNOWN };
+	return kinds;
+}
+
 gboolean
 cd_sensor_coldplug (CdSensor *sensor, GError **error)
 {
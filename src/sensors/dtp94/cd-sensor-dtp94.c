@@ -220,6 +220,14 @@ cd_sensor_unref_private (CdSensorDtp94Private *priv)
 	g_free (priv);
 }
 
+const CdSensorKind *
+cd_sensor_get_kinds (void)
+{
+	static const CdSensorKind kinds[] = { CD_SENSOR_KIND_DTP94,
+						  CD_SENSOR_KIND_UNKNOWN };
+	return kinds;
+}
+
 gboolean
 cd_sensor_coldplug (CdSensor *sensor, GError **error)
 {
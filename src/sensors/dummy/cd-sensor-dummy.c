@@ -206,6 +206,14 @@ out:
 	return transform;
 }
 
+const CdSensorKind *
+cd_sensor_get_kinds (void)
+{
+	static const CdSensorKind kinds[] = { CD_SENSOR_KIND_DUMMY,
+						  CD_SENSOR_KIND_UNKNOWN };
+	return kinds;
+}
+
 gboolean
 cd_sensor_coldplug (CdSensor *sensor, GError **error)
 {
@@ -127,6 +127,62 @@ cd_sensor_get_sample_finish (CdSensor *sensor, GAsyncResult *res, GError **error
 	return g_task_propagate_pointer (G_TASK (res), error);
 }
 
+void
+cd_sensor_set_options_async (CdSensor *sensor,
+			     GHashTable *options,
+			     GCancellable *cancellable,
+			     GAsyncReadyCallback callback,
+			     gpointer user_data)
+{
+	CdSensorHueyPrivate *priv = cd_sensor_huey_get_private (sensor);
+	GList *l;
+	const gchar *key_name;
+	GVariant *value;
+	g_autoptr(GTask) task = NULL;
+	g_autoptr(GList) keys = NULL;
+
+	g_return_if_fail (CD_IS_SENSOR (sensor));
+
+	task = g_task_new (sensor, cancellable, callback, user_data);
+
+	/* look for any keys we recognise */
+	keys = g_hash_table_get_keys (options);
+	for (l = keys; l != NULL; l = l->next) {
+		key_name = (const gchar *) l->data;
+		value = g_hash_table_lookup (options, key_name);
+		if (g_strcmp0 (key_name, "predict-gain") != 0) {
+			g_task_return_new_error (task,
+						 CD_SENSOR_ERROR,
+						 CD_SENSOR_ERROR_NO_SUPPORT,
+						 "Sensor option %s is not supported",
+						 key_name);
+			return;
+		}
+
+		/* only useful when the patches are measured in order */
+		if (!g_variant_is_of_type (value, G_VARIANT_TYPE_BOOLEAN)) {
+			g_task_return_new_error (task,
+						 CD_SENSOR_ERROR,
+						 CD_SENSOR_ERROR_INTERNAL,
+						 "Sensor option %s has to be a boolean",
+						 key_name);
+			return;
+		}
+		huey_ctx_set_predict_gain (priv->ctx, g_variant_get_boolean (value));
+		cd_sensor_add_option (sensor, key_name, value);
+	}
+
+	/* success */
+	g_task_return_boolean (task, TRUE);
+}
+
+gboolean
+cd_sensor_set_options_finish (CdSensor *sensor, GAsyncResult *res, GError **error)
+{
+	g_return_val_if_fail (g_task_is_valid (res, sensor), FALSE);
+	return g_task_propagate_boolean (G_TASK (res), error);
+}
+
 static void
 cd_sensor_huey_lock_thread_cb (GTask *task,
 			       gpointer source_object,
@@ -327,6 +383,14 @@ cd_sensor_unref_private (CdSensorHueyPrivate *priv)
 	g_free (priv);
 }
 
+const CdSensorKind *
+cd_sensor_get_kinds (void)
+{
+	static const CdSensorKind kinds[] = { CD_SENSOR_KIND_HUEY,
+						  CD_SENSOR_KIND_UNKNOWN };
+	return kinds;
+}
+
 gboolean
 cd_sensor_coldplug (CdSensor *sensor, GError **error)
 {
@@ -51,6 +51,19 @@ static void	huey_ctx_finalize	(GObject	*object);
  * indicates we doing something wrong. */
 #define HUEY_XYZ_POST_MULTIPLY_FACTOR	3.428
 
+/* The two-pass sample truncates the multipliers, so its second pass counts
+ * to between half of HUEY_POLL_FREQUENCY and HUEY_POLL_FREQUENCY, and the
+ * two passes together count to less than twice HUEY_POLL_FREQUENCY.
+ * Reused multipliers are good enough if they are as precise and as quick. */
+#define HUEY_PREDICT_RAW_MIN		(HUEY_POLL_FREQUENCY / 2)
+#define HUEY_PREDICT_RAW_MAX		(HUEY_POLL_FREQUENCY * 2)
+
+typedef struct {
+	guint16	R;
+	guint16	G;
+	guint16	B;
+} HueyCtxMultiplier;
+
 typedef struct
 {
 	CdMat3x3		 calibration_crt;
@@ -59,6 +72,9 @@ typedef struct
 	gchar			*unlock_string;
 	gfloat			 calibration_value;
 	GUsbDevice		*device;
+	gboolean		 predict_gain;
+	gboolean		 multiplier_valid;
+	HueyCtxMultiplier	 multiplier;
 } HueyCtxPrivate;
 
 enum {
@@ -95,6 +111,9 @@ huey_ctx_setup (HueyCtx *ctx, GError **error)
 	g_return_val_if_fail (HUEY_IS_CTX (ctx), FALSE);
 	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
+	/* the device might have been replugged */
+	priv->multiplier_valid = FALSE;
+
 	/* get matrix */
 	cd_mat33_clear (&priv->calibration_lcd);
 	ret = huey_device_read_register_matrix (priv->device,
@@ -175,11 +194,27 @@ huey_ctx_get_unlock_string (HueyCtx *ctx)
 	return priv->unlock_string;
 }
 
-typedef struct {
-	guint16	R;
-	guint16	G;
-	guint16	B;
-} HueyCtxMultiplier;
+/* consecutive patches usually have a similar luminance, so the multipliers
+ * of the last sample can be reused rather than measuring at unity gain
+ * first, which halves the number of USB transactions for each patch.
+ * A much darker patch takes a long time to count up, so this should only
+ * be enabled when the caller measures patches in a smooth sequence */
+void
+huey_ctx_set_predict_gain (HueyCtx *ctx, gboolean predict_gain)
+{
+	HueyCtxPrivate *priv = GET_PRIVATE (ctx);
+	g_return_if_fail (HUEY_IS_CTX (ctx));
+	priv->predict_gain = predict_gain;
+	priv->multiplier_valid = FALSE;
+}
+
+gboolean
+huey_ctx_get_predict_gain (HueyCtx *ctx)
+{
+	HueyCtxPrivate *priv = GET_PRIVATE (ctx);
+	g_return_val_if_fail (HUEY_IS_CTX (ctx), FALSE);
+	return priv->predict_gain;
+}
 
 typedef struct {
 	guint32	R;
@@ -187,13 +222,67 @@ typedef struct {
 	guint32	B;
 } HueyCtxDeviceRaw;
 
+static gboolean
+huey_ctx_real_send_data (HueyCtx *ctx,
+			 const guint8 *request,
+			 gsize request_len,
+			 guint8 *reply,
+			 gsize reply_len,
+			 gsize *reply_read,
+			 GError **error)
+{
+	HueyCtxPrivate *priv = GET_PRIVATE (ctx);
+	return huey_device_send_data (priv->device,
+				      request, request_len,
+				      reply, reply_len,
+				      reply_read,
+				      error);
+}
+
+static gboolean
+huey_ctx_real_reset (HueyCtx *ctx, GError **error)
+{
+	HueyCtxPrivate *priv = GET_PRIVATE (ctx);
+	if (!g_usb_device_reset (priv->device, error))
+		return FALSE;
+	return huey_device_unlock (priv->device, error);
+}
+
+static gboolean
+huey_ctx_send_data (HueyCtx *ctx,
+		    const guint8 *request,
+		    gsize request_len,
+		    guint8 *reply,
+		    gsize reply_len,
+		    gsize *reply_read,
+		    GError **error)
+{
+	HueyCtxClass *klass = HUEY_CTX_GET_CLASS (ctx);
+	return klass->send_data (ctx, request, request_len,
+				 reply, reply_len, reply_read, error);
+}
+
+/* the multiplier that would make this channel count to HUEY_POLL_FREQUENCY */
+static guint16
+huey_ctx_get_multiplier_for_raw (guint16 multiplier, guint32 raw)
+{
+	gdouble tmp;
+	if (raw == 0)
+		return multiplier;
+	tmp = (gdouble) multiplier * HUEY_POLL_FREQUENCY / (gdouble) raw;
+	if (tmp < 1.f)
+		return 1;
+	if (tmp > G_MAXUINT16)
+		return G_MAXUINT16;
+	return (guint16) tmp;
+}
+
 static gboolean
 huey_ctx_sample_for_threshold (HueyCtx *ctx,
 			       HueyCtxMultiplier *threshold,
 			       HueyCtxDeviceRaw *raw,
 			       GError **error)
 {
-	HueyCtxPrivate *priv = GET_PRIVATE (ctx);
 	guint8 request[] = { HUEY_CMD_SENSOR_MEASURE_RGB,
 			     0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
 	guint8 reply[8];
@@ -206,11 +295,11 @@ huey_ctx_sample_for_threshold (HueyCtx *ctx,
 	cd_buffer_write_uint16_be (request + 5, threshold->B);
 
 	/* measure, and get red */
-	ret = huey_device_send_data (priv->device,
-				     request, 8,
-				     reply, 8,
-				     &reply_read,
-				     error);
+	ret = huey_ctx_send_data (ctx,
+				  request, 8,
+				  reply, 8,
+				  &reply_read,
+				  error);
 	if (!ret)
 		return FALSE;
 
@@ -219,11 +308,11 @@ huey_ctx_sample_for_threshold (HueyCtx *ctx,
 
 	/* get green */
 	request[0] = HUEY_CMD_READ_GREEN;
-	ret = huey_device_send_data (priv->device,
-				     request, 8,
-				     reply, 8,
-				     &reply_read,
-				     error);
+	ret = huey_ctx_send_data (ctx,
+				  request, 8,
+				  reply, 8,
+				  &reply_read,
+				  error);
 	if (!ret)
 		return FALSE;
 
@@ -232,11 +321,11 @@ huey_ctx_sample_for_threshold (HueyCtx *ctx,
 
 	/* get blue */
 	request[0] = HUEY_CMD_READ_BLUE;
-	ret = huey_device_send_data (priv->device,
-				     request, 8,
-				     reply, 8,
-				     &reply_read,
-				     error);
+	ret = huey_ctx_send_data (ctx,
+				  request, 8,
+				  reply, 8,
+				  &reply_read,
+				  error);
 	if (!ret)
 		return FALSE;
 
@@ -245,6 +334,36 @@ huey_ctx_sample_for_threshold (HueyCtx *ctx,
 	return TRUE;
 }
 
+static gboolean
+huey_ctx_raw_in_range (guint32 raw)
+{
+	return raw >= HUEY_PREDICT_RAW_MIN && raw <= HUEY_PREDICT_RAW_MAX;
+}
+
+static gboolean
+huey_ctx_sample_predicted (HueyCtx *ctx,
+			   HueyCtxMultiplier *multiplier,
+			   HueyCtxDeviceRaw *raw,
+			   GError **error)
+{
+	HueyCtxPrivate *priv = GET_PRIVATE (ctx);
+
+	*multiplier = priv->multiplier;
+	if (!huey_ctx_sample_for_threshold (ctx, multiplier, raw, error))
+		return FALSE;
+	g_debug ("predicted values: red=%u, green=%u, blue=%u",
+		 raw->R, raw->G, raw->B);
+	if (huey_ctx_raw_in_range (raw->R) &&
+	    huey_ctx_raw_in_range (raw->G) &&
+	    huey_ctx_raw_in_range (raw->B))
+		return TRUE;
+	g_set_error_literal (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_INVALID_DATA,
+			     "predicted multipliers out of range");
+	return FALSE;
+}
+
 /**
  * huey_ctx_convert_device_RGB_to_XYZ:
  *
@@ -296,6 +415,28 @@ huey_ctx_take_sample (HueyCtx *ctx, CdSensorCap cap, GError **error)
 		return NULL;
 	}
 
+	/* try the multipliers that worked for the last sample */
+	if (priv->predict_gain && priv->multiplier_valid) {
+		g_autoptr(GError) error_local = NULL;
+		if (huey_ctx_sample_predicted (ctx, &multiplier,
+					       &color_native, &error_local))
+			goto out;
+		if (g_error_matches (error_local, G_USB_DEVICE_ERROR, G_USB_DEVICE_ERROR_TIMED_OUT)) {
+			/* the device is still counting, so the next command
+			 * would get the reply for this one */
+			g_debug ("%s, resetting device", error_local->message);
+			if (!HUEY_CTX_GET_CLASS (ctx)->reset (ctx, error)) {
+				priv->multiplier_valid = FALSE;
+				return NULL;
+			}
+		} else if (!g_error_matches (error_local, G_IO_ERROR, G_IO_ERROR_INVALID_DATA)) {
+			g_propagate_error (error, g_steal_pointer (&error_local));
+			return NULL;
+		}
+		g_debug ("%s, falling back to two passes", error_local->message);
+	}
+	priv->multiplier_valid = FALSE;
+
 	/* set this to one value for a quick approximate value */
 	multiplier.R = 1;
 	multiplier.G = 1;
@@ -310,20 +451,9 @@ huey_ctx_take_sample (HueyCtx *ctx, CdSensorCap cap, GError **error)
 		 color_native.R, color_native.G, color_native.B);
 
 	/* try to fill the 16 bit register for accuracy */
-	if (color_native.R != 0)
-		multiplier.R = HUEY_POLL_FREQUENCY / color_native.R;
-	if (color_native.G != 0)
-		multiplier.G = HUEY_POLL_FREQUENCY / color_native.G;
-	if (color_native.B != 0)
-		multiplier.B = HUEY_POLL_FREQUENCY / color_native.B;
-
-	/* don't allow a value of zero */
-	if (multiplier.R == 0)
-		multiplier.R = 1;
-	if (multiplier.G == 0)
-		multiplier.G = 1;
-	if (multiplier.B == 0)
-		multiplier.B = 1;
+	multiplier.R = huey_ctx_get_multiplier_for_raw (1, color_native.R);
+	multiplier.G = huey_ctx_get_multiplier_for_raw (1, color_native.G);
+	multiplier.B = huey_ctx_get_multiplier_for_raw (1, color_native.B);
 	g_debug ("using multiplier factor: red=%i, green=%i, blue=%i",
 		 multiplier.R, multiplier.G, multiplier.B);
 	ret = huey_ctx_sample_for_threshold (ctx,
@@ -332,9 +462,16 @@ huey_ctx_take_sample (HueyCtx *ctx, CdSensorCap cap, GError **error)
 					     error);
 	if (!ret)
 		return NULL;
+out:
 	g_debug ("raw values: red=%u, green=%u, blue=%u",
 		 color_native.R, color_native.G, color_native.B);
 
+	/* follow the luminance of the patches for the next prediction */
+	priv->multiplier.R = huey_ctx_get_multiplier_for_raw (multiplier.R, color_native.R);
+	priv->multiplier.G = huey_ctx_get_multiplier_for_raw (multiplier.G, color_native.G);
+	priv->multiplier.B = huey_ctx_get_multiplier_for_raw (multiplier.B, color_native.B);
+	priv->multiplier_valid = TRUE;
+
 	/* get DeviceRGB values */
 	values.R = (gdouble) multiplier.R * 0.5f * HUEY_POLL_FREQUENCY / ((gdouble) color_native.R);
 	values.G = (gdouble) multiplier.G * 0.5f * HUEY_POLL_FREQUENCY / ((gdouble) color_native.G);
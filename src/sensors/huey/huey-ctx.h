@@ -35,10 +35,18 @@ G_DECLARE_DERIVABLE_TYPE (HueyCtx, huey_ctx, HUEY, CTX, GObject)
 struct _HueyCtxClass
 {
 	GObjectClass		 parent_class;
+	/* the USB transport, which the self test emulates */
+	gboolean (*send_data)	(HueyCtx	*ctx,
+				 const guint8	*request,
+				 gsize		 request_len,
+				 guint8		*reply,
+				 gsize		 reply_len,
+				 gsize		*reply_read,
+				 GError		**error);
+	gboolean (*reset)	(HueyCtx	*ctx,
+				 GError		**error);
 	/*< private >*/
 	/* Padding for future expansion */
-	void (*_huey_ctx_reserved1) (void);
-	void (*_huey_ctx_reserved2) (void);
 	void (*_huey_ctx_reserved3) (void);
 	void (*_huey_ctx_reserved4) (void);
 	void (*_huey_ctx_reserved5) (void);
@@ -64,6 +72,9 @@ const CdMat3x3	*huey_ctx_get_calibration_crt	(HueyCtx	*ctx);
 gfloat		 huey_ctx_get_calibration_value	(HueyCtx	*ctx);
 const CdVec3	*huey_ctx_get_dark_offset	(HueyCtx	*ctx);
 const gchar	*huey_ctx_get_unlock_string	(HueyCtx	*ctx);
+void		 huey_ctx_set_predict_gain	(HueyCtx	*ctx,
+						 gboolean	 predict_gain);
+gboolean	 huey_ctx_get_predict_gain	(HueyCtx	*ctx);
 
 G_END_DECLS
 
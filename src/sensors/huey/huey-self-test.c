@@ -0,0 +1,186 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2013 Richard Hughes <richard@hughsie.com>
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "config.h"
+
+#include <glib.h>
+#include <glib-object.h>
+#include <gusb.h>
+#include <colord-private.h>
+
+#include "huey-ctx.h"
+#include "huey-enum.h"
+
+/* the emulated device counts this fast, like the real one */
+#define HUEY_EMULATED_FREQUENCY		1e6
+
+/* a transfer taking longer than this times out */
+#define HUEY_EMULATED_TIMEOUT_RAW	(HUEY_EMULATED_FREQUENCY * 4)
+
+#define HUEY_TYPE_CTX_EMULATED (huey_ctx_emulated_get_type ())
+G_DECLARE_FINAL_TYPE (HueyCtxEmulated, huey_ctx_emulated, HUEY, CTX_EMULATED, HueyCtx)
+
+struct _HueyCtxEmulated
+{
+	HueyCtx			 parent_instance;
+	gdouble			 luminance;	/* of the patch, in device RGB */
+	guint32			 raw[3];
+	guint			 transactions;
+	guint			 resets;
+};
+
+G_DEFINE_TYPE (HueyCtxEmulated, huey_ctx_emulated, HUEY_TYPE_CTX)
+
+static gboolean
+huey_ctx_emulated_send_data (HueyCtx *ctx,
+			     const guint8 *request,
+			     gsize request_len,
+			     guint8 *reply,
+			     gsize reply_len,
+			     gsize *reply_read,
+			     GError **error)
+{
+	HueyCtxEmulated *self = HUEY_CTX_EMULATED (ctx);
+	guint i;
+
+	self->transactions++;
+	reply[0] = HUEY_RC_SUCCESS;
+	reply[1] = request[0];
+	switch (request[0]) {
+	case HUEY_CMD_SENSOR_MEASURE_RGB:
+		/* the device counts until it has seen multiplier pulses */
+		for (i = 0; i < 3; i++) {
+			guint16 multiplier = cd_buffer_read_uint16_be (request + 1 + i * 2);
+			gdouble raw = multiplier * 0.5f * HUEY_EMULATED_FREQUENCY / self->luminance;
+			if (raw > HUEY_EMULATED_TIMEOUT_RAW) {
+				g_set_error_literal (error,
+						     G_USB_DEVICE_ERROR,
+						     G_USB_DEVICE_ERROR_TIMED_OUT,
+						     "emulated timeout");
+				return FALSE;
+			}
+			self->raw[i] = raw;
+		}
+		cd_buffer_write_uint32_be (reply + 2, self->raw[0]);
+		break;
+	case HUEY_CMD_READ_GREEN:
+		cd_buffer_write_uint32_be (reply + 2, self->raw[1]);
+		break;
+	case HUEY_CMD_READ_BLUE:
+		cd_buffer_write_uint32_be (reply + 2, self->raw[2]);
+		break;
+	default:
+		g_assert_not_reached ();
+	}
+	*reply_read = 8;
+	return TRUE;
+}
+
+static gboolean
+huey_ctx_emulated_reset (HueyCtx *ctx, GError **error)
+{
+	HueyCtxEmulated *self = HUEY_CTX_EMULATED (ctx);
+	self->resets++;
+	return TRUE;
+}
+
+static void
+huey_ctx_emulated_class_init (HueyCtxEmulatedClass *klass)
+{
+	HueyCtxClass *ctx_class = HUEY_CTX_CLASS (klass);
+	ctx_class->send_data = huey_ctx_emulated_send_data;
+	ctx_class->reset = huey_ctx_emulated_reset;
+}
+
+static void
+huey_ctx_emulated_init (HueyCtxEmulated *self)
+{
+}
+
+static guint
+huey_test_sample (HueyCtxEmulated *self, gdouble luminance)
+{
+	CdColorXYZ *xyz;
+	guint transactions = self->transactions;
+	g_autoptr(GError) error = NULL;
+
+	self->luminance = luminance;
+	xyz = huey_ctx_take_sample (HUEY_CTX (self), CD_SENSOR_CAP_LCD, &error);
+	g_assert_no_error (error);
+	g_assert (xyz != NULL);
+	cd_color_xyz_free (xyz);
+	return self->transactions - transactions;
+}
+
+static void
+huey_predict_gain_func (void)
+{
+	gdouble luminance;
+	guint i;
+	g_autoptr(HueyCtxEmulated) self = NULL;
+
+	/* two passes of three transfers for each patch */
+	self = g_object_new (HUEY_TYPE_CTX_EMULATED, NULL);
+	luminance = 50.f;
+	for (i = 0; i < 10; i++) {
+		g_assert_cmpint (huey_test_sample (self, luminance), ==, 6);
+		luminance *= 0.95f;
+	}
+	g_assert_cmpint (self->transactions, ==, 60);
+
+	/* a ramp only needs one pass after the first patch */
+	huey_ctx_set_predict_gain (HUEY_CTX (self), TRUE);
+	self->transactions = 0;
+	luminance = 50.f;
+	for (i = 0; i < 10; i++) {
+		huey_test_sample (self, luminance);
+		luminance *= 0.95f;
+	}
+	g_assert_cmpint (self->transactions, ==, 6 + 9 * 3);
+
+	/* the multipliers follow the ramp, so it also works going back up */
+	self->transactions = 0;
+	for (i = 0; i < 10; i++) {
+		luminance /= 0.95f;
+		g_assert_cmpint (huey_test_sample (self, luminance), ==, 3);
+	}
+
+	/* a much darker patch times out, so the device is reset */
+	g_assert_cmpint (huey_test_sample (self, 0.2f), ==, 1 + 6);
+	g_assert_cmpint (self->resets, ==, 1);
+
+	/* a much brighter patch is out of range */
+	g_assert_cmpint (huey_test_sample (self, 50.f), ==, 3 + 6);
+	g_assert_cmpint (self->resets, ==, 1);
+}
+
+int
+main (int argc, char **argv)
+{
+	g_test_init (&argc, &argv, NULL);
+
+	/* only critical and error are fatal */
+	g_log_set_fatal_mask (NULL, G_LOG_LEVEL_ERROR | G_LOG_LEVEL_CRITICAL);
+
+	/* tests go here */
+	g_test_add_func ("/huey/predict-gain", huey_predict_gain_func);
+	return g_test_run ();
+}
@@ -678,6 +678,14 @@ cd_sensor_unref_private (CdSensorMunkiPrivate *priv)
 	g_free (priv);
 }
 
+const CdSensorKind *
+cd_sensor_get_kinds (void)
+{
+	static const CdSensorKind kinds[] = { CD_SENSOR_KIND_COLOR_MUNKI_PHOTO,
+						  CD_SENSOR_KIND_UNKNOWN };
+	return kinds;
+}
+
 gboolean
 cd_sensor_coldplug (CdSensor *sensor, GError **error)
 {